@@ -1,6 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include "Common.h"
+#include "dsp_core/PluginCommon.h"
 
 // TODO: Quantidade de parametros
 const long unsigned int NUM_PARAMS = 1;
@@ -19,6 +19,7 @@ MyAudioProcessor::MyAudioProcessor()
 
     castParameter(apvts, ParamID::gain, gainParam);
     apvts.state.addListener(this);
+    trace.setup(getName(), getParameters());
     
     createPrograms();
     setCurrentProgram(0);
@@ -36,7 +37,8 @@ MyAudioProcessor::~MyAudioProcessor()
 
 // TODO: funcao que roda logo ANTES de começar a processar
 void MyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock) {
-     juce::ignoreUnused(sampleRate, samplesPerBlock); 
+     juce::ignoreUnused(samplesPerBlock);
+     trace.prepare(sampleRate);
 }
 
 // TODO: funcao que processa audio em loop - AUDIO THREAD!!!
@@ -45,6 +47,13 @@ void MyAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Mid
     //ignora mensagens MIDI
     juce::ignoreUnused(midiMessages);
 
+    // marca o bloco no trace (so com DSP_CORE_TRACE definido; ver dsp_core/Trace.h)
+    const dsp_core::Trace::ScopedBlock tracedBlock(trace, buffer.getNumSamples());
+
+    // ativa FTZ/DAZ na thread de audio (ver dsp_core/Denormals.h). O modo da CPU so e
+    // alterado na primeira vez, em vez de ser trocado e restaurado a cada bloco
+    dsp_core::disableDenormals();
+
     //loop pelos canais (plugin stereo)
     for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
     {
@@ -74,10 +83,9 @@ void MyAudioProcessor::update() {
 
     gain_ = gainParam->get();
 
-    // exemplo de debug de parametro na console (precisa compilar em modo debug)  
-    std::stringstream ss;
-    ss << "gain: " << gain_;
-    DBG(ss.str()); //print na console para debug rapido
+    // debug de parametros: DBG monta strings e aloca, entao nao pode rodar aqui. O trace
+    // grava so os parametros que mudaram, sem alocar (DSP_CORE_TRACE=<arquivo.json>)
+    trace.parameters(getParameters());
 }
 
 //==============================================================================
@@ -98,7 +106,19 @@ juce::AudioProcessorValueTreeState::ParameterLayout MyAudioProcessor::createPara
 }
 
 //==============================================================================
-// Gestao de presets (somente funcoes que variam por plugin. Ver Common.h)
+// Controle de GUI
+//------------------------------------------------------------------------------
+// Cria editor generico
+juce::AudioProcessorEditor* MyAudioProcessor::createEditor() 
+{ 
+    auto editor = new juce::GenericAudioProcessorEditor(*this);
+    editor->setSize(500, 500);
+    return editor;
+}
+//==============================================================================
+
+//==============================================================================
+// Gestao de presets (somente funcoes que variam por plugin. Ver dsp_core/PluginCommon.h)
 //------------------------------------------------------------------------------
 
 // TODO: Cria presets iniciais
@@ -15,7 +15,9 @@
 #include <vector>
 #include <cmath>
 
-#include "Preset.h"
+#include "dsp_core/Preset.h"
+#include "dsp_core/Denormals.h"
+#include "dsp_core/Trace.h"
 
 // TODO: Namespace onde os parametros do plugin sao declarados
 // Para adicionar um parametro, adicionar uma nova linha PARAMETER_ID(<nome_parametro>)
@@ -93,6 +95,8 @@ private:
     int currentProgram;
     // Indica se algum parametro mudou
     std::atomic<bool> parametersChanged { false };    
+    // Registro de eventos da thread de audio (ver dsp_core/Trace.h)
+    dsp_core::Trace trace;
 
     void valueTreePropertyChanged(juce::ValueTree&, const juce::Identifier&) override;
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
@@ -1,6 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include "Common.h"
+#include "dsp_core/PluginCommon.h"
 
 // TODO: Quantidade de parametros
 const long unsigned int NUM_PARAMS = 2;
@@ -32,11 +32,12 @@ MyAudioProcessor::MyAudioProcessor()
     //asymmetrical waveshaping: float threshold = 1.0f; [threshold](float x) { return x < -threshold ? std::sin(x * (M_PI / (2.0f * threshold))) : std::min(x, threshold); };
 
     // Primeira funcao da lista como default
-    shapingFunc = shapingFunctions[0];
+    shaper.functionToUse = shapingFunctions[0];
 
     castParameter(apvts, ParamID::gain, gainParam);
     castParameter(apvts, ParamID::waveshapingFunc, waveshapingFuncParam);
     apvts.state.addListener(this);
+    trace.setup(getName(), getParameters());
     
     createPrograms();
     setCurrentProgram(0);
@@ -54,7 +55,17 @@ MyAudioProcessor::~MyAudioProcessor()
 
 // TODO: Funcao que roda logo ANTES de começar a processar
 void MyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock) {
-     juce::ignoreUnused(sampleRate, samplesPerBlock); 
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = (unsigned int)samplesPerBlock;
+    spec.numChannels = (unsigned int)getTotalNumOutputChannels();
+
+    // comeca no ganho atual, sem rampa
+    gainStage.prepare(spec);
+    gainStage.setGain(gain_);
+    gainStage.reset();
+
+    trace.prepare(sampleRate);
 }
 
 // TODO: Funcao que processa audio em loop - AUDIO THREAD!!!
@@ -63,9 +74,12 @@ void MyAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Mid
     //ignora mensagens MIDI
     juce::ignoreUnused(midiMessages);
 
-    // define uma flag especial para a CPU que trunca valores muito pequenos para zero
-    // em vez de processa-los como numeros denormais
-    juce::ScopedNoDenormals noDenormals;
+    // marca o bloco no trace (so com DSP_CORE_TRACE definido; ver dsp_core/Trace.h)
+    const dsp_core::Trace::ScopedBlock tracedBlock(trace, buffer.getNumSamples());
+
+    // ativa FTZ/DAZ na thread de audio (ver dsp_core/Denormals.h). O modo da CPU so e
+    // alterado na primeira vez, em vez de ser trocado e restaurado a cada bloco
+    dsp_core::disableDenormals();
 
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -74,19 +88,11 @@ void MyAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Mid
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    //loop pelos canais (plugin stereo)
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        //ponteiro para canal
-        auto* channelData = buffer.getWritePointer(channel);
-        
-        //loop pelas amostras de audio no buffer
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
-        {
-            // altera audio direto no buffer do canal via ponteiro
-            channelData[sample] = shape(gain_ * channelData[sample]);
-        }
-    }
+    // ganho seguido da funcao de waveshaping, aplicados no bloco inteiro (todos os canais)
+    juce::dsp::AudioBlock<float> block(buffer);
+    juce::dsp::ProcessContextReplacing<float> context(block);
+    gainStage.process(context);
+    shaper.process(context);
 
     //variavel parametersChanged muda pelo evento valueTreePropertyChanged que executa na thread de UI
     bool expected = true;
@@ -101,15 +107,14 @@ void MyAudioProcessor::releaseResources() {}
 // TODO: atualiza parametros - AUDIO THREAD!!!
 void MyAudioProcessor::update() {
     unsigned long i = static_cast<std::vector<int>::size_type>(waveshapingFuncParam->getIndex());
-    shapingFunc = shapingFunctions[i];
+    shaper.functionToUse = shapingFunctions[i];
 
-    smoother.setCurrentAndTargetValue(gainParam->get());
     gain_ = gainParam->get();
+    gainStage.setGain(gain_);
 
-    // exemplo de debug de parametro na console (precisa compilar em modo debug)  
-    // std::stringstream ss;
-    // ss << "gain: " << gain_;
-    // DBG(ss.str()); //print na console para debug rapido
+    // debug de parametros: DBG monta strings e aloca, entao nao pode rodar aqui. O trace
+    // grava so os parametros que mudaram, sem alocar (DSP_CORE_TRACE=<arquivo.json>)
+    trace.parameters(getParameters());
 }
 
 //==============================================================================
@@ -140,7 +145,19 @@ juce::AudioProcessorValueTreeState::ParameterLayout MyAudioProcessor::createPara
 }
 
 //==============================================================================
-// Gestao de presets (somente funcoes que variam por plugin. Ver Common.h)
+// Controle de GUI
+//------------------------------------------------------------------------------
+// Cria editor generico
+juce::AudioProcessorEditor* MyAudioProcessor::createEditor() 
+{ 
+    auto editor = new juce::GenericAudioProcessorEditor(*this);
+    editor->setSize(500, 500);
+    return editor;
+}
+//==============================================================================
+
+//==============================================================================
+// Gestao de presets (somente funcoes que variam por plugin. Ver dsp_core/PluginCommon.h)
 //------------------------------------------------------------------------------
 
 // TODO: Cria presets iniciais
@@ -174,13 +191,3 @@ void MyAudioProcessor::setCurrentProgram (int index)
     reset();
 }
 //==============================================================================
-
-//==============================================================================
-// Detalhes especificos deste plugin
-//------------------------------------------------------------------------------
-// Funcao de waveshaping
-float MyAudioProcessor::shape(float x)
-{
-    return shapingFunc(x);
-}
-//==============================================================================
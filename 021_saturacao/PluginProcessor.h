@@ -16,7 +16,11 @@
 #include <cmath>
 #include <functional>
 
-#include "Preset.h"
+#include "dsp_core/Preset.h"
+#include "dsp_core/Denormals.h"
+#include "dsp_core/Smoother.h"
+#include "dsp_core/Waveshaper.h"
+#include "dsp_core/Trace.h"
 
 // TODO: Namespace onde os parametros do plugin sao declarados
 // Para adicionar um parametro, adicionar uma nova linha PARAMETER_ID(<nome_parametro>)
@@ -95,6 +99,8 @@ private:
     int currentProgram;
     // Indica se algum parametro mudou
     std::atomic<bool> parametersChanged { false };    
+    // Registro de eventos da thread de audio (ver dsp_core/Trace.h)
+    dsp_core::Trace trace;
 
     void valueTreePropertyChanged(juce::ValueTree&, const juce::Identifier&) override;
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
@@ -108,19 +114,16 @@ private:
     //==============================================================================
     // TODO: Detalhes especificos deste plugin
     //------------------------------------------------------------------------------
-    // Suavizador de trocas de parametros
-    juce::LinearSmoothedValue<float> smoother;
+    // Ganho de entrada, com rampa nas trocas de parametro
+    dsp_core::SmoothedGain<float> gainStage;
     // Parametro para definir ganho
     juce::AudioParameterFloat* gainParam;
 
     // Parametro para escolher funcao de waveshaping
     juce::AudioParameterChoice* waveshapingFuncParam;
 
-    // Funcao wrapper para chamar a funcao de waveshaping
-    float shape(float x);
-
-    //Referencia para funcao de waveshaping
-    std::function<float(float)> shapingFunc;
+    //Waveshaper com a funcao de waveshaping escolhida (functionToUse)
+    dsp_core::Waveshaper<float> shaper;
 
     //Lista de funcoes de waveshaping
     std::vector<std::function<float(float)>> shapingFunctions;
@@ -1,6 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include "Common.h"
+#include "dsp_core/PluginCommon.h"
 
 // TODO: Quantidade de parametros
 const long unsigned int NUM_PARAMS = 4;
@@ -12,8 +12,7 @@ MyAudioProcessor::MyAudioProcessor()
     : AudioProcessor (BusesProperties()
         //TODO: Define se plugin mono ou stereo
         .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)),
-        delayBuffer_(2, 1)
+        .withOutput ("Output", juce::AudioChannelSet::stereo(), true))
 {
     //TODO: inicializacao dos parametros do plugin    
     castParameter(apvts, ParamID::delayLength, delayLengthParam);
@@ -39,23 +38,18 @@ MyAudioProcessor::~MyAudioProcessor()
 
 // TODO: funcao que roda logo ANTES de começar a processar
 void MyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock) {
-    juce::ignoreUnused(samplesPerBlock); 
-
-    // Ponteiros para o buffer circular
-    delayReadPosition_ = 0;
-    delayWritePosition_ = 0;
-
-    sampleRate_ = getSampleRate();
-
-    // Aloca e zera o buffer de delay
-    delayBufferLength_ = (int)(2.0 * sampleRate_); //delay maximo == 2s
-
-    // Checa resultado da alocacao para evitar buffer de tamanho zero
-    if(delayBufferLength_ < 1)
-        delayBufferLength_ = 1;
-
-    delayBuffer_.setSize(2, delayBufferLength_);
-    delayBuffer_.clear();
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = (unsigned int)samplesPerBlock;
+    spec.numChannels = 2;
+
+    // Aloca e zera o buffer de delay. Com feedback longo as mesmas amostras recirculam
+    // muitas vezes, entao quando o host processa em double a linha de delay tambem fica
+    // em double. So o delay da precisao em uso e alocado
+    if (isUsingDoublePrecision())
+        delayDouble_.prepare(spec, MAX_DELAY_LENGTH);
+    else
+        delay_.prepare(spec, MAX_DELAY_LENGTH);
 
     delayLengthSmoother.reset(sampleRate, 0.05);
 
@@ -68,62 +62,38 @@ void MyAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Mid
 {
     //ignora mensagens MIDI
     juce::ignoreUnused(midiMessages);
+    processSamples(buffer, delay_);
+}
 
-    juce::ScopedNoDenormals noDenormals;
+// Versao em double, chamada quando o host processa em precisao dupla. Evita a
+// conversao double -> float -> double que o wrapper do plugin faria
+void MyAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    //ignora mensagens MIDI
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer, delayDouble_);
+}
+
+bool MyAudioProcessor::supportsDoublePrecisionProcessing() const { return true; }
+
+template <typename SampleType>
+void MyAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer, dsp_core::FeedbackDelay<SampleType>& delay)
+{
+    // ativa FTZ/DAZ na thread de audio (ver dsp_core/Denormals.h). O modo da CPU so e
+    // alterado na primeira vez, em vez de ser trocado e restaurado a cada bloco
+    dsp_core::disableDenormals();
 
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
     
-    const int numSamples = buffer.getNumSamples();
-    
-    // dpr = delay read pointer; dpw = delay write pointer
-    int dpr = 0;
-    int dpw = 0;
-    
     // clears any output channels that didn't contain input data
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    // This is the place where you'd normally do the guts of your plugin's audio processing...
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        // get read/write pointer to buffer
-        auto* channelData = buffer.getWritePointer(channel);
-
-        // delayData is the circular buffer for implementing delay on this channel
-        float* delayData = delayBuffer_.getWritePointer(juce::jmin(channel, delayBuffer_.getNumChannels() - 1));
-
-        // Make a temporary copy of any state variables declared in PluginProcessor.h which need to be
-        // maintained between calls to processBlock(). Each channel needs to be processed identically
-        // which means that the activity of processing one channel can't affect the state variable for
-        // the next channel.
-        dpr = delayReadPosition_;
-        dpw = delayWritePosition_;
-
-        for (int i = 0; i < numSamples; ++i)
-        {
-            const float in = channelData[i];
-            float out = 0.0;
-
-            // input + delayed samples
-            out = (dryMix_ * in + wetMix_ * delayData[dpr]);
-
-            // Store the current information in the delay buffer. delayData[dpr] is the delay sample we just read,
-            // i.e. what came out of the buffer. delayData[dpw] is what we write to the buffer, i.e. what goes in
-            delayData[dpw] = in + (delayData[dpr] * feedback_);
-
-            if (++dpr >= delayBufferLength_)
-                dpr = 0;
-            if (++dpw >= delayBufferLength_)
-                dpw = 0;
-
-            // Store the output sample in the buffer, replacing the input
-            channelData[i] = out;
-        }
-    }
-    
-    delayReadPosition_ = dpr;
-    delayWritePosition_ = dpw;
+    // Delay com realimentacao nos canais de entrada (ver dsp_core/DelayLine.h). Cada canal
+    // e processado da mesma forma, a partir das mesmas posicoes de leitura e escrita
+    juce::dsp::AudioBlock<SampleType> block = juce::dsp::AudioBlock<SampleType>(buffer).getSubsetChannelBlock(0, (size_t)totalNumInputChannels);
+    delay.process(juce::dsp::ProcessContextReplacing<SampleType>(block));
 
     //variavel parametersChanged muda pelo evento valueTreePropertyChanged que executa na thread de UI
     bool expected = true;
@@ -144,17 +114,23 @@ void MyAudioProcessor::update() {
     wetMix_ = wetMixParam->get();
     feedback_ = feedbackParam->get();
     
-    // Use the sample rate to figure out what the delay position offset should be
+    // setDelay uses the sample rate to figure out what the delay position offset should be
     // (since it is specified in seconds, and we need to convert it to a number of samples)
-    // This was moved here since delayLength_ can be changed in the UI
     //
-    // dpr = read position from the delay buffer, e.g., delayed samples
-    // dpr initially points to the start of the last block of size (delayLength_ * sampleRate) in the delay buffer.
-    // e.g.: if (delayLength = 1, sampleRate = 44100, delayBufferLength_ = 88200) => dpr = 44100
-    // this means that after reading (delayLength_ * sampleRate) samples from the input,
-    // dpr will point to the begining of the delay buffer. From that point on it will read
-    // delayed samples and include them in the output
-    delayReadPosition_ = (int)(delayWritePosition_ - (delayLength_ * sampleRate_) + delayBufferLength_) % delayBufferLength_;
+    // The read position initially points to the start of the last block of size
+    // (delayLength_ * sampleRate) in the delay buffer. After reading (delayLength_ * sampleRate)
+    // samples from the input, it will point to the begining of the delay buffer. From that
+    // point on it will read delayed samples and include them in the output
+    auto setParameters = [this](auto& delay)
+    {
+        delay.setDelay(delayLength_);
+        delay.setDryLevel(dryMix_);
+        delay.setWetLevel(wetMix_);
+        delay.setFeedback(feedback_);
+    };
+
+    setParameters(delay_);
+    setParameters(delayDouble_);
 }
 
 //==============================================================================
@@ -185,7 +161,19 @@ juce::AudioProcessorValueTreeState::ParameterLayout MyAudioProcessor::createPara
 }
 
 //==============================================================================
-// Gestao de presets (somente funcoes que variam por plugin. Ver Common.h)
+// Controle de GUI
+//------------------------------------------------------------------------------
+// Cria editor generico
+juce::AudioProcessorEditor* MyAudioProcessor::createEditor() 
+{ 
+    auto editor = new juce::GenericAudioProcessorEditor(*this);
+    editor->setSize(500, 500);
+    return editor;
+}
+//==============================================================================
+
+//==============================================================================
+// Gestao de presets (somente funcoes que variam por plugin. Ver dsp_core/PluginCommon.h)
 //------------------------------------------------------------------------------
 
 // TODO: Cria presets iniciais
@@ -15,7 +15,9 @@
 #include <vector>
 #include <cmath>
 
-#include "Preset.h"
+#include "dsp_core/Preset.h"
+#include "dsp_core/Denormals.h"
+#include "dsp_core/DelayLine.h"
 
 // TODO: Namespace onde os parametros do plugin sao declarados
 // Para adicionar um parametro, adicionar uma nova linha PARAMETER_ID(<nome_parametro>)
@@ -45,6 +47,8 @@ public:
     //------------------------------------------------------------------------------
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
     void releaseResources() override;
     double getTailLengthSeconds() const override;
     //==============================================================================
@@ -85,6 +89,8 @@ public:
     float dryMix_;
     float wetMix_;
     float feedback_;
+
+    const double MAX_DELAY_LENGTH = 2.0; // delay maximo em segundos
 private:
     //==============================================================================
     // Gestao de parametros
@@ -110,12 +116,10 @@ private:
     //==============================================================================
     // TODO: Detalhes especificos deste plugin
     //------------------------------------------------------------------------------
-    // Circular buffer variables for implementing delay
-    juce::AudioBuffer<float> delayBuffer_;
-    int delayBufferLength_;
-    int delayReadPosition_, delayWritePosition_;
-
-    double sampleRate_;
+    // Delay com realimentacao em cada precisao. O host escolhe float ou double antes de
+    // prepareToPlay, entao so o da precisao em uso tem o buffer alocado
+    dsp_core::FeedbackDelay<float> delay_;
+    dsp_core::FeedbackDelay<double> delayDouble_;
 
     // Suavizador de trocas de parametros
     juce::LinearSmoothedValue<float> delayLengthSmoother;
@@ -124,6 +128,10 @@ private:
     juce::AudioParameterFloat* dryMixParam;
     juce::AudioParameterFloat* wetMixParam;
     juce::AudioParameterFloat* feedbackParam;
+
+    // Processamento comum as versoes float e double de processBlock
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, dsp_core::FeedbackDelay<SampleType>& delay);
     //==============================================================================
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MyAudioProcessor)
@@ -15,7 +15,9 @@
 #include <vector>
 #include <cmath>
 
-#include "Preset.h"
+#include "dsp_core/Preset.h"
+#include "dsp_core/Denormals.h"
+#include "dsp_core/DelayLine.h"
 
 // TODO: Namespace onde os parametros do plugin sao declarados
 // Para adicionar um parametro, adicionar uma nova linha PARAMETER_ID(<nome_parametro>)
@@ -29,12 +31,8 @@ namespace ParamID {
     #undef PARAMETER_ID
 }
 
-enum class Interpolation
-{
-    NearestNeighbour,
-    Linear,
-    Cubic
-};
+// Tipos de interpolacao da leitura do delay (ver dsp_core/Interpolation.h)
+using Interpolation = dsp_core::Interpolation;
 
 class MyAudioProcessor : public juce::AudioProcessor, private juce::ValueTree::Listener
 {
@@ -89,6 +87,8 @@ public:
     //------------------------------------------------------------------------------
     float frequency_;  // LFO Frequency
     float sweepWidth_; // width of LFO in samples
+
+    const float MAX_SWEEP_WIDTH = 0.05f;
 private:
     //==============================================================================
     // Gestao de parametros
@@ -114,18 +114,13 @@ private:
     //==============================================================================
     // TODO: Detalhes especificos deste plugin
     //------------------------------------------------------------------------------
-    inline float lfo(float phase);
-    
     Interpolation interpolation_;
     
-    // Circular buffer variables for implementing delay
-    juce::AudioBuffer<float> delayBuffer_;
-    int delayBufferLength_;
-    int delayWritePosition_;
-
-    float sampleRate_;
-    float inverseSampleRate_;
-    float lfoPhase_;
+    // Delay modulado pelo LFO (buffer circular, LFO e interpolacao)
+    dsp_core::ModulatedDelay<float> modulatedDelay;
+
+    // Repassa os parametros atuais para o delay modulado
+    void updateModulatedDelay();
 
     juce::AudioParameterFloat* frequencyParam;  // LFO Frequency
     juce::AudioParameterFloat* sweepWidthParam; // width of LFO in samples
@@ -1,6 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include "Common.h"
+#include "dsp_core/PluginCommon.h"
 
 // TODO: Quantidade de parametros
 const long unsigned int NUM_PARAMS = 5;
@@ -12,8 +12,7 @@ MyAudioProcessor::MyAudioProcessor()
     : AudioProcessor (BusesProperties()
         //TODO: Define se plugin mono ou stereo
         .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)),
-        delayBuffer_(2, 1)
+        .withOutput ("Output", juce::AudioChannelSet::stereo(), true))
 {
     //TODO: inicializacao dos parametros do plugin
     // Set default values:
@@ -23,13 +22,11 @@ MyAudioProcessor::MyAudioProcessor()
     frequency_ = 0.2f;
     
     interpolation_ = Interpolation::Linear;
-        
-    delayBufferLength_ = 1;
-    lfoPhase_ = 0.0f;
-    inverseSampleRate_ = 1.0f/DEFAULT_SAMPLE_RATE;
-        
-    // Start the circular buffer pointer at the beginning
-    delayWritePosition_ = 0;
+
+    // Flanger: sinal original mais uma voz atrasada, com realimentacao
+    modulatedDelay.setDryLevel(1.0f);
+    modulatedDelay.setNumVoices(1);
+    updateModulatedDelay();
 
     castParameter(apvts, ParamID::sweepWidth, sweepWidthParam);
     castParameter(apvts, ParamID::depth, depthParam);
@@ -55,19 +52,16 @@ MyAudioProcessor::~MyAudioProcessor()
 
 // TODO: funcao que roda logo ANTES de começar a processar
 void MyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock) {
-    juce::ignoreUnused(samplesPerBlock); 
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = (unsigned int)samplesPerBlock;
+    spec.numChannels = 2;
 
-    sampleRate_ = (float)sampleRate;
+    // Aloca e zera o buffer de delay e reinicia a fase do LFO
+    modulatedDelay.prepare(spec, MAX_SWEEP_WIDTH);
 
-    delayBufferLength_ = (int)(MAX_SWEEP_WIDTH * sampleRate) + 3;
-    delayBuffer_.setSize(2, delayBufferLength_);
-    delayBuffer_.clear();
+    frequencySmoother.reset(sampleRate, 0.05);
 
-    frequencySmoother.reset(sampleRate_, 0.05f);
-    
-    lfoPhase_ = 0.0f;
-    inverseSampleRate_ = 1.0f/sampleRate_;
-    
     parametersChanged.store(true);
     reset();
 }
@@ -75,117 +69,24 @@ void MyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock) {
 // TODO: funcao que processa audio em loop - AUDIO THREAD!!!
 void MyAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-   //ignora mensagens MIDI
+    //ignora mensagens MIDI
     juce::ignoreUnused(midiMessages);
- 
-    juce::ScopedNoDenormals noDenormals;
+
+    // ativa FTZ/DAZ na thread de audio (ver dsp_core/Denormals.h). O modo da CPU so e
+    // alterado na primeira vez, em vez de ser trocado e restaurado a cada bloco
+    dsp_core::disableDenormals();
+
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
-    
-    const int numSamples = buffer.getNumSamples();
-    int dpw = 0;
-    float dpr = 0.0f;
-    float currentDelay = 0.0f;
-    float ph = 0.0f;
-    
+
     // clears any output channels that didn't contain input data
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    // This is the place where you'd normally do the guts of your plugin's audio processing...
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        // get read/write pointer to buffer
-        auto* channelData = buffer.getWritePointer(channel);
-
-        // delayData is the circular buffer for implementing delay on this channel
-        float* delayData = delayBuffer_.getWritePointer(juce::jmin(channel, delayBuffer_.getNumChannels() - 1));
-
-        // Make a temporary copy of any state variables declared in PluginProcessor.h which need to be
-        // maintained between calls to processBlock(). Each channel needs to be processed identically
-        // which means that the activity of processing one channel can't affect the state variable for
-        // the next channel.
-        dpw = delayWritePosition_;
-        ph = lfoPhase_;
-
-        for (int i = 0; i < numSamples; ++i)
-        {
-            const float in = channelData[i];
-            float interpolatedSample = 0.0;
-            
-            currentDelay = sweepWidth_ * lfo(ph);
-            
-            // Subtract 3 samples to the delay pointer to make sure we have enough previously written
-            // samples to interpolate with
-            dpr = fmodf((float)dpw - (float)(currentDelay * getSampleRate()) + (float)delayBufferLength_ -3.0f, (float)delayBufferLength_);
-            
-            if (interpolation_ == Interpolation::Linear)
-            {
-                // Find the fraction by which the read pointer sits between two
-                // samples and use this to adjust weights of the samples
-                float fraction = dpr - floorf(dpr);
-                int previousSample = (int)floorf(dpr);
-                int nextSample = (previousSample + 1) % delayBufferLength_;
-                interpolatedSample = fraction * delayData[nextSample] + (1.0f - fraction) * delayData[previousSample];
-            }
-            else if (interpolation_ == Interpolation::Cubic)
-            {
-                // Cubic interpolation will produce cleaner results at the expense
-                // of more computation. This code uses the Catmull-Rom variant of
-                // cubic interpolation. To reduce the load, calculate a few quantities
-                // in advance that will be used several times in the equation:
-                int sample1 = (int)floorf(dpr);
-                int sample2 = (sample1 + 1) % delayBufferLength_;
-                int sample3 = (sample2 + 1) % delayBufferLength_;
-                int sample0 = (sample1 - 1 + delayBufferLength_) % delayBufferLength_;
-                
-                float fraction = dpr - floorf(dpr);
-                float frsq = fraction * fraction;
-                
-                float a0 = -0.5f*delayData[sample0] + 1.5f*delayData[sample1] - 1.5f*delayData[sample2] + 0.5f*delayData[sample3];
-                float a1 = delayData[sample0] - 2.5f*delayData[sample1] + 2.0f*delayData[sample2] - 0.5f*delayData[sample3];
-                float a2 = -0.5f*delayData[sample0] + 0.5f*delayData[sample2];
-                float a3 = delayData[sample1];
-                
-                interpolatedSample = a0 * fraction * frsq + a1 * frsq + a2 * fraction + a3;
-            }
-            else // Nearest neighbour interpolation
-            {
-                // Find the nearest input sample by rounding the fractional index to the
-                // nearest integer. It's possible this will round it to the end of the buffer,
-                // in which case we need to roll it back to the beginning.
-                int closestSample = (int)floorf(dpr + 0.5f);
-                if(closestSample == delayBufferLength_)
-                    closestSample = 0;
-                interpolatedSample = delayData[closestSample];
-            }
-            
-            // Store the current information in the delay buffer. With feedback, what we read is
-            // included in what gets stored in the buffer, otherwise it's just a simple delay line
-            // of the input signal.
-            delayData[dpw] = in + (interpolatedSample * feedback_);
-
-            // Increment the write pointer at a constant rate. The read pointer will move at different
-            // rates depending on the settings of the LFO, the delay and the sweep width.
-            
-            if (++dpw >= delayBufferLength_)
-                dpw = 0;
-
-            // Store the output sample in the buffer, replacing the input. In the vibrato effect,
-            // the delaye sample is the only component of the output (no mixing with the dry signal)
-            channelData[i] = in + depth_ * interpolatedSample;
-
-            // Update the LFO phase, keeping it in the range 0-1
-            ph += frequency_ * inverseSampleRate_;
-            if(ph >= 1.0f)
-                ph -= 1.0f;
-        }
-    }
-    
-    // Having made a local copy of the state variables for each channel, now transfer the result
-    // back to the main state variable so they will be preserved for the next call of processBlock()
-    delayWritePosition_ = dpw;
-    lfoPhase_ = ph;
+    // Delay modulado pelo LFO nos canais de entrada (ver dsp_core/DelayLine.h). Cada canal
+    // e processado da mesma forma, a partir da mesma posicao de escrita e fase do LFO
+    juce::dsp::AudioBlock<float> block = juce::dsp::AudioBlock<float>(buffer).getSubsetChannelBlock(0, (size_t)totalNumInputChannels);
+    modulatedDelay.process(juce::dsp::ProcessContextReplacing<float>(block));
 
     //variable parametersChanged is updated by valueTreePropertyChanged running on any UI thread
     bool expected = true;
@@ -194,14 +95,6 @@ void MyAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::Midi
     }
 }
 
-//==============================================================================
-// Function for calculating LFO waveforms. Phase runs from 0-1, output is scaled
-// from 0 to 1 (note: not -1 to 1 as would be typical of sine).
-float MyAudioProcessor::lfo(float phase)
-{
-    return 0.5f + 0.5f * sinf(2.0f * (float)M_PI * phase);
-}
-
 // chamada logo DEPOIS de processar
 void MyAudioProcessor::releaseResources() {}
 
@@ -214,6 +107,18 @@ void MyAudioProcessor::update() {
     interpolation_ = static_cast<Interpolation>(interpolationTypeParam->getIndex());
     depth_ = depthParam->get();
     feedback_ = feedbackParam->get();
+
+    updateModulatedDelay();
+}
+
+// Repassa os parametros atuais para o delay modulado
+void MyAudioProcessor::updateModulatedDelay()
+{
+    modulatedDelay.setSweepWidth(sweepWidth_);
+    modulatedDelay.setDepth(depth_);
+    modulatedDelay.setFeedback(feedback_);
+    modulatedDelay.setFrequency(frequency_);
+    modulatedDelay.setInterpolation(interpolation_);
 }
 
 //==============================================================================
@@ -253,7 +158,19 @@ juce::AudioProcessorValueTreeState::ParameterLayout MyAudioProcessor::createPara
 }
 
 //==============================================================================
-// Gestao de presets (somente funcoes que variam por plugin. Ver Common.h)
+// Controle de GUI
+//------------------------------------------------------------------------------
+// Cria editor generico
+juce::AudioProcessorEditor* MyAudioProcessor::createEditor() 
+{ 
+    auto editor = new juce::GenericAudioProcessorEditor(*this);
+    editor->setSize(500, 500);
+    return editor;
+}
+//==============================================================================
+
+//==============================================================================
+// Gestao de presets (somente funcoes que variam por plugin. Ver dsp_core/PluginCommon.h)
 //------------------------------------------------------------------------------
 
 // TODO: Cria presets iniciais
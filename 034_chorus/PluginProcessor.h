@@ -15,7 +15,9 @@
 #include <vector>
 #include <cmath>
 
-#include "Preset.h"
+#include "dsp_core/Preset.h"
+#include "dsp_core/Denormals.h"
+#include "dsp_core/DelayLine.h"
 
 // TODO: Namespace onde os parametros do plugin sao declarados
 // Para adicionar um parametro, adicionar uma nova linha PARAMETER_ID(<nome_parametro>)
@@ -32,12 +34,8 @@ namespace ParamID {
     #undef PARAMETER_ID
 }
 
-enum class Interpolation
-{
-    NearestNeighbour,
-    Linear,
-    Cubic
-};
+// Tipos de interpolacao da leitura do delay (ver dsp_core/Interpolation.h)
+using Interpolation = dsp_core::Interpolation;
 
 class MyAudioProcessor : public juce::AudioProcessor, private juce::ValueTree::Listener
 {
@@ -99,7 +97,6 @@ public:
     
     const float MAX_DELAY = 0.05f;
     const float MAX_SWEEP_WIDTH = 0.05f;
-    const float DEFAULT_SAMPLE_RATE = 44100.0f;
     const int VOICES[4] = {2, 3, 4, 5};
 private:
     //==============================================================================
@@ -126,17 +123,11 @@ private:
     //==============================================================================
     // TODO: Detalhes especificos deste plugin
     //------------------------------------------------------------------------------
-    // Circular buffer variables for implementing delay
-    inline float lfo(float phase);
-    
-    // Circular buffer variables for implementing delay
-    juce::AudioBuffer<float> delayBuffer_;
-    int delayBufferLength_;
-    int delayWritePosition_;
-
-    float sampleRate_;
-    float inverseSampleRate_;
-    float lfoPhase_;
+    // Delay modulado pelo LFO (buffer circular, LFO e interpolacao)
+    dsp_core::ModulatedDelay<float> modulatedDelay;
+
+    // Repassa os parametros atuais para o delay modulado
+    void updateModulatedDelay();
 
     juce::AudioParameterFloat* delayParam;
     juce::AudioParameterFloat* sweepWidthParam;
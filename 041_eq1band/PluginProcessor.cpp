@@ -1,6 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include "Common.h"
+#include "dsp_core/PluginCommon.h"
 
 // TODO: Quantidade de parametros
 const long unsigned int NUM_PARAMS = 3;
@@ -44,28 +44,67 @@ void MyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock) {
     juce::dsp::ProcessSpec spec;
     spec.sampleRate = sampleRate;
     spec.maximumBlockSize = (unsigned int)samplesPerBlock;
-    spec.numChannels = 1; //(unsigned int)getTotalNumOutputChannels();
+    spec.numChannels = (unsigned int)getTotalNumOutputChannels();
 
-    filterChainL.prepare(spec);
-    filterChainR.prepare(spec);
+    if (isUsingDoublePrecision())
+        doubleFilter.prepare(spec);
+    else
+        floatFilter.prepare(spec);
+}
+
+// Retorna o filtro da precisao pedida
+template <typename SampleType>
+MyAudioProcessor::Filter<SampleType>& MyAudioProcessor::getFilter()
+{
+    if constexpr (std::is_same_v<SampleType, double>)
+        return doubleFilter;
+    else
+        return floatFilter;
 }
 
 void MyAudioProcessor::setCoeffs()
 {
-    // Configurando os coeficientes do filtro
-    midPeakCoeff = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), freq_, Q_, juce::Decibels::decibelsToGain(gain_));
-    *filterChainL.get<0>().coefficients = *midPeakCoeff;
-    *filterChainR.get<0>().coefficients = *midPeakCoeff;
+    if (isUsingDoublePrecision())
+        setCoeffs(doubleFilter);
+    else
+        setCoeffs(floatFilter);
+}
+
+template <typename SampleType>
+void MyAudioProcessor::setCoeffs(Filter<SampleType>& filter)
+{
+    // Configurando os coeficientes do filtro (sem alocacao, ver dsp_core/Biquad.h)
+    using Coefficients = typename Filter<SampleType>::Coefficients;
+
+    filter.setCoefficients(0, Coefficients::makePeakFilter(getSampleRate(),
+                                                           (SampleType)freq_,
+                                                           (SampleType)Q_,
+                                                           juce::Decibels::decibelsToGain((SampleType)gain_)));
 }
 
 // TODO: funcao que processa audio em loop - AUDIO THREAD!!!
 void MyAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused(midiMessages);
+    processSamples(buffer);
+}
 
-    // define uma flag especial para a CPU que trunca valores muito pequenos para zero
-    // em vez de processa-los como numeros denormais
-    juce::ScopedNoDenormals noDenormals;
+// Versao em double, chamada quando o host processa em precisao dupla. Evita a
+// conversao double -> float -> double que o wrapper do plugin faria
+void MyAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer);
+}
+
+bool MyAudioProcessor::supportsDoublePrecisionProcessing() const { return true; }
+
+template <typename SampleType>
+void MyAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer)
+{
+    // ativa FTZ/DAZ na thread de audio (ver dsp_core/Denormals.h). O modo da CPU so e
+    // alterado na primeira vez, em vez de ser trocado e restaurado a cada bloco
+    dsp_core::disableDenormals();
 
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -73,13 +112,9 @@ void MyAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::Midi
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
-    juce::dsp::AudioBlock<float> block(buffer);
-
-    auto blockL = block.getSingleChannelBlock(0);
-    filterChainL.process(juce::dsp::ProcessContextReplacing<float>(blockL));
-
-    auto blockR = block.getSingleChannelBlock(1);
-    filterChainR.process(juce::dsp::ProcessContextReplacing<float>(blockR));
+    // filtra todos os canais de uma vez
+    juce::dsp::AudioBlock<SampleType> block(buffer);
+    getFilter<SampleType>().process(juce::dsp::ProcessContextReplacing<SampleType>(block));
 
     //valueTreePropertyChanged altera variavel parametersChanged quando algum parametro muda
     bool expected = true;
@@ -137,7 +172,19 @@ juce::AudioProcessorValueTreeState::ParameterLayout MyAudioProcessor::createPara
 }
 
 //==============================================================================
-// Gestao de presets (somente funcoes que variam por plugin. Ver Common.h)
+// Controle de GUI
+//------------------------------------------------------------------------------
+// Cria editor generico
+juce::AudioProcessorEditor* MyAudioProcessor::createEditor() 
+{ 
+    auto editor = new juce::GenericAudioProcessorEditor(*this);
+    editor->setSize(500, 500);
+    return editor;
+}
+//==============================================================================
+
+//==============================================================================
+// Gestao de presets (somente funcoes que variam por plugin. Ver dsp_core/PluginCommon.h)
 //------------------------------------------------------------------------------
 
 // TODO: Cria presets iniciais
@@ -15,9 +15,12 @@
 #include <atomic>
 #include <vector>
 #include <cmath>
+#include <type_traits>
 #include <functional>
 
-#include "Preset.h"
+#include "dsp_core/Preset.h"
+#include "dsp_core/Denormals.h"
+#include "dsp_core/Biquad.h"
 
 // TODO: Namespace onde os parametros do plugin sao declarados
 // Para adicionar um parametro, adicionar uma nova linha PARAMETER_ID(<nome_parametro>)
@@ -46,6 +49,8 @@ public:
     //------------------------------------------------------------------------------
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
     void releaseResources() override;
     double getTailLengthSeconds() const override;
     //==============================================================================
@@ -114,11 +119,24 @@ private:
     // TODO: Detalhes especificos deste plugin
     //------------------------------------------------------------------------------
     void setCoeffs();
-    
-    juce::dsp::ProcessorChain<juce::dsp::IIR::Filter<float>> filterChainL;
-    juce::dsp::ProcessorChain<juce::dsp::IIR::Filter<float>> filterChainR;
 
-    juce::dsp::IIR::Coefficients<float>::Ptr midPeakCoeff;
+    // Processamento comum as versoes float e double de processBlock
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer);
+
+    // Filtro em cada precisao (ver dsp_core/Biquad.h). O host escolhe float ou double
+    // antes de prepareToPlay, entao so o da precisao em uso e preparado e atualizado
+    template <typename SampleType>
+    using Filter = dsp_core::BiquadCascade<SampleType, 1>;
+
+    Filter<float> floatFilter;
+    Filter<double> doubleFilter;
+
+    template <typename SampleType>
+    Filter<SampleType>& getFilter();
+
+    template <typename SampleType>
+    void setCoeffs(Filter<SampleType>& filter);
 
     // Parametro para definir frequencia
     juce::AudioParameterFloat* freqParam;
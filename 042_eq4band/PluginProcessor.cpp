@@ -1,6 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include "Common.h"
+#include "dsp_core/PluginCommon.h"
 
 // TODO: Quantidade de parametros
 const long unsigned int NUM_PARAMS = 12;
@@ -67,10 +67,12 @@ void MyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock) {
     juce::dsp::ProcessSpec spec;
     spec.sampleRate = sampleRate;
     spec.maximumBlockSize = (unsigned int)samplesPerBlock;
-    spec.numChannels = 1; //(unsigned int)getTotalNumOutputChannels();
+    spec.numChannels = (unsigned int)getTotalNumOutputChannels();
 
-    filterChainL.prepare(spec);
-    filterChainR.prepare(spec);
+    if (isUsingDoublePrecision())
+        doubleFilter.prepare(spec);
+    else
+        floatFilter.prepare(spec);
 
     setCoeffs();
 }
@@ -79,10 +81,36 @@ void MyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock) {
 void MyAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused(midiMessages);
+    processSamples(buffer);
+}
+
+// Versao em double, chamada quando o host processa em precisao dupla. Shelves em
+// frequencias baixas com taxas de amostragem altas ficam mais precisos em double,
+// e evita a conversao double -> float -> double que o wrapper do plugin faria
+void MyAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer);
+}
 
-    // define uma flag especial para a CPU que trunca valores muito pequenos para zero
-    // em vez de processa-los como numeros denormais
-    juce::ScopedNoDenormals noDenormals;
+bool MyAudioProcessor::supportsDoublePrecisionProcessing() const { return true; }
+
+// Retorna os filtros da precisao pedida
+template <typename SampleType>
+MyAudioProcessor::Filter<SampleType>& MyAudioProcessor::getFilter()
+{
+    if constexpr (std::is_same_v<SampleType, double>)
+        return doubleFilter;
+    else
+        return floatFilter;
+}
+
+template <typename SampleType>
+void MyAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer)
+{
+    // ativa FTZ/DAZ na thread de audio (ver dsp_core/Denormals.h). O modo da CPU so e
+    // alterado na primeira vez, em vez de ser trocado e restaurado a cada bloco
+    dsp_core::disableDenormals();
 
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -90,13 +118,9 @@ void MyAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::Midi
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
-    juce::dsp::AudioBlock<float> block(buffer);
-
-    auto blockL = block.getSingleChannelBlock(0);
-    filterChainL.process(juce::dsp::ProcessContextReplacing<float>(blockL));
-    
-    auto blockR = block.getSingleChannelBlock(1);
-    filterChainR.process(juce::dsp::ProcessContextReplacing<float>(blockR));
+    // filtra todos os canais de uma vez, com as amostras passando pelos quatro filtros
+    juce::dsp::AudioBlock<SampleType> block(buffer);
+    getFilter<SampleType>().process(juce::dsp::ProcessContextReplacing<SampleType>(block));
 
     //valueTreePropertyChanged altera variavel parametersChanged quando algum parametro muda
     bool expected = true;
@@ -152,20 +176,22 @@ void MyAudioProcessor::update() {
 // Configura os coeficientes do filtro
 void MyAudioProcessor::setCoeffs() //AUDIO THREAD!!!
 {
-    lowShelfCoeff = juce::dsp::IIR::Coefficients<float>::makeLowShelf(getSampleRate(), freq_low_, Q_low_, gain_low_);
-    midPeak1Coeff = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), freq_mid_1_, Q_mid_1_, gain_mid_1_);
-    midPeak2Coeff = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), freq_mid_2_, Q_mid_2_, gain_mid_2_);
-    highShelfCoeff = juce::dsp::IIR::Coefficients<float>::makeHighShelf(getSampleRate(), freq_high_, Q_high_, gain_high_);
-
-    *filterChainL.get<0>().coefficients = *lowShelfCoeff;
-    *filterChainL.get<1>().coefficients = *midPeak1Coeff;
-    *filterChainL.get<2>().coefficients = *midPeak2Coeff;
-    *filterChainL.get<3>().coefficients = *highShelfCoeff;
-
-    *filterChainR.get<0>().coefficients = *lowShelfCoeff;
-    *filterChainR.get<1>().coefficients = *midPeak1Coeff;
-    *filterChainR.get<2>().coefficients = *midPeak2Coeff;
-    *filterChainR.get<3>().coefficients = *highShelfCoeff;
+    if (isUsingDoublePrecision())
+        setCoeffs(doubleFilter);
+    else
+        setCoeffs(floatFilter);
+}
+
+template <typename SampleType>
+void MyAudioProcessor::setCoeffs(Filter<SampleType>& filter)
+{
+    // coeficientes calculados sem alocacao (ver dsp_core/Biquad.h)
+    using Coefficients = typename Filter<SampleType>::Coefficients;
+
+    filter.setCoefficients(0, Coefficients::makeLowShelf(getSampleRate(), (SampleType)freq_low_, (SampleType)Q_low_, (SampleType)gain_low_));
+    filter.setCoefficients(1, Coefficients::makePeakFilter(getSampleRate(), (SampleType)freq_mid_1_, (SampleType)Q_mid_1_, (SampleType)gain_mid_1_));
+    filter.setCoefficients(2, Coefficients::makePeakFilter(getSampleRate(), (SampleType)freq_mid_2_, (SampleType)Q_mid_2_, (SampleType)gain_mid_2_));
+    filter.setCoefficients(3, Coefficients::makeHighShelf(getSampleRate(), (SampleType)freq_high_, (SampleType)Q_high_, (SampleType)gain_high_));
 }
 
 //==============================================================================
@@ -268,7 +294,19 @@ juce::AudioProcessorValueTreeState::ParameterLayout MyAudioProcessor::createPara
 }
 
 //==============================================================================
-// Gestao de presets (somente funcoes que variam por plugin. Ver Common.h)
+// Controle de GUI
+//------------------------------------------------------------------------------
+// Cria editor generico
+juce::AudioProcessorEditor* MyAudioProcessor::createEditor() 
+{ 
+    auto editor = new juce::GenericAudioProcessorEditor(*this);
+    editor->setSize(500, 500);
+    return editor;
+}
+//==============================================================================
+
+//==============================================================================
+// Gestao de presets (somente funcoes que variam por plugin. Ver dsp_core/PluginCommon.h)
 //------------------------------------------------------------------------------
 
 // TODO: Cria presets iniciais
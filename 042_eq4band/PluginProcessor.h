@@ -15,9 +15,12 @@
 #include <atomic>
 #include <vector>
 #include <cmath>
+#include <type_traits>
 #include <functional>
 
-#include "Preset.h"
+#include "dsp_core/Preset.h"
+#include "dsp_core/Denormals.h"
+#include "dsp_core/Biquad.h"
 
 // TODO: Namespace onde os parametros do plugin sao declarados
 // Para adicionar um parametro, adicionar uma nova linha PARAMETER_ID(<nome_parametro>)
@@ -55,6 +58,8 @@ public:
     //------------------------------------------------------------------------------
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
     void releaseResources() override;
     double getTailLengthSeconds() const override;
     //==============================================================================
@@ -133,22 +138,21 @@ private:
     //==============================================================================
     // TODO: Detalhes especificos deste plugin
     //------------------------------------------------------------------------------
-    juce::dsp::ProcessorChain<
-        juce::dsp::IIR::Filter<float>,
-        juce::dsp::IIR::Filter<float>,
-        juce::dsp::IIR::Filter<float>,
-        juce::dsp::IIR::Filter<float>> filterChainL;
-
-    juce::dsp::ProcessorChain<
-        juce::dsp::IIR::Filter<float>,
-        juce::dsp::IIR::Filter<float>,
-        juce::dsp::IIR::Filter<float>,
-        juce::dsp::IIR::Filter<float>> filterChainR;
-
-    juce::dsp::IIR::Coefficients<float>::Ptr lowShelfCoeff;
-    juce::dsp::IIR::Coefficients<float>::Ptr midPeak1Coeff;
-    juce::dsp::IIR::Coefficients<float>::Ptr midPeak2Coeff;
-    juce::dsp::IIR::Coefficients<float>::Ptr highShelfCoeff;
+    // Os quatro filtros em serie, em cada precisao (ver dsp_core/Biquad.h). O host escolhe
+    // float ou double antes de prepareToPlay, entao so o da precisao em uso e preparado
+    // e atualizado
+    template <typename SampleType>
+    using Filter = dsp_core::BiquadCascade<SampleType, 4>;
+
+    Filter<float> floatFilter;
+    Filter<double> doubleFilter;
+
+    template <typename SampleType>
+    Filter<SampleType>& getFilter();
+
+    // Processamento comum as versoes float e double de processBlock
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer);
 
     // Parametro para definir frequencia
     juce::AudioParameterFloat* freqLowParam;
@@ -172,6 +176,9 @@ private:
 
     // Define coeficientes para todos os filtros
     void setCoeffs();
+
+    template <typename SampleType>
+    void setCoeffs(Filter<SampleType>& filter);
     //==============================================================================
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MyAudioProcessor)
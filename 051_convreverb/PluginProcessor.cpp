@@ -1,9 +1,9 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include "Common.h"
+#include "dsp_core/PluginCommon.h"
 
 // TODO: Quantidade de parametros
-const long unsigned int NUM_PARAMS = 1;
+const long unsigned int NUM_PARAMS = 11;
 
 //==============================================================================
 // Construtor e destrutor
@@ -18,8 +18,19 @@ MyAudioProcessor::MyAudioProcessor()
     wet_dry_mix_ = 0.5f; //50%
 
     castParameter(apvts, ParamID::wet_dry, wetDryMixParam);
+    castParameter(apvts, ParamID::latency, latencyParam);
+    castParameter(apvts, ParamID::stereo_mode, stereoModeParam);
+    castParameter(apvts, ParamID::engine, engineParam);
+    castParameter(apvts, ParamID::fdn_lines, fdnLinesParam);
+    castParameter(apvts, ParamID::fdn_size, fdnSizeParam);
+    castParameter(apvts, ParamID::fdn_decay, fdnDecayParam);
+    castParameter(apvts, ParamID::fdn_damping, fdnDampingParam);
+    castParameter(apvts, ParamID::fdn_modulation, fdnModulationParam);
+    castParameter(apvts, ParamID::hybrid_split, hybridSplitParam);
+    castParameter(apvts, ParamID::fft_backend, fftBackendParam);
     
     apvts.state.addListener(this);
+    trace.setup(getName(), getParameters());
     
     createPrograms();
     setCurrentProgram(0);
@@ -27,6 +38,7 @@ MyAudioProcessor::MyAudioProcessor()
 
 MyAudioProcessor::~MyAudioProcessor() 
 {
+    cancelPendingUpdate();
     apvts.state.removeListener(this);
 }
 
@@ -42,13 +54,51 @@ void MyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
     spec.sampleRate = sampleRate;
     spec.maximumBlockSize = (unsigned int)samplesPerBlock;
     spec.numChannels = (unsigned int)getTotalNumInputChannels();
+    trace.prepare(sampleRate);
+
+    // o motor e recriado aqui se o orcamento ou o modo mudaram sem passar por handleAsyncUpdate
+    latencyBudget.store(dsp_core::Convolution::getLatencyBudgetForChoice(latencyParam->getIndex()));
+    stereoMode.store(stereoModeParam->getIndex());
+    fftBackend.store(fftBackendParam->getIndex());
+    convolution.setLatencyBudget(latencyBudget.load());
+    convolution.setMode(dsp_core::Convolution::getModeForChoice(stereoMode.load()));
+    convolution.setFftBackend(dsp_core::Fft::getBackendForChoice(fftBackend.load()));
 
     convolution.reset();
     convolution.prepare(spec);
+
+    hybridSplit.store(hybridSplitParam->get());
+    hybrid.setLatencyBudget(latencyBudget.load());
+    hybrid.setMode(dsp_core::Convolution::getModeForChoice(stereoMode.load()));
+    hybrid.setFftBackend(dsp_core::Fft::getBackendForChoice(fftBackend.load()));
+    hybrid.setSplitTime(0.001 * hybridSplit.load());
+    hybrid.reset();
+    hybrid.prepare(spec);
+
+    fdn8.prepare(spec);
+    fdn16.prepare(spec);
+    updateFdn();
+    requestedEngine.store(engineParam->getIndex());
+    loadActiveEngine();
+    reverbEngine.store(requestedEngine.load());
+    setLatencySamples(getWetLatency());
     
     mixer.prepare(spec);
     mixer.setMixingRule(juce::dsp::DryWetMixingRule::balanced);
     mixer.setWetMixProportion(wet_dry_mix_);
+    mixerLatency = getWetLatency();
+    mixer.setWetLatency((float)mixerLatency);
+}
+
+// Latencia do motor atual: a FDN nao tem latencia
+int MyAudioProcessor::getWetLatency() const noexcept
+{
+    switch (reverbEngine.load())
+    {
+        case 1:  return 0;
+        case 2:  return hybrid.getLatency();
+        default: return convolution.getLatency();
+    }
 }
 
 // TODO: funcao que processa audio em loop - AUDIO THREAD!!!
@@ -56,15 +106,34 @@ void MyAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::Midi
 {
     juce::ignoreUnused(midiMessages);
 
-    // define uma flag especial para a CPU que trunca valores muito pequenos para zero
-    // em vez de processa-los como numeros denormais
-    juce::ScopedNoDenormals noDenormals;
+    // marca o bloco no trace (so com DSP_CORE_TRACE definido; ver dsp_core/Trace.h)
+    const dsp_core::Trace::ScopedBlock tracedBlock(trace, buffer.getNumSamples());
+
+    // ativa FTZ/DAZ na thread de audio (ver dsp_core/Denormals.h). O modo da CPU so e
+    // alterado na primeira vez, em vez de ser trocado e restaurado a cada bloco
+    dsp_core::disableDenormals();
 
     juce::dsp::AudioBlock<float> block(buffer);
     juce::dsp::ProcessContextReplacing<float> context(block);
 
+    // alinha o sinal seco com o motor atual depois de uma troca de orcamento ou de motor
+    if (getWetLatency() != mixerLatency)
+    {
+        mixerLatency = getWetLatency();
+        mixer.setWetLatency((float)mixerLatency);
+    }
+
     mixer.pushDrySamples(block);
-    convolution.process(context);
+
+    if (reverbEngine.load() == 0)
+        convolution.process(context);
+    else if (reverbEngine.load() == 2)
+        hybrid.process(context);
+    else if (fdnLinesParam->getIndex() == 0)
+        fdn8.process(context);
+    else
+        fdn16.process(context);
+
     mixer.mixWetSamples(block);
 
     //valueTreePropertyChanged altera variavel parametersChanged quando algum parametro muda
@@ -84,12 +153,106 @@ void MyAudioProcessor::update()
     wet_dry_mix_ = wetDryMixParam->get();
 
     mixer.setWetMixProportion(wet_dry_mix_);
+
+    updateFdn();
+
+    // troca de orcamento de latencia: o motor e recriado na thread de mensagens
+    const int newBudget = dsp_core::Convolution::getLatencyBudgetForChoice(latencyParam->getIndex());
+
+    if (newBudget != latencyBudget.load())
+    {
+        latencyBudget.store(newBudget);
+        triggerAsyncUpdate();
+    }
+
+    // troca de modo estereo: tambem recria o motor
+    if (stereoModeParam->getIndex() != stereoMode.load())
+    {
+        stereoMode.store(stereoModeParam->getIndex());
+        triggerAsyncUpdate();
+    }
+
+    // troca de FFT: tambem recria os motores de convolucao
+    if (fftBackendParam->getIndex() != fftBackend.load())
+    {
+        fftBackend.store(fftBackendParam->getIndex());
+        triggerAsyncUpdate();
+    }
+
+    // corte do modo hibrido: recarrega o inicio da IR e refaz o ajuste da cauda
+    if (hybridSplitParam->get() != hybridSplit.load())
+    {
+        hybridSplit.store(hybridSplitParam->get());
+        triggerAsyncUpdate();
+    }
+
+    // troca de motor: a IR e carregada no motor novo (se estiver desatualizado) na thread
+    // de mensagens, que tambem informa a nova latencia ao host
+    if (engineParam->getIndex() != requestedEngine.load())
+    {
+        requestedEngine.store(engineParam->getIndex());
+        triggerAsyncUpdate();
+    }
+}
+
+// Parametros da FDN nas duas redes: so recalculam ganhos e tempos, sem alocacao
+void MyAudioProcessor::updateFdn() noexcept
+{
+    fdn8.setSize(fdnSizeParam->get());
+    fdn8.setDecay(fdnDecayParam->get());
+    fdn8.setDamping(fdnDampingParam->get());
+    fdn8.setModulation(fdnModulationParam->get());
+
+    fdn16.setSize(fdnSizeParam->get());
+    fdn16.setDecay(fdnDecayParam->get());
+    fdn16.setDamping(fdnDampingParam->get());
+    fdn16.setModulation(fdnModulationParam->get());
+
+    trace.parameters(getParameters());
 }
 
+// Recria o motor de convolucao com o novo orcamento e modo e informa a latencia ao host
+void MyAudioProcessor::handleAsyncUpdate()
+{
+    convolution.setLatencyBudget(latencyBudget.load());
+    convolution.setMode(dsp_core::Convolution::getModeForChoice(stereoMode.load()));
+    convolution.setFftBackend(dsp_core::Fft::getBackendForChoice(fftBackend.load()));
+    hybrid.setLatencyBudget(latencyBudget.load());
+    hybrid.setMode(dsp_core::Convolution::getModeForChoice(stereoMode.load()));
+    hybrid.setFftBackend(dsp_core::Fft::getBackendForChoice(fftBackend.load()));
+    hybrid.setSplitTime(0.001 * hybridSplit.load());
+    loadActiveEngine();
+    reverbEngine.store(requestedEngine.load());
+    setLatencySamples(getWetLatency());
+    trace.messageEvent("engine rebuild", (float)getWetLatency());
+}
+
+// A IR vai so para o motor em uso: carregar os dois dobraria a memoria e o tempo de carga
 void MyAudioProcessor::loadImpulseResponse(juce::File file)
 {
     DBG("load file" << file.getFileName());
-    convolution.loadImpulseResponse(file, juce::dsp::Convolution::Stereo::yes, juce::dsp::Convolution::Trim::yes, 0);
+    impulseFile = file;
+    convolutionStale = true;
+    hybridStale = true;
+    loadActiveEngine();
+    trace.messageEvent("ir swap");
+}
+
+// Carrega a ultima IR no motor pedido, se ele ainda nao a tiver. A FDN nao usa IR
+void MyAudioProcessor::loadActiveEngine()
+{
+    const int engine = requestedEngine.load();
+
+    if (engine == 0 && convolutionStale)
+    {
+        convolution.loadImpulseResponse(impulseFile, juce::dsp::Convolution::Trim::yes);
+        convolutionStale = false;
+    }
+    else if (engine == 2 && hybridStale)
+    {
+        hybrid.loadImpulseResponse(impulseFile);
+        hybridStale = false;
+    }
 }
 
 //==============================================================================
@@ -108,17 +271,100 @@ juce::AudioProcessorValueTreeState::ParameterLayout MyAudioProcessor::createPara
         1.0f, 
         0.5f));
 
+    // Orcamento de latencia em amostras: mais latencia, menos CPU
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParamID::latency,
+        "Latency",
+        dsp_core::Convolution::getLatencyChoices(),
+        0));
+
+    // true stereo: IRs de 4 canais (LL, LR, RL, RR), como as das salas de pos-producao
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParamID::stereo_mode,
+        "Stereo Mode",
+        dsp_core::Convolution::getModeChoices(),
+        1));
+
+    // Motor do reverb: convolucao com a IR carregada ou FDN algoritmica
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParamID::engine,
+        "Engine",
+        juce::StringArray { "convolucao", "fdn", "hibrido" },
+        0));
+
+    // Parametros da FDN (ver dsp_core/FdnReverb.h)
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParamID::fdn_lines,
+        "FDN Lines",
+        juce::StringArray { "8", "16" },
+        1));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParamID::fdn_size,
+        "FDN Size",
+        0.0f,
+        1.0f,
+        0.5f));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParamID::fdn_decay,
+        "FDN Decay",
+        juce::NormalisableRange<float>(0.1f, 20.0f, 0.01f, 0.4f),
+        2.0f));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParamID::fdn_damping,
+        "FDN Damping",
+        0.0f,
+        1.0f,
+        0.5f));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParamID::fdn_modulation,
+        "FDN Modulation",
+        0.0f,
+        1.0f,
+        0.2f));
+
+    // Fim das reflexoes iniciais no modo hibrido: o resto da IR vira a cauda da FDN
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParamID::hybrid_split,
+        "Hybrid Split (ms)",
+        juce::NormalisableRange<float>((float)(1000.0 * dsp_core::HybridReverb::minSplitSeconds),
+                                       (float)(1000.0 * dsp_core::HybridReverb::maxSplitSeconds), 1.0f),
+        80.0f));
+
+    // auto: a FFT mais rapida para cada tamanho de particao nesta maquina. juce usa o
+    // juce::dsp::Convolution (ver dsp_core/Convolution.h)
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParamID::fft_backend,
+        "FFT Backend",
+        dsp_core::Fft::getBackendChoices(),
+        0));
+
     return layout;
 }
 
 //==============================================================================
-// Gestao de presets (somente funcoes que variam por plugin. Ver Common.h)
+// Controle de GUI
+//------------------------------------------------------------------------------
+// Cria editor do plugin
+juce::AudioProcessorEditor* MyAudioProcessor::createEditor() 
+{ 
+    return new MyAudioProcessorEditor(*this, apvts);
+}
+//==============================================================================
+
+//==============================================================================
+// Gestao de presets (somente funcoes que variam por plugin. Ver dsp_core/PluginCommon.h)
 //------------------------------------------------------------------------------
 
 // TODO: Cria presets iniciais
 void MyAudioProcessor::createPrograms()
 {
-    presets.emplace_back(Preset("default", {0.0f}));
+    presets.emplace_back(Preset("default", {0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.5f, 2.0f, 0.5f, 0.2f, 80.0f, 0.0f}));
+    presets.emplace_back(Preset("fdn ambient", {0.5f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 12.0f, 0.6f, 0.5f, 80.0f, 0.0f}));
+    presets.emplace_back(Preset("hybrid hall", {0.4f, 2.0f, 1.0f, 2.0f, 1.0f, 0.5f, 2.0f, 0.5f, 0.2f, 80.0f, 0.0f}));
 }
 
 // TODO: Define preset atual
@@ -127,7 +373,17 @@ void MyAudioProcessor::setCurrentProgram (int index)
     currentProgram = index;
     
     juce::RangedAudioParameter *params[NUM_PARAMS] = {
-        wetDryMixParam
+        wetDryMixParam,
+        latencyParam,
+        stereoModeParam,
+        engineParam,
+        fdnLinesParam,
+        fdnSizeParam,
+        fdnDecayParam,
+        fdnDampingParam,
+        fdnModulationParam,
+        hybridSplitParam,
+        fftBackendParam
     };
 
     const Preset& preset = presets[(unsigned int)index];
@@ -17,7 +17,12 @@
 #include <cmath>
 #include <functional>
 
-#include "Preset.h"
+#include "dsp_core/Preset.h"
+#include "dsp_core/Denormals.h"
+#include "dsp_core/Convolution.h"
+#include "dsp_core/FdnReverb.h"
+#include "dsp_core/HybridReverb.h"
+#include "dsp_core/Trace.h"
 
 // TODO: Namespace onde os parametros do plugin sao declarados
 // Para adicionar um parametro, adicionar uma nova linha PARAMETER_ID(<nome_parametro>)
@@ -26,10 +31,20 @@
 namespace ParamID {
     #define PARAMETER_ID(str) const juce::ParameterID str(#str, 1);
     PARAMETER_ID(wet_dry)
+    PARAMETER_ID(latency)   // orcamento de latencia da convolucao (ver dsp_core/Convolution.h)
+    PARAMETER_ID(stereo_mode)   // roteamento da convolucao (ver dsp_core/PartitionedConvolution.h)
+    PARAMETER_ID(engine)        // convolucao, FDN ou hibrido (ver dsp_core/FdnReverb.h e HybridReverb.h)
+    PARAMETER_ID(fdn_lines)
+    PARAMETER_ID(fdn_size)
+    PARAMETER_ID(fdn_decay)
+    PARAMETER_ID(fdn_damping)
+    PARAMETER_ID(fdn_modulation)
+    PARAMETER_ID(hybrid_split)  // fim das reflexoes iniciais no modo hibrido, em ms
+    PARAMETER_ID(fft_backend)   // implementacao da FFT da convolucao (ver dsp_core/Fft.h)
     #undef PARAMETER_ID
 }
 
-class MyAudioProcessor : public juce::AudioProcessor, private juce::ValueTree::Listener
+class MyAudioProcessor : public juce::AudioProcessor, private juce::ValueTree::Listener, private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -95,6 +110,8 @@ private:
     int currentProgram;
     // Indica se algum parametro mudou
     std::atomic<bool> parametersChanged { false };   
+    // Registro de eventos da thread de audio (ver dsp_core/Trace.h)
+    dsp_core::Trace trace;
     
     // Indica se IR mudou
     std::atomic<bool> irChanged { false };    
@@ -114,10 +131,57 @@ private:
     std::unique_ptr<juce::TextButton> loadButton;
     
     juce::dsp::ProcessSpec spec;
-    juce::dsp::Convolution convolution;
-    juce::dsp::DryWetMixer<float> mixer;
+    dsp_core::Convolution convolution;
+    // o sinal seco e atrasado pela latencia da convolucao antes da mistura
+    juce::dsp::DryWetMixer<float> mixer { dsp_core::Convolution::maxLatencyBudget };
+    int mixerLatency = 0;
 
     juce::AudioParameterFloat* wetDryMixParam;
+    juce::AudioParameterChoice* latencyParam;
+    juce::AudioParameterChoice* stereoModeParam;
+
+    // Orcamento de latencia pedido pelo parametro. A troca recria o motor de convolucao,
+    // entao e feita na thread de mensagens (handleAsyncUpdate)
+    std::atomic<int> latencyBudget { 0 };
+    std::atomic<int> stereoMode { (int)dsp_core::ConvolutionMode::stereo };
+
+    juce::AudioParameterChoice* fftBackendParam;
+    std::atomic<int> fftBackend { (int)dsp_core::FftBackend::automatic };
+
+    // Reverb algoritmico, alternativa de CPU baixa e fixa para caudas longas. As duas
+    // redes sao preparadas em prepareToPlay, entao a troca de motor nao aloca
+    dsp_core::FdnReverb<float, 8> fdn8;
+    dsp_core::FdnReverb<float, 16> fdn16;
+
+    juce::AudioParameterChoice* engineParam;
+    juce::AudioParameterChoice* fdnLinesParam;
+    juce::AudioParameterFloat* fdnSizeParam;
+    juce::AudioParameterFloat* fdnDecayParam;
+    juce::AudioParameterFloat* fdnDampingParam;
+    juce::AudioParameterFloat* fdnModulationParam;
+
+    // Reverb hibrido: convolucao so no inicio da IR e cauda por FDN ajustada a IR ao
+    // carregar. O corte recarrega a IR, entao e aplicado na thread de mensagens
+    dsp_core::HybridReverb hybrid;
+    juce::AudioParameterFloat* hybridSplitParam;
+    std::atomic<float> hybridSplit { 80.0f };
+
+    // Motor atual (0 convolucao, 1 FDN, 2 hibrido). A latencia informada ao host muda com
+    // o motor. Um motor novo so passa a processar (reverbEngine) depois de receber a IR,
+    // na thread de mensagens
+    std::atomic<int> reverbEngine { 0 };
+    std::atomic<int> requestedEngine { 0 };
+    int getWetLatency() const noexcept;
+
+    // Ultima IR escolhida. So o motor em uso a carrega; o outro motor de convolucao fica
+    // desatualizado ate ser escolhido. Thread de mensagens
+    juce::File impulseFile;
+    bool convolutionStale = false;
+    bool hybridStale = false;
+    void loadActiveEngine();
+    void updateFdn() noexcept;
+
+    void handleAsyncUpdate() override;
 
     // Suavizador de trocas de parametros
     juce::LinearSmoothedValue<float> gainSmoother;    
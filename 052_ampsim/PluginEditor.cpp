@@ -1,14 +1,35 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace
+{
+    constexpr int parameterHeight = 500;
+    constexpr int modelHeight = 30;
+    constexpr int rowHeight = 20;
+    constexpr int profileHeight = rowHeight * (MyAudioProcessor::numStages + 2);
+}
+
 MyAudioProcessorEditor::MyAudioProcessorEditor (MyAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p), parameterEditor (p)
 {
-    // Para evitar warnings
-    juce::ignoreUnused(audioProcessor);
-    
+    addAndMakeVisible (parameterEditor);
+
+    loadModelButton.setButtonText ("Load Amp Model");
+    loadModelButton.onClick = [this] { loadAmpModel(); };
+    addAndMakeVisible (loadModelButton);
+
+    const auto description = audioProcessor.getAmpModelDescription();
+    modelLabel.setText (description.isEmpty() ? "sem modelo" : description, juce::dontSendNotification);
+    addAndMakeVisible (modelLabel);
+
+    for (int stage = 0; stage < MyAudioProcessor::numStages; ++stage)
+        lastProfiles[(size_t)stage] = audioProcessor.getStageProfile (stage);
+
     // Define o tamanho do editor
-    setSize (400, 300);
+    setSize (500, parameterHeight + modelHeight + profileHeight);
+
+    // estatisticas do ultimo segundo
+    startTimerHz (1);
 }
 
 MyAudioProcessorEditor::~MyAudioProcessorEditor() {}
@@ -18,11 +39,78 @@ void MyAudioProcessorEditor::paint (juce::Graphics& g)
     // Preenche a tela com uma cor solida
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
     g.setColour (juce::Colours::white);
-    g.setFont (15.0f);
+    g.setFont (14.0f);
+
+    // Custo de CPU por estagio: carga media e p99 (fracao da duracao do bloco) e tempo medio por bloco
+    auto area = getLocalBounds().withTrimmedTop (parameterHeight + modelHeight).reduced (10, 0);
+    auto drawRow = [&] (const juce::String& name, const juce::String& mean, const juce::String& p99, const juce::String& time)
+    {
+        auto row = area.removeFromTop (rowHeight);
+        g.drawText (name, row.removeFromLeft (160), juce::Justification::centredLeft);
+        g.drawText (mean, row.removeFromLeft (100), juce::Justification::centredRight);
+        g.drawText (p99, row.removeFromLeft (100), juce::Justification::centredRight);
+        g.drawText (time, row, juce::Justification::centredRight);
+    };
+
+    drawRow ("estagio", "media", "p99", "us/bloco");
 
-    // TODO: Define nome do plugin na tela. Aqui usamos "Plugin" apenas
-    g.drawFittedText ("Plugin", getLocalBounds(), juce::Justification::centred, 1);
+    for (int stage = 0; stage < MyAudioProcessor::numStages; ++stage)
+    {
+        const auto& profile = stageProfiles[(size_t)stage];
+        drawRow (MyAudioProcessor::getStageName (stage),
+                 juce::String (100.0 * profile.getMeanLoad(), 2) + " %",
+                 juce::String (100.0 * profile.getPercentileLoad (0.99), 2) + " %",
+                 juce::String (profile.getMeanMicrosecondsPerBlock(), 1));
+    }
 }
 
 // Funcao em que sao definidas posicoes customizadas dos elementos
-void MyAudioProcessorEditor::resized() {}
\ No newline at end of file
+void MyAudioProcessorEditor::resized()
+{
+    auto area = getLocalBounds();
+    parameterEditor.setBounds (area.removeFromTop (parameterHeight));
+
+    auto modelRow = area.removeFromTop (modelHeight).reduced (10, 5);
+    loadModelButton.setBounds (modelRow.removeFromLeft (130));
+    modelLabel.setBounds (modelRow.withTrimmedLeft (10));
+}
+
+// Escolhe o arquivo de pesos; o modelo e trocado aqui, na thread de mensagens
+void MyAudioProcessorEditor::loadAmpModel()
+{
+    chooser = std::make_unique<juce::FileChooser>(
+        "Select amp model",
+        juce::File::getSpecialLocation(juce::File::userHomeDirectory),
+        "*.json",
+        false);
+
+    auto chooserFlags = juce::FileBrowserComponent::openMode |
+        juce::FileBrowserComponent::canSelectFiles;
+
+    chooser->launchAsync(chooserFlags, [this](const juce::FileChooser& fc) {
+        const juce::File file = fc.getResult();
+
+        if (file == juce::File{})
+            return;
+
+        juce::String error;
+
+        if (audioProcessor.loadAmpModel(file, error))
+            modelLabel.setText (audioProcessor.getAmpModelDescription() + " (" + file.getFileName() + ")", juce::dontSendNotification);
+        else
+            modelLabel.setText ("erro: " + error, juce::dontSendNotification);
+    });
+}
+
+// Janela do ultimo intervalo: diferenca entre leituras dos contadores do processador
+void MyAudioProcessorEditor::timerCallback()
+{
+    for (int stage = 0; stage < MyAudioProcessor::numStages; ++stage)
+    {
+        const auto profile = audioProcessor.getStageProfile (stage);
+        stageProfiles[(size_t)stage] = profile.since (lastProfiles[(size_t)stage]);
+        lastProfiles[(size_t)stage] = profile;
+    }
+
+    repaint (getLocalBounds().withTrimmedTop (parameterHeight + modelHeight));
+}
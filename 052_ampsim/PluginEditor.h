@@ -6,7 +6,9 @@
 
 #include "PluginProcessor.h"
 
-class MyAudioProcessorEditor : public juce::AudioProcessorEditor
+#include <array>
+
+class MyAudioProcessorEditor : public juce::AudioProcessorEditor, private juce::Timer
 {
 public:
     MyAudioProcessorEditor (MyAudioProcessor&);
@@ -18,5 +20,21 @@ public:
 private:
     // Referencia para o editor acessar o objeto MyAudioProcessor que o criou
     MyAudioProcessor& audioProcessor;
+
+    // Parametros (editor generico do JUCE)
+    juce::GenericAudioProcessorEditor parameterEditor;
+
+    // Modelo capturado do amplificador: arquivo JSON de pesos e descricao do atual
+    std::unique_ptr<juce::FileChooser> chooser;
+    juce::TextButton loadModelButton;
+    juce::Label modelLabel;
+    void loadAmpModel();
+
+    // Custo por estagio: leitura anterior e estatisticas do ultimo intervalo do timer
+    using Snapshot = dsp_core::StageProfiler::Snapshot;
+    std::array<Snapshot, MyAudioProcessor::numStages> lastProfiles, stageProfiles;
+
+    void timerCallback() override;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MyAudioProcessorEditor)
-};
\ No newline at end of file
+};
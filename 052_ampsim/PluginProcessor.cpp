@@ -1,10 +1,15 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include "Common.h"
+// get/setStateInformation guardam tambem o caminho do modelo capturado
+#define PLUGIN_CUSTOM_STATE
+#include "dsp_core/PluginCommon.h"
 #include "IR.h"
 
 // TODO: Quantidade de parametros
-const long unsigned int NUM_PARAMS = 12;
+const long unsigned int NUM_PARAMS = 30;
+
+// Propriedade da arvore de estado com o caminho do modelo capturado
+static const juce::Identifier ampModelProperty { "amp_model" };
 
 //==============================================================================
 // Construtor e destrutor
@@ -31,6 +36,20 @@ MyAudioProcessor::MyAudioProcessor()
     pre_gain_ = 0.0f;
     post_gain_ = 0.0f;
 
+    tone_stack_ = 0;
+    bass_ = 5.0f;
+    mid_ = 5.0f;
+    treble_ = 5.0f;
+
+    amp_stage_ = 0;
+
+    gate_ = false;
+    gate_threshold_ = -60.0f;
+    gate_hysteresis_ = 6.0f;
+    gate_attack_ = 1.0f;
+    gate_hold_ = 50.0f;
+    gate_release_ = 100.0f;
+
     irIndex = 0;
 
     castParameter(apvts, ParamID::freq_low, freqLowParam);
@@ -49,11 +68,31 @@ MyAudioProcessor::MyAudioProcessor()
     castParameter(apvts, ParamID::post_gain, postGainParam);
 
     castParameter(apvts, ParamID::ir, irParam);
-
-    auto& waveshaper = filterChain.get<4>();
-    waveshaper.functionToUse = [](float x) { return (float)(std::copysign(1.0, x) * (1 - 0.25 / (std::fabs(x) + 0.25))); };
+    castParameter(apvts, ParamID::latency, latencyParam);
+    castParameter(apvts, ParamID::ir_trim, irTrimParam);
+    castParameter(apvts, ParamID::ir_min_phase, irMinPhaseParam);
+    castParameter(apvts, ParamID::ir_quality, irQualityParam);
+    castParameter(apvts, ParamID::cab_decimate, cabDecimateParam);
+    castParameter(apvts, ParamID::stereo_mode, stereoModeParam);
+    castParameter(apvts, ParamID::fft_backend, fftBackendParam);
+    castParameter(apvts, ParamID::tone_stack, toneStackParam);
+    castParameter(apvts, ParamID::bass, bassParam);
+    castParameter(apvts, ParamID::mid, midParam);
+    castParameter(apvts, ParamID::treble, trebleParam);
+    castParameter(apvts, ParamID::amp_stage, ampStageParam);
+    castParameter(apvts, ParamID::gate, gateParam);
+    castParameter(apvts, ParamID::gate_threshold, gateThresholdParam);
+    castParameter(apvts, ParamID::gate_hysteresis, gateHysteresisParam);
+    castParameter(apvts, ParamID::gate_attack, gateAttackParam);
+    castParameter(apvts, ParamID::gate_hold, gateHoldParam);
+    castParameter(apvts, ParamID::gate_release, gateReleaseParam);
+
+    // espectros da IR compartilhados entre as instancias que usam a mesma caixa: cada
+    // instancia guarda so o historico de entrada (ver dsp_core/PartitionedConvolution.h)
+    filterChain.get<7>().setSharedPartitions(true);
 
     apvts.state.addListener(this);
+    trace.setup(getName(), getParameters());
     
     createPrograms();
     setCurrentProgram(0);
@@ -61,20 +100,25 @@ MyAudioProcessor::MyAudioProcessor()
 
 MyAudioProcessor::~MyAudioProcessor() 
 {
+    cancelPendingUpdate();
     apvts.state.removeListener(this);
 }
 
 void MyAudioProcessor::loadIR()
 {
-    auto& convolution = filterChain.get<6>();
-    static const unsigned char* ir;
+    auto& convolution = filterChain.get<7>();
+    // variavel local (nao static): varias instancias podem carregar IRs em paralelo
+    const unsigned char* ir;
     uint32_t ir_size = 0;
 
-    if (irIndex == 0) { //JZ120
+    // le o parametro diretamente: roda na thread de mensagens, e irIndex pertence a thread de audio
+    const int index = irParam->getIndex();
+
+    if (index == 0) { //JZ120
         ir = IR_JZ120;
         ir_size = IR_JZ120_BYTES;
     }
-    else if (irIndex == 1) { //AC30
+    else if (index == 1) { //AC30
         ir = IR_AC30;
         ir_size = IR_AC30_BYTES;
     }
@@ -83,7 +127,22 @@ void MyAudioProcessor::loadIR()
         ir_size = IR_JCM900_BYTES;
     }
 
-    convolution.loadImpulseResponse(ir, ir_size, juce::dsp::Convolution::Stereo::yes, juce::dsp::Convolution::Trim::yes, 0);
+    // corte por energia (-60/-80 dB) com fade-out e fase minima opcional, calculados uma
+    // vez aqui. IRs de caixa raramente precisam de mais de 20 a 50 ms
+    static constexpr float truncationDb[] = { 0.0f, -60.0f, -80.0f };
+
+    dsp_core::ImpulseResponseOptions options;
+    options.truncationDb = truncationDb[juce::jlimit(0, 2, irTrimParam->getIndex())];
+    options.minimumPhase = irMinPhaseParam->get();
+
+    // a IR e convertida para a taxa de processamento aqui, e nao pelo motor, e o
+    // resultado fica guardado por taxa (ver dsp_core/Convolution.h)
+    options.resampling = irQualityParam->getIndex() == 0 ? dsp_core::ResamplingQuality::sinc
+                                                         : dsp_core::ResamplingQuality::linear;
+
+    convolution.setImpulseResponseOptions(options);
+    convolution.loadImpulseResponse(ir, ir_size, juce::dsp::Convolution::Trim::yes);
+    trace.messageEvent("ir swap", (float)irIndex);
 }
 
 //==============================================================================
@@ -98,12 +157,35 @@ void MyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock) {
     spec.sampleRate = sampleRate;
     spec.maximumBlockSize = (unsigned int)samplesPerBlock;
     spec.numChannels = (unsigned int)getTotalNumOutputChannels();
+    trace.prepare(sampleRate);
+
+    // IR e orcamento de latencia atuais, mesmo sem thread de mensagens (ferramentas offline)
+    irIndex = (unsigned int)irParam->getIndex();
+    irTrimIndex = irTrimParam->getIndex();
+    irMinPhase = irMinPhaseParam->get();
+    irQuality = irQualityParam->getIndex();
+    latencyBudget.store(dsp_core::Convolution::getLatencyBudgetForChoice(latencyParam->getIndex()));
+    cabDecimate.store(cabDecimateParam->get());
+    stereoMode.store(stereoModeParam->getIndex());
+    fftBackend.store(fftBackendParam->getIndex());
+    filterChain.get<7>().setLatencyBudget(latencyBudget.load());
+    filterChain.get<7>().setDecimation(cabDecimate.load());
+    filterChain.get<7>().setMode(dsp_core::Convolution::getModeForChoice(stereoMode.load()));
+    filterChain.get<7>().setFftBackend(dsp_core::Fft::getBackendForChoice(fftBackend.load()));
 
     loadIR();
 
     filterChain.prepare(spec);
+    gate.prepare(spec);
+    silentSamples = 0;
+    idle = false;
+    gateProfiler.prepare(sampleRate);
+    updateLatency();
 
+    // ganhos ja no valor dos parametros, sem rampa a partir de 1
     setCoeffs();
+    filterChain.get<1>().reset();
+    filterChain.get<6>().reset();
 }
 
 // TODO: funcao que processa audio em loop - AUDIO THREAD!!!
@@ -111,9 +193,12 @@ void MyAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::Midi
 {
     juce::ignoreUnused(midiMessages);
 
-    // define uma flag especial para a CPU que trunca valores muito pequenos para zero
-    // em vez de processa-los como numeros denormais
-    juce::ScopedNoDenormals noDenormals;
+    // marca o bloco no trace (so com DSP_CORE_TRACE definido; ver dsp_core/Trace.h)
+    const dsp_core::Trace::ScopedBlock tracedBlock(trace, buffer.getNumSamples());
+
+    // ativa FTZ/DAZ na thread de audio (ver dsp_core/Denormals.h). O modo da CPU so e
+    // alterado na primeira vez, em vez de ser trocado e restaurado a cada bloco
+    dsp_core::disableDenormals();
 
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -123,18 +208,55 @@ void MyAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::Midi
     
     juce::dsp::AudioBlock<float> block(buffer);
     juce::dsp::ProcessContextReplacing<float> context(block);
-    filterChain.process(context);
+
+    // noise gate na entrada, medido como mais um estagio
+    if (gate_)
+    {
+        const bool shouldProfile = filterChain.isProfilingEnabled();
+        const auto start = shouldProfile ? dsp_core::ProfileClock::now() : 0;
+
+        gate.process(context);
+
+        if (shouldProfile)
+            gateProfiler.record(dsp_core::ProfileClock::now() - start, buffer.getNumSamples());
+    }
+
+    // O EQ vem antes do pre-ganho e da saturacao: a entrada deles so e zero com o bloco
+    // todo zerado pelo gate e o EQ sem cauda. silentSamples conta ha quanto tempo a saida
+    // do EQ (a entrada do resto da cadeia) e silencio exato
+    const auto numSamples = buffer.getNumSamples();
+    const bool silentInput = gate_ && gate.getClosedSamples() >= numSamples && filterChain.get<0>().isAtRest();
+    silentSamples = silentInput ? silentSamples + numSamples : 0;
+
+    // Passada a cauda da caixa e a margem, a saida da cadeia tambem ja e silencio: o bloco
+    // (zerado pelo gate) sai direto, sem processar a cadeia. Ao parar, valvula e tone
+    // stack voltam ao estado de repouso, e e dali que continuam quando o gate abre.
+    // Com o modelo capturado a cadeia nunca para: a saida dele com entrada zero e o bias
+    // da camada linear (sem bloqueio de DC), entao parar seria um degrau de DC e
+    // reiniciar a rede da h = 0 um transiente na volta
+    const bool useNeuralAmp = amp_stage_ == 1 && filterChain.get<3>().hasModel();
+    const int idleAfter = idleAfterSamples.load();
+    const bool shouldIdle = idleAfter >= 0 && silentSamples > idleAfter && ! useNeuralAmp;
+
+    if (shouldIdle && ! idle)
+    {
+        filterChain.get<4>().reset();
+        filterChain.get<5>().reset();
+    }
+
+    idle = shouldIdle;
+
+    if (! idle)
+    {
+        updateStageBypass(silentInput);
+        filterChain.process(context);
+    }
 
     //valueTreePropertyChanged altera variavel parametersChanged quando algum parametro muda
     bool expected = true;
     if (parametersChanged.compare_exchange_strong(expected, false)) {
         update();
     }
-
-    expected = true;
-    if (irChanged.compare_exchange_strong(expected, false)) {
-        loadIR();
-    }
 }
 
 // chamada logo DEPOIS de processar
@@ -175,33 +297,250 @@ void MyAudioProcessor::update() {
     smoother.setCurrentAndTargetValue(postGainParam->get());
     post_gain_ = postGainParam->get();
 
+    tone_stack_ = toneStackParam->getIndex();
+    bass_ = bassParam->get();
+    mid_ = midParam->get();
+    treble_ = trebleParam->get();
+
+    // a valvula acrescenta a latencia do oversampling: o host e avisado fora da thread de audio
+    if (ampStageParam->getIndex() != amp_stage_)
+    {
+        amp_stage_ = ampStageParam->getIndex();
+        triggerAsyncUpdate();
+    }
+
+    // o gate comeca fechado quando e ligado: a cadeia so para depois da cauda
+    if (gateParam->get() && ! gate_)
+        gate.reset();
+
+    gate_ = gateParam->get();
+    gate_threshold_ = gateThresholdParam->get();
+    gate_hysteresis_ = gateHysteresisParam->get();
+    gate_attack_ = gateAttackParam->get();
+    gate_hold_ = gateHoldParam->get();
+    gate_release_ = gateReleaseParam->get();
+
     unsigned int newIr = (unsigned int)irParam->getIndex();
 
-    if (irIndex != newIr)
+    if (irIndex != newIr || irTrimIndex != irTrimParam->getIndex() || irMinPhase != irMinPhaseParam->get()
+        || irQuality != irQualityParam->getIndex())
     {
         irIndex = newIr;
+        irTrimIndex = irTrimParam->getIndex();
+        irMinPhase = irMinPhaseParam->get();
+        irQuality = irQualityParam->getIndex();
         irChanged.store(true);
+        triggerAsyncUpdate();
+    }
+
+    // troca de orcamento de latencia: o motor de convolucao e recriado na thread de mensagens
+    const int newBudget = dsp_core::Convolution::getLatencyBudgetForChoice(latencyParam->getIndex());
+
+    if (newBudget != latencyBudget.load())
+    {
+        latencyBudget.store(newBudget);
+        triggerAsyncUpdate();
+    }
+
+    if (cabDecimateParam->get() != cabDecimate.load())
+    {
+        cabDecimate.store(cabDecimateParam->get());
+        triggerAsyncUpdate();
+    }
+
+    if (stereoModeParam->getIndex() != stereoMode.load())
+    {
+        stereoMode.store(stereoModeParam->getIndex());
+        triggerAsyncUpdate();
+    }
+
+    if (fftBackendParam->getIndex() != fftBackend.load())
+    {
+        fftBackend.store(fftBackendParam->getIndex());
+        triggerAsyncUpdate();
     }
 
     setCoeffs();
+    trace.parameters(getParameters());
+}
+
+// Carregar IR, recriar o motor de convolucao e ler o modelo alocam memoria, entao rodam aqui e nao em update()
+void MyAudioProcessor::handleAsyncUpdate()
+{
+    auto& convolution = filterChain.get<7>();
+
+    bool expected = true;
+    if (irChanged.compare_exchange_strong(expected, false)) {
+        loadIR();
+    }
+
+    expected = true;
+    if (ampModelChanged.compare_exchange_strong(expected, false)) {
+        loadSavedAmpModel();
+    }
+
+    convolution.setLatencyBudget(latencyBudget.load());
+    convolution.setDecimation(cabDecimate.load());
+    convolution.setMode(dsp_core::Convolution::getModeForChoice(stereoMode.load()));
+    convolution.setFftBackend(dsp_core::Fft::getBackendForChoice(fftBackend.load()));
+    updateLatency();
+    trace.messageEvent("engine rebuild", (float)convolution.getLatency());
+}
+
+// Le o parametro diretamente, como loadIR: roda fora da thread de audio
+void MyAudioProcessor::updateLatency()
+{
+    const bool useTriode = ampStageParam->getIndex() == 2;
+    const int triodeLatency = useTriode ? filterChain.get<4>().getLatency() : 0;
+    setLatencySamples(filterChain.get<7>().getLatency() + triodeLatency);
+
+    // silencio na saida do EQ por mais que a cauda da caixa (ja com a latencia dela) e
+    // 100 ms para a valvula e o tone stack chegarem perto do repouso (e entao sao
+    // reiniciados). Sem a cauda conhecida, a cadeia nunca para (nem com o modelo capturado)
+    const int cabTail = filterChain.get<7>().getTailLength();
+    idleAfterSamples.store(cabTail < 0 ? -1 : cabTail + triodeLatency + (int)(0.1 * getSampleRate()));
 }
 
 // Configura os coeficientes do filtro
 void MyAudioProcessor::setCoeffs() //AUDIO THREAD!!!
 {
-    lowShelfCoeff = juce::dsp::IIR::Coefficients<float>::makeLowShelf(getSampleRate(), freq_low_, Q_low_, gain_low_);
-    midPeakCoeff = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), freq_mid_, Q_mid_, gain_mid_);
-    highShelfCoeff = juce::dsp::IIR::Coefficients<float>::makeHighShelf(getSampleRate(), freq_high_, Q_high_, gain_high_);
+    // coeficientes calculados sem alocacao (ver dsp_core/Biquad.h)
+    using Coefficients = dsp_core::BiquadCoefficients<float>;
 
-    *filterChain.get<0>().coefficients = *lowShelfCoeff;
-    *filterChain.get<1>().coefficients = *midPeakCoeff;
-    *filterChain.get<2>().coefficients = *highShelfCoeff;
+    auto& eq = filterChain.get<0>();
+    eq.setCoefficients(0, Coefficients::makeLowShelf(getSampleRate(), freq_low_, Q_low_, gain_low_));
+    eq.setCoefficients(1, Coefficients::makePeakFilter(getSampleRate(), freq_mid_, Q_mid_, gain_mid_));
+    eq.setCoefficients(2, Coefficients::makeHighShelf(getSampleRate(), freq_high_, Q_high_, gain_high_));
 
-    auto& preGain = filterChain.get<3>();
-    preGain.setGainDecibels(pre_gain_);
+    // ganhos em rampa (ver dsp_core/Smoother.h)
+    auto& preGain = filterChain.get<1>();
+    preGain.setGain(juce::Decibels::decibelsToGain(pre_gain_));
  
-    auto& postGain = filterChain.get<5>();
-    postGain.setGainDecibels(post_gain_);
+    auto& postGain = filterChain.get<6>();
+    postGain.setGain(juce::Decibels::decibelsToGain(post_gain_));
+
+    gate.setThreshold(gate_threshold_, gate_hysteresis_);
+    gate.setTimes(gate_attack_, gate_hold_, gate_release_);
+
+    // tone stack: consulta a tabela da topologia, sem calcular o circuito (ver dsp_core/ToneStack.h)
+    auto& toneStack = filterChain.get<5>();
+    toneStack.setModel(getToneStackModel());
+    toneStack.setKnobs(bass_ / 10.0f, mid_ / 10.0f, treble_ / 10.0f);
+}
+
+// "auto" segue a IR: JZ120 -> Fender, AC30 -> Vox, JCM900 -> Marshall
+dsp_core::ToneStackModel MyAudioProcessor::getToneStackModel() const noexcept
+{
+    static constexpr dsp_core::ToneStackModel byIr[] = { dsp_core::ToneStackModel::fender,
+                                                         dsp_core::ToneStackModel::vox,
+                                                         dsp_core::ToneStackModel::marshall };
+    static constexpr dsp_core::ToneStackModel byChoice[] = { dsp_core::ToneStackModel::fender,
+                                                             dsp_core::ToneStackModel::marshall,
+                                                             dsp_core::ToneStackModel::vox };
+
+    if (tone_stack_ <= 1)
+        return byIr[juce::jlimit(0, 2, (int)irIndex)];
+
+    return byChoice[juce::jlimit(0, 2, tone_stack_ - 2)];
+}
+
+// Muitos presets deixam o EQ plano e os ganhos em 0 dB. Estagios neutros ficam em bypass
+// e o pre-ganho, linear como o EQ, vira parte dos coeficientes do ultimo biquad ativo
+// (ver dsp_core/Biquad.h). Os ganhos so entram em bypass ou sao dobrados fora da rampa,
+// e o EQ so entra em bypass com o estado zerado, entao as trocas nao causam cliques.
+// Com a entrada zerada pelo gate e o EQ em repouso, pre-ganho e saturacao (sem memoria,
+// f(0) = 0) tambem ficam em bypass enquanto o resto da cadeia termina a cauda
+void MyAudioProcessor::updateStageBypass(bool silentInput) //AUDIO THREAD!!!
+{
+    auto& eq = filterChain.get<0>();
+    auto& preGain = filterChain.get<1>();
+    auto& neuralAmp = filterChain.get<3>();
+    auto& triode = filterChain.get<4>();
+    auto& toneStack = filterChain.get<5>();
+    auto& postGain = filterChain.get<6>();
+
+    const bool foldPreGain = ! preGain.isSmoothing() && ! eq.isFlat();
+    eq.setOutputGain(foldPreGain ? preGain.getGain() : 1.0f);
+
+    filterChain.setBypassed<0>(eq.isIdentity());
+    filterChain.setBypassed<1>(silentInput || foldPreGain || (! preGain.isSmoothing() && preGain.getGain() == 1.0f));
+    filterChain.setBypassed<6>(! postGain.isSmoothing() && postGain.getGain() == 1.0f);
+
+    // o tone stack volta sem a cauda de quando foi desligado
+    if (filterChain.isBypassed<5>() && tone_stack_ != 0)
+        toneStack.reset();
+
+    filterChain.setBypassed<5>(tone_stack_ == 0);
+
+    // modelo capturado (so com um modelo carregado) ou valvula no lugar da saturacao.
+    // Tambem voltam sem o estado de quando foram desligados
+    const bool useNeuralAmp = amp_stage_ == 1 && neuralAmp.hasModel();
+    const bool useTriode = amp_stage_ == 2;
+
+    if (filterChain.isBypassed<3>() && useNeuralAmp)
+        neuralAmp.reset();
+
+    if (filterChain.isBypassed<4>() && useTriode)
+        triode.reset();
+
+    filterChain.setBypassed<2>(silentInput || useNeuralAmp || useTriode);
+    filterChain.setBypassed<3>(! useNeuralAmp);
+    filterChain.setBypassed<4>(! useTriode);
+}
+
+// Nomes dos estagios: o gate e depois os de filterChain, na ordem
+const char* MyAudioProcessor::getStageName(int stage) noexcept
+{
+    static constexpr const char* names[numStages] = { "noise gate", "EQ", "pre-ganho", "saturacao", "modelo (rede)",
+                                                      "valvula (WDF)", "tone stack", "pos-ganho", "caixa (IR)" };
+    return names[juce::jlimit(0, numStages - 1, stage)];
+}
+
+// Contadores acumulados do estagio. Qualquer thread; o editor calcula a janela com since()
+dsp_core::StageProfiler::Snapshot MyAudioProcessor::getStageProfile(int stage) const noexcept
+{
+    if (stage <= 0)
+        return gateProfiler.getSnapshot();
+
+    return filterChain.getProfiler((size_t)juce::jmin(numStages - 1, stage) - 1).getSnapshot();
+}
+
+// Le os pesos e troca o modelo (dsp_core::NeuralAmp). Em caso de erro, o modelo atual continua
+bool MyAudioProcessor::loadAmpModel(const juce::File& file, juce::String& error)
+{
+    if (! filterChain.get<3>().loadModel(file, error))
+        return false;
+
+    apvts.state.setProperty(ampModelProperty, file.getFullPathName(), nullptr);
+    trace.messageEvent("amp model swap");
+    return true;
+}
+
+juce::String MyAudioProcessor::getAmpModelDescription() const
+{
+    return filterChain.get<3>().getModelDescription();
+}
+
+void MyAudioProcessor::loadSavedAmpModel()
+{
+    auto& neuralAmp = filterChain.get<3>();
+    const auto path = apvts.state.getProperty(ampModelProperty, {}).toString();
+
+    if (path.isEmpty())
+    {
+        neuralAmp.clearModel();
+        return;
+    }
+
+    juce::String error;
+
+    if (! neuralAmp.loadModel(juce::File(path), error))
+    {
+        DBG("amp model: " << error);
+        return;
+    }
+
+    trace.messageEvent("amp model swap");
 }
 
 //==============================================================================
@@ -299,11 +638,145 @@ juce::AudioProcessorValueTreeState::ParameterLayout MyAudioProcessor::createPara
         juce::StringArray { "JZ120", "AC30", "JCM900" }, 
         0));
 
+    // Orcamento de latencia em amostras: mais latencia, menos CPU
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParamID::latency,
+        "Latency",
+        dsp_core::Convolution::getLatencyChoices(),
+        0));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParamID::ir_trim,
+        "IR Trim",
+        juce::StringArray { "off", "-60 dB", "-80 dB" },
+        2));
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        ParamID::ir_min_phase,
+        "IR Minimum Phase",
+        false));
+
+    // Conversao da IR para a taxa do host: sinc (sem aliasing) ou linear (mais rapida)
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParamID::ir_quality,
+        "IR Resampling",
+        juce::StringArray { "sinc", "linear" },
+        0));
+
+    // Em 88.2 kHz ou mais a caixa roda em taxa / 2 ou / 4: a IR nao tem conteudo util
+    // acima de ~12 kHz
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        ParamID::cab_decimate,
+        "Cabinet Decimation",
+        true));
+
+    // mono: IR de 1 canal nos dois lados; mono > stereo e true stereo precisam de IRs
+    // de 2 e 4 canais
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParamID::stereo_mode,
+        "Stereo Mode",
+        dsp_core::Convolution::getModeChoices(),
+        1));
+
+    // auto: a FFT mais rapida para cada tamanho de particao nesta maquina (medida uma vez
+    // e guardada em arquivo). fftw so existe com DSP_CORE_USE_FFTW no build
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParamID::fft_backend,
+        "FFT Backend",
+        dsp_core::Fft::getBackendChoices(),
+        0));
+
+    // Tone stack passivo de 3a ordem (Fender, Marshall ou Vox). auto usa a topologia do
+    // amplificador da IR escolhida
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParamID::tone_stack,
+        "Tone Stack",
+        juce::StringArray { "off", "auto", "Fender", "Marshall", "Vox" },
+        0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParamID::bass,
+        "Bass",
+        juce::NormalisableRange<float>(0.0f, 10.0f, 0.1f),
+        5.0f));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParamID::mid,
+        "Middle",
+        juce::NormalisableRange<float>(0.0f, 10.0f, 0.1f),
+        5.0f));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParamID::treble,
+        "Treble",
+        juce::NormalisableRange<float>(0.0f, 10.0f, 0.1f),
+        5.0f));
+
+    // Modelo capturado (LSTM/GRU) ou valvula 12AX7 no lugar da saturacao. Sem modelo
+    // carregado, neural fica na saturacao
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParamID::amp_stage,
+        "Amp Stage",
+        juce::StringArray { "waveshaper", "neural", "triode" },
+        0));
+
+    // Noise gate antes do pre-ganho. Abre acima de Gate Threshold e fecha abaixo de
+    // Gate Threshold - Gate Hysteresis, depois de Gate Hold
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        ParamID::gate,
+        "Gate",
+        false));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParamID::gate_threshold,
+        "Gate Threshold",
+        juce::NormalisableRange<float>(-90.0f, 0.0f, 0.1f),
+        -60.0f,
+        juce::AudioParameterFloatAttributes().withLabel("dB")));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParamID::gate_hysteresis,
+        "Gate Hysteresis",
+        juce::NormalisableRange<float>(0.0f, 20.0f, 0.1f),
+        6.0f,
+        juce::AudioParameterFloatAttributes().withLabel("dB")));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParamID::gate_attack,
+        "Gate Attack",
+        juce::NormalisableRange<float>(0.1f, 50.0f, 0.1f, 0.5f),
+        1.0f,
+        juce::AudioParameterFloatAttributes().withLabel("ms")));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParamID::gate_hold,
+        "Gate Hold",
+        juce::NormalisableRange<float>(0.0f, 500.0f, 1.0f, 0.5f),
+        50.0f,
+        juce::AudioParameterFloatAttributes().withLabel("ms")));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParamID::gate_release,
+        "Gate Release",
+        juce::NormalisableRange<float>(5.0f, 1000.0f, 1.0f, 0.5f),
+        100.0f,
+        juce::AudioParameterFloatAttributes().withLabel("ms")));
+
     return layout;
 }
 
 //==============================================================================
-// Gestao de presets (somente funcoes que variam por plugin. Ver Common.h)
+// Controle de GUI
+//------------------------------------------------------------------------------
+// Cria editor generico, com o custo por estagio abaixo dos parametros
+juce::AudioProcessorEditor* MyAudioProcessor::createEditor() 
+{ 
+    return new MyAudioProcessorEditor(*this);
+}
+//==============================================================================
+
+//==============================================================================
+// Gestao de presets (somente funcoes que variam por plugin. Ver dsp_core/PluginCommon.h)
 //------------------------------------------------------------------------------
 
 // TODO: Cria presets iniciais
@@ -312,7 +785,11 @@ void MyAudioProcessor::createPrograms()
     presets.emplace_back(Preset("default", {50.0f, 1.0f, 1.0f,
                                     450.0f, 1.0f, 1.0f,
                                     3000.0f, 1.0f, 1.0f,
-                                    0.0f, 0.0f, 0.0f}));
+                                    0.0f, 0.0f, 0.0f, 0.0f,
+                                    2.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f,
+                                    0.0f, 5.0f, 5.0f, 5.0f,
+                                    0.0f,
+                                    0.0f, -60.0f, 6.0f, 1.0f, 50.0f, 100.0f}));
 
 }
 
@@ -333,7 +810,25 @@ void MyAudioProcessor::setCurrentProgram (int index)
         gainHighParam,
         preGainParam,
         postGainParam,
-        irParam
+        irParam,
+        latencyParam,
+        irTrimParam,
+        irMinPhaseParam,
+        irQualityParam,
+        cabDecimateParam,
+        stereoModeParam,
+        fftBackendParam,
+        toneStackParam,
+        bassParam,
+        midParam,
+        trebleParam,
+        ampStageParam,
+        gateParam,
+        gateThresholdParam,
+        gateHysteresisParam,
+        gateAttackParam,
+        gateHoldParam,
+        gateReleaseParam
     };
     
     const Preset& preset = presets[(unsigned int)index];
@@ -347,3 +842,27 @@ void MyAudioProcessor::setCurrentProgram (int index)
 }
 
 //==============================================================================
+
+//==============================================================================
+// Estado do plugin: parametros e caminho do modelo capturado (propriedade da arvore)
+//------------------------------------------------------------------------------
+// Retorna configuracao atual, com presets, para host capaz de salvar configuracoes, como uma DAW
+void MyAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    copyXmlToBinary(*apvts.copyState().createXml(), destData);
+}
+
+// Restaura configuracoes salvas. O modelo e lido do arquivo depois, na thread de mensagens
+void MyAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    std::unique_ptr<juce::XmlElement> xml(getXmlFromBinary(data, sizeInBytes));
+
+    if (xml.get() != nullptr && xml->hasTagName(apvts.state.getType())) {
+        apvts.replaceState(juce::ValueTree::fromXml(*xml));
+        parametersChanged.store(true);
+        ampModelChanged.store(true);
+        triggerAsyncUpdate();
+    }
+}
+
+//==============================================================================
@@ -18,7 +18,18 @@
 #include <cmath>
 #include <functional>
 
-#include "Preset.h"
+#include "dsp_core/Preset.h"
+#include "dsp_core/Denormals.h"
+#include "dsp_core/NoiseGate.h"
+#include "dsp_core/Biquad.h"
+#include "dsp_core/Waveshaper.h"
+#include "dsp_core/Smoother.h"
+#include "dsp_core/NeuralAmp.h"
+#include "dsp_core/TriodePreamp.h"
+#include "dsp_core/ToneStack.h"
+#include "dsp_core/Convolution.h"
+#include "dsp_core/Trace.h"
+#include "dsp_core/Profiler.h"
 
 // TODO: Namespace onde os parametros do plugin sao declarados
 // Para adicionar um parametro, adicionar uma nova linha PARAMETER_ID(<nome_parametro>)
@@ -38,10 +49,28 @@ namespace ParamID {
     PARAMETER_ID(pre_gain)
     PARAMETER_ID(post_gain)
     PARAMETER_ID(ir)
+    PARAMETER_ID(latency)   // orcamento de latencia da convolucao (ver dsp_core/Convolution.h)
+    PARAMETER_ID(ir_trim)   // corte da cauda da IR por energia (ver dsp_core/ImpulseResponse.h)
+    PARAMETER_ID(ir_min_phase)
+    PARAMETER_ID(ir_quality)    // conversao de taxa da IR
+    PARAMETER_ID(cab_decimate)  // convolucao da caixa em taxa interna reduzida
+    PARAMETER_ID(stereo_mode)   // roteamento da convolucao (ver dsp_core/PartitionedConvolution.h)
+    PARAMETER_ID(fft_backend)   // implementacao da FFT da convolucao (ver dsp_core/Fft.h)
+    PARAMETER_ID(tone_stack)    // tone stack passivo depois da saturacao (ver dsp_core/ToneStack.h)
+    PARAMETER_ID(bass)
+    PARAMETER_ID(mid)
+    PARAMETER_ID(treble)
+    PARAMETER_ID(amp_stage)     // saturacao, modelo capturado ou valvula (ver dsp_core/NeuralAmp.h e TriodePreamp.h)
+    PARAMETER_ID(gate)          // noise gate na entrada (ver dsp_core/NoiseGate.h)
+    PARAMETER_ID(gate_threshold)
+    PARAMETER_ID(gate_hysteresis)
+    PARAMETER_ID(gate_attack)
+    PARAMETER_ID(gate_hold)
+    PARAMETER_ID(gate_release)
     #undef PARAMETER_ID
 }
 
-class MyAudioProcessor : public juce::AudioProcessor, private juce::ValueTree::Listener
+class MyAudioProcessor : public juce::AudioProcessor, private juce::ValueTree::Listener, private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -110,6 +139,41 @@ public:
     float gain_low_;
     float gain_mid_;
     float gain_high_;
+
+    // Tone stack: topologia (0 = desligado, 1 = conforme a IR) e botoes de 0 a 10
+    int tone_stack_;
+    float bass_;
+    float mid_;
+    float treble_;
+
+    // Estagio de amplificador: 0 = waveshaper, 1 = modelo capturado (se houver um carregado),
+    // 2 = valvula em WDF
+    int amp_stage_;
+
+    // Noise gate: limiar (dBFS), histerese (dB) e tempos (ms)
+    bool gate_;
+    float gate_threshold_;
+    float gate_hysteresis_;
+    float gate_attack_;
+    float gate_hold_;
+    float gate_release_;
+
+    //==============================================================================
+    // Custo de CPU por estagio (ver dsp_core/Profiler.h), lido pelo editor: o gate e
+    // depois os estagios de filterChain
+    //------------------------------------------------------------------------------
+    static constexpr int numStages = 9;
+    static const char* getStageName(int stage) noexcept;
+    dsp_core::StageProfiler::Snapshot getStageProfile(int stage) const noexcept;
+    //==============================================================================
+
+    //==============================================================================
+    // Modelo capturado do amplificador (ver dsp_core/NeuralAmp.h). Thread de mensagens.
+    // O caminho do arquivo e salvo no estado do plugin
+    //------------------------------------------------------------------------------
+    bool loadAmpModel(const juce::File& file, juce::String& error);
+    juce::String getAmpModelDescription() const;
+    //==============================================================================
 private:
     //==============================================================================
     // Gestao de parametros
@@ -122,9 +186,13 @@ private:
     int currentProgram;
     // Indica se algum parametro mudou
     std::atomic<bool> parametersChanged { false };   
+    // Registro de eventos da thread de audio (ver dsp_core/Trace.h)
+    dsp_core::Trace trace;
     
     // Indica se IR mudou
     std::atomic<bool> irChanged { false };    
+    // Indica se o estado restaurado pede outro modelo de amplificador
+    std::atomic<bool> ampModelChanged { false };
 
     void valueTreePropertyChanged(juce::ValueTree&, const juce::Identifier&) override;
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
@@ -138,20 +206,33 @@ private:
     //==============================================================================
     // TODO: Detalhes especificos deste plugin
     //------------------------------------------------------------------------------
-    juce::dsp::ProcessorChain<
-        juce::dsp::IIR::Filter<float>,
-        juce::dsp::IIR::Filter<float>,
-        juce::dsp::IIR::Filter<float>,
-        juce::dsp::Gain<float>,
-        juce::dsp::WaveShaper<float>,
-        juce::dsp::Gain<float>,
-        juce::dsp::Convolution> filterChain;
+    // EQ (low shelf, mid peak, high shelf) -> pre-ganho -> saturacao, modelo capturado ou
+    // valvula -> tone stack -> pos-ganho -> IR, com o tempo de cada estagio medido a cada bloco
+    dsp_core::ProfiledChain<
+        dsp_core::BiquadCascade<float, 3>,
+        dsp_core::SmoothedGain<float>,
+        dsp_core::Waveshaper<float, dsp_core::SoftClip<float>>,
+        dsp_core::NeuralAmp,
+        dsp_core::TriodePreamp,
+        dsp_core::ToneStack<float>,
+        dsp_core::SmoothedGain<float>,
+        dsp_core::Convolution> filterChain;
 
     juce::HeapBlock<juce::AudioBuffer<float>> IRBlock[3];
 
-    juce::dsp::IIR::Coefficients<float>::Ptr lowShelfCoeff;
-    juce::dsp::IIR::Coefficients<float>::Ptr midPeakCoeff;
-    juce::dsp::IIR::Coefficients<float>::Ptr highShelfCoeff;
+    // Noise gate antes da cadeia, fora de filterChain: o bypass dos estagios depende do
+    // estado do gate no bloco atual. Tem o proprio profiler
+    dsp_core::NoiseGate<float> gate;
+    dsp_core::StageProfiler gateProfiler;
+
+    // Amostras de silencio na saida do EQ depois das quais a saida da cadeia e silencio
+    // (cauda da caixa mais uma margem para os estagios seguintes). -1 enquanto nao se sabe
+    // a cauda
+    std::atomic<int> idleAfterSamples { -1 };
+
+    // Silencio exato na saida do EQ ate o bloco atual e cadeia parada (thread de audio)
+    juce::int64 silentSamples = 0;
+    bool idle = false;
 
     // Parametro para definir frequencia
     juce::AudioParameterFloat* freqLowParam;
@@ -173,14 +254,71 @@ private:
     juce::AudioParameterChoice* irParam;
     unsigned int irIndex;
 
+    juce::AudioParameterChoice* latencyParam;
+    std::atomic<int> latencyBudget { 0 };
+
+    // Preparo da IR. A IR e recarregada (fora da thread de audio) quando muda
+    juce::AudioParameterChoice* irTrimParam;
+    juce::AudioParameterBool* irMinPhaseParam;
+    juce::AudioParameterChoice* irQualityParam;
+    int irTrimIndex = -1;
+    bool irMinPhase = false;
+    int irQuality = -1;
+
+    // Taxa interna reduzida da convolucao. O motor e recriado (fora da thread de audio) quando muda
+    juce::AudioParameterBool* cabDecimateParam;
+    std::atomic<bool> cabDecimate { true };
+
+    // Modo estereo da convolucao. Tambem recria o motor fora da thread de audio
+    juce::AudioParameterChoice* stereoModeParam;
+    std::atomic<int> stereoMode { (int)dsp_core::ConvolutionMode::stereo };
+
+    // FFT da convolucao. Tambem recria o motor fora da thread de audio
+    juce::AudioParameterChoice* fftBackendParam;
+    std::atomic<int> fftBackend { (int)dsp_core::FftBackend::automatic };
+
+    // Tone stack. Os coeficientes vem de tabelas por topologia e taxa, entao os botoes
+    // mudam na thread de audio sem alocacao
+    juce::AudioParameterChoice* toneStackParam;
+    juce::AudioParameterFloat* bassParam;
+    juce::AudioParameterFloat* midParam;
+    juce::AudioParameterFloat* trebleParam;
+
+    // Modelo capturado. O arquivo e lido e o modelo trocado na thread de mensagens
+    juce::AudioParameterChoice* ampStageParam;
+
+    juce::AudioParameterBool* gateParam;
+    juce::AudioParameterFloat* gateThresholdParam;
+    juce::AudioParameterFloat* gateHysteresisParam;
+    juce::AudioParameterFloat* gateAttackParam;
+    juce::AudioParameterFloat* gateHoldParam;
+    juce::AudioParameterFloat* gateReleaseParam;
+
     // Suavizador de trocas de parametros
     juce::LinearSmoothedValue<float> smoother;
 
     // Define coeficientes para todos os filtros
     void setCoeffs();
 
+    // Bypass dos estagios neutros e pre-ganho dobrado no EQ, a cada bloco. silentInput:
+    // a saida do EQ e zero no bloco inteiro (gate fechado no bloco todo e EQ sem cauda)
+    void updateStageBypass(bool silentInput);
+
+    // Topologia do tone stack para a escolha atual (e a IR, no modo auto)
+    dsp_core::ToneStackModel getToneStackModel() const noexcept;
+
     // Carrega IR
     void loadIR();
+
+    // Carrega o modelo salvo no estado (ou remove o atual, se nao houver)
+    void loadSavedAmpModel();
+
+    // Latencia informada ao host (caixa mais o oversampling da valvula, quando em uso) e
+    // tempo de gate fechado ate a cadeia parar
+    void updateLatency();
+
+    // Troca de IR, de orcamento de latencia e de modelo, fora da thread de audio
+    void handleAsyncUpdate() override;
     
     //==============================================================================
 
@@ -0,0 +1,38 @@
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+MyAudioProcessorEditor::MyAudioProcessorEditor (MyAudioProcessor& p)
+    : AudioProcessorEditor (&p), audioProcessor (p)
+{
+    const auto background = getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId);
+
+    // editor generico com os parametros do proprio rack (bypass de cada estagio)
+    tabs.addTab ("Rack", background, new juce::GenericAudioProcessorEditor (audioProcessor), true);
+
+    // editores dos plugins hospedados. As abas sao donas dos editores e os destroem
+    // junto com este editor
+    auto& graph = audioProcessor.getGraph();
+
+    for (RackGraph::NodeID id = 0; id < graph.getNumNodes(); ++id)
+        if (auto* editor = graph.getProcessor (id)->createEditorIfNeeded())
+            tabs.addTab (graph.getName (id), background, editor, true);
+
+    addAndMakeVisible (tabs);
+
+    // Define o tamanho do editor
+    setSize (600, 540);
+}
+
+MyAudioProcessorEditor::~MyAudioProcessorEditor() {}
+
+void MyAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    // Preenche a tela com uma cor solida
+    g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
+}
+
+// Funcao em que sao definidas posicoes customizadas dos elementos
+void MyAudioProcessorEditor::resized()
+{
+    tabs.setBounds (getLocalBounds());
+}
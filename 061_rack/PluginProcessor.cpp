@@ -0,0 +1,265 @@
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+// get/setStateInformation guardam tambem o estado dos plugins hospedados
+#define PLUGIN_CUSTOM_STATE
+#include "dsp_core/PluginCommon.h"
+
+// TODO: Quantidade de parametros
+const long unsigned int NUM_PARAMS = 6;
+
+//==============================================================================
+// Construtor e destrutor
+//------------------------------------------------------------------------------
+MyAudioProcessor::MyAudioProcessor()
+    : AudioProcessor (BusesProperties()
+        //TODO: Define se plugin mono ou stereo
+        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+        .withOutput ("Output", juce::AudioChannelSet::stereo(), true))
+{
+    //TODO: inicializacao dos parametros do plugin
+    saturacaoNode = graph.addNode(std::unique_ptr<juce::AudioProcessor>(createSaturacaoProcessor()), "Saturacao");
+    eqNode = graph.addNode(std::unique_ptr<juce::AudioProcessor>(createEq4BandProcessor()), "EQ");
+    delayNode = graph.addNode(std::unique_ptr<juce::AudioProcessor>(createDelayProcessor()), "Delay");
+    reverbNode = graph.addNode(std::unique_ptr<juce::AudioProcessor>(createConvReverbProcessor()), "Reverb");
+
+    // um no que muda de latencia (ex.: orcamento do reverb na aba dele) refaz a
+    // compensacao dos ramos e a latencia informada ao host, na thread de mensagens
+    graph.onLatencyChange = [this] { triggerAsyncUpdate(); };
+
+    castParameter(apvts, ParamID::bypassSaturacao, bypassSaturacaoParam);
+    castParameter(apvts, ParamID::bypassEq, bypassEqParam);
+    castParameter(apvts, ParamID::bypassDelay, bypassDelayParam);
+    castParameter(apvts, ParamID::bypassReverb, bypassReverbParam);
+    castParameter(apvts, ParamID::routing, routingParam);
+    castParameter(apvts, ParamID::parallel, parallelParam);
+
+    applyRouting();
+
+    apvts.state.addListener(this);
+
+    createPrograms();
+    setCurrentProgram(0);
+}
+
+MyAudioProcessor::~MyAudioProcessor()
+{
+    cancelPendingUpdate();
+    apvts.state.removeListener(this);
+}
+//==============================================================================
+
+//==============================================================================
+// Funcoes de processamento de audio
+//------------------------------------------------------------------------------
+
+// TODO: funcao que roda logo ANTES de começar a processar
+void MyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock) {
+    // Prepara os plugins hospedados e aloca o pool de buffers do grafo. O roteamento e
+    // aplicado aqui tambem para valer sem thread de mensagens (ferramentas offline)
+    applyRouting();
+    graph.prepare(sampleRate, samplesPerBlock);
+    setLatencySamples(graph.getLatencySamples());
+
+    parametersChanged.store(true);
+}
+
+// TODO: funcao que processa audio em loop - AUDIO THREAD!!!
+void MyAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    // ativa FTZ/DAZ na thread de audio (ver dsp_core/Denormals.h). O modo da CPU so e
+    // alterado na primeira vez, em vez de ser trocado e restaurado a cada bloco
+    dsp_core::disableDenormals();
+
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear (i, 0, buffer.getNumSamples());
+
+    // Cada plugin hospedado processa o bloco na ordem do grafo, com os ramos paralelos
+    // em threads de trabalho quando o parametro parallel esta ligado (ver RackGraph.h)
+    graph.process(buffer, midiMessages);
+
+    //variavel parametersChanged muda pelo evento valueTreePropertyChanged que executa na thread de UI
+    bool expected = true;
+    if (parametersChanged.compare_exchange_strong(expected, false)) {
+        update();
+    }
+}
+
+// chamada logo DEPOIS de processar
+void MyAudioProcessor::releaseResources()
+{
+    graph.release();
+}
+
+// Repassa o modo offline para os plugins hospedados
+void MyAudioProcessor::setNonRealtime(bool isNonRealtime) noexcept
+{
+    AudioProcessor::setNonRealtime(isNonRealtime);
+    graph.setNonRealtime(isNonRealtime);
+}
+
+// TODO: atualiza parametros - AUDIO THREAD!!!
+void MyAudioProcessor::update() {
+    graph.setBypassed(saturacaoNode, bypassSaturacaoParam->get());
+    graph.setBypassed(eqNode, bypassEqParam->get());
+    graph.setBypassed(delayNode, bypassDelayParam->get());
+    graph.setBypassed(reverbNode, bypassReverbParam->get());
+    graph.setParallel(parallelParam->get());
+
+    // troca de roteamento: o grafo e reconstruido na thread de mensagens
+    if (routingParam->getIndex() != currentRouting.load())
+        triggerAsyncUpdate();
+}
+
+// Conecta os nos conforme o parametro routing e reconstroi o roteiro do grafo (fora da
+// thread de audio)
+void MyAudioProcessor::applyRouting()
+{
+    const int routing = routingParam->getIndex();
+
+    if (routing == currentRouting.load())
+        return;
+
+    graph.disconnectAll();
+    graph.connect(RackGraph::inputNode, saturacaoNode);
+    graph.connect(saturacaoNode, eqNode);
+
+    if (routing == 0)
+    {
+        graph.connect(eqNode, delayNode);
+        graph.connect(delayNode, reverbNode);
+        graph.connect(reverbNode, RackGraph::outputNode);
+    }
+    else
+    {
+        graph.connect(eqNode, delayNode);
+        graph.connect(eqNode, reverbNode);
+        graph.connect(delayNode, RackGraph::outputNode);
+        graph.connect(reverbNode, RackGraph::outputNode);
+    }
+
+    graph.rebuild();
+    currentRouting.store(routing);
+}
+
+void MyAudioProcessor::handleAsyncUpdate()
+{
+    applyRouting();
+    graph.updateLatencies();
+    setLatencySamples(graph.getLatencySamples());
+}
+
+//==============================================================================
+// Gestao de parametros
+//------------------------------------------------------------------------------
+// TODO: Cria parametros e adiciona em layout
+juce::AudioProcessorValueTreeState::ParameterLayout MyAudioProcessor::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(ParamID::bypassSaturacao, "Bypass Saturacao", false));
+    layout.add(std::make_unique<juce::AudioParameterBool>(ParamID::bypassEq, "Bypass EQ", false));
+    layout.add(std::make_unique<juce::AudioParameterBool>(ParamID::bypassDelay, "Bypass Delay", false));
+    layout.add(std::make_unique<juce::AudioParameterBool>(ParamID::bypassReverb, "Bypass Reverb", false));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(ParamID::routing, "Roteamento", juce::StringArray { "serie", "paralelo" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterBool>(ParamID::parallel, "Processamento paralelo", false));
+
+    return layout;
+}
+
+//==============================================================================
+// Controle de GUI
+//------------------------------------------------------------------------------
+// Cria editor com uma aba para o rack e uma para cada plugin hospedado
+juce::AudioProcessorEditor* MyAudioProcessor::createEditor()
+{
+    return new MyAudioProcessorEditor(*this);
+}
+//==============================================================================
+
+//==============================================================================
+// Gestao de presets (somente funcoes que variam por plugin. Ver dsp_core/PluginCommon.h)
+//------------------------------------------------------------------------------
+
+// TODO: Cria presets iniciais. Valores: bypass de saturacao, EQ, delay e reverb,
+// roteamento (0 serie, 1 paralelo) e processamento paralelo
+void MyAudioProcessor::createPrograms()
+{
+    presets.emplace_back(Preset("full chain", {0, 0, 0, 0, 0, 0}));
+    presets.emplace_back(Preset("saturacao + eq", {0, 0, 1, 1, 0, 0}));
+    presets.emplace_back(Preset("delay + reverb", {1, 1, 0, 0, 0, 0}));
+    presets.emplace_back(Preset("parallel sends", {0, 0, 0, 0, 1, 1}));
+}
+
+// TODO: Define preset atual
+void MyAudioProcessor::setCurrentProgram (int index)
+{
+    currentProgram = index;
+
+    juce::RangedAudioParameter *params[NUM_PARAMS] = {
+        bypassSaturacaoParam,
+        bypassEqParam,
+        bypassDelayParam,
+        bypassReverbParam,
+        routingParam,
+        parallelParam
+    };
+
+    const Preset& preset = presets[(unsigned int)index];
+
+    for (long unsigned int i = 0; i < NUM_PARAMS; ++i)
+    {
+        params[i]->setValueNotifyingHost(params[i]->convertTo0to1(preset.param[i]));
+    }
+
+    reset();
+}
+
+// Estado do rack: parametros proprios mais um elemento <Node> por plugin hospedado,
+// com o estado binario do plugin em base64
+void MyAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    auto xml = apvts.copyState().createXml();
+
+    for (RackGraph::NodeID id = 0; id < graph.getNumNodes(); ++id)
+    {
+        juce::MemoryBlock nodeState;
+        graph.getProcessor(id)->getStateInformation(nodeState);
+
+        auto* node = xml->createNewChildElement("Node");
+        node->setAttribute("name", graph.getName(id));
+        node->addTextElement(nodeState.toBase64Encoding());
+    }
+
+    copyXmlToBinary(*xml, destData);
+}
+
+// Restaura configuracoes salvas
+void MyAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    std::unique_ptr<juce::XmlElement> xml(getXmlFromBinary(data, sizeInBytes));
+
+    if (xml.get() == nullptr || ! xml->hasTagName(apvts.state.getType()))
+        return;
+
+    // estados dos plugins hospedados, identificados pelo nome do no
+    for (RackGraph::NodeID id = 0; id < graph.getNumNodes(); ++id)
+    {
+        if (auto* node = xml->getChildByAttribute("name", graph.getName(id)))
+        {
+            juce::MemoryBlock nodeState;
+
+            if (nodeState.fromBase64Encoding(node->getAllSubText()))
+                graph.getProcessor(id)->setStateInformation(nodeState.getData(), (int)nodeState.getSize());
+        }
+    }
+
+    xml->deleteAllChildElementsWithTagName("Node");
+    apvts.replaceState(juce::ValueTree::fromXml(*xml));
+    parametersChanged.store(true);
+}
+
+//==============================================================================
@@ -0,0 +1,149 @@
+//==============================================================================
+// PluginProcessor.h: definicao do PluginProcessor
+//==============================================================================
+
+#pragma once
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Woverloaded-virtual=1"
+#endif
+
+#define _USE_MATH_DEFINES
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <atomic>
+#include <vector>
+#include <cmath>
+
+#include "dsp_core/Preset.h"
+#include "dsp_core/Denormals.h"
+#include "RackGraph.h"
+
+// TODO: Namespace onde os parametros do plugin sao declarados
+// Para adicionar um parametro, adicionar uma nova linha PARAMETER_ID(<nome_parametro>)
+// dentro do bloco #define/#undef
+
+namespace ParamID {
+    #define PARAMETER_ID(str) const juce::ParameterID str(#str, 1);
+    PARAMETER_ID(bypassSaturacao)   // desliga o estagio de saturacao (021)
+    PARAMETER_ID(bypassEq)          // desliga o EQ de 4 bandas (042)
+    PARAMETER_ID(bypassDelay)       // desliga o delay (031)
+    PARAMETER_ID(bypassReverb)      // desliga o reverb por convolucao (051)
+    PARAMETER_ID(routing)           // serie ou delay e reverb em paralelo depois do EQ
+    PARAMETER_ID(parallel)          // ramos paralelos em threads de trabalho
+    #undef PARAMETER_ID
+}
+
+//==============================================================================
+// Fabricas dos plugins hospedados. Cada plugin e compilado neste projeto com
+// MyAudioProcessor e createPluginFilter renomeados (ver CMakeLists.txt)
+juce::AudioProcessor* JUCE_CALLTYPE createSaturacaoProcessor();
+juce::AudioProcessor* JUCE_CALLTYPE createEq4BandProcessor();
+juce::AudioProcessor* JUCE_CALLTYPE createDelayProcessor();
+juce::AudioProcessor* JUCE_CALLTYPE createConvReverbProcessor();
+
+class MyAudioProcessor : public juce::AudioProcessor, private juce::ValueTree::Listener, private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    // Construtor e destrutor
+    //------------------------------------------------------------------------------
+    MyAudioProcessor();
+    ~MyAudioProcessor() override;
+    //==============================================================================
+
+    //==============================================================================
+    // Funcoes de processamento de audio
+    //------------------------------------------------------------------------------
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void releaseResources() override;
+    double getTailLengthSeconds() const override;
+    void setNonRealtime(bool isNonRealtime) noexcept override;
+    //==============================================================================
+
+    //==============================================================================
+    // Controle de GUI
+    //------------------------------------------------------------------------------
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+    //==============================================================================
+
+    //==============================================================================
+    // Gestao de presets
+    //------------------------------------------------------------------------------
+    const juce::String getName() const override;
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram (int index) override;
+    const juce::String getProgramName (int index) override;
+    void changeProgramName (int index, const juce::String& newName) override;
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+    //==============================================================================
+
+    //==============================================================================
+    // Configuracoes de MIDI e barramentos (nao vamos usar)
+    //------------------------------------------------------------------------------
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+    //==============================================================================
+
+    //==============================================================================
+    // Grafo com os plugins hospedados (o editor mostra o editor de cada no)
+    //------------------------------------------------------------------------------
+    RackGraph& getGraph() noexcept { return graph; }
+
+private:
+    //==============================================================================
+    // Gestao de parametros
+    //------------------------------------------------------------------------------
+    // Arvore de parametros
+    juce::AudioProcessorValueTreeState apvts { *this, nullptr, "Parameters", createParameterLayout() };
+    // Lista de presets
+    std::vector<Preset> presets;
+    // Indice do preset atual
+    int currentProgram;
+    // Indica se algum parametro mudou
+    std::atomic<bool> parametersChanged { false };    
+
+    void valueTreePropertyChanged(juce::ValueTree&, const juce::Identifier&) override;
+    juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    void update();
+    void createPrograms();
+
+    template<typename T>
+    inline static void castParameter(juce::AudioProcessorValueTreeState& apvts, const juce::ParameterID& id, T& destination);
+    //==============================================================================
+
+    //==============================================================================
+    // TODO: Detalhes especificos deste plugin
+    //------------------------------------------------------------------------------
+    // Roteamentos (parametro routing):
+    //   serie:    saturacao -> EQ -> delay -> reverb
+    //   paralelo: saturacao -> EQ -> (delay | reverb), com a saida dos dois misturada
+    RackGraph graph;
+
+    RackGraph::NodeID saturacaoNode;
+    RackGraph::NodeID eqNode;
+    RackGraph::NodeID delayNode;
+    RackGraph::NodeID reverbNode;
+
+    juce::AudioParameterBool* bypassSaturacaoParam;
+    juce::AudioParameterBool* bypassEqParam;
+    juce::AudioParameterBool* bypassDelayParam;
+    juce::AudioParameterBool* bypassReverbParam;
+    juce::AudioParameterChoice* routingParam;
+    juce::AudioParameterBool* parallelParam;
+
+    // Roteamento aplicado ao grafo (-1: nenhum). Trocar conexoes aloca memoria, entao a
+    // troca e feita na thread de mensagens (handleAsyncUpdate)
+    std::atomic<int> currentRouting { -1 };
+    void applyRouting();
+    void handleAsyncUpdate() override;
+    //==============================================================================
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MyAudioProcessor)
+};
@@ -0,0 +1,695 @@
+#include "RackGraph.h"
+
+#include <algorithm>
+#include <thread>
+
+//==============================================================================
+// Thread de trabalho do modo paralelo: dorme ate a thread de audio abrir um bloco e
+// entao ajuda a processar os passos prontos
+//------------------------------------------------------------------------------
+class RackGraph::Worker : public juce::Thread
+{
+public:
+    Worker(RackGraph& owner, int index)
+        : juce::Thread("RackGraph worker " + juce::String(index)), graph(owner) {}
+
+    void wake() noexcept { wakeUp.signal(); }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            wakeUp.wait(-1);
+
+            if (threadShouldExit())
+                break;
+
+            graph.helpWithBlock();
+        }
+    }
+
+private:
+    RackGraph& graph;
+    juce::WaitableEvent wakeUp;
+};
+
+//==============================================================================
+// Compensacao de latencia: atrasa source em delay amostras (o tamanho da linha) e
+// escreve ou soma em destination. source e destination podem ser o mesmo buffer
+//------------------------------------------------------------------------------
+static void delayInto(dsp_core::DelayLine<float>& line, const float* const* source, float* const* destination,
+                      int numChannels, int numSamples, bool accumulate) noexcept
+{
+    const int length = line.getLength();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const float* in = source[channel];
+        float* out = destination[channel];
+        float* data = line.getChannel(channel);
+        int position = line.getWritePosition();
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float delayed = data[position];
+            data[position] = in[i];
+            out[i] = accumulate ? out[i] + delayed : delayed;
+
+            if (++position >= length)
+                position = 0;
+        }
+    }
+
+    line.advance(numSamples);
+}
+
+RackGraph::RackGraph() = default;
+
+RackGraph::~RackGraph()
+{
+    stopWorkers();
+
+    for (auto& node : nodes)
+        node->processor->removeListener(this);
+}
+
+//==============================================================================
+// Construcao do grafo
+//------------------------------------------------------------------------------
+RackGraph::NodeID RackGraph::addNode(std::unique_ptr<juce::AudioProcessor> processor, const juce::String& name)
+{
+    auto node = std::make_unique<Node>();
+    node->name = name;
+    node->processor = std::move(processor);
+    node->processor->addListener(this);
+    nodes.push_back(std::move(node));
+    return (NodeID)nodes.size() - 1;
+}
+
+// Conecta a saida de source a entrada de destination. Conexoes repetidas sao ignoradas
+bool RackGraph::connect(NodeID source, NodeID destination)
+{
+    const bool validSource = source == inputNode || (source >= 0 && source < getNumNodes());
+    const bool validDestination = destination == outputNode || (destination >= 0 && destination < getNumNodes());
+
+    if (! validSource || ! validDestination || source == destination)
+        return false;
+
+    auto& inputs = destination == outputNode ? outputInputs : nodes[(size_t)destination]->inputs;
+
+    if (std::find(inputs.begin(), inputs.end(), source) == inputs.end())
+        inputs.push_back(source);
+
+    return true;
+}
+
+void RackGraph::disconnectAll()
+{
+    for (auto& node : nodes)
+        node->inputs.clear();
+
+    outputInputs.clear();
+}
+
+bool RackGraph::rebuild()
+{
+    const int numNodes = getNumNodes();
+
+    // indice de um produtor de audio (no ou entrada do grafo) nos vetores abaixo
+    auto slot = [numNodes](NodeID id) { return (size_t)(id == inputNode ? numNodes : id); };
+
+    //------------------------------------------------------------------------------
+    // ordem topologica: um no entra na ordem quando todas as suas entradas ja entraram
+    std::vector<NodeID> order;
+    std::vector<bool> scheduled((size_t)numNodes + 1, false);
+    scheduled[slot(inputNode)] = true;
+
+    while ((int)order.size() < numNodes)
+    {
+        bool progress = false;
+
+        for (NodeID id = 0; id < numNodes; ++id)
+        {
+            const auto& inputs = nodes[(size_t)id]->inputs;
+
+            if (! scheduled[slot(id)]
+                && std::all_of(inputs.begin(), inputs.end(), [&](NodeID input) { return scheduled[slot(input)]; }))
+            {
+                order.push_back(id);
+                scheduled[slot(id)] = true;
+                progress = true;
+            }
+        }
+
+        if (! progress)
+            return false; // ciclo
+    }
+
+    // latencias lidas uma vez: o roteiro fica coerente mesmo se um no mudar no meio
+    std::vector<int> newLatencies;
+
+    for (const auto& node : nodes)
+        newLatencies.push_back(node->processor->getLatencySamples());
+
+    //------------------------------------------------------------------------------
+    // ancestrais: ancestor[a][b] indica que b depende (direta ou indiretamente) de a. A
+    // entrada do grafo esta pronta antes do bloco e vale como ancestral de todos
+    std::vector<std::vector<bool>> ancestor((size_t)numNodes, std::vector<bool>((size_t)numNodes, false));
+
+    for (auto id : order)
+        for (auto input : nodes[(size_t)id]->inputs)
+        {
+            if (input == inputNode)
+                continue;
+
+            ancestor[(size_t)input][(size_t)id] = true;
+
+            for (NodeID a = 0; a < numNodes; ++a)
+                if (ancestor[(size_t)a][(size_t)input])
+                    ancestor[(size_t)a][(size_t)id] = true;
+        }
+
+    auto runsBefore = [&](NodeID a, NodeID b) { return a == inputNode || ancestor[(size_t)a][(size_t)b]; };
+
+    // leitores de cada produtor
+    std::vector<std::vector<NodeID>> readers((size_t)numNodes + 1);
+    std::vector<bool> readByOutput((size_t)numNodes + 1, false);
+
+    for (auto id : order)
+        for (auto input : nodes[(size_t)id]->inputs)
+            readers[slot(input)].push_back(id);
+
+    for (auto input : outputInputs)
+        readByOutput[slot(input)] = true;
+
+    //------------------------------------------------------------------------------
+    // atribuicao de buffers. Um buffer esta vivo enquanto o valor do seu produtor ainda
+    // sera lido; users sao os nos que escreveram ou leram esse valor. Um buffer livre so
+    // e entregue a um no que roda depois de todos os seus users
+    struct BufferState
+    {
+        bool live = false;
+        std::vector<NodeID> users;
+    };
+
+    std::vector<BufferState> buffers(1);
+    std::vector<int> bufferOf((size_t)numNodes + 1, -1);
+    std::vector<int> pendingReaders((size_t)numNodes + 1, 0);
+
+    for (size_t i = 0; i < readers.size(); ++i)
+        pendingReaders[i] = (int)readers[i].size();
+
+    bufferOf[slot(inputNode)] = hostBuffer;
+    buffers[hostBuffer].live = pendingReaders[slot(inputNode)] > 0 || readByOutput[slot(inputNode)];
+    buffers[hostBuffer].users = { inputNode };
+
+    auto allocate = [&](NodeID id)
+    {
+        for (size_t b = 0; b < buffers.size(); ++b)
+            if (! buffers[b].live
+                && std::all_of(buffers[b].users.begin(), buffers[b].users.end(),
+                               [&](NodeID user) { return runsBefore(user, id); }))
+                return (int)b;
+
+        buffers.emplace_back();
+        return (int)buffers.size() - 1;
+    };
+
+    std::vector<Step> newSchedule;
+    std::vector<int> nodeLatency((size_t)numNodes + 1, 0);
+    std::vector<int> stepOf((size_t)numNodes, -1);
+
+    // entradas de um passo com a compensacao de latencia: cada entrada e atrasada ate a
+    // latencia da entrada mais lenta. A entrada in-place (ou a copiada) vem primeiro
+    auto makeInputs = [&](Step& step, const std::vector<NodeID>& inputs, int first, Input::Mode firstMode)
+    {
+        int maxLatency = 0;
+
+        for (auto input : inputs)
+            maxLatency = juce::jmax(maxLatency, nodeLatency[slot(input)]);
+
+        std::vector<NodeID> ordered(inputs);
+        std::rotate(ordered.begin(), ordered.begin() + first, ordered.begin() + first + 1);
+
+        for (size_t i = 0; i < ordered.size(); ++i)
+        {
+            Input in;
+            in.buffer = bufferOf[slot(ordered[i])];
+            in.mode = i == 0 ? firstMode : Input::add;
+            in.delay = maxLatency - nodeLatency[slot(ordered[i])];
+
+            if (in.delay > 0)
+            {
+                in.compensation = std::make_unique<dsp_core::DelayLine<float>>();
+                in.compensation->prepare(numChannels, in.delay);
+            }
+
+            step.inputs.push_back(std::move(in));
+        }
+
+        return maxLatency;
+    };
+
+    for (auto id : order)
+    {
+        Node& node = *nodes[(size_t)id];
+        Step step;
+        step.node = &node;
+
+        // in-place no buffer de uma entrada que so e lida por este no e por ancestrais dele
+        const auto inPlace = std::find_if(node.inputs.begin(), node.inputs.end(), [&](NodeID input)
+        {
+            const auto& others = readers[slot(input)];
+            return ! readByOutput[slot(input)]
+                && std::all_of(others.begin(), others.end(),
+                               [&](NodeID reader) { return reader == id || runsBefore(reader, id); });
+        });
+
+        int inputLatency = 0;
+
+        if (node.inputs.empty())
+        {
+            step.target = allocate(id);
+            step.clear = true;
+        }
+        else if (inPlace != node.inputs.end())
+        {
+            step.target = bufferOf[slot(*inPlace)];
+            inputLatency = makeInputs(step, node.inputs, (int)(inPlace - node.inputs.begin()), Input::inPlace);
+        }
+        else
+        {
+            step.target = allocate(id);
+            inputLatency = makeInputs(step, node.inputs, 0, Input::copy);
+        }
+
+        for (auto input : node.inputs)
+        {
+            auto& buffer = buffers[(size_t)bufferOf[slot(input)]];
+            buffer.users.push_back(id);
+
+            if (--pendingReaders[slot(input)] == 0 && ! readByOutput[slot(input)])
+                buffer.live = false;
+        }
+
+        // o buffer do no passa a guardar a sua saida
+        auto& target = buffers[(size_t)step.target];
+        target.live = pendingReaders[slot(id)] > 0 || readByOutput[slot(id)];
+        target.users = { id };
+
+        bufferOf[slot(id)] = step.target;
+        nodeLatency[slot(id)] = inputLatency + newLatencies[(size_t)id];
+        stepOf[(size_t)id] = (int)newSchedule.size();
+
+        newSchedule.push_back(std::move(step));
+    }
+
+    // dependencias entre os passos dos nos
+    for (auto id : order)
+    {
+        auto& step = newSchedule[(size_t)stepOf[(size_t)id]];
+
+        for (auto input : nodes[(size_t)id]->inputs)
+        {
+            if (input == inputNode)
+                continue;
+
+            newSchedule[(size_t)stepOf[(size_t)input]].successors.push_back(stepOf[(size_t)id]);
+            ++step.numPredecessors;
+        }
+    }
+
+    std::vector<int> newRootSteps;
+
+    for (size_t i = 0; i < newSchedule.size(); ++i)
+        if (newSchedule[i].numPredecessors == 0)
+            newRootSteps.push_back((int)i);
+
+    // a ordem topologica e uma cadeia quando cada no depende do anterior; senao ha ramos
+    // que podem rodar ao mesmo tempo
+    bool newHasParallelBranches = false;
+
+    for (size_t i = 1; i < order.size(); ++i)
+        if (! ancestor[(size_t)order[i - 1]][(size_t)order[i]])
+            newHasParallelBranches = true;
+
+    //------------------------------------------------------------------------------
+    // passo da saida: roda depois de todos os nos e monta a saida no buffer do host.
+    // Neste ponto o buffer do host guarda uma das entradas da saida ou esta livre
+    Step output;
+    output.target = hostBuffer;
+    int newLatency = 0;
+
+    const auto hostInput = std::find_if(outputInputs.begin(), outputInputs.end(),
+                                        [&](NodeID input) { return bufferOf[slot(input)] == hostBuffer; });
+
+    if (outputInputs.empty())
+        output.clear = true;
+    else if (hostInput != outputInputs.end())
+        newLatency = makeInputs(output, outputInputs, (int)(hostInput - outputInputs.begin()), Input::inPlace);
+    else
+        newLatency = makeInputs(output, outputInputs, 0, Input::copy);
+
+    newSchedule.push_back(std::move(output));
+    builtLatencies.swap(newLatencies);
+
+    //------------------------------------------------------------------------------
+    // buffers do pool (o indice 0 e o buffer do host e fica vazio)
+    std::vector<juce::AudioBuffer<float>> newPool(buffers.size());
+    std::vector<std::array<float*, numChannels>> newPoolChannels(buffers.size());
+
+    for (size_t i = 1; i < newPool.size(); ++i)
+    {
+        newPool[i].setSize(numChannels, currentBlockSize);
+        newPool[i].clear();
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            newPoolChannels[i][(size_t)channel] = newPool[i].getWritePointer(channel);
+    }
+
+    const size_t numNodeSteps = newSchedule.size() - 1;
+    std::vector<std::atomic<int>> newPendingInputs(numNodeSteps);
+    std::vector<std::atomic<int>> newReadyList(numNodeSteps);
+
+    {
+        const juce::SpinLock::ScopedLockType lock(scheduleLock);
+        schedule.swap(newSchedule);
+        pool.swap(newPool);
+        poolChannels.swap(newPoolChannels);
+        rootSteps.swap(newRootSteps);
+        pendingInputs.swap(newPendingInputs);
+        readyList.swap(newReadyList);
+        hasParallelBranches = newHasParallelBranches;
+        latencySamples = newLatency;
+    }
+
+    return true;
+}
+
+bool RackGraph::updateLatencies()
+{
+    for (size_t i = 0; i < nodes.size(); ++i)
+        if (i >= builtLatencies.size() || nodes[i]->processor->getLatencySamples() != builtLatencies[i])
+            return rebuild();
+
+    return false;
+}
+
+// Os nos avisam a mudanca de latencia por updateHostDisplay, em qualquer thread
+void RackGraph::audioProcessorChanged(juce::AudioProcessor*, const ChangeDetails& details)
+{
+    if (details.latencyChanged && onLatencyChange != nullptr)
+        onLatencyChange();
+}
+
+//==============================================================================
+// Processamento
+//------------------------------------------------------------------------------
+void RackGraph::prepare(double sampleRate, int maximumBlockSize)
+{
+    stopWorkers();
+
+    currentSampleRate = sampleRate;
+    currentBlockSize = maximumBlockSize;
+
+    for (auto& node : nodes)
+    {
+        node->processor->setRateAndBufferSizeDetails(sampleRate, maximumBlockSize);
+        node->processor->prepareToPlay(sampleRate, maximumBlockSize);
+    }
+
+    // a latencia dos nos so e conhecida depois de prepareToPlay
+    rebuild();
+
+    // a thread de audio tambem processa, entao bastam nucleos - 1 threads de trabalho
+    startWorkers(juce::jmin(getNumNodes() - 1, juce::SystemStats::getNumCpus() - 1));
+}
+
+void RackGraph::release()
+{
+    stopWorkers();
+
+    for (auto& node : nodes)
+        node->processor->releaseResources();
+}
+
+void RackGraph::setNonRealtime(bool isNonRealtime)
+{
+    for (auto& node : nodes)
+        node->processor->setNonRealtime(isNonRealtime);
+}
+
+void RackGraph::startWorkers(int numWorkers)
+{
+    std::vector<std::unique_ptr<Worker>> newWorkers;
+
+    // a thread de audio espera pelos passos que uma thread de trabalho ja comecou: uma
+    // thread comum, preemptada no meio de um passo, atrasaria o bloco inteiro. Sem tempo
+    // real concedido, nenhuma thread de trabalho e criada e o grafo roda em serie
+    const auto options = juce::Thread::RealtimeOptions().withPriority(10)
+                                                        .withApproximateAudioProcessingTime(currentBlockSize, currentSampleRate);
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto worker = std::make_unique<Worker>(*this, i);
+
+        if (! worker->startRealtimeThread(options))
+            break;
+
+        newWorkers.push_back(std::move(worker));
+    }
+
+    const juce::SpinLock::ScopedLockType lock(scheduleLock);
+    workers.swap(newWorkers);
+}
+
+void RackGraph::stopWorkers()
+{
+    std::vector<std::unique_ptr<Worker>> oldWorkers;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(scheduleLock);
+        workers.swap(oldWorkers);
+    }
+
+    for (auto& worker : oldWorkers)
+    {
+        worker->signalThreadShouldExit();
+        worker->wake();
+        worker->stopThread(1000);
+    }
+}
+
+float* const* RackGraph::getChannels(int index) noexcept
+{
+    return index == hostBuffer ? hostChannels : poolChannels[(size_t)index].data();
+}
+
+void RackGraph::process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    const juce::SpinLock::ScopedTryLockType lock(scheduleLock);
+
+    if (! lock.isLocked())
+    {
+        buffer.clear();
+        return;
+    }
+
+    jassert(buffer.getNumSamples() <= currentBlockSize);
+
+    // estado do bloco, lido tambem pelas threads de trabalho
+    hostChannels = buffer.getArrayOfWritePointers();
+    blockChannels = juce::jmin(numChannels, buffer.getNumChannels());
+    blockSamples = buffer.getNumSamples();
+
+    const size_t numNodeSteps = schedule.size() - 1;
+
+    if (parallel.load(std::memory_order_relaxed) && hasParallelBranches && ! workers.empty())
+    {
+        processParallel();
+    }
+    else
+    {
+        for (size_t i = 0; i < numNodeSteps; ++i)
+            runStep(schedule[i], midiMessages);
+    }
+
+    // a saida e montada pela thread de audio depois que todos os nos terminaram
+    runStep(schedule.back(), midiMessages);
+}
+
+void RackGraph::runStep(Step& step, juce::MidiBuffer& midiMessages) noexcept
+{
+    float* const* target = getChannels(step.target);
+
+    // buffer que apenas aponta para os canais do host ou do pool (sem alocacao)
+    juce::AudioBuffer<float> audio(target, blockChannels, blockSamples);
+
+    if (step.clear)
+        audio.clear();
+
+    for (auto& input : step.inputs)
+    {
+        const float* const* source = getChannels(input.buffer);
+
+        if (input.compensation != nullptr)
+        {
+            delayInto(*input.compensation, source, target, blockChannels, blockSamples, input.mode == Input::add);
+            continue;
+        }
+
+        for (int channel = 0; channel < blockChannels; ++channel)
+        {
+            if (input.mode == Input::copy)
+                juce::FloatVectorOperations::copy(target[channel], source[channel], blockSamples);
+            else if (input.mode == Input::add)
+                juce::FloatVectorOperations::add(target[channel], source[channel], blockSamples);
+        }
+    }
+
+    // mistura das entradas com ganho igual
+    if (step.inputs.size() > 1)
+        audio.applyGain(1.0f / (float)step.inputs.size());
+
+    if (step.node == nullptr)
+        return;
+
+    if (step.node->bypassed.load(std::memory_order_relaxed))
+        step.node->processor->processBlockBypassed(audio, midiMessages);
+    else
+        step.node->processor->processBlock(audio, midiMessages);
+}
+
+//==============================================================================
+// Execucao paralela
+//------------------------------------------------------------------------------
+void RackGraph::processParallel() noexcept
+{
+    const size_t numNodeSteps = schedule.size() - 1;
+
+    for (size_t i = 0; i < numNodeSteps; ++i)
+    {
+        pendingInputs[i].store(schedule[i].numPredecessors, std::memory_order_relaxed);
+        readyList[i].store(-1, std::memory_order_relaxed);
+        schedule[i].midi.clear();
+    }
+
+    readyRead.store(0, std::memory_order_relaxed);
+    readyWrite.store(0, std::memory_order_relaxed);
+    stepsLeft.store((int)numNodeSteps, std::memory_order_relaxed);
+
+    for (auto index : rootSteps)
+        pushReady(index);
+
+    // abre o bloco (release: as threads de trabalho enxergam o estado acima) e acorda
+    // as threads, que se registram em workerState antes de tirar passos da lista
+    workerState.store(1, std::memory_order_release);
+
+    for (auto& worker : workers)
+        worker->wake();
+
+    runReadySteps(true);
+
+    // fecha o bloco e espera as threads que chegaram a entrar. Threads que acordarem
+    // depois encontram o bloco fechado e voltam a dormir
+    workerState.fetch_sub(1, std::memory_order_acq_rel);
+
+    while (workerState.load(std::memory_order_acquire) != 0)
+        ;
+}
+
+void RackGraph::helpWithBlock() noexcept
+{
+    int state = workerState.load(std::memory_order_acquire);
+
+    do
+    {
+        if ((state & 1) == 0)
+            return;
+    }
+    while (! workerState.compare_exchange_weak(state, state + 2, std::memory_order_acq_rel, std::memory_order_acquire));
+
+    runReadySteps(false);
+
+    workerState.fetch_sub(2, std::memory_order_release);
+}
+
+void RackGraph::runReadySteps(bool isAudioThread) noexcept
+{
+    while (stepsLeft.load(std::memory_order_acquire) > 0)
+    {
+        const int index = popReady();
+
+        if (index < 0)
+        {
+            // a thread de audio nao entrega o nucleo ao sistema enquanto espera
+            if (! isAudioThread)
+                std::this_thread::yield();
+
+            continue;
+        }
+
+        auto& step = schedule[(size_t)index];
+        runStep(step, step.midi);
+
+        // o ultimo predecessor a terminar libera o sucessor
+        for (auto successor : step.successors)
+            if (pendingInputs[(size_t)successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                pushReady(successor);
+
+        stepsLeft.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+// Cada passo entra na lista uma unica vez por bloco, entao a lista e um vetor com um
+// indice de escrita e um de leitura. Quem reserva uma posicao de leitura espera o
+// valor ser escrito, o que acontece logo depois da reserva da escrita
+void RackGraph::pushReady(int stepIndex) noexcept
+{
+    const int position = readyWrite.fetch_add(1, std::memory_order_acq_rel);
+    readyList[(size_t)position].store(stepIndex, std::memory_order_release);
+}
+
+int RackGraph::popReady() noexcept
+{
+    int position = readyRead.load(std::memory_order_acquire);
+
+    while (position < readyWrite.load(std::memory_order_acquire))
+    {
+        if (readyRead.compare_exchange_weak(position, position + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            int stepIndex;
+
+            while ((stepIndex = readyList[(size_t)position].load(std::memory_order_acquire)) < 0)
+                ;
+
+            return stepIndex;
+        }
+    }
+
+    return -1;
+}
+
+//==============================================================================
+// Acesso aos nos
+//------------------------------------------------------------------------------
+juce::AudioProcessor* RackGraph::getProcessor(NodeID id) const
+{
+    return id >= 0 && id < getNumNodes() ? nodes[(size_t)id]->processor.get() : nullptr;
+}
+
+juce::String RackGraph::getName(NodeID id) const
+{
+    return id >= 0 && id < getNumNodes() ? nodes[(size_t)id]->name : juce::String();
+}
+
+void RackGraph::setBypassed(NodeID id, bool shouldBeBypassed) noexcept
+{
+    if (id >= 0 && id < getNumNodes())
+        nodes[(size_t)id]->bypassed.store(shouldBeBypassed, std::memory_order_relaxed);
+}
+
+bool RackGraph::isBypassed(NodeID id) const noexcept
+{
+    return id >= 0 && id < getNumNodes() && nodes[(size_t)id]->bypassed.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,196 @@
+//==============================================================================
+// RackGraph.h: grafo de processadores (plugins) hospedados em uma unica instancia
+//==============================================================================
+
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "dsp_core/DelayLine.h"
+
+//==============================================================================
+// Os nos sao juce::AudioProcessor estereo e as conexoes formam um grafo aciclico
+// entre a entrada e a saida do rack. Entradas com mais de uma conexao sao misturadas
+// com ganho igual (media), para que ramos paralelos com dry proprio, como delay e
+// reverb, nao somem o sinal original varias vezes.
+//
+// rebuild() ordena os nos topologicamente e monta o roteiro de processamento: cada no
+// processa in-place no buffer da sua primeira entrada quando todos os outros leitores
+// dessa entrada sao ancestrais dele; senao recebe um buffer do pool. Um buffer so e
+// reaproveitado por um no que depende de todos os que o usaram, entao o mesmo roteiro
+// vale em serie e em paralelo. Uma cadeia em serie processa inteira no buffer do host,
+// sem copias.
+//
+// Compensacao de latencia: cada entrada de um no (e da saida) e atrasada ate a latencia
+// da entrada mais lenta, usando getLatencySamples() dos nos. getLatencySamples() do
+// grafo e a latencia do caminho mais longo. Um no pode mudar de latencia depois do
+// prepare (ex.: orcamento de latencia do 051): o grafo escuta os nos e avisa por
+// onLatencyChange, e updateLatencies() refaz o roteiro fora da thread de audio.
+//
+// Modo paralelo (setParallel): os nos cujas entradas ja estao prontas rodam ao mesmo
+// tempo em threads de trabalho de tempo real, com a thread de audio tambem processando
+// (e assumindo qualquer passo pronto que nenhuma outra thread comecou). Cada no tem
+// um contador atomico de entradas pendentes; o ultimo predecessor a terminar coloca o
+// no em uma lista de prontos sem lock, e a thread de audio espera (sem bloquear) o
+// contador de nos restantes chegar a zero antes de montar a saida. Como ela espera
+// pelos passos ja comecados, so threads de tempo real sao usadas: se o sistema nao as
+// conceder, o grafo roda em serie.
+//
+// Nos, conexoes, prepare() e rebuild() sao chamados fora da thread de audio. O roteiro
+// e trocado sob um SpinLock; se process() encontrar o lock ocupado, o bloco sai em
+// silencio
+class RackGraph : private juce::AudioProcessorListener
+{
+public:
+    using NodeID = int;
+
+    // Pontas do grafo: o audio do host entra por inputNode e sai por outputNode
+    static constexpr NodeID inputNode = -1;
+    static constexpr NodeID outputNode = -2;
+
+    static constexpr int numChannels = 2;
+
+    RackGraph();
+    ~RackGraph();
+
+    //------------------------------------------------------------------------------
+    // Construcao do grafo
+    NodeID addNode(std::unique_ptr<juce::AudioProcessor> processor, const juce::String& name);
+    bool connect(NodeID source, NodeID destination);
+    void disconnectAll();
+
+    // Recalcula ordem, buffers e latencia. Retorna false (e mantem o roteiro anterior)
+    // se as conexoes formarem um ciclo
+    bool rebuild();
+
+    //------------------------------------------------------------------------------
+    // Processamento
+    void prepare(double sampleRate, int maximumBlockSize);
+    void release();
+    void process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages);
+
+    // Latencia do caminho mais longo entre a entrada e a saida, em amostras
+    int getLatencySamples() const noexcept { return latencySamples; }
+
+    // Chamado quando um no informa outra latencia, na thread em que o no a mudou (pode
+    // ser a de audio): so deve agendar updateLatencies() na thread de mensagens
+    std::function<void()> onLatencyChange;
+
+    // Refaz o roteiro se a latencia de algum no mudou desde o ultimo rebuild(). Retorna
+    // true se refez. Fora da thread de audio
+    bool updateLatencies();
+
+    void setNonRealtime(bool isNonRealtime);
+
+    // Ramos independentes em threads de trabalho (pode ser chamado na thread de audio).
+    // As threads sao criadas em prepare(), uma a menos que o numero de nucleos
+    void setParallel(bool shouldRunInParallel) noexcept { parallel.store(shouldRunInParallel, std::memory_order_relaxed); }
+    bool isParallel() const noexcept { return parallel.load(std::memory_order_relaxed); }
+
+    //------------------------------------------------------------------------------
+    // Acesso aos nos
+    int getNumNodes() const noexcept { return (int)nodes.size(); }
+    juce::AudioProcessor* getProcessor(NodeID id) const;
+    juce::String getName(NodeID id) const;
+
+    // No em bypass: o sinal passa por processBlockBypassed (pode ser chamado na thread de audio)
+    void setBypassed(NodeID id, bool shouldBeBypassed) noexcept;
+    bool isBypassed(NodeID id) const noexcept;
+
+private:
+    struct Node
+    {
+        juce::String name;
+        std::unique_ptr<juce::AudioProcessor> processor;
+        std::vector<NodeID> inputs;
+        std::atomic<bool> bypassed { false };
+    };
+
+    // Entrada de um passo: o buffer lido e o atraso de compensacao de latencia
+    struct Input
+    {
+        enum Mode { inPlace, copy, add };
+
+        int buffer = 0;
+        Mode mode = add;
+        int delay = 0;
+        std::unique_ptr<dsp_core::DelayLine<float>> compensation; // so quando delay > 0
+    };
+
+    // Um passo do roteiro: monta as entradas no buffer target e processa o no. O ultimo
+    // passo (node == nullptr) monta a saida do grafo no buffer do host
+    struct Step
+    {
+        Node* node = nullptr;
+        int target = 0;
+        bool clear = false;                 // sem entradas
+        std::vector<Input> inputs;
+
+        std::vector<int> successors;        // passos que leem a saida deste
+        int numPredecessors = 0;            // passos dos quais este depende
+        juce::MidiBuffer midi;              // MIDI proprio no modo paralelo
+    };
+
+    class Worker;
+
+    // Buffer 0 e o buffer do host; os demais vem do pool
+    static constexpr int hostBuffer = 0;
+
+    float* const* getChannels(int index) noexcept;
+    void runStep(Step& step, juce::MidiBuffer& midiMessages) noexcept;
+
+    // Execucao paralela: a thread de audio e as de trabalho tiram passos da lista de
+    // prontos ate que todos os passos dos nos terminem
+    void processParallel() noexcept;
+    void helpWithBlock() noexcept;
+    void runReadySteps(bool isAudioThread) noexcept;
+    void pushReady(int stepIndex) noexcept;
+    int popReady() noexcept;
+
+    void startWorkers(int numWorkers);
+    void stopWorkers();
+
+    void audioProcessorParameterChanged(juce::AudioProcessor*, int, float) override {}
+    void audioProcessorChanged(juce::AudioProcessor*, const ChangeDetails& details) override;
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::vector<NodeID> outputInputs;
+    std::vector<int> builtLatencies;        // latencia de cada no no ultimo rebuild()
+
+    std::vector<Step> schedule;
+    std::vector<juce::AudioBuffer<float>> pool;
+    std::vector<std::array<float*, numChannels>> poolChannels;
+    std::vector<int> rootSteps;             // passos sem predecessores
+    bool hasParallelBranches = false;
+    juce::SpinLock scheduleLock;
+
+    // Estado do bloco em andamento (escrito pela thread de audio antes de liberar as
+    // threads de trabalho)
+    float* const* hostChannels = nullptr;
+    int blockChannels = 0;
+    int blockSamples = 0;
+
+    std::vector<std::atomic<int>> pendingInputs;    // por passo
+    std::vector<std::atomic<int>> readyList;        // indices de passos, -1 = ainda nao escrito
+    std::atomic<int> readyRead { 0 };
+    std::atomic<int> readyWrite { 0 };
+    std::atomic<int> stepsLeft { 0 };
+
+    // bit 0: bloco aberto para as threads de trabalho; demais bits: 2 * threads ativas
+    std::atomic<int> workerState { 0 };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> parallel { false };
+
+    double currentSampleRate = 44100.0;
+    int currentBlockSize = 512;
+    int latencySamples = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RackGraph)
+};
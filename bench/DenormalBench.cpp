@@ -0,0 +1,235 @@
+//==============================================================================
+// DenormalBench.cpp: mede o custo por amostra de caudas que decaem ate a faixa
+// de denormais, com e sem as protecoes de dsp_core/Denormals.h
+//
+// Para cada kernel sao medidos dois trechos de mesmo tamanho:
+//   ativo: entrada com ruido em nivel normal
+//   cauda: estado carregado com valores denormais e entrada nula (fade out)
+// A razao cauda/ativo deve ficar proxima de 1. Sem protecao ela chega a 10-100x.
+//==============================================================================
+
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+
+#include "dsp_core/Denormals.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int numBlocks = 2 * (int)sampleRate / blockSize; // ~2 s de audio por trecho
+    constexpr float denormalLevel = 1.0e-39f;                  // abaixo de FLT_MIN (1.18e-38)
+    constexpr double maxTailRatio = 1.5;                       // margem para ruido de medicao
+
+    //==============================================================================
+    // Kernels: mesma estrutura dos lacos de realimentacao dos plugins
+    //------------------------------------------------------------------------------
+    // 031_delay: delay inteiro com realimentacao
+    struct FeedbackDelay
+    {
+        static constexpr const char* name = "031_delay (feedback)";
+
+        std::vector<float> buffer = std::vector<float>((size_t)(0.1 * sampleRate), 0.0f);
+        int writePosition = 0;
+        float feedback = 0.9f;
+
+        int stateLength() const { return (int)buffer.size(); }
+
+        template <bool flush>
+        void process(float* data, int numSamples)
+        {
+            const int length = (int)buffer.size();
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const float in = data[i];
+                const float delayed = buffer[(size_t)writePosition];
+
+                float next = in + delayed * feedback;
+                if constexpr (flush)
+                    next = dsp_core::flushDenormal(next);
+
+                buffer[(size_t)writePosition] = next;
+                data[i] = in + 0.5f * delayed;
+
+                if (++writePosition >= length)
+                    writePosition = 0;
+            }
+        }
+    };
+
+    // 033_flanger: leitura fracionaria (interpolacao linear) com realimentacao
+    struct FeedbackComb
+    {
+        static constexpr const char* name = "033_flanger (feedback)";
+
+        std::vector<float> buffer = std::vector<float>((size_t)(0.0205 * sampleRate) + 3, 0.0f);
+        int writePosition = 0;
+        float delaySamples = 240.37f;
+        float feedback = 0.95f;
+
+        int stateLength() const { return (int)buffer.size(); }
+
+        template <bool flush>
+        void process(float* data, int numSamples)
+        {
+            const int length = (int)buffer.size();
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const float in = data[i];
+
+                float readPosition = (float)writePosition - delaySamples;
+                if (readPosition < 0.0f)
+                    readPosition += (float)length;
+
+                const int previousSample = (int)readPosition;
+                const int nextSample = (previousSample + 1) % length;
+                const float fraction = readPosition - (float)previousSample;
+                const float delayed = fraction * buffer[(size_t)nextSample] + (1.0f - fraction) * buffer[(size_t)previousSample];
+
+                float next = in + delayed * feedback;
+                if constexpr (flush)
+                    next = dsp_core::flushDenormal(next);
+
+                buffer[(size_t)writePosition] = next;
+                data[i] = in + delayed;
+
+                if (++writePosition >= length)
+                    writePosition = 0;
+            }
+        }
+    };
+
+    // 041/042: biquad do juce_dsp (estado zerado ao fim do bloco por JUCE_DSP_ENABLE_SNAP_TO_ZERO)
+    struct Biquad
+    {
+        static constexpr const char* name = "041/042 (IIR peak)";
+
+        juce::dsp::IIR::Filter<float> filter;
+
+        Biquad()
+        {
+            filter.coefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, 200.0, 0.7, 4.0f);
+            filter.prepare({ sampleRate, (juce::uint32)blockSize, 1 });
+        }
+
+        int stateLength() const { return blockSize; }
+
+        template <bool flush>
+        void process(float* data, int numSamples)
+        {
+            float* channels[] = { data };
+            juce::dsp::AudioBlock<float> block(channels, 1, (size_t)numSamples);
+            filter.process(juce::dsp::ProcessContextReplacing<float>(block));
+        }
+    };
+
+    //==============================================================================
+    // Medicao
+    //------------------------------------------------------------------------------
+    enum class Mode
+    {
+        Unprotected,    // denormais habilitados, sem flush: o problema original
+        FlushOnly,      // denormais habilitados (plataforma sem FTZ), com flush de estado
+        FlushAndFtz     // configuracao dos plugins: FTZ/DAZ + flush de estado
+    };
+
+    const char* modeName(Mode mode)
+    {
+        switch (mode)
+        {
+            case Mode::Unprotected: return "sem protecao";
+            case Mode::FlushOnly:   return "flush, sem FTZ";
+            case Mode::FlushAndFtz: return "flush + FTZ/DAZ";
+        }
+        return "";
+    }
+
+    // Custo medio em nanossegundos por amostra de um trecho ativo ou de cauda
+    template <typename Kernel, bool flush>
+    double nanosecondsPerSample(bool tail)
+    {
+        Kernel kernel;
+        juce::Random random(1234);
+        std::vector<float> block((size_t)blockSize);
+
+        // gerar o ruido faz parte dos dois trechos, para que a razao compare apenas o kernel
+        auto fill = [&](float level)
+        {
+            for (auto& sample : block)
+                sample = level * (2.0f * random.nextFloat() - 1.0f);
+        };
+
+        // carrega todo o estado com valores denormais antes de medir a cauda
+        if (tail)
+        {
+            for (int n = 0; n < kernel.stateLength(); n += blockSize)
+            {
+                fill(denormalLevel);
+                kernel.template process<flush>(block.data(), blockSize);
+            }
+        }
+
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            fill(tail ? 0.0f : 0.5f);
+            kernel.template process<flush>(block.data(), blockSize);
+        }
+
+        const auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        return 1.0e9 * elapsed / (double)(numBlocks * blockSize);
+    }
+
+    // Roda um kernel em um modo e retorna true se a cauda nao ficou mais lenta que o permitido
+    template <typename Kernel>
+    bool run(Mode mode)
+    {
+        juce::FloatVectorOperations::disableDenormalisedNumberSupport(false);
+
+        if (mode == Mode::FlushAndFtz)
+            dsp_core::disableDenormals();
+
+        const bool flush = mode != Mode::Unprotected;
+        const double active = flush ? nanosecondsPerSample<Kernel, true>(false) : nanosecondsPerSample<Kernel, false>(false);
+        const double tail   = flush ? nanosecondsPerSample<Kernel, true>(true)  : nanosecondsPerSample<Kernel, false>(true);
+        const double ratio  = tail / active;
+
+        const bool ok = mode == Mode::Unprotected || ratio <= maxTailRatio;
+
+        std::printf("%-24s %-18s %12.2f %12.2f %8.2fx %s\n",
+                    Kernel::name, modeName(mode), active, tail, ratio,
+                    mode == Mode::Unprotected ? "(referencia)" : (ok ? "ok" : "FALHOU"));
+        return ok;
+    }
+
+    template <typename Kernel>
+    bool runAllModes()
+    {
+        bool ok = true;
+
+        for (auto mode : { Mode::Unprotected, Mode::FlushOnly, Mode::FlushAndFtz })
+            ok = run<Kernel>(mode) && ok;
+
+        return ok;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    std::printf("%-24s %-18s %12s %12s %9s\n", "kernel", "modo", "ativo ns/am", "cauda ns/am", "razao");
+
+    bool ok = true;
+    ok = runAllModes<FeedbackDelay>() && ok;
+    ok = runAllModes<FeedbackComb>() && ok;
+    ok = runAllModes<Biquad>() && ok;
+
+    // retorna erro se alguma configuracao protegida ficou mais lenta na cauda
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+//==============================================================================
+// DspCoreTest.cpp: verificacoes de comportamento dos componentes de dsp_core
+//
+// Cada caso monta um componente isolado, processa um sinal sintetico e compara com
+// uma referencia (o processador do JUCE equivalente ou o valor esperado). Imprime um
+// resultado por caso e retorna erro se algum falhar.
+//
+// Uso:
+//   DspCoreTest                      roda todos os casos
+//   DspCoreTest --filter=Biquad      apenas os casos cujo nome contem o texto
+//==============================================================================
+
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+
+#include "dsp_core/Biquad.h"
+#include "dsp_core/CpuDispatch.h"
+#include "dsp_core/Denormals.h"
+#include "dsp_core/NoiseGate.h"
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+namespace
+{
+    struct TestCase
+    {
+        juce::String name;
+        std::function<bool()> run;
+    };
+
+    bool expect(bool condition, const char* description)
+    {
+        if (! condition)
+            std::printf("    falhou: %s\n", description);
+
+        return condition;
+    }
+
+    //==============================================================================
+    // Biquad: peak e shelf de baixa frequencia, Q alto e ganho pequeno tem b e a muito
+    // proximos, mas nao sao neutros. A cascata tem que processa-los como o
+    // juce::dsp::IIR::Filter, e so pular os estagios em exatamente 0 dB.
+    //
+    // Roda no nivel detectado da maquina: a cascata nao tem variantes por conjunto de
+    // instrucoes, entao a saida tem que ser identica a do JUCE em qualquer processador
+    // (em float, um filtro desses e tao sensivel ao arredondamento que uma variante
+    // com FMA chega a diferir em ~10% do efeito do filtro)
+    //------------------------------------------------------------------------------
+    using MakeArray = std::array<float, 6> (*)(double, float, float, float);
+
+    bool checkBiquadStage(MakeArray make, double sampleRate, float frequency, float Q, float gainDb, float testFrequency)
+    {
+        const auto gainFactor = juce::Decibels::decibelsToGain(gainDb);
+        const auto coefficients = dsp_core::BiquadCoefficients<float>::fromArray(make(sampleRate, frequency, Q, gainFactor));
+
+        dsp_core::BiquadCascade<float, 1> cascade;
+        cascade.prepare({ sampleRate, 512, 1 });
+        cascade.setCoefficients(0, coefficients);
+
+        juce::dsp::IIR::Filter<float> reference;
+        reference.prepare({ sampleRate, 512, 1 });
+        reference.coefficients = new juce::dsp::IIR::Coefficients<float>();
+        *reference.coefficients = make(sampleRate, frequency, Q, gainFactor);
+
+        // dois segundos de senoide: passa da cauda do filtro e chega ao regime
+        const int numSamples = (int)(2.0 * sampleRate);
+        juce::AudioBuffer<float> buffer(1, numSamples);
+        std::vector<float> expected((size_t)numSamples);
+        float effect = 0, error = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto x = 0.5f * (float)std::sin(juce::MathConstants<double>::twoPi * testFrequency * i / sampleRate);
+            buffer.setSample(0, i, x);
+            expected[(size_t)i] = reference.processSample(x);
+            effect = juce::jmax(effect, std::abs(expected[(size_t)i] - x));
+        }
+
+        for (int start = 0; start < numSamples; start += 512)
+        {
+            auto block = juce::dsp::AudioBlock<float>(buffer).getSubBlock((size_t)start, (size_t)juce::jmin(512, numSamples - start));
+            cascade.process(juce::dsp::ProcessContextReplacing<float>(block));
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+            error = juce::jmax(error, std::abs(buffer.getSample(0, i) - expected[(size_t)i]));
+
+        bool passed = true;
+
+        if (gainDb == 0.0f)
+        {
+            passed &= expect(coefficients.isIdentity(), "0 dB deveria ser neutro");
+            passed &= expect(cascade.isFlat(), "cascata deveria ficar plana");
+        }
+        else
+        {
+            passed &= expect(! coefficients.isIdentity(), "estagio tratado como neutro");
+            passed &= expect(! cascade.isFlat(), "cascata plana com estagio ativo");
+        }
+
+        passed &= expect(error == 0.0f, "saida diferente do juce::dsp::IIR::Filter");
+
+        std::printf("    efeito %.3g, erro %.3g\n", effect, error);
+        return passed;
+    }
+
+    void addBiquad(std::vector<TestCase>& tests)
+    {
+        using Array = juce::dsp::IIR::ArrayCoefficients<float>;
+
+        tests.push_back({ "Biquad/lowShelf/30Hz/192k/Q10/+1dB",
+                          [] { return checkBiquadStage(&Array::makeLowShelf, 192000.0, 30.0f, 10.0f, 1.0f, 20.0f); } });
+        tests.push_back({ "Biquad/lowShelf/30Hz/192k/Q10/+0.1dB",
+                          [] { return checkBiquadStage(&Array::makeLowShelf, 192000.0, 30.0f, 10.0f, 0.1f, 20.0f); } });
+        tests.push_back({ "Biquad/peak/30Hz/192k/Q10/+1dB",
+                          [] { return checkBiquadStage(&Array::makePeakFilter, 192000.0, 30.0f, 10.0f, 1.0f, 30.0f); } });
+        tests.push_back({ "Biquad/peak/30Hz/192k/Q10/+0.1dB",
+                          [] { return checkBiquadStage(&Array::makePeakFilter, 192000.0, 30.0f, 10.0f, 0.1f, 30.0f); } });
+        tests.push_back({ "Biquad/highShelf/30Hz/192k/Q10/+1dB",
+                          [] { return checkBiquadStage(&Array::makeHighShelf, 192000.0, 30.0f, 10.0f, 1.0f, 1000.0f); } });
+        tests.push_back({ "Biquad/lowShelf/30Hz/192k/Q10/0dB",
+                          [] { return checkBiquadStage(&Array::makeLowShelf, 192000.0, 30.0f, 10.0f, 0.0f, 20.0f); } });
+        tests.push_back({ "Biquad/peak/1kHz/48k/Q0.7/0dB",
+                          [] { return checkBiquadStage(&Array::makePeakFilter, 48000.0, 1000.0f, 0.7f, 0.0f, 1000.0f); } });
+    }
+
+    //==============================================================================
+    // NoiseGate: getClosedSamples() nunca passa do silencio que ja saiu. As ultimas
+    // getClosedSamples() amostras da saida tem que ser zero exato em todos os canais,
+    // para qualquer tamanho de bloco (o 052 para a cadeia com base nessa conta)
+    //------------------------------------------------------------------------------
+    bool checkGateClosedSamples(int blockSize)
+    {
+        constexpr double sampleRate = 48000.0;
+        const int numSamples = (int)(4.0 * sampleRate);
+
+        // ruido de fundo (nunca zero) com rajadas de tom a cada 0.75 s
+        juce::AudioBuffer<float> buffer(2, numSamples);
+        juce::Random random(1);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float noise = 1.0e-6f + 0.0003f * (random.nextFloat() * 2.0f - 1.0f);
+            const bool burst = (i / 12000) % 3 == 0;
+            buffer.setSample(0, i, noise + (burst ? 0.3f * (float)std::sin(juce::MathConstants<double>::twoPi * 82.0 * i / sampleRate) : 0.0f));
+            buffer.setSample(1, i, noise);
+        }
+
+        dsp_core::NoiseGate<float> gate;
+        gate.prepare({ sampleRate, (juce::uint32)blockSize, 2 });
+        gate.setThreshold(-50.0f, 6.0f);
+        gate.setTimes(1.0f, 10.0f, 20.0f);
+
+        juce::int64 trailingZeros = 0, maxClosed = 0;
+        bool withinSilence = true;
+
+        for (int start = 0; start + blockSize <= numSamples; start += blockSize)
+        {
+            auto block = juce::dsp::AudioBlock<float>(buffer).getSubBlock((size_t)start, (size_t)blockSize);
+            gate.process(juce::dsp::ProcessContextReplacing<float>(block));
+
+            for (int i = start; i < start + blockSize; ++i)
+                trailingZeros = (buffer.getSample(0, i) == 0.0f && buffer.getSample(1, i) == 0.0f) ? trailingZeros + 1 : 0;
+
+            const auto closedSamples = gate.getClosedSamples();
+            maxClosed = juce::jmax(maxClosed, closedSamples);
+
+            if (closedSamples > trailingZeros)
+                withinSilence = false;
+        }
+
+        bool passed = expect(withinSilence, "getClosedSamples() maior que o silencio na saida");
+        passed &= expect(maxClosed > 0, "gate nunca fechou");
+
+        std::printf("    maior silencio contado %lld amostras\n", (long long)maxClosed);
+        return passed;
+    }
+
+    void addNoiseGate(std::vector<TestCase>& tests)
+    {
+        for (int blockSize : { 1, 7, 100, 512 })
+            tests.push_back({ "NoiseGate/closedSamples/block:" + juce::String(blockSize),
+                              [blockSize] { return checkGateClosedSamples(blockSize); } });
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    const juce::ArgumentList args(argc, argv);
+    const auto filter = args.containsOption("--filter") ? args.getValueForOption("--filter") : juce::String();
+
+    // mesma configuracao de ponto flutuante dos plugins
+    dsp_core::disableDenormals();
+
+    // os casos rodam na variante desta maquina (ou a limitada por DSP_CORE_MAX_SIMD)
+    std::printf("variante: %s\n\n", dsp_core::CpuDispatch::getName(dsp_core::CpuDispatch::getLevel()));
+
+    std::vector<TestCase> tests;
+    addBiquad(tests);
+    addNoiseGate(tests);
+
+    int failures = 0;
+
+    for (const auto& test : tests)
+    {
+        if (filter.isNotEmpty() && ! test.name.contains(filter))
+            continue;
+
+        std::printf("%s\n", test.name.toRawUTF8());
+        const bool passed = test.run();
+        std::printf("    %s\n", passed ? "ok" : "FALHOU");
+
+        if (! passed)
+            ++failures;
+    }
+
+    if (failures > 0)
+    {
+        std::printf("\n%d caso(s) falharam\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
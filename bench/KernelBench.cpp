@@ -0,0 +1,945 @@
+//==============================================================================
+// KernelBench.cpp: micro-benchmarks dos lacos internos de DSP dos plugins
+//
+// Cada caso roda um kernel isolado (sem host, sem parametros) em blocos estereo de
+// tamanho fixo e reporta a vazao em amostras/s e o custo em ciclos/amostra
+// (contando as amostras de todos os canais). Os nomes seguem o formato
+//   Kernel/variante/parametro:valor/block:N
+// e podem ser filtrados por substring.
+//
+// Uso:
+//   KernelBench                                       roda tudo e imprime a tabela
+//   KernelBench --filter=Convolution                  apenas os casos que contem o texto
+//   KernelBench --save=baseline.json                  grava os resultados como referencia
+//   KernelBench --compare=baseline.json --threshold=10
+//       compara com a referencia e retorna erro se algum caso perdeu mais de 10% de
+//       vazao (o padrao e 10)
+//   --min-time=0.2                                    segundos por repeticao (padrao 0.1)
+//   --repetitions=5                                   repeticoes; reporta a mediana
+//   --isa=avx2                                        limita a variante dos kernels
+//                                                     (generic, avx2, avx512; ver
+//                                                     dsp_core/CpuDispatch.h)
+//   --isa=all                                         roda cada caso em todas as variantes
+//                                                     suportadas, com o sufixo /isa:<nome>
+//
+// A comparacao so faz sentido entre execucoes na mesma maquina, em modo Release e
+// com o governador de frequencia da CPU fixo.
+//
+// Compilado com DSP_CORE_RT_CHECK, cada chamada de kernel e uma secao de tempo real: os
+// casos que alocam memoria ou travam um mutex sao listados com as pilhas de chamadas e
+// o benchmark retorna erro (ver dsp_core/RealtimeCheck.h).
+//
+// Os casos AmpChain rodam a cadeia do 052 em uma dsp_core::ProfiledChain e, depois da
+// linha do caso, listam cada estagio com o sufixo /stage:<nome> (vazao e ciclos do
+// estagio sozinho, medidos dentro da cadeia). Essas linhas tambem entram em --save e
+// --compare (ver dsp_core/Profiler.h).
+//==============================================================================
+
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+
+#include "dsp_core/Biquad.h"
+#include "dsp_core/Convolution.h"
+#include "dsp_core/CpuDispatch.h"
+#include "dsp_core/DelayLine.h"
+#include "dsp_core/Denormals.h"
+#include "dsp_core/FdnReverb.h"
+#include "dsp_core/Fft.h"
+#include "dsp_core/NeuralAmp.h"
+#include "dsp_core/NoiseGate.h"
+#include "dsp_core/Profiler.h"
+#include "dsp_core/RealtimeCheck.h"
+#include "dsp_core/Smoother.h"
+#include "dsp_core/ToneStack.h"
+#include "dsp_core/TriodePreamp.h"
+#include "dsp_core/Waveshaper.h"
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numChannels = 2;
+
+    //==============================================================================
+    // Opcoes de linha de comando
+    //------------------------------------------------------------------------------
+    struct Options
+    {
+        juce::String filter;
+        juce::File saveFile;
+        juce::File compareFile;
+        double threshold = 10.0;    // perda de vazao maxima, em %
+        double minTime = 0.1;       // segundos por repeticao
+        int repetitions = 5;
+        juce::String isa;
+    };
+
+    Options parseOptions(const juce::ArgumentList& args)
+    {
+        Options options;
+
+        if (args.containsOption("--filter"))
+            options.filter = args.getValueForOption("--filter");
+        if (args.containsOption("--save"))
+            options.saveFile = args.getFileForOption("--save");
+        if (args.containsOption("--compare"))
+            options.compareFile = args.getFileForOption("--compare");
+        if (args.containsOption("--threshold"))
+            options.threshold = args.getValueForOption("--threshold").getDoubleValue();
+        if (args.containsOption("--min-time"))
+            options.minTime = juce::jmax(0.001, args.getValueForOption("--min-time").getDoubleValue());
+        if (args.containsOption("--repetitions"))
+            options.repetitions = juce::jmax(1, args.getValueForOption("--repetitions").getIntValue());
+        if (args.containsOption("--isa"))
+            options.isa = args.getValueForOption("--isa");
+
+        return options;
+    }
+
+    //==============================================================================
+    // Contador de ciclos. Em x86 usa o TSC, que conta em frequencia nominal (com turbo
+    // a frequencia real e maior); nas demais plataformas estima pelo tempo e pela
+    // frequencia informada pelo sistema
+    //------------------------------------------------------------------------------
+    juce::int64 readCycleCounter() noexcept
+    {
+       #if JUCE_INTEL
+        return (juce::int64)__rdtsc();
+       #else
+        return 0;
+       #endif
+    }
+
+    double cyclesFor(juce::int64 cycles, double seconds)
+    {
+       #if JUCE_INTEL
+        juce::ignoreUnused(seconds);
+        return (double)cycles;
+       #else
+        juce::ignoreUnused(cycles);
+        return seconds * 1.0e6 * (double)juce::SystemStats::getCpuSpeedInMegahertz();
+       #endif
+    }
+
+    //==============================================================================
+    // Buffers de um caso: entrada fixa com ruido e saida separada. Os kernels usam
+    // ProcessContextNonReplacing, entao o estado interno sempre ve a mesma entrada e
+    // nao diverge ao longo das repeticoes
+    //------------------------------------------------------------------------------
+    template <typename SampleType>
+    struct BlockBuffers
+    {
+        explicit BlockBuffers(int blockSize)
+            : input(numChannels, blockSize), output(numChannels, blockSize)
+        {
+            juce::Random random(1234);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    input.setSample(channel, i, (SampleType)(0.5f * (2.0f * random.nextFloat() - 1.0f)));
+
+            output.clear();
+        }
+
+        template <typename Processor>
+        void process(Processor& processor)
+        {
+            juce::dsp::AudioBlock<const SampleType> inputBlock(input);
+            juce::dsp::AudioBlock<SampleType> outputBlock(output);
+            processor.process(juce::dsp::ProcessContextNonReplacing<SampleType>(inputBlock, outputBlock));
+        }
+
+        juce::AudioBuffer<SampleType> input, output;
+    };
+
+    // Processa um bloco de blockSize amostras por chamada
+    using Kernel = std::function<void()>;
+
+    struct Benchmark
+    {
+        juce::String name;
+        int blockSize;
+        std::function<Kernel(int blockSize)> create;
+    };
+
+    // Monta um kernel a partir de um processador do tipo prepare/process
+    template <typename SampleType, typename Processor>
+    Kernel makeKernel(std::shared_ptr<Processor> processor, int blockSize)
+    {
+        auto buffers = std::make_shared<BlockBuffers<SampleType>>(blockSize);
+        return [processor, buffers] { buffers->process(*processor); };
+    }
+
+    juce::dsp::ProcessSpec makeSpec(int blockSize)
+    {
+        return { sampleRate, (juce::uint32)blockSize, (juce::uint32)numChannels };
+    }
+
+    //==============================================================================
+    // Casos
+    //------------------------------------------------------------------------------
+    const std::vector<int> blockSizes { 32, 256, 1024 };
+
+    // 032/033/034: delay modulado, com a interpolacao e o numero de vozes do chorus
+    void addModulatedDelay(std::vector<Benchmark>& benchmarks)
+    {
+        using dsp_core::Interpolation;
+
+        const std::pair<Interpolation, const char*> interpolations[] = {
+            { Interpolation::NearestNeighbour, "nearest" },
+            { Interpolation::Linear, "linear" },
+            { Interpolation::Cubic, "cubic" }
+        };
+
+        for (const auto& [interpolation, interpolationName] : interpolations)
+            for (int voices : { 1, 2, 4 })
+                for (int blockSize : blockSizes)
+                {
+                    const auto name = juce::String("ModulatedDelay/") + interpolationName
+                                    + "/voices:" + juce::String(voices) + "/block:" + juce::String(blockSize);
+
+                    benchmarks.push_back({ name, blockSize, [interpolation = interpolation, voices](int size)
+                    {
+                        auto delay = std::make_shared<dsp_core::ModulatedDelay<float>>();
+                        delay->prepare(makeSpec(size), 0.05);
+                        delay->setDelay(0.03f);
+                        delay->setSweepWidth(0.01f);
+                        delay->setFrequency(0.5f);
+                        delay->setDepth(0.7f);
+                        delay->setFeedback(0.5f);
+                        delay->setInterpolation(interpolation);
+                        delay->setNumVoices(voices);
+                        return makeKernel<float>(delay, size);
+                    } });
+                }
+    }
+
+    // 041/042/052: cascatas de biquads. juce_chain e a referencia com uma ProcessorChain
+    // de juce::dsp::IIR::Filter por canal, como os EQs faziam antes de dsp_core
+    template <typename SampleType, int NumStages>
+    void setupCascade(dsp_core::BiquadCascade<SampleType, NumStages>& cascade)
+    {
+        for (int stage = 0; stage < NumStages; ++stage)
+            cascade.setCoefficients(stage, dsp_core::BiquadCoefficients<SampleType>::makePeakFilter(
+                                               sampleRate, (SampleType)(100 * (stage + 1)), (SampleType)0.7, (SampleType)2));
+    }
+
+    template <typename SampleType, int NumStages>
+    void addBiquadCascade(std::vector<Benchmark>& benchmarks, const char* typeName)
+    {
+        for (int blockSize : blockSizes)
+        {
+            const auto name = juce::String("Biquad/dsp_core/stages:") + juce::String(NumStages)
+                            + "/" + typeName + "/block:" + juce::String(blockSize);
+
+            benchmarks.push_back({ name, blockSize, [](int size)
+            {
+                auto cascade = std::make_shared<dsp_core::BiquadCascade<SampleType, NumStages>>();
+                cascade->prepare(makeSpec(size));
+                setupCascade(*cascade);
+                return makeKernel<SampleType>(cascade, size);
+            } });
+        }
+    }
+
+    struct JuceFilterChain
+    {
+        using Filter = juce::dsp::IIR::Filter<float>;
+        juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter> chains[numChannels];
+
+        void prepare(int blockSize)
+        {
+            for (auto& chain : chains)
+            {
+                chain.prepare({ sampleRate, (juce::uint32)blockSize, 1 });
+                setCoefficients<0>(chain);
+                setCoefficients<1>(chain);
+                setCoefficients<2>(chain);
+                setCoefficients<3>(chain);
+            }
+        }
+
+        template <int Index, typename Chain>
+        static void setCoefficients(Chain& chain)
+        {
+            chain.template get<Index>().coefficients =
+                juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, 100.0f * (Index + 1), 0.7f, 2.0f);
+        }
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context)
+        {
+            for (size_t channel = 0; channel < (size_t)numChannels; ++channel)
+            {
+                auto inputBlock = context.getInputBlock().getSingleChannelBlock(channel);
+                auto outputBlock = context.getOutputBlock().getSingleChannelBlock(channel);
+                chains[channel].process(juce::dsp::ProcessContextNonReplacing<float>(inputBlock, outputBlock));
+            }
+        }
+    };
+
+    void addBiquad(std::vector<Benchmark>& benchmarks)
+    {
+        addBiquadCascade<float, 1>(benchmarks, "float");
+        addBiquadCascade<float, 4>(benchmarks, "float");
+        addBiquadCascade<double, 4>(benchmarks, "double");
+
+        for (int blockSize : blockSizes)
+        {
+            benchmarks.push_back({ "Biquad/juce_chain/stages:4/float/block:" + juce::String(blockSize), blockSize, [](int size)
+            {
+                auto chain = std::make_shared<JuceFilterChain>();
+                chain->prepare(size);
+                return makeKernel<float>(chain, size);
+            } });
+        }
+    }
+
+    // 021/052: waveshaper. std_function e o caminho do 021 (funcao escolhida em tempo
+    // de execucao); tanh e softclip sao chamadas expandidas inline
+    void addWaveshaper(std::vector<Benchmark>& benchmarks)
+    {
+        for (int blockSize : blockSizes)
+        {
+            const auto suffix = "/block:" + juce::String(blockSize);
+
+            benchmarks.push_back({ "Waveshaper/tanh" + suffix, blockSize, [](int size)
+            {
+                return makeKernel<float>(std::make_shared<dsp_core::Waveshaper<float, dsp_core::Tanh<float>>>(), size);
+            } });
+
+            benchmarks.push_back({ "Waveshaper/tanh_std_function" + suffix, blockSize, [](int size)
+            {
+                auto shaper = std::make_shared<dsp_core::Waveshaper<float>>();
+                shaper->functionToUse = [](float x) { return std::tanh(x); };
+                return makeKernel<float>(shaper, size);
+            } });
+
+            benchmarks.push_back({ "Waveshaper/softclip" + suffix, blockSize, [](int size)
+            {
+                return makeKernel<float>(std::make_shared<dsp_core::Waveshaper<float, dsp_core::SoftClip<float>>>(), size);
+            } });
+        }
+    }
+
+    // 052: noise gate. open: limiar abaixo do sinal, so o detector de pico (o ganho fica
+    // em 1); closed: limiar acima do sinal, detector e bloco zerado
+    void addNoiseGate(std::vector<Benchmark>& benchmarks)
+    {
+        for (int blockSize : blockSizes)
+            for (float threshold : { -90.0f, 0.0f })
+            {
+                const auto name = juce::String(threshold < 0.0f ? "NoiseGate/open" : "NoiseGate/closed")
+                                + "/block:" + juce::String(blockSize);
+
+                benchmarks.push_back({ name, blockSize, [threshold](int size)
+                {
+                    auto gate = std::make_shared<dsp_core::NoiseGate<float>>();
+                    gate->prepare(makeSpec(size));
+                    gate->setThreshold(threshold, 6.0f);
+                    return makeKernel<float>(gate, size);
+                } });
+            }
+    }
+
+    // 052: modelo capturado com pesos aleatorios (o custo nao depende dos valores). O
+    // custo por amostra define quantas instancias cabem em um nucleo
+    void addNeuralAmp(std::vector<Benchmark>& benchmarks)
+    {
+        const std::pair<dsp_core::RecurrentCell, const char*> cells[] = {
+            { dsp_core::RecurrentCell::lstm, "lstm" },
+            { dsp_core::RecurrentCell::gru, "gru" }
+        };
+
+        for (const auto& [cell, cellName] : cells)
+            for (int hiddenSize : dsp_core::NeuralAmpWeights::supportedSizes)
+                for (int blockSize : { 64, 256 })
+                {
+                    const auto name = "NeuralAmp/" + juce::String(cellName) + "/hidden:" + juce::String(hiddenSize)
+                                    + "/block:" + juce::String(blockSize);
+
+                    benchmarks.push_back({ name, blockSize, [cell = cell, hiddenSize](int size)
+                    {
+                        auto amp = std::make_shared<dsp_core::NeuralAmp>();
+                        amp->prepare(makeSpec(size));
+                        amp->loadModel(dsp_core::NeuralAmpWeights::makeRandom(cell, hiddenSize));
+                        return makeKernel<float>(amp, size);
+                    } });
+                }
+    }
+
+    // 052: valvula em WDF com oversampling 2x. A tabela da raiz e criada no prepare do
+    // primeiro caso e reaproveitada pelos seguintes
+    void addTriodePreamp(std::vector<Benchmark>& benchmarks)
+    {
+        for (int blockSize : blockSizes)
+            benchmarks.push_back({ "TriodePreamp/oversampling:2/block:" + juce::String(blockSize), blockSize, [](int size)
+            {
+                auto preamp = std::make_shared<dsp_core::TriodePreamp>();
+                preamp->prepare(makeSpec(size));
+                return makeKernel<float>(preamp, size);
+            } });
+    }
+
+    // 051/052: convolucao com respostas sinteticas (ruido com decaimento exponencial).
+    // 1024 amostras ~ caixa curta, 24000 ~ as IRs do 052 (0.5 s), 96000 ~ reverb de 2 s
+    juce::AudioBuffer<float> makeImpulseResponse(int length, int irChannels = numChannels)
+    {
+        juce::AudioBuffer<float> ir(irChannels, length);
+        juce::Random random(42);
+
+        for (int channel = 0; channel < irChannels; ++channel)
+            for (int i = 0; i < length; ++i)
+                ir.setSample(channel, i, (2.0f * random.nextFloat() - 1.0f) * std::exp(-6.0f * (float)i / (float)length));
+
+        return ir;
+    }
+
+    // Cada orcamento de latencia de dsp_core::Convolution (0 = particionamento nao
+    // uniforme sem latencia, N = particoes uniformes de N amostras)
+    void addConvolution(std::vector<Benchmark>& benchmarks)
+    {
+        for (int irLength : { 1024, 24000, 96000 })
+            for (int latency : dsp_core::Convolution::latencyBudgets)
+                for (int blockSize : { 64, 256, 1024 })
+                {
+                    const auto name = "Convolution/ir:" + juce::String(irLength) + "/latency:" + juce::String(latency)
+                                    + "/block:" + juce::String(blockSize);
+
+                    benchmarks.push_back({ name, blockSize, [irLength, latency](int size)
+                    {
+                        std::shared_ptr<juce::dsp::Convolution> convolution = dsp_core::Convolution::makeEngine(latency);
+                        convolution->prepare(makeSpec(size));
+                        convolution->loadImpulseResponse(makeImpulseResponse(irLength), sampleRate,
+                                                         juce::dsp::Convolution::Stereo::yes,
+                                                         juce::dsp::Convolution::Trim::no,
+                                                         juce::dsp::Convolution::Normalise::yes);
+
+                        // a IR e carregada em uma thread de fundo e instalada durante process:
+                        // processa ate ela estar ativa, para nao medir o caminho sem convolucao
+                        auto kernel = makeKernel<float>(convolution, size);
+                        const auto timeout = juce::Time::getMillisecondCounter() + 5000;
+
+                        while (convolution->getCurrentIRSize() != irLength && juce::Time::getMillisecondCounter() < timeout)
+                        {
+                            kernel();
+                            juce::Thread::sleep(1);
+                        }
+
+                        if (convolution->getCurrentIRSize() != irLength)
+                            std::printf("aviso: IR de %d amostras nao foi carregada a tempo\n", irLength);
+
+                        return kernel;
+                    } });
+                }
+    }
+
+    // Convolucao com particoes compartilhadas (dsp_core::PartitionedConvolution), com o
+    // mesmo particionamento de dsp_core::Convolution, para comparar com os casos
+    // Convolution de mesma IR e latencia. true_stereo usa uma IR de 4 canais: 2 FFTs e
+    // 2 IFFTs por particao, contra 4 convolucoes independentes
+    void addPartitionedConvolution(std::vector<Benchmark>& benchmarks)
+    {
+        const std::pair<dsp_core::ConvolutionMode, const char*> modes[] = {
+            { dsp_core::ConvolutionMode::stereo, "stereo" },
+            { dsp_core::ConvolutionMode::trueStereo, "true_stereo" }
+        };
+
+        for (const auto& [mode, modeName] : modes)
+            for (int irLength : { 1024, 24000, 96000 })
+                for (int latency : dsp_core::Convolution::latencyBudgets)
+                    for (int blockSize : { 64, 256, 1024 })
+                    {
+                        const auto name = "PartitionedConvolution/" + juce::String(modeName) + "/ir:" + juce::String(irLength)
+                                        + "/latency:" + juce::String(latency) + "/block:" + juce::String(blockSize);
+
+                        benchmarks.push_back({ name, blockSize, [mode = mode, irLength, latency](int size)
+                        {
+                            auto ir = makeImpulseResponse(irLength, dsp_core::getNumImpulseChannels(mode));
+                            const int partitionSize = latency > 0 ? latency : dsp_core::Convolution::sharedHeadSize;
+
+                            auto convolution = std::make_shared<dsp_core::PartitionedConvolution>();
+                            convolution->prepare(dsp_core::ImpulseResponsePartitions::getShared(
+                                                     ir, partitionSize, latency <= 0, dsp_core::Convolution::zeroLatencyHeadSize),
+                                                 numChannels, mode);
+                            return makeKernel<float>(convolution, size);
+                        } });
+                    }
+    }
+
+    // Ida e volta (forward + inverse) de uma FFT real de N = bloco pontos por canal, com
+    // cada backend disponivel no build. Sao as transformadas das particoes da convolucao
+    struct FftRoundTrip
+    {
+        FftRoundTrip(int size, dsp_core::FftBackend backend)
+            : fft(juce::roundToInt(std::log2(size)), backend), buffer((size_t)(2 * size))
+        {
+        }
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context)
+        {
+            const auto& input = context.getInputBlock();
+            auto& output = context.getOutputBlock();
+            const auto n = (int)input.getNumSamples();
+
+            for (size_t channel = 0; channel < input.getNumChannels(); ++channel)
+            {
+                juce::FloatVectorOperations::copy(buffer.data(), input.getChannelPointer(channel), n);
+                fft.forward(buffer.data());
+                fft.inverse(buffer.data());
+                juce::FloatVectorOperations::copy(output.getChannelPointer(channel), buffer.data(), n);
+            }
+        }
+
+        dsp_core::Fft fft;
+        std::vector<float> buffer;
+    };
+
+    void addFft(std::vector<Benchmark>& benchmarks)
+    {
+        const std::pair<dsp_core::FftBackend, const char*> backends[] = {
+            { dsp_core::FftBackend::juce, "juce" },
+            { dsp_core::FftBackend::builtin, "builtin" },
+            { dsp_core::FftBackend::fftw, "fftw" }
+        };
+
+        for (const auto& [backend, backendName] : backends)
+        {
+            if (! dsp_core::Fft::isAvailable(backend))
+                continue;
+
+            for (int size : { 128, 512, 2048, 4096 })
+            {
+                const auto name = juce::String("Fft/") + backendName + "/block:" + juce::String(size);
+
+                benchmarks.push_back({ name, size, [backend = backend](int blockSize)
+                {
+                    return makeKernel<float>(std::make_shared<FftRoundTrip>(blockSize, backend), blockSize);
+                } });
+            }
+        }
+    }
+
+    // 051: FDN de 8 e 16 linhas com as duas matrizes. O custo nao depende do decaimento
+    template <int NumLines>
+    void addFdn(std::vector<Benchmark>& benchmarks)
+    {
+        for (auto matrix : { dsp_core::FdnMatrix::hadamard, dsp_core::FdnMatrix::householder })
+            for (int blockSize : blockSizes)
+            {
+                const auto name = "Fdn/lines:" + juce::String(NumLines)
+                                + (matrix == dsp_core::FdnMatrix::hadamard ? "/hadamard" : "/householder")
+                                + "/block:" + juce::String(blockSize);
+
+                benchmarks.push_back({ name, blockSize, [matrix](int size)
+                {
+                    auto fdn = std::make_shared<dsp_core::FdnReverb<float, NumLines>>();
+                    fdn->prepare(makeSpec(size));
+                    fdn->setMatrix(matrix);
+                    fdn->setModulation(0.5f);
+                    return makeKernel<float>(fdn, size);
+                } });
+            }
+    }
+
+    // 052: a cadeia inteira do amp sim (EQ de 3 bandas, ganhos, saturacao, modelo
+    // capturado ou valvula, tone stack e caixa com IR de 0.5 s em particoes compartilhadas, sem latencia). Cada caso registra
+    // a cadeia em stageReports para o custo por estagio ser listado depois da medicao
+    struct CabStage : dsp_core::PartitionedConvolution
+    {
+        // as particoes sao preparadas depois, com a IR; o bloco nao importa
+        using PartitionedConvolution::prepare;
+        void prepare(const juce::dsp::ProcessSpec&) {}
+    };
+
+    using AmpChain = dsp_core::ProfiledChain<dsp_core::BiquadCascade<float, 3>,
+                                             dsp_core::SmoothedGain<float>,
+                                             dsp_core::Waveshaper<float, dsp_core::SoftClip<float>>,
+                                             dsp_core::NeuralAmp,
+                                             dsp_core::TriodePreamp,
+                                             dsp_core::ToneStack<float>,
+                                             dsp_core::SmoothedGain<float>,
+                                             CabStage>;
+
+    const char* const ampChainStages[] = { "eq", "pre_gain", "shaper", "neural_amp", "triode", "tone_stack", "post_gain", "cab" };
+
+    std::vector<std::shared_ptr<AmpChain>> stageReports;
+
+    // Mesmas regras de MyAudioProcessor::updateStageBypass do 052: estagios neutros em
+    // bypass, o pre-ganho dobrado nos coeficientes do EQ e ampStage como o parametro
+    // amp_stage: 0 = saturacao, 1 = modelo capturado (LSTM 20, tamanho comum das
+    // capturas), 2 = valvula
+    void setupAmpChain(AmpChain& chain, float eqGainDb, float preGainDb, float postGainDb, bool toneStack, int ampStage)
+    {
+        using Coefficients = dsp_core::BiquadCoefficients<float>;
+        const auto eqGain = juce::Decibels::decibelsToGain(eqGainDb);
+
+        auto& eq = chain.get<0>();
+        eq.setCoefficients(0, Coefficients::makeLowShelf(sampleRate, 200.0f, 0.7f, eqGain));
+        eq.setCoefficients(1, Coefficients::makePeakFilter(sampleRate, 800.0f, 0.7f, 1.0f / eqGain));
+        eq.setCoefficients(2, Coefficients::makeHighShelf(sampleRate, 4000.0f, 0.7f, eqGain));
+
+        auto& preGain = chain.get<1>();
+        auto& postGain = chain.get<6>();
+        preGain.setGain(juce::Decibels::decibelsToGain(preGainDb));
+        postGain.setGain(juce::Decibels::decibelsToGain(postGainDb));
+        preGain.reset();
+        postGain.reset();
+
+        eq.setOutputGain(eq.isFlat() ? 1.0f : preGain.getGain());
+        chain.setBypassed<0>(eq.isIdentity());
+        chain.setBypassed<5>(! toneStack);
+        chain.get<5>().setModel(dsp_core::ToneStackModel::marshall);
+        chain.get<5>().setKnobs(0.5, 0.5, 0.5);
+        chain.setBypassed<1>(! eq.isFlat() || preGain.getGain() == 1.0f);
+        chain.setBypassed<6>(postGain.getGain() == 1.0f);
+
+        if (ampStage == 1)
+            chain.get<3>().loadModel(dsp_core::NeuralAmpWeights::makeRandom(dsp_core::RecurrentCell::lstm, 20));
+
+        chain.setBypassed<2>(ampStage != 0);
+        chain.setBypassed<3>(ampStage != 1);
+        chain.setBypassed<4>(ampStage != 2);
+    }
+
+    // tone: EQ em +-3 dB, ganhos de +12/-6 dB e tone stack Marshall; flat: tudo em 0 dB
+    // e sem tone stack (so saturacao e caixa); neural e triode: como tone, com o modelo
+    // capturado ou a valvula no lugar da saturacao
+    void addAmpChain(std::vector<Benchmark>& benchmarks)
+    {
+        const std::pair<const char*, int> variants[] = { { "", 0 }, { "/flat", 0 }, { "/neural", 1 }, { "/triode", 2 } };
+
+        for (const auto& [variant, ampStage] : variants)
+            for (int blockSize : { 64, 256, 1024 })
+            {
+                const auto name = "AmpChain" + juce::String(variant) + "/block:" + juce::String(blockSize);
+                const bool flat = juce::String(variant) == "/flat";
+
+                benchmarks.push_back({ name, blockSize, [flat, ampStage = ampStage](int size)
+                {
+                    auto chain = std::make_shared<AmpChain>();
+                    chain->prepare(makeSpec(size));
+
+                    if (flat)
+                        setupAmpChain(*chain, 0.0f, 0.0f, 0.0f, false, 0);
+                    else
+                        setupAmpChain(*chain, 3.0f, 12.0f, -6.0f, true, ampStage);
+
+                    const auto ir = makeImpulseResponse(24000);
+                    chain->get<7>().prepare(dsp_core::ImpulseResponsePartitions::getShared(
+                                                ir, dsp_core::Convolution::sharedHeadSize, true,
+                                                dsp_core::Convolution::zeroLatencyHeadSize),
+                                            numChannels, dsp_core::ConvolutionMode::stereo);
+
+                    stageReports.push_back(chain);
+                    return makeKernel<float>(chain, size);
+                } });
+            }
+    }
+
+    //==============================================================================
+    // Medicao
+    //------------------------------------------------------------------------------
+    struct Result
+    {
+        juce::String name;
+        double samplesPerSecond = 0;
+        double cyclesPerSample = 0;
+    };
+
+    Result run(const Benchmark& benchmark, const Options& options)
+    {
+        auto kernel = benchmark.create(benchmark.blockSize);
+        const double samplesPerBlock = (double)(benchmark.blockSize * numChannels);
+
+        // so as chamadas do kernel: a criacao do caso pode alocar
+        const dsp_core::RealtimeCheck::ScopedSection realtimeSection;
+
+        // aquecimento: caches, preditor de desvios e o estado dos kernels
+        for (int i = 0; i < 100; ++i)
+            kernel();
+
+        std::vector<double> samplesPerSecond, cyclesPerSample;
+
+        for (int repetition = 0; repetition < options.repetitions; ++repetition)
+        {
+            juce::int64 blocks = 0;
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            const auto startCycles = readCycleCounter();
+            double elapsed = 0;
+
+            // blocos em lotes, para que a leitura do relogio nao entre na medida
+            do
+            {
+                for (int i = 0; i < 16; ++i)
+                    kernel();
+
+                blocks += 16;
+                elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+            }
+            while (elapsed < options.minTime);
+
+            const double samples = samplesPerBlock * (double)blocks;
+            samplesPerSecond.push_back(samples / elapsed);
+            cyclesPerSample.push_back(cyclesFor(readCycleCounter() - startCycles, elapsed) / samples);
+        }
+
+        auto median = [](std::vector<double>& values)
+        {
+            std::sort(values.begin(), values.end());
+            return values[values.size() / 2];
+        };
+
+        return { benchmark.name, median(samplesPerSecond), median(cyclesPerSample) };
+    }
+
+    // Uma linha por estagio das cadeias criadas pelo ultimo caso: o tempo acumulado de
+    // cada estagio durante aquecimento e repeticoes, nas mesmas unidades da tabela
+    void addStageResults(const Benchmark& benchmark, std::vector<Result>& results)
+    {
+        for (const auto& chain : stageReports)
+            for (size_t stage = 0; stage < AmpChain::numStages; ++stage)
+            {
+                const auto profile = chain->getProfiler(stage).getSnapshot();
+                const double samples = (double)(profile.samples * numChannels);
+                const double seconds = (double)profile.ticks / profile.ticksPerSecond;
+
+                if (samples <= 0 || seconds <= 0)
+                    continue;
+
+                results.push_back({ benchmark.name + "/stage:" + ampChainStages[stage], samples / seconds,
+                                    cyclesFor(profile.ticks, seconds) / samples });
+            }
+
+        stageReports.clear();
+    }
+
+    //==============================================================================
+    // Arquivo de referencia (JSON)
+    //------------------------------------------------------------------------------
+    bool saveResults(const std::vector<Result>& results, const Options& options)
+    {
+        auto* context = new juce::DynamicObject();
+        context->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+        context->setProperty("cpu_model", juce::SystemStats::getCpuModel());
+        context->setProperty("cpu_mhz", juce::SystemStats::getCpuSpeedInMegahertz());
+        context->setProperty("num_cpus", juce::SystemStats::getNumCpus());
+        context->setProperty("sample_rate", sampleRate);
+        context->setProperty("num_channels", numChannels);
+        context->setProperty("min_time", options.minTime);
+        context->setProperty("repetitions", options.repetitions);
+
+        juce::Array<juce::var> benchmarks;
+
+        for (const auto& result : results)
+        {
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty("name", result.name);
+            entry->setProperty("samples_per_second", result.samplesPerSecond);
+            entry->setProperty("cycles_per_sample", result.cyclesPerSample);
+            benchmarks.add(juce::var(entry));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("context", juce::var(context));
+        root->setProperty("benchmarks", benchmarks);
+
+        return options.saveFile.replaceWithText(juce::JSON::toString(juce::var(root)));
+    }
+
+    // Vazao por nome de caso. Retorna vazio se o arquivo nao existir ou for invalido
+    std::map<juce::String, double> loadBaseline(const juce::File& file)
+    {
+        std::map<juce::String, double> baseline;
+        const auto json = juce::JSON::parse(file);
+
+        if (const auto* benchmarks = json.getProperty("benchmarks", {}).getArray())
+            for (const auto& entry : *benchmarks)
+                baseline[entry.getProperty("name", {}).toString()] = (double)entry.getProperty("samples_per_second", 0.0);
+
+        return baseline;
+    }
+
+    // Retorna o numero de regressoes acima do limiar
+    int compareResults(const std::vector<Result>& results, const Options& options)
+    {
+        const auto baseline = loadBaseline(options.compareFile);
+
+        if (baseline.empty())
+        {
+            std::printf("referencia vazia ou invalida: %s\n", options.compareFile.getFullPathName().toRawUTF8());
+            return 1;
+        }
+
+        std::printf("\n%-52s %14s %14s %9s\n", "comparacao", "ref am/s", "atual am/s", "delta");
+
+        int regressions = 0;
+
+        for (const auto& result : results)
+        {
+            const auto it = baseline.find(result.name);
+
+            if (it == baseline.end() || it->second <= 0)
+            {
+                std::printf("%-52s %14s %14.4g %9s\n", result.name.toRawUTF8(), "-", result.samplesPerSecond, "novo");
+                continue;
+            }
+
+            // delta positivo = mais rapido que a referencia
+            const double delta = 100.0 * (result.samplesPerSecond - it->second) / it->second;
+            const bool regression = -delta > options.threshold;
+
+            if (regression)
+                ++regressions;
+
+            std::printf("%-52s %14.4g %14.4g %+8.1f%% %s\n", result.name.toRawUTF8(), it->second,
+                        result.samplesPerSecond, delta, regression ? "REGRESSAO" : "");
+        }
+
+        std::printf("\n%d regressao(oes) acima de %.1f%%\n", regressions, options.threshold);
+        return regressions;
+    }
+
+    //==============================================================================
+    // Variantes por conjunto de instrucoes. Os processadores guardam a variante no
+    // prepare(), entao basta limitar o nivel enquanto o caso e criado
+    //------------------------------------------------------------------------------
+    bool parseLevel(const juce::String& name, dsp_core::SimdLevel& level)
+    {
+        for (auto candidate : { dsp_core::SimdLevel::generic, dsp_core::SimdLevel::avx2, dsp_core::SimdLevel::avx512 })
+            if (name == dsp_core::CpuDispatch::getName(candidate))
+            {
+                level = candidate;
+                return true;
+            }
+
+        return false;
+    }
+
+    std::vector<Benchmark> expandLevels(const std::vector<Benchmark>& benchmarks)
+    {
+        std::vector<Benchmark> expanded;
+        const auto maxLevel = dsp_core::CpuDispatch::getMaxLevel();
+
+        for (auto level : { dsp_core::SimdLevel::generic, dsp_core::SimdLevel::avx2, dsp_core::SimdLevel::avx512 })
+        {
+            if (! dsp_core::CpuDispatch::isSupported(level))
+                continue;
+
+            for (const auto& benchmark : benchmarks)
+                expanded.push_back({ benchmark.name + "/isa:" + dsp_core::CpuDispatch::getName(level), benchmark.blockSize,
+                                     [create = benchmark.create, level, maxLevel](int size)
+                                     {
+                                         dsp_core::CpuDispatch::setMaxLevel(level);
+                                         auto kernel = create(size);
+                                         dsp_core::CpuDispatch::setMaxLevel(maxLevel);
+                                         return kernel;
+                                     } });
+        }
+
+        return expanded;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    const auto options = parseOptions(juce::ArgumentList(argc, argv));
+
+    // mesma configuracao de ponto flutuante dos plugins
+    dsp_core::disableDenormals();
+
+    std::vector<Benchmark> benchmarks;
+    addModulatedDelay(benchmarks);
+    addBiquad(benchmarks);
+    addWaveshaper(benchmarks);
+    addNoiseGate(benchmarks);
+    addNeuralAmp(benchmarks);
+    addTriodePreamp(benchmarks);
+    addConvolution(benchmarks);
+    addPartitionedConvolution(benchmarks);
+    addFft(benchmarks);
+    addFdn<8>(benchmarks);
+    addFdn<16>(benchmarks);
+    addAmpChain(benchmarks);
+
+    if (options.isa == "all")
+    {
+        benchmarks = expandLevels(benchmarks);
+    }
+    else if (options.isa.isNotEmpty())
+    {
+        dsp_core::SimdLevel level;
+
+        if (! parseLevel(options.isa, level))
+        {
+            std::printf("variante desconhecida: %s\n", options.isa.toRawUTF8());
+            return 1;
+        }
+
+        dsp_core::CpuDispatch::setMaxLevel(level);
+    }
+
+    std::printf("CPU: %s, variante dos kernels: %s\n\n",
+                dsp_core::CpuDispatch::getName(dsp_core::CpuDispatch::getDetectedLevel()),
+                dsp_core::CpuDispatch::getName(dsp_core::CpuDispatch::getLevel()));
+
+    std::printf("%-52s %14s %14s\n", "caso", "amostras/s", "ciclos/am");
+
+    std::vector<Result> results;
+    int realtimeFailures = 0;
+
+    for (const auto& benchmark : benchmarks)
+    {
+        if (options.filter.isNotEmpty() && ! benchmark.name.contains(options.filter))
+            continue;
+
+        const auto first = results.size();
+        results.push_back(run(benchmark, options));
+        addStageResults(benchmark, results);
+
+        for (auto result = results.begin() + (std::ptrdiff_t)first; result != results.end(); ++result)
+            std::printf("%-52s %14.4g %14.3f\n", result->name.toRawUTF8(), result->samplesPerSecond, result->cyclesPerSample);
+
+        if (dsp_core::RealtimeCheck::getNumViolations() > 0)
+        {
+            dsp_core::RealtimeCheck::printReport(benchmark.name.toRawUTF8());
+            dsp_core::RealtimeCheck::reset();
+            ++realtimeFailures;
+        }
+    }
+
+    if (options.saveFile != juce::File() && ! saveResults(results, options))
+    {
+        std::printf("nao foi possivel gravar %s\n", options.saveFile.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    int exitCode = 0;
+
+    if (options.compareFile != juce::File() && compareResults(results, options) > 0)
+        exitCode = 1;
+
+    if (realtimeFailures > 0)
+    {
+        std::printf("\n%d caso(s) com chamadas proibidas em tempo real\n", realtimeFailures);
+        exitCode = 1;
+    }
+
+    return exitCode;
+}
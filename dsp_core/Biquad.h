@@ -0,0 +1,324 @@
+//==============================================================================
+// Biquad.h: cascata de filtros biquad (IIR de segunda ordem)
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Coeficientes normalizados (a0 = 1). Os make* usam as mesmas formulas de
+    // juce::dsp::IIR::Coefficients, mas sem alocacao: podem ser chamados na thread de audio
+    template <typename SampleType>
+    struct BiquadCoefficients
+    {
+        SampleType b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+
+        // Recebe {b0, b1, b2, a0, a1, a2}, como juce::dsp::IIR::ArrayCoefficients. Zeros e
+        // polos iguais bit a bit (o que os make* de peak e shelf retornam com ganho 1, 0 dB)
+        // viram a identidade exata, sem o erro de arredondamento da normalizacao
+        static BiquadCoefficients fromArray(const std::array<SampleType, 6>& c) noexcept
+        {
+            if (c[0] == c[3] && c[1] == c[4] && c[2] == c[5])
+                return {};
+
+            const SampleType a0inv = c[3] != SampleType(0) ? SampleType(1) / c[3] : SampleType(0);
+            return { c[0] * a0inv, c[1] * a0inv, c[2] * a0inv, c[4] * a0inv, c[5] * a0inv };
+        }
+
+        static BiquadCoefficients makePeakFilter(double sampleRate, SampleType frequency, SampleType Q, SampleType gainFactor) noexcept
+        {
+            return fromArray(juce::dsp::IIR::ArrayCoefficients<SampleType>::makePeakFilter(sampleRate, frequency, Q, gainFactor));
+        }
+
+        static BiquadCoefficients makeLowShelf(double sampleRate, SampleType frequency, SampleType Q, SampleType gainFactor) noexcept
+        {
+            return fromArray(juce::dsp::IIR::ArrayCoefficients<SampleType>::makeLowShelf(sampleRate, frequency, Q, gainFactor));
+        }
+
+        static BiquadCoefficients makeHighShelf(double sampleRate, SampleType frequency, SampleType Q, SampleType gainFactor) noexcept
+        {
+            return fromArray(juce::dsp::IIR::ArrayCoefficients<SampleType>::makeHighShelf(sampleRate, frequency, Q, gainFactor));
+        }
+
+        static BiquadCoefficients makeLowPass(double sampleRate, SampleType frequency, SampleType Q) noexcept
+        {
+            return fromArray(juce::dsp::IIR::ArrayCoefficients<SampleType>::makeLowPass(sampleRate, frequency, Q));
+        }
+
+        static BiquadCoefficients makeHighPass(double sampleRate, SampleType frequency, SampleType Q) noexcept
+        {
+            return fromArray(juce::dsp::IIR::ArrayCoefficients<SampleType>::makeHighPass(sampleRate, frequency, Q));
+        }
+
+        // Atraso de grupo em frequencia zero, em amostras: sum(n * b[n]) / sum(b[n]) menos o
+        // mesmo para a (com a0 = 1). 0 se o ganho em zero for nulo (passa-altas)
+        double getGroupDelayAtDc() const noexcept
+        {
+            const double sumB = (double)b0 + (double)b1 + (double)b2;
+            const double sumA = 1.0 + (double)a1 + (double)a2;
+
+            if (sumB == 0.0 || sumA == 0.0)
+                return 0.0;
+
+            return ((double)b1 + 2.0 * (double)b2) / sumB - ((double)a1 + 2.0 * (double)a2) / sumA;
+        }
+
+        // Resposta exatamente igual a 1 (b = a, sem tolerancia). Um shelf ou peak de
+        // baixa frequencia e Q alto com ganho pequeno tem b e a muito proximos e ainda
+        // assim audiveis, entao so o neutro exato conta
+        bool isIdentity() const noexcept
+        {
+            return b0 == SampleType(1) && b1 == a1 && b2 == a2;
+        }
+    };
+
+    //==============================================================================
+    // NumStages biquads em serie, para todos os canais do bloco (juce::dsp::IIR::Filter
+    // e mono). Forma direta transposta II, com as mesmas operacoes e a mesma ordem de
+    // juce::dsp::IIR::Filter, entao a saida e identica a uma ProcessorChain de filtros.
+    // As amostras passam por todos os estagios de uma vez, com o estado em registradores.
+    //
+    // Sempre no conjunto base, sem as variantes de CpuDispatch: a recursao nao vetoriza
+    // entre amostras, e nas variantes avx2/avx512 as multiplicacoes e somas virariam FMA.
+    // Num peak ou shelf de baixa frequencia e Q alto isso muda a saida em ate ~10% do
+    // efeito do filtro, e o mesmo preset soaria diferente em cada maquina.
+    //
+    // Estagios neutros (isIdentity, ex.: peak ou shelf em exatamente 0 dB) sao pulados:
+    // viram a identidade exata e, depois que o estado deles zera (duas amostras), saem do
+    // laco. A saida e a mesma de processa-los. setOutputGain aplica um ganho linear na saida
+    // sem passada extra, multiplicando os coeficientes b do ultimo estagio nao neutro
+    template <typename SampleType, int NumStages>
+    class BiquadCascade
+    {
+    public:
+        using Coefficients = BiquadCoefficients<SampleType>;
+
+        void prepare(const juce::dsp::ProcessSpec& spec)
+        {
+            state.resize(spec.numChannels);
+            reset();
+        }
+
+        void reset() noexcept
+        {
+            for (auto& channelState : state)
+                channelState.fill({});
+        }
+
+        void setCoefficients(int stage, const Coefficients& newCoefficients) noexcept
+        {
+            jassert(stage >= 0 && stage < NumStages);
+            coefficients[(size_t)stage] = newCoefficients.isIdentity() ? Coefficients() : newCoefficients;
+            updateEffectiveCoefficients();
+        }
+
+        const Coefficients& getCoefficients(int stage) const noexcept { return coefficients[(size_t)stage]; }
+
+        // Ganho dobrado nos coeficientes. O estado dos estagios afetados e reescalado
+        // junto (o filtro e linear), entao trocar o ganho ou o estagio que o recebe nao
+        // descontinua a saida; a rampa, se houver, fica com quem chama
+        void setOutputGain(SampleType newGain) noexcept
+        {
+            outputGain = newGain;
+            updateEffectiveCoefficients();
+        }
+
+        SampleType getOutputGain() const noexcept { return outputGain; }
+
+        // Todos os estagios neutros (sem contar o ganho de saida)
+        bool isFlat() const noexcept
+        {
+            for (const auto& c : coefficients)
+                if (! isExactIdentity(c))
+                    return false;
+
+            return true;
+        }
+
+        // Estado zerado em todos os estagios: sem cauda, entrada zero da saida zero
+        bool isAtRest() const noexcept { return ! hasAnyState(); }
+
+        // A cascata nao altera o sinal: coeficientes neutros, ganho 1 e estado zerado.
+        // So entao pode ficar em bypass sem perder a cauda dos filtros
+        bool isIdentity() const noexcept
+        {
+            return isFlat() && outputGain == SampleType(1) && isAtRest();
+        }
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            auto&& inputBlock = context.getInputBlock();
+            auto&& outputBlock = context.getOutputBlock();
+            const auto numChannels = outputBlock.getNumChannels();
+            const auto numSamples = outputBlock.getNumSamples();
+
+            jassert(inputBlock.getNumChannels() == numChannels);
+            jassert(numChannels <= state.size());
+
+            if (context.isBypassed)
+            {
+                if (context.usesSeparateInputAndOutputBlocks())
+                    outputBlock.copyFrom(inputBlock);
+                return;
+            }
+
+            // estagios que ainda mudam o sinal neste bloco
+            int numActive = 0;
+
+            for (int stage = 0; stage < NumStages; ++stage)
+                if (! isExactIdentity(effective[(size_t)stage]) || hasState(stage))
+                    activeStages[(size_t)numActive++] = stage;
+
+            if (numActive == 0)
+            {
+                if (context.usesSeparateInputAndOutputBlocks())
+                    outputBlock.copyFrom(inputBlock);
+                return;
+            }
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+                processChannel<NumStages>(numActive,
+                                          inputBlock.getChannelPointer(channel),
+                                          outputBlock.getChannelPointer(channel),
+                                          numSamples,
+                                          state[channel]);
+        }
+
+    private:
+        struct StageState
+        {
+            SampleType s1 = 0, s2 = 0;
+        };
+
+        using ChannelState = std::array<StageState, (size_t)NumStages>;
+
+        static bool isExactIdentity(const Coefficients& c) noexcept
+        {
+            return c.b0 == SampleType(1) && c.b1 == SampleType(0) && c.b2 == SampleType(0)
+                && c.a1 == SampleType(0) && c.a2 == SampleType(0);
+        }
+
+        // Algum canal com estado nao nulo no estagio
+        bool hasState(int stage) const noexcept
+        {
+            for (const auto& channelState : state)
+                if (channelState[(size_t)stage].s1 != SampleType(0) || channelState[(size_t)stage].s2 != SampleType(0))
+                    return true;
+
+            return false;
+        }
+
+        bool hasAnyState() const noexcept
+        {
+            for (int stage = 0; stage < NumStages; ++stage)
+                if (hasState(stage))
+                    return true;
+
+            return false;
+        }
+
+        // O ganho vai para o ultimo estagio nao neutro (ou o ultimo, se todos forem). O
+        // estado de cada estagio e proporcional ao produto dos ganhos ate ele, entao e
+        // reescalado pela variacao desse produto
+        void updateEffectiveCoefficients() noexcept
+        {
+            int gainStage = NumStages - 1;
+
+            while (gainStage > 0 && isExactIdentity(coefficients[(size_t)gainStage]))
+                --gainStage;
+
+            for (int stage = 0; stage < NumStages; ++stage)
+            {
+                auto c = coefficients[(size_t)stage];
+                const SampleType scale = stage >= gainStage ? outputGain : SampleType(1);
+
+                if (stage == gainStage)
+                {
+                    c.b0 *= outputGain;
+                    c.b1 *= outputGain;
+                    c.b2 *= outputGain;
+                }
+
+                const SampleType previousScale = stateScale[(size_t)stage];
+
+                if (scale != previousScale && previousScale != SampleType(0))
+                    for (auto& channelState : state)
+                    {
+                        channelState[(size_t)stage].s1 *= scale / previousScale;
+                        channelState[(size_t)stage].s2 *= scale / previousScale;
+                    }
+
+                effective[(size_t)stage] = c;
+                stateScale[(size_t)stage] = scale;
+            }
+        }
+
+        // Uma versao do laco por numero de estagios ativos, para o laco interno continuar
+        // com tamanho fixo e desenrolado
+        template <int NumActive>
+        void processChannel(int numActive, const SampleType* input, SampleType* output, size_t numSamples,
+                            ChannelState& channelState) noexcept
+        {
+            if constexpr (NumActive > 1)
+            {
+                if (numActive < NumActive)
+                    return processChannel<NumActive - 1>(numActive, input, output, numSamples, channelState);
+            }
+
+            std::array<Coefficients, (size_t)NumActive> c;
+            std::array<StageState, (size_t)NumActive> s;
+
+            for (size_t k = 0; k < (size_t)NumActive; ++k)
+            {
+                c[k] = effective[(size_t)activeStages[k]];
+                s[k] = channelState[(size_t)activeStages[k]];
+            }
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                SampleType x = input[i];
+
+                for (size_t stage = 0; stage < (size_t)NumActive; ++stage)
+                {
+                    const SampleType y = (x * c[stage].b0) + s[stage].s1;
+                    s[stage].s1 = (x * c[stage].b1) - (y * c[stage].a1) + s[stage].s2;
+                    s[stage].s2 = (x * c[stage].b2) - (y * c[stage].a2);
+                    x = y;
+                }
+
+                output[i] = x;
+            }
+
+            // zera estado denormal no fim do bloco, como juce::dsp::IIR::Filter
+            // (ativo com JUCE_DSP_ENABLE_SNAP_TO_ZERO)
+            for (size_t k = 0; k < (size_t)NumActive; ++k)
+            {
+                juce::dsp::util::snapToZero(s[k].s1);
+                juce::dsp::util::snapToZero(s[k].s2);
+                channelState[(size_t)activeStages[k]] = s[k];
+            }
+        }
+
+        std::array<Coefficients, (size_t)NumStages> coefficients;
+        std::array<Coefficients, (size_t)NumStages> effective;
+        std::array<SampleType, (size_t)NumStages> stateScale = makeUnitScale();
+        std::array<int, (size_t)NumStages> activeStages {};
+        SampleType outputGain = 1;
+        std::vector<ChannelState> state;
+
+        static std::array<SampleType, (size_t)NumStages> makeUnitScale() noexcept
+        {
+            std::array<SampleType, (size_t)NumStages> scale;
+            scale.fill(SampleType(1));
+            return scale;
+        }
+    };
+}
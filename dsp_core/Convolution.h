@@ -0,0 +1,732 @@
+//==============================================================================
+// Convolution.h: convolucao com orcamento de latencia selecionavel
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "Biquad.h"
+#include "ImpulseResponse.h"
+#include "PartitionedConvolution.h"
+
+namespace dsp_core
+{
+    //==============================================================================
+    // juce::dsp::Convolution com a latencia escolhida pelo usuario. A latencia do
+    // juce::dsp::Convolution so pode ser definida no construtor (o ultimo argumento de
+    // loadImpulseResponse e o tamanho maximo da IR, nao a latencia), entao cada troca de
+    // orcamento cria um motor novo e recarrega nele a IR atual.
+    //
+    // Orcamentos (latencyBudgets):
+    //   0     latencia zero com particionamento nao uniforme: a cabeca da IR (as primeiras
+    //         zeroLatencyHeadSize amostras) usa particoes do tamanho do bloco do host e a
+    //         cauda usa particoes de zeroLatencyHeadSize
+    //   N > 0 particoes uniformes de N amostras, com N amostras de latencia. Particoes
+    //         maiores custam menos FFTs por amostra, e a diferenca cresce com o tamanho da
+    //         IR (ver bench/KernelBench.cpp, casos Convolution/.../latency:N)
+    //
+    // A IR pode ser preparada ao carregar (conversao de taxa, corte por energia, fade-out,
+    // fase minima; ver ImpulseResponse.h). A IR decodificada fica guardada e a preparada
+    // e guardada por taxa de processamento, entao recriar o motor ou voltar a uma taxa ja
+    // usada nao repete o preparo.
+    //
+    // Taxa interna reduzida (setDecimation): em taxas altas a convolucao roda em
+    // taxa / fator (o fator inteiro que leva a taxa para perto de 44.1/48 kHz), entre um
+    // passa-baixas com decimacao e uma insercao de zeros com passa-baixas. A IR fica fator
+    // vezes menor e cada amostra interna custa o mesmo, entao o custo cai perto de fator^2.
+    // So serve para IRs sem energia util acima de decimationCutoffHz, como as de caixa.
+    //
+    // Particoes compartilhadas (setSharedPartitions): em vez do juce::dsp::Convolution, que
+    // guarda uma copia dos espectros da IR por instancia, usa PartitionedConvolution com
+    // espectros imutaveis compartilhados entre todas as instancias do processo que carregam
+    // a mesma IR preparada (ver PartitionedConvolution.h). Particoes do tamanho do
+    // orcamento (no orcamento 0, cabeca direta e particoes de sharedHeadSize amostras) e,
+    // depois de zeroLatencyHeadSize amostras, particoes de zeroLatencyHeadSize na cauda.
+    //
+    // Modos (setMode, ver ConvolutionMode): mono e stereo funcionam nos dois motores;
+    // monoToStereo e trueStereo existem so no PartitionedConvolution, que passa a ser
+    // usado nesses modos mesmo sem particoes compartilhadas.
+    //
+    // FFT (setFftBackend, ver Fft.h): o juce::dsp::Convolution so usa a FFT do JUCE, que
+    // sem FFTW/IPP/vDSP configurados no JUCE e a implementacao generica. Com qualquer
+    // backend diferente de juce (o padrao e automatic), o motor e o PartitionedConvolution
+    // com a FFT escolhida; juce volta ao juce::dsp::Convolution.
+    //
+    // setLatencyBudget, setDecimation, setSharedPartitions, setMode, setFftBackend e loadImpulseResponse
+    // sao chamados fora da thread de audio. O motor novo e publicado por um ponteiro
+    // atomico e adotado por process() no bloco seguinte, sem lock. O motor anterior
+    // continua processando a mesma entrada durante crossfadeSeconds, em crossfade com o
+    // novo (que comeca sem historico), e so entao e devolvido para ser destruido fora da
+    // thread de audio. process() e reset() rodam na thread de audio (ou com ela parada)
+    class Convolution
+    {
+    public:
+        static constexpr int latencyBudgets[] = { 0, 64, 256, 1024 };
+        static constexpr int numLatencyBudgets = 4;
+        static constexpr int maxLatencyBudget = 1024;
+        static constexpr int zeroLatencyHeadSize = 1024;
+
+        // Taxa interna reduzida: taxa alvo e corte dos filtros de conversao
+        static constexpr double decimationTargetRate = 44100.0;
+        static constexpr double decimationCutoffHz = 12000.0;
+
+        // Particoes compartilhadas: cabeca direta (e particao) do orcamento 0
+        static constexpr int sharedHeadSize = 64;
+
+        // Crossfade entre o motor anterior e o novo a cada troca
+        static constexpr double crossfadeSeconds = 0.05;
+
+        // Opcoes para um juce::AudioParameterChoice, na ordem de latencyBudgets
+        static juce::StringArray getLatencyChoices() { return { "0", "64", "256", "1024" }; }
+
+        static int getLatencyBudgetForChoice(int index) noexcept
+        {
+            return latencyBudgets[juce::jlimit(0, numLatencyBudgets - 1, index)];
+        }
+
+        // Opcoes para um juce::AudioParameterChoice, na ordem de ConvolutionMode
+        static juce::StringArray getModeChoices() { return { "mono", "stereo", "mono > stereo", "true stereo" }; }
+
+        static ConvolutionMode getModeForChoice(int index) noexcept
+        {
+            return (ConvolutionMode)juce::jlimit(0, 3, index);
+        }
+
+        Convolution() : engine(std::make_unique<Engine>())
+        {
+            if (! usesPartitionedEngine())
+                engine->convolution = makeEngine(0);
+
+            active = engine.get();
+        }
+
+        //------------------------------------------------------------------------------
+        // Troca o orcamento de latencia, em amostras. Nao faz nada se o orcamento nao mudou
+        void setLatencyBudget(int samples)
+        {
+            if (samples == budget)
+                return;
+
+            budget = samples;
+            rebuild();
+        }
+
+        int getLatencyBudget() const noexcept { return budget; }
+
+        // Liga a taxa interna reduzida. Nao faz nada se o modo nao mudou
+        void setDecimation(bool shouldDecimate)
+        {
+            if (shouldDecimate == decimation)
+                return;
+
+            decimation = shouldDecimate;
+            rebuild();
+        }
+
+        bool isDecimating() const noexcept { return decimation; }
+
+        // Usa particoes compartilhadas entre instancias. Nao faz nada se o modo nao mudou
+        void setSharedPartitions(bool shouldShare)
+        {
+            if (shouldShare == sharing)
+                return;
+
+            sharing = shouldShare;
+            rebuild();
+        }
+
+        bool isSharingPartitions() const noexcept { return sharing; }
+
+        // Roteamento entre entradas, canais da IR e saidas. Nao faz nada se o modo nao mudou
+        void setMode(ConvolutionMode newMode)
+        {
+            if (newMode == mode)
+                return;
+
+            mode = newMode;
+            rebuild();
+        }
+
+        ConvolutionMode getMode() const noexcept { return mode; }
+
+        // Implementacao da FFT. Nao faz nada se nao mudou
+        void setFftBackend(FftBackend newBackend)
+        {
+            if (newBackend == fftBackend)
+                return;
+
+            fftBackend = newBackend;
+            rebuild();
+        }
+
+        FftBackend getFftBackend() const noexcept { return fftBackend; }
+
+        // Latencia real do motor atual, em amostras na taxa do host, incluindo o atraso dos
+        // filtros de conversao com taxa reduzida (pode ser lida na thread de audio)
+        int getLatency() const noexcept { return latency.load(); }
+
+        //------------------------------------------------------------------------------
+        // Preparo aplicado as proximas cargas de IR
+        void setImpulseResponseOptions(const ImpulseResponseOptions& newOptions) { options = newOptions; }
+        const ImpulseResponseOptions& getImpulseResponseOptions() const noexcept { return options; }
+
+        // IR a partir de dados em memoria. Sem preparo e sem taxa interna reduzida, os dados
+        // sao recarregados direto da memoria a cada troca de motor: devem continuar validos
+        // enquanto o processador existir (ex.: arrays estaticos como os de IR.h)
+        void loadImpulseResponse(const void* data, size_t dataSize,
+                                 juce::dsp::Convolution::Trim trim,
+                                 size_t size = 0)
+        {
+            source = {};
+            source.type = Source::memoryData;
+            source.data = data;
+            source.dataSize = dataSize;
+            source.trim = trim;
+            source.size = size;
+            source.options = options;
+            source.decoded = readImpulseResponse(data, dataSize, source.buffer, source.sampleRate);
+
+            reload();
+        }
+
+        // IR a partir de um arquivo de audio
+        void loadImpulseResponse(const juce::File& file,
+                                 juce::dsp::Convolution::Trim trim,
+                                 size_t size = 0)
+        {
+            source = {};
+            source.type = Source::audioFile;
+            source.file = file;
+            source.trim = trim;
+            source.size = size;
+            source.options = options;
+            source.decoded = readImpulseResponse(file, source.buffer, source.sampleRate);
+
+            reload();
+        }
+
+        // Tamanho da IR preparada para o motor atual, em amostras (0 sem preparo)
+        int getPreparedIRSize() const noexcept { return engine->preparedSize; }
+
+        // Quanto a saida ainda dura depois que a entrada fica em silencio, em amostras na
+        // taxa do host: a IR decodificada (antes do corte por energia, que so a encurta)
+        // mais a latencia do motor. -1 se a IR nao foi decodificada aqui. Fora da thread de audio
+        int getTailLength() const
+        {
+            if (! source.decoded || source.sampleRate <= 0.0)
+                return -1;
+
+            int length = source.buffer.getNumSamples();
+
+            if (source.size > 0)
+                length = juce::jmin(length, (int)source.size);
+
+            const double rate = isPrepared ? spec.sampleRate : source.sampleRate;
+            return (int)std::ceil(length * rate / source.sampleRate) + getLatency();
+        }
+
+        int getCurrentIRSize() const
+        {
+            if (engine->convolution != nullptr)
+                return engine->convolution->getCurrentIRSize();
+
+            const auto* partitions = engine->partitioned.getPartitions();
+            return partitions != nullptr ? partitions->impulse.getNumSamples() : 0;
+        }
+
+        // Motor usado para um orcamento (tambem usado pelo bench/KernelBench.cpp)
+        static std::unique_ptr<juce::dsp::Convolution> makeEngine(int samples)
+        {
+            if (samples <= 0)
+                return std::make_unique<juce::dsp::Convolution>(juce::dsp::Convolution::NonUniform { zeroLatencyHeadSize });
+
+            return std::make_unique<juce::dsp::Convolution>(juce::dsp::Convolution::Latency { samples });
+        }
+
+        // Fator de decimacao para uma taxa do host: 1 ate 88.2 kHz, 2 em 88.2/96 kHz,
+        // 4 em 176.4/192 kHz
+        static int getDecimationFactor(double sampleRate) noexcept
+        {
+            return juce::jmax(1, (int)(sampleRate / decimationTargetRate + 1.0e-6));
+        }
+
+        //------------------------------------------------------------------------------
+        // Recria o motor para a nova especificacao e recarrega a IR na taxa interna
+        void prepare(const juce::dsp::ProcessSpec& newSpec)
+        {
+            spec = newSpec;
+            isPrepared = true;
+            rebuild();
+        }
+
+        // Adota o motor publicado, sem crossfade, e zera o estado
+        void reset() noexcept
+        {
+            adoptPendingEngine(false);
+
+            if (fading != nullptr)
+            {
+                releaseEngine(fading);
+                fading = nullptr;
+            }
+
+            if (active->convolution != nullptr)
+                active->convolution->reset();
+
+            active->partitioned.reset();
+            active->downFilter.reset();
+            active->upFilter.reset();
+            active->phase = 0;
+        }
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            adoptPendingEngine(true);
+
+            auto&& outputBlock = context.getOutputBlock();
+            const auto numSamples = outputBlock.getNumSamples();
+
+            // o motor anterior processa uma copia da entrada no proprio buffer de crossfade
+            if (fading != nullptr && (numSamples > (size_t)fading->fadeBuffer.getNumSamples()
+                                      || outputBlock.getNumChannels() > (size_t)fading->fadeBuffer.getNumChannels()))
+            {
+                releaseEngine(fading);
+                fading = nullptr;
+            }
+
+            if (fading != nullptr)
+            {
+                auto fadeBlock = juce::dsp::AudioBlock<float>(fading->fadeBuffer)
+                                     .getSubsetChannelBlock(0, outputBlock.getNumChannels())
+                                     .getSubBlock(0, numSamples);
+                fadeBlock.copyFrom(context.getInputBlock());
+                processWith(*fading, juce::dsp::ProcessContextReplacing<float>(fadeBlock));
+            }
+
+            processWith(*active, context);
+
+            if (fading != nullptr)
+                crossfade(outputBlock);
+        }
+
+    private:
+        // Motor atual: a convolucao e, com taxa interna reduzida, os filtros de conversao
+        // e o buffer na taxa interna. E trocado inteiro (ver adoptPendingEngine)
+        struct Engine
+        {
+            std::unique_ptr<juce::dsp::Convolution> convolution;  // nulo com particoes compartilhadas
+            PartitionedConvolution partitioned;
+            int factor = 1;
+            BiquadCascade<float, 4> downFilter, upFilter;
+            juce::AudioBuffer<float> internal;
+            int phase = 0;          // posicao da proxima amostra dentro do grupo de factor
+            int preparedSize = 0;
+            int filterLatency = 0;  // atraso dos passa-baixas de conversao, na taxa do host
+
+            // saida deste motor enquanto ele sai em crossfade, e a duracao do crossfade
+            juce::AudioBuffer<float> fadeBuffer;
+            int fadeLength = 0;
+        };
+
+        // Ultima IR carregada, para recarregar no motor novo
+        struct Source
+        {
+            enum Type { none, memoryData, audioFile };
+
+            Type type = none;
+            const void* data = nullptr;
+            size_t dataSize = 0;
+            juce::File file;
+            juce::dsp::Convolution::Trim trim = juce::dsp::Convolution::Trim::yes;
+            size_t size = 0;
+            ImpulseResponseOptions options;
+
+            // IR decodificada, na taxa do arquivo, e as versoes preparadas por taxa
+            bool decoded = false;
+            juce::AudioBuffer<float> buffer;
+            double sampleRate = 0.0;
+            std::map<double, juce::AudioBuffer<float>> prepared;
+        };
+
+        // O PartitionedConvolution nao pode ser recarregado enquanto processa: o motor e
+        // trocado inteiro. O juce::dsp::Convolution troca a IR internamente
+        void reload()
+        {
+            if (usesPartitionedEngine())
+                rebuild();
+            else
+                loadSource(*engine);
+        }
+
+        void rebuild()
+        {
+            auto newEngine = std::make_unique<Engine>();
+
+            if (! usesPartitionedEngine())
+                newEngine->convolution = makeEngine(budget);
+
+            if (isPrepared)
+            {
+                newEngine->factor = decimation ? getDecimationFactor(spec.sampleRate) : 1;
+
+                auto internalSpec = spec;
+                internalSpec.sampleRate = spec.sampleRate / newEngine->factor;
+                internalSpec.maximumBlockSize = spec.maximumBlockSize / (juce::uint32)newEngine->factor + 1;
+                if (newEngine->convolution != nullptr)
+                    newEngine->convolution->prepare(internalSpec);
+
+                if (newEngine->factor > 1)
+                {
+                    // Butterworth de 8a ordem: os Q dos 4 pares de polos
+                    static constexpr float q[] = { 0.50980f, 0.60134f, 0.89998f, 2.56292f };
+                    const float cutoff = (float)juce::jmin(decimationCutoffHz, 0.25 * internalSpec.sampleRate);
+
+                    newEngine->downFilter.prepare(spec);
+                    newEngine->upFilter.prepare(spec);
+
+                    double filterDelay = 0.0;
+
+                    for (int stage = 0; stage < 4; ++stage)
+                    {
+                        const auto lowPass = BiquadCoefficients<float>::makeLowPass(spec.sampleRate, cutoff, q[stage]);
+                        filterDelay += 2.0 * lowPass.getGroupDelayAtDc();
+                        newEngine->downFilter.setCoefficients(stage, lowPass);
+                        newEngine->upFilter.setCoefficients(stage, lowPass);
+                    }
+
+                    // os dois filtros atrasam a banda passante; o atraso de grupo em
+                    // frequencia zero vale para a regiao de graves e medios de uma IR de caixa
+                    newEngine->filterLatency = juce::roundToInt(filterDelay);
+
+                    newEngine->internal.setSize((int)spec.numChannels, (int)internalSpec.maximumBlockSize);
+                }
+
+                newEngine->fadeBuffer.setSize((int)spec.numChannels, (int)spec.maximumBlockSize);
+                newEngine->fadeLength = juce::jmax(1, (int)(crossfadeSeconds * spec.sampleRate));
+            }
+
+            loadSource(*newEngine);
+
+            const int engineLatency = newEngine->convolution != nullptr ? newEngine->convolution->getLatency()
+                                                                        : newEngine->partitioned.getLatency();
+            latency.store(engineLatency * newEngine->factor + newEngine->filterLatency);
+
+            // destroi os motores que a thread de audio ja devolveu e publica o novo. O anterior
+            // fica guardado ate ser devolvido; se a thread de audio nem chegou a adota-lo,
+            // pode ser destruido ja
+            destroyReleasedEngines();
+
+            auto* published = newEngine.get();
+            retiredEngines.push_back(std::move(engine));
+            engine = std::move(newEngine);
+
+            if (auto* skipped = pending.exchange(published))
+                destroyRetiredEngine(skipped);
+        }
+
+        // Motores devolvidos pela thread de audio (releaseEngine)
+        void destroyReleasedEngines()
+        {
+            const auto scope = releasedFifo.read(releasedFifo.getNumReady());
+
+            for (int i = 0; i < scope.blockSize1; ++i)
+                destroyRetiredEngine(releasedEngines[(size_t)(scope.startIndex1 + i)]);
+
+            for (int i = 0; i < scope.blockSize2; ++i)
+                destroyRetiredEngine(releasedEngines[(size_t)(scope.startIndex2 + i)]);
+        }
+
+        void destroyRetiredEngine(Engine* target)
+        {
+            retiredEngines.erase(std::remove_if(retiredEngines.begin(), retiredEngines.end(),
+                                                [target](const auto& retired) { return retired.get() == target; }),
+                                 retiredEngines.end());
+        }
+
+        //------------------------------------------------------------------------------
+        // Thread de audio: troca para o motor publicado. Com crossfade, o atual passa a sair
+        // em fade-out (um crossfade ainda em andamento e interrompido)
+        void adoptPendingEngine(bool withCrossfade) noexcept
+        {
+            auto* next = pending.exchange(nullptr);
+
+            if (next == nullptr)
+                return;
+
+            if (fading != nullptr)
+                releaseEngine(fading);
+
+            fading = nullptr;
+
+            if (withCrossfade && active->fadeLength > 0)
+            {
+                fading = active;
+                fadeLength = active->fadeLength;
+                fadePosition = 0;
+            }
+            else
+            {
+                releaseEngine(active);
+            }
+
+            active = next;
+        }
+
+        // Thread de audio: devolve um motor que nao sera mais usado. A fila so enche se a
+        // thread de mensagens parar de trocar motores; o motor entao fica guardado ate o
+        // destrutor
+        void releaseEngine(Engine* target) noexcept
+        {
+            const auto scope = releasedFifo.write(1);
+
+            if (scope.blockSize1 > 0)
+                releasedEngines[(size_t)scope.startIndex1] = target;
+            else if (scope.blockSize2 > 0)
+                releasedEngines[(size_t)scope.startIndex2] = target;
+            else
+                jassertfalse;
+        }
+
+        // Rampa linear do motor anterior (em fadeBuffer) para o novo (no bloco)
+        void crossfade(juce::dsp::AudioBlock<float>& block) noexcept
+        {
+            const int numSamples = (int)block.getNumSamples();
+            const int count = juce::jmin(numSamples, fadeLength - fadePosition);
+
+            for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+            {
+                float* y = block.getChannelPointer(channel);
+                const float* previous = fading->fadeBuffer.getReadPointer((int)channel);
+
+                for (int i = 0; i < count; ++i)
+                {
+                    const float position = (float)(fadePosition + i + 1) / (float)fadeLength;
+                    y[i] = previous[i] + position * (y[i] - previous[i]);
+                }
+            }
+
+            fadePosition += count;
+
+            if (fadePosition >= fadeLength)
+            {
+                releaseEngine(fading);
+                fading = nullptr;
+            }
+        }
+
+        bool usesPartitionedEngine() const noexcept
+        {
+            return sharing || fftBackend != FftBackend::juce
+                || mode == ConvolutionMode::monoToStereo || mode == ConvolutionMode::trueStereo;
+        }
+
+        juce::dsp::Convolution::Stereo getStereo() const noexcept
+        {
+            return mode == ConvolutionMode::mono ? juce::dsp::Convolution::Stereo::no : juce::dsp::Convolution::Stereo::yes;
+        }
+
+        void loadSource(Engine& target)
+        {
+            target.preparedSize = 0;
+
+            if (source.type == Source::none)
+                return;
+
+            // sem preparo (ou sem decodificar), o proprio motor le e converte a IR
+            if (target.convolution != nullptr && (! source.decoded || (source.options.isIdentity() && target.factor == 1)))
+            {
+                if (source.type == Source::memoryData)
+                    target.convolution->loadImpulseResponse(source.data, source.dataSize, getStereo(), source.trim, source.size);
+                else
+                    target.convolution->loadImpulseResponse(source.file, getStereo(), source.trim, source.size);
+
+                return;
+            }
+
+            // Taxa da IR preparada: a taxa interna, se a conversao for feita aqui. Com taxa
+            // interna reduzida a conversao e sempre feita aqui (sinc, se a opcao for engine),
+            // pois a IR precisa ficar abaixo da Nyquist interna. Antes de prepare() a taxa
+            // interna nao e conhecida e a IR fica na taxa do arquivo. As particoes
+            // compartilhadas nao convertem a taxa, entao a conversao tambem e feita aqui
+            auto resampling = source.options.resampling;
+
+            if (resampling == ResamplingQuality::engine && (target.factor > 1 || target.convolution == nullptr))
+                resampling = ResamplingQuality::sinc;
+
+            if (! source.decoded || (target.convolution == nullptr && ! isPrepared))
+                return;
+
+            const double rate = isPrepared && resampling != ResamplingQuality::engine
+                              ? spec.sampleRate / target.factor : source.sampleRate;
+
+            auto prepared = source.prepared.find(rate);
+
+            if (prepared == source.prepared.end())
+            {
+                juce::AudioBuffer<float> ir(source.buffer);
+
+                if (source.size > 0 && (int)source.size < ir.getNumSamples())
+                    ir.setSize(ir.getNumChannels(), (int)source.size, true);
+
+                resampleImpulseResponse(ir, source.sampleRate, rate, resampling);
+                processImpulseResponse(ir, rate, source.options);
+
+                prepared = source.prepared.emplace(rate, std::move(ir)).first;
+            }
+
+            target.preparedSize = prepared->second.getNumSamples();
+
+            if (target.convolution != nullptr)
+            {
+                target.convolution->loadImpulseResponse(juce::AudioBuffer<float>(prepared->second), rate,
+                                                        getStereo(), source.trim, juce::dsp::Convolution::Normalise::yes);
+                return;
+            }
+
+            // PartitionedConvolution: corte, canais e normalizacao como no juce::dsp::Convolution
+            juce::AudioBuffer<float> ir(prepared->second);
+
+            if (ir.getNumChannels() > getNumImpulseChannels(mode))
+                ir.setSize(getNumImpulseChannels(mode), ir.getNumSamples(), true);
+
+            if (source.trim == juce::dsp::Convolution::Trim::yes)
+                trimSilence(ir);
+
+            normaliseImpulseResponse(ir);
+
+            const int partitionSize = budget > 0 ? budget : sharedHeadSize;
+            target.partitioned.prepare(ImpulseResponsePartitions::getShared(ir, partitionSize, budget <= 0, zeroLatencyHeadSize, fftBackend),
+                                       (int)spec.numChannels, mode);
+        }
+
+        template <typename ProcessContext>
+        static void processWith(Engine& target, const ProcessContext& context) noexcept
+        {
+            if (target.factor == 1)
+            {
+                processEngine(target, context);
+                return;
+            }
+
+            auto&& outputBlock = context.getOutputBlock();
+
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom(context.getInputBlock());
+
+            processDecimated(target, outputBlock);
+        }
+
+        template <typename ProcessContext>
+        static void processEngine(Engine& target, const ProcessContext& context) noexcept
+        {
+            if (target.convolution != nullptr)
+                target.convolution->process(context);
+            else
+                target.partitioned.process(context);
+        }
+
+        //------------------------------------------------------------------------------
+        // Passa-baixas -> decimacao -> convolucao na taxa interna -> insercao de zeros ->
+        // passa-baixas. As duas conversoes seguem a mesma sequencia de fases, entao o bloco
+        // interno tem o mesmo numero de amostras na ida e na volta
+        static void processDecimated(Engine& target, juce::dsp::AudioBlock<float>& block) noexcept
+        {
+            const int numSamples = (int)block.getNumSamples();
+            const int numChannels = juce::jmin((int)block.getNumChannels(), target.internal.getNumChannels());
+            const int factor = target.factor;
+
+            // factor repoe a energia perdida na insercao de zeros. A IR e normalizada por
+            // energia na taxa interna, com 1/factor das amostras: sqrt(factor) devolve a
+            // banda passante ao nivel da IR normalizada na taxa do host
+            const float gain = (float)factor * std::sqrt((float)factor);
+
+            target.downFilter.process(juce::dsp::ProcessContextReplacing<float>(block));
+
+            int numInternal = 0;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                const float* x = block.getChannelPointer((size_t)channel);
+                float* internal = target.internal.getWritePointer(channel);
+                int phase = target.phase;
+                numInternal = 0;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    if (phase == 0)
+                        internal[numInternal++] = x[i];
+
+                    if (++phase == factor)
+                        phase = 0;
+                }
+            }
+
+            if (numInternal > 0)
+            {
+                juce::dsp::AudioBlock<float> internalBlock(target.internal);
+                auto subBlock = internalBlock.getSubsetChannelBlock(0, (size_t)numChannels).getSubBlock(0, (size_t)numInternal);
+                processEngine(target, juce::dsp::ProcessContextReplacing<float>(subBlock));
+            }
+
+            // zeros entre as amostras internas, com o ganho acima
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                float* y = block.getChannelPointer((size_t)channel);
+                const float* internal = target.internal.getReadPointer(channel);
+                int phase = target.phase;
+                int j = 0;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    y[i] = phase == 0 ? gain * internal[j++] : 0.0f;
+
+                    if (++phase == factor)
+                        phase = 0;
+                }
+            }
+
+            target.upFilter.process(juce::dsp::ProcessContextReplacing<float>(block));
+            target.phase = (target.phase + numSamples) % factor;
+        }
+
+        // Thread de mensagens: engine e o ultimo motor criado (dono), retiredEngines os
+        // anteriores que a thread de audio pode ainda estar usando
+        std::unique_ptr<Engine> engine;
+        std::vector<std::unique_ptr<Engine>> retiredEngines;
+
+        // Passagem entre as threads: motor publicado e ainda nao adotado, e motores que a
+        // thread de audio devolveu
+        std::atomic<Engine*> pending { nullptr };
+        static constexpr int releasedCapacity = 16;
+        juce::AbstractFifo releasedFifo { releasedCapacity };
+        std::array<Engine*, (size_t)releasedCapacity> releasedEngines {};
+
+        // Thread de audio: motor em uso e o anterior, em fade-out
+        Engine* active = nullptr;
+        Engine* fading = nullptr;
+        int fadeLength = 0, fadePosition = 0;
+        int budget = 0;
+        bool decimation = false;
+        bool sharing = false;
+        ConvolutionMode mode = ConvolutionMode::stereo;
+        FftBackend fftBackend = FftBackend::automatic;
+        std::atomic<int> latency { 0 };
+
+        juce::dsp::ProcessSpec spec {};
+        bool isPrepared = false;
+        Source source;
+        ImpulseResponseOptions options;
+
+        JUCE_DECLARE_NON_COPYABLE (Convolution)
+    };
+}
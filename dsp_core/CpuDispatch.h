@@ -0,0 +1,131 @@
+//==============================================================================
+// CpuDispatch.h: escolha em tempo de execucao do conjunto de instrucoes dos kernels
+//==============================================================================
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+// Variantes por conjunto de instrucoes com atributos de funcao do GCC/Clang, sem flags
+// de compilacao por arquivo. Com DSP_CORE_DISPATCH=0 (ou em outros compiladores, como o
+// MSVC, que so gera AVX com /arch para o arquivo todo) fica so a variante base
+#ifndef DSP_CORE_DISPATCH
+ #define DSP_CORE_DISPATCH 1
+#endif
+
+#if DSP_CORE_DISPATCH && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+ #define DSP_CORE_DISPATCH_X86 1
+ #define DSP_CORE_TARGET_AVX2 __attribute__((target("avx2,fma"), flatten))
+ #define DSP_CORE_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma"), flatten))
+#else
+ #define DSP_CORE_DISPATCH_X86 0
+#endif
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Variantes dos kernels:
+    //   generic  conjunto base do build (SSE2 em x86-64; NEON em arm64, onde e obrigatorio)
+    //   avx2     AVX2 + FMA
+    //   avx512   AVX-512F (vetores de 16 floats)
+    enum class SimdLevel { generic, avx2, avx512 };
+
+    //==============================================================================
+    // Nivel detectado pelo CPUID (via juce::SystemStats) uma vez por processo. O mesmo
+    // binario roda em maquinas diferentes: cada processador escolhe o nivel no prepare(),
+    // que rodam em prepareToPlay. setMaxLevel e a variavel de ambiente DSP_CORE_MAX_SIMD
+    // (generic, avx2, avx512) limitam o nivel, para comparar variantes ou contornar um
+    // problema em uma maquina especifica; valem para os prepare() seguintes
+    class CpuDispatch
+    {
+    public:
+        static SimdLevel getDetectedLevel() noexcept
+        {
+            static const SimdLevel detected = detect();
+            return detected;
+        }
+
+        static SimdLevel getLevel() noexcept
+        {
+            return juce::jmin(getDetectedLevel(), maxLevel().load());
+        }
+
+        static void setMaxLevel(SimdLevel newMaxLevel) noexcept { maxLevel().store(newMaxLevel); }
+        static SimdLevel getMaxLevel() noexcept { return maxLevel().load(); }
+
+        static bool isSupported(SimdLevel level) noexcept { return level <= getDetectedLevel(); }
+
+        static const char* getName(SimdLevel level) noexcept
+        {
+            switch (level)
+            {
+                case SimdLevel::avx2:   return "avx2";
+                case SimdLevel::avx512: return "avx512";
+                case SimdLevel::generic: break;
+            }
+            return "generic";
+        }
+
+    private:
+        static SimdLevel detect() noexcept
+        {
+           #if DSP_CORE_DISPATCH_X86
+            if (juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+                return SimdLevel::avx512;
+            if (juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+                return SimdLevel::avx2;
+           #endif
+            return SimdLevel::generic;
+        }
+
+        static std::atomic<SimdLevel>& maxLevel() noexcept
+        {
+            static std::atomic<SimdLevel> value { readEnvironment() };
+            return value;
+        }
+
+        static SimdLevel readEnvironment() noexcept
+        {
+            if (const char* name = std::getenv("DSP_CORE_MAX_SIMD"))
+            {
+                if (std::strcmp(name, "generic") == 0) return SimdLevel::generic;
+                if (std::strcmp(name, "avx2") == 0)    return SimdLevel::avx2;
+            }
+            return SimdLevel::avx512;
+        }
+    };
+
+    //==============================================================================
+    // Roda kernel() na variante do nivel. Cada variante e a mesma funcao compilada com
+    // outro conjunto de instrucoes: flatten expande kernel e o que ele chama dentro dela,
+    // entao os lacos sao vetorizados para aquele conjunto. O nivel vem de
+    // CpuDispatch::getLevel() guardado no prepare() do processador, nunca do CPUID no laco
+    //------------------------------------------------------------------------------
+   #if DSP_CORE_DISPATCH_X86
+    template <typename Kernel>
+    DSP_CORE_TARGET_AVX2 void runAvx2(const Kernel& kernel) noexcept { kernel(); }
+
+    template <typename Kernel>
+    DSP_CORE_TARGET_AVX512 void runAvx512(const Kernel& kernel) noexcept { kernel(); }
+   #endif
+
+    template <typename Kernel>
+    inline void dispatch(SimdLevel level, const Kernel& kernel) noexcept
+    {
+       #if DSP_CORE_DISPATCH_X86
+        switch (level)
+        {
+            case SimdLevel::avx512: runAvx512(kernel); return;
+            case SimdLevel::avx2:   runAvx2(kernel); return;
+            case SimdLevel::generic: break;
+        }
+       #else
+        juce::ignoreUnused(level);
+       #endif
+        kernel();
+    }
+}
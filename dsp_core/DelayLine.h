@@ -0,0 +1,278 @@
+//==============================================================================
+// DelayLine.h: linhas de delay (buffer circular), delay com realimentacao e
+// delay modulado por LFO (vibrato, flanger, chorus)
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include "CpuDispatch.h"
+#include "Denormals.h"
+#include "Interpolation.h"
+#include "Lfo.h"
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Buffer circular com um canal por canal de audio. Todos os canais compartilham a
+    // mesma posicao de escrita: cada canal parte da posicao atual e, depois do bloco,
+    // a posicao e avancada uma unica vez (advance)
+    template <typename SampleType>
+    class DelayLine
+    {
+    public:
+        DelayLine() : buffer(1, 1) { buffer.clear(); }
+
+        // Aloca o buffer (fora da thread de audio)
+        void prepare(int numChannels, int newLength)
+        {
+            length = juce::jmax(1, newLength);
+            buffer.setSize(juce::jmax(1, numChannels), length);
+            reset();
+        }
+
+        void reset() noexcept
+        {
+            buffer.clear();
+            writePosition = 0;
+        }
+
+        int getLength() const noexcept { return length; }
+        int getWritePosition() const noexcept { return writePosition; }
+
+        // Canais alem dos alocados usam o ultimo canal
+        SampleType* getChannel(int channel) noexcept
+        {
+            return buffer.getWritePointer(juce::jmin(channel, buffer.getNumChannels() - 1));
+        }
+
+        const SampleType* getChannel(int channel) const noexcept
+        {
+            return buffer.getReadPointer(juce::jmin(channel, buffer.getNumChannels() - 1));
+        }
+
+        void advance(int numSamples) noexcept { writePosition = (writePosition + numSamples) % length; }
+
+    private:
+        juce::AudioBuffer<SampleType> buffer;
+        int length = 1;
+        int writePosition = 0;
+    };
+
+    //==============================================================================
+    // Delay de tempo fixo com realimentacao:
+    //   y[n] = dry * x[n] + wet * d[n],   d[n + D] = x[n] + feedback * d[n]
+    template <typename SampleType>
+    class FeedbackDelay
+    {
+    public:
+        // maxDelaySeconds define o tamanho do buffer
+        void prepare(const juce::dsp::ProcessSpec& spec, double maxDelaySeconds)
+        {
+            sampleRate = spec.sampleRate;
+            delayLine.prepare((int)spec.numChannels, (int)(maxDelaySeconds * sampleRate));
+            readPosition = 0;
+        }
+
+        void reset() noexcept
+        {
+            delayLine.reset();
+            readPosition = 0;
+            updateReadPosition();
+        }
+
+        // Tempo em segundos. A posicao de leitura e recalculada a partir da escrita,
+        // entao a troca de tempo tem efeito imediato (sem rampa)
+        void setDelay(double seconds) noexcept
+        {
+            delaySeconds = seconds;
+            updateReadPosition();
+        }
+
+        void setFeedback(SampleType newFeedback) noexcept { feedback = newFeedback; }
+        void setDryLevel(SampleType newDryLevel) noexcept { dryLevel = newDryLevel; }
+        void setWetLevel(SampleType newWetLevel) noexcept { wetLevel = newWetLevel; }
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            auto&& inputBlock = context.getInputBlock();
+            auto&& outputBlock = context.getOutputBlock();
+            const int numSamples = (int)outputBlock.getNumSamples();
+            const int length = delayLine.getLength();
+
+            int dpr = readPosition;
+            int dpw = delayLine.getWritePosition();
+
+            for (size_t channel = 0; channel < outputBlock.getNumChannels(); ++channel)
+            {
+                const SampleType* input = inputBlock.getChannelPointer(channel);
+                SampleType* output = outputBlock.getChannelPointer(channel);
+                SampleType* delayData = delayLine.getChannel((int)channel);
+
+                // cada canal parte das mesmas posicoes
+                dpr = readPosition;
+                dpw = delayLine.getWritePosition();
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const SampleType in = input[i];
+                    const SampleType delayed = delayData[dpr];
+
+                    // o caminho de realimentacao e zerado abaixo do limiar para que a cauda
+                    // va a zero em vez de recircular denormais (ver Denormals.h)
+                    delayData[dpw] = flushDenormal(in + (delayed * feedback));
+
+                    if (++dpr >= length)
+                        dpr = 0;
+                    if (++dpw >= length)
+                        dpw = 0;
+
+                    output[i] = dryLevel * in + wetLevel * delayed;
+                }
+            }
+
+            readPosition = dpr;
+            delayLine.advance(numSamples);
+        }
+
+    private:
+        void updateReadPosition() noexcept
+        {
+            const int length = delayLine.getLength();
+            readPosition = (int)(delayLine.getWritePosition() - (delaySeconds * sampleRate) + length) % length;
+        }
+
+        DelayLine<SampleType> delayLine;
+        double sampleRate = 44100.0;
+        double delaySeconds = 0.0;
+        int readPosition = 0;
+
+        SampleType feedback = 0;
+        SampleType dryLevel = 1;
+        SampleType wetLevel = 0;
+    };
+
+    //==============================================================================
+    // Delay modulado por LFO, base de vibrato, flanger e chorus. Cada voz le o buffer em
+    //   delay + sweepWidth * lfo(fase + offset da voz)    (segundos)
+    // e a saida e dry * x[n] + depth * (soma das vozes). A escrita recebe a entrada mais
+    // a ultima voz lida multiplicada pela realimentacao.
+    //   vibrato: dry = 0, depth = 1, 1 voz
+    //   flanger: dry = 1, 1 voz, com realimentacao
+    //   chorus:  dry = 1, delay > 0, 1 a 4 vozes defasadas
+    template <typename SampleType>
+    class ModulatedDelay
+    {
+    public:
+        // maxDelaySeconds deve cobrir delay + sweepWidth. O buffer tem 3 amostras extras
+        // para a interpolacao cubica
+        void prepare(const juce::dsp::ProcessSpec& spec, double maxDelaySeconds)
+        {
+            sampleRate = (SampleType)spec.sampleRate;
+            delayLine.prepare((int)spec.numChannels, (int)(maxDelaySeconds * spec.sampleRate) + 3);
+            lfo.prepare(spec);
+            simdLevel = CpuDispatch::getLevel();
+        }
+
+        void reset() noexcept
+        {
+            delayLine.reset();
+            lfo.reset();
+        }
+
+        void setDelay(SampleType seconds) noexcept { delay = seconds; }
+        void setSweepWidth(SampleType seconds) noexcept { sweepWidth = seconds; }
+        void setFrequency(SampleType hz) noexcept { lfo.setFrequency(hz); }
+        void setDepth(SampleType newDepth) noexcept { depth = newDepth; }
+        void setDryLevel(SampleType newDryLevel) noexcept { dryLevel = newDryLevel; }
+        void setFeedback(SampleType newFeedback) noexcept { feedback = newFeedback; }
+        void setInterpolation(Interpolation newInterpolation) noexcept { interpolation = newInterpolation; }
+
+        // Numero de vozes lidas do buffer (sem contar o sinal original)
+        void setNumVoices(int newNumVoices) noexcept { numVoices = juce::jmax(1, newNumVoices); }
+
+        // Amostras subtraidas da posicao de leitura, para garantir que ha amostras ja
+        // escritas suficientes para interpolar com delay proximo de zero
+        void setReadGuard(SampleType samples) noexcept { readGuard = samples; }
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            auto&& inputBlock = context.getInputBlock();
+            auto&& outputBlock = context.getOutputBlock();
+            const int numSamples = (int)outputBlock.getNumSamples();
+            const int length = delayLine.getLength();
+            const SampleType phaseIncrement = lfo.getPhaseIncrement();
+
+            // 2 vozes (1 atrasada) usam quadratura; acima disso as fases sao distribuidas
+            // uniformemente
+            const SampleType phaseStep = numVoices < 2 ? SampleType(0.25) : SampleType(1) / (SampleType)numVoices;
+
+            SampleType ph = lfo.getPhase();
+
+            // o laco inteiro roda na variante do conjunto de instrucoes escolhida no prepare
+            dispatch(simdLevel, [&]
+            {
+                for (size_t channel = 0; channel < outputBlock.getNumChannels(); ++channel)
+                {
+                    const SampleType* input = inputBlock.getChannelPointer(channel);
+                    SampleType* output = outputBlock.getChannelPointer(channel);
+                    SampleType* delayData = delayLine.getChannel((int)channel);
+
+                    // cada canal e processado de forma identica, a partir do mesmo estado
+                    int dpw = delayLine.getWritePosition();
+                    ph = lfo.getPhase();
+
+                    for (int i = 0; i < numSamples; ++i)
+                    {
+                        const SampleType in = input[i];
+                        SampleType out = dryLevel * in;
+                        SampleType interpolatedSample = 0;
+                        SampleType phaseOffset = 0;
+
+                        for (int voice = 0; voice < numVoices; ++voice)
+                        {
+                            const SampleType currentDelay = delay + sweepWidth * Lfo<SampleType>::unipolarSine(ph + phaseOffset);
+
+                            const SampleType dpr = std::fmod((SampleType)dpw - (SampleType)(currentDelay * sampleRate) + (SampleType)length - readGuard,
+                                                             (SampleType)length);
+
+                            interpolatedSample = interpolate(delayData, length, dpr, interpolation);
+                            out += depth * interpolatedSample;
+                            phaseOffset += phaseStep;
+                        }
+
+                        delayData[dpw] = flushDenormal(in + (interpolatedSample * feedback));
+
+                        if (++dpw >= length)
+                            dpw = 0;
+
+                        output[i] = out;
+
+                        ph = Lfo<SampleType>::advance(ph, phaseIncrement);
+                    }
+                }
+            });
+
+            lfo.setPhase(ph);
+            delayLine.advance(numSamples);
+        }
+
+    private:
+        DelayLine<SampleType> delayLine;
+        Lfo<SampleType> lfo;
+        SampleType sampleRate = 44100;
+
+        SampleType delay = 0;
+        SampleType sweepWidth = 0;
+        SampleType depth = 1;
+        SampleType dryLevel = 1;
+        SampleType feedback = 0;
+        SampleType readGuard = 3;
+        int numVoices = 1;
+        Interpolation interpolation = Interpolation::Linear;
+        SimdLevel simdLevel = SimdLevel::generic;
+    };
+}
@@ -0,0 +1,46 @@
+//==============================================================================
+// Denormals.h: protecao contra numeros denormais no processamento
+//==============================================================================
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <cmath>
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Ativa FTZ/DAZ (flush-to-zero / denormals-are-zero) na thread que chama.
+    // Diferente de juce::ScopedNoDenormals, o registrador de controle da CPU (MXCSR/FPCR)
+    // nao e restaurado no fim do bloco: ele so e escrito se ainda nao estiver configurado,
+    // entao em regime o custo por bloco e uma unica leitura do registrador.
+    inline void disableDenormals() noexcept
+    {
+        if (! juce::FloatVectorOperations::areDenormalsDisabled())
+            juce::FloatVectorOperations::disableDenormalisedNumberSupport(true);
+    }
+
+    // Limiar abaixo do qual o estado e zerado (-300 dB): muito acima da faixa de
+    // denormais (~1e-38 em float) e muito abaixo de qualquer sinal audivel
+    template <typename SampleType>
+    constexpr SampleType denormalThreshold = static_cast<SampleType>(1.0e-15);
+
+    //------------------------------------------------------------------------------
+    // Zera valores muito pequenos. Usado na escrita de lacos de realimentacao para que
+    // o estado nunca decaia ate a faixa de denormais, mesmo em plataformas onde o modo
+    // FTZ nao e respeitado. Compila para comparacao + mascara, sem desvio.
+    template <typename SampleType>
+    inline SampleType flushDenormal(SampleType x) noexcept
+    {
+        return std::abs(x) < denormalThreshold<SampleType> ? SampleType(0) : x;
+    }
+
+    // Mesma operacao para um bloco de estado (ex.: buffer de delay inteiro)
+    template <typename SampleType>
+    inline void flushDenormals(SampleType* data, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            data[i] = flushDenormal(data[i]);
+    }
+}
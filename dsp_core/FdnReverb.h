@@ -0,0 +1,339 @@
+//==============================================================================
+// FdnReverb.h: reverb algoritmico por rede de linhas de delay realimentadas (FDN)
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <cmath>
+#include <vector>
+
+#include "Denormals.h"
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Matriz de realimentacao (ambas ortogonais: a rede so perde energia nos ganhos
+    // de cada linha):
+    //   hadamard     H / sqrt(N) pela transformada rapida de Walsh-Hadamard, N log2 N somas.
+    //                Mistura densa: cada linha alimenta todas com o mesmo peso
+    //   householder  I - 2/N * 1 1^T, 2N operacoes. Mistura mais fraca, eco inicial mais
+    //                esparso
+    enum class FdnMatrix { hadamard, householder };
+
+    //==============================================================================
+    // FDN de NumLines linhas (8 ou 16). Por amostra: le a saida das linhas, aplica o
+    // ganho e o filtro de amortecimento de cada linha, mistura pela matriz e escreve de
+    // volta com a entrada. O custo por amostra e fixo e nao depende do tempo de decaimento.
+    //
+    // Layout para SIMD: o estado de todas as linhas fica em arrays de NumLines elementos
+    // (ganhos, filtros, modulacao) e as linhas dividem um unico buffer intercalado
+    // (posicao * NumLines + linha). A escrita das NumLines linhas e um acesso contiguo, e
+    // os lacos sobre as linhas tem tamanho fixo, entao o compilador os vetoriza.
+    //
+    // Parametros (setSize, setDecay, setDamping, setModulation, sem alocacao):
+    //   size        0..1, escala os tempos das linhas entre minDelayMs e maxDelayMs
+    //   decay       RT60 em baixas frequencias, em segundos
+    //   damping     0..1, razao entre o RT60 em Nyquist e o RT60 em baixas frequencias
+    //               (0 = igual, 1 = 10 vezes menor). Filtro de 1 polo por linha com o ganho
+    //               exato em DC e em Nyquist (Jot)
+    //   modulation  0..1, variacao lenta dos tempos das linhas (ate maxModulationMs), que
+    //               desfaz as ressonancias metalicas da cauda
+    //
+    // Entrada: canais alternados nas linhas (linha i recebe o canal i % canais). Saida:
+    // canal c soma as linhas c, c + canais, ...
+    template <typename SampleType, int NumLines>
+    class FdnReverb
+    {
+    public:
+        static_assert(NumLines == 8 || NumLines == 16, "FdnReverb: 8 ou 16 linhas");
+
+        static constexpr double minDelayMs = 23.0;
+        static constexpr double maxDelayMs = 97.0;
+        static constexpr double maxModulationMs = 0.5;
+        static constexpr double modulationHz = 0.7;
+
+        // Aloca o buffer das linhas (fora da thread de audio)
+        void prepare(const juce::dsp::ProcessSpec& spec)
+        {
+            sampleRate = spec.sampleRate;
+            numChannels = (int)juce::jmax(1u, spec.numChannels);
+
+            // folga para o arredondamento dos tempos para primos e para a interpolacao
+            length = (int)std::ceil((maxDelayMs + maxModulationMs) * 0.001 * sampleRate) + 64;
+            buffer.assign((size_t)(length * NumLines), SampleType(0));
+
+            // fases da modulacao espalhadas entre as linhas, para que nao andem juntas
+            const double increment = juce::MathConstants<double>::twoPi * modulationHz / sampleRate;
+            rotationCos = (SampleType)std::cos(increment);
+            rotationSin = (SampleType)std::sin(increment);
+
+            updateDelays();
+            setModulation(modulation);
+            reset();
+        }
+
+        void reset() noexcept
+        {
+            std::fill(buffer.begin(), buffer.end(), SampleType(0));
+            writePosition = 0;
+
+            for (int i = 0; i < NumLines; ++i)
+            {
+                const double phase = juce::MathConstants<double>::twoPi * i / NumLines;
+                filterState[i] = 0;
+                modulationCos[i] = (SampleType)std::cos(phase);
+                modulationSin[i] = (SampleType)std::sin(phase);
+            }
+        }
+
+        //------------------------------------------------------------------------------
+        void setSize(SampleType newSize) noexcept
+        {
+            size = juce::jlimit(SampleType(0), SampleType(1), newSize);
+            updateDelays();
+        }
+
+        void setDecay(SampleType seconds) noexcept
+        {
+            decay = juce::jmax(SampleType(0.05), seconds);
+            updateGains();
+        }
+
+        void setDamping(SampleType newDamping) noexcept
+        {
+            damping = juce::jlimit(SampleType(0), SampleType(1), newDamping);
+            updateGains();
+        }
+
+        void setModulation(SampleType newModulation) noexcept
+        {
+            modulation = juce::jlimit(SampleType(0), SampleType(1), newModulation);
+            // (1 + sin) vai de 0 a 2: metade da variacao maxima
+            modulationDepth = modulation * (SampleType)(0.5 * maxModulationMs * 0.001 * sampleRate);
+        }
+
+        void setMatrix(FdnMatrix newMatrix) noexcept { matrix = newMatrix; }
+
+        // Atraso da primeira saida depois de um impulso na entrada (a linha mais curta), em
+        // amostras. Valido depois de prepare()
+        int getFirstArrival() const noexcept { return (int)delays[0]; }
+
+        //------------------------------------------------------------------------------
+        // Substitui o bloco pelo sinal reverberado (100% wet)
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            auto&& outputBlock = context.getOutputBlock();
+
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom(context.getInputBlock());
+
+            const int numSamples = (int)outputBlock.getNumSamples();
+            const int blockChannels = juce::jmin((int)outputBlock.getNumChannels(), numChannels);
+
+            if (blockChannels <= 0)
+                return;
+
+            const SampleType outputGain = SampleType(1) / std::sqrt((SampleType)(NumLines / blockChannels));
+
+            alignas(32) SampleType lines[NumLines];
+            alignas(32) SampleType inputs[NumLines];
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                readLines(lines);
+
+                // ganho e amortecimento de cada linha
+                for (int i = 0; i < NumLines; ++i)
+                {
+                    filterState[i] = filterGain[i] * lines[i] + filterPole[i] * filterState[i];
+                    lines[i] = filterState[i];
+                }
+
+                for (int i = 0; i < NumLines; ++i)
+                    inputs[i] = outputBlock.getChannelPointer((size_t)(i % blockChannels))[n];
+
+                for (int channel = 0; channel < blockChannels; ++channel)
+                {
+                    SampleType sum = 0;
+
+                    for (int i = channel; i < NumLines; i += blockChannels)
+                        sum += lines[i];
+
+                    outputBlock.getChannelPointer((size_t)channel)[n] = outputGain * sum;
+                }
+
+                if (matrix == FdnMatrix::hadamard)
+                    hadamard(lines);
+                else
+                    householder(lines);
+
+                SampleType* frame = buffer.data() + writePosition * NumLines;
+
+                for (int i = 0; i < NumLines; ++i)
+                    frame[i] = lines[i] + inputs[i];
+
+                if (++writePosition == length)
+                    writePosition = 0;
+
+                advanceModulation();
+            }
+
+            for (int i = 0; i < NumLines; ++i)
+                filterState[i] = flushDenormal(filterState[i]);
+        }
+
+    private:
+        //------------------------------------------------------------------------------
+        // Le a saida de cada linha, com o tempo modulado e interpolacao linear
+        void readLines(SampleType* lines) const noexcept
+        {
+            for (int i = 0; i < NumLines; ++i)
+            {
+                const SampleType delay = delays[i] + modulationDepth * (SampleType(1) + modulationSin[i]);
+                SampleType position = (SampleType)writePosition - delay;
+
+                if (position < 0)
+                    position += (SampleType)length;
+
+                const int index = (int)position;
+                const SampleType fraction = position - (SampleType)index;
+                const int next = index + 1 == length ? 0 : index + 1;
+
+                const SampleType a = buffer[(size_t)(index * NumLines + i)];
+                const SampleType b = buffer[(size_t)(next * NumLines + i)];
+                lines[i] = a + fraction * (b - a);
+            }
+        }
+
+        // Fasor girando em quadratura por linha (sem sin/cos por amostra). A norma e
+        // corrigida a cada passo para nao derivar
+        void advanceModulation() noexcept
+        {
+            for (int i = 0; i < NumLines; ++i)
+            {
+                const SampleType c = modulationCos[i] * rotationCos - modulationSin[i] * rotationSin;
+                const SampleType s = modulationSin[i] * rotationCos + modulationCos[i] * rotationSin;
+                const SampleType norm = SampleType(1.5) - SampleType(0.5) * (c * c + s * s);
+                modulationCos[i] = c * norm;
+                modulationSin[i] = s * norm;
+            }
+        }
+
+        static void hadamard(SampleType* x) noexcept
+        {
+            for (int half = 1; half < NumLines; half *= 2)
+                for (int start = 0; start < NumLines; start += 2 * half)
+                    for (int i = start; i < start + half; ++i)
+                    {
+                        const SampleType a = x[i];
+                        const SampleType b = x[i + half];
+                        x[i] = a + b;
+                        x[i + half] = a - b;
+                    }
+
+            const SampleType scale = SampleType(1) / std::sqrt((SampleType)NumLines);
+
+            for (int i = 0; i < NumLines; ++i)
+                x[i] *= scale;
+        }
+
+        static void householder(SampleType* x) noexcept
+        {
+            SampleType sum = 0;
+
+            for (int i = 0; i < NumLines; ++i)
+                sum += x[i];
+
+            sum *= SampleType(2) / (SampleType)NumLines;
+
+            for (int i = 0; i < NumLines; ++i)
+                x[i] -= sum;
+        }
+
+        //------------------------------------------------------------------------------
+        // Tempos em progressao geometrica entre minDelayMs e maxDelayMs (escalados por
+        // size), arredondados para primos distintos: linhas com tempos sem fator comum
+        // nao reforcam as mesmas frequencias
+        void updateDelays() noexcept
+        {
+            if (sampleRate <= 0)
+                return;
+
+            const double scale = 0.25 + 0.75 * (double)size;
+            int previous = 0;
+
+            for (int i = 0; i < NumLines; ++i)
+            {
+                const double ms = minDelayMs * std::pow(maxDelayMs / minDelayMs, (double)i / (NumLines - 1)) * scale;
+                int samples = juce::jmax(previous + 1, (int)(ms * 0.001 * sampleRate));
+
+                while (! isPrime(samples))
+                    ++samples;
+
+                delays[i] = (SampleType)samples;
+                previous = samples;
+            }
+
+            updateGains();
+        }
+
+        // Ganho por linha para o RT60 pedido: -60 dB em decay segundos, proporcional ao
+        // tempo da linha. O polo do filtro da ao ganho em Nyquist o RT60 reduzido
+        void updateGains() noexcept
+        {
+            if (sampleRate <= 0)
+                return;
+
+            const double hfRatio = std::pow(10.0, -(double)damping);   // RT60 em Nyquist / RT60 em DC
+
+            for (int i = 0; i < NumLines; ++i)
+            {
+                const double seconds = (double)delays[i] / sampleRate;
+                const double dcGain = std::pow(10.0, -3.0 * seconds / (double)decay);
+                const double nyquistGain = std::pow(10.0, -3.0 * seconds / ((double)decay * hfRatio));
+                const double ratio = nyquistGain / dcGain;
+                const double pole = (1.0 - ratio) / (1.0 + ratio);
+
+                filterPole[i] = (SampleType)pole;
+                filterGain[i] = (SampleType)(dcGain * (1.0 - pole));
+            }
+        }
+
+        static bool isPrime(int n) noexcept
+        {
+            if (n < 2)
+                return false;
+
+            for (int d = 2; d * d <= n; ++d)
+                if (n % d == 0)
+                    return false;
+
+            return true;
+        }
+
+        std::vector<SampleType> buffer;     // intercalado: posicao * NumLines + linha
+        int length = 1;
+        int writePosition = 0;
+        double sampleRate = 0;
+        int numChannels = 2;
+
+        alignas(32) SampleType delays[NumLines] {};
+        alignas(32) SampleType filterGain[NumLines] {};
+        alignas(32) SampleType filterPole[NumLines] {};
+        alignas(32) SampleType filterState[NumLines] {};
+        alignas(32) SampleType modulationCos[NumLines] {};
+        alignas(32) SampleType modulationSin[NumLines] {};
+
+        SampleType rotationCos = 1, rotationSin = 0;
+        SampleType modulationDepth = 0;
+
+        SampleType size = SampleType(0.5);
+        SampleType decay = SampleType(2);
+        SampleType damping = SampleType(0.5);
+        SampleType modulation = SampleType(0.2);
+        FdnMatrix matrix = FdnMatrix::hadamard;
+    };
+}
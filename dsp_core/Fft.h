@@ -0,0 +1,523 @@
+//==============================================================================
+// Fft.h: FFT real com implementacao (backend) selecionavel
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <map>
+#include <memory>
+#include <vector>
+
+#if DSP_CORE_USE_FFTW
+ #include <fftw3.h>
+#endif
+
+// Backend padrao do processo, definido no build (ver dsp_core/CMakeLists.txt)
+#ifndef DSP_CORE_DEFAULT_FFT_BACKEND
+ #define DSP_CORE_DEFAULT_FFT_BACKEND automatic
+#endif
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Implementacoes da FFT:
+    //   automatic  a mais rapida para cada tamanho, medida na primeira vez que o tamanho
+    //              e usado no processo e guardada no arquivo de wisdom (ver Fft)
+    //   juce       juce::dsp::FFT. Sem FFTW, IPP ou vDSP configurados no JUCE, e a
+    //              implementacao generica do JUCE, que faz a FFT real como uma FFT complexa
+    //              de tamanho N
+    //   builtin    FFT real como FFT complexa de N / 2 pontos mais uma etapa de separacao.
+    //              Radix-2 iterativa com tabelas de twiddles contiguas por etapa, entao as
+    //              borboletas de cada etapa sao vetorizadas pelo compilador
+    //   fftw       FFTW (float), so com DSP_CORE_USE_FFTW no build. Os planos usam
+    //              FFTW_MEASURE e a wisdom do FFTW fica junto do arquivo de wisdom
+    enum class FftBackend { automatic, juce, builtin, fftw };
+
+    //==============================================================================
+    // FFT real de 2^order pontos, com o formato de juce::dsp::FFT: um buffer de 2 * N
+    // floats, N amostras na ida e N / 2 + 1 complexos intercalados (DC ate Nyquist) na
+    // volta. inverse() le so esses N / 2 + 1 complexos e divide por N, entao
+    // inverse(forward(x)) = x. forward e inverse sao const. Com builtin e fftw tambem sao
+    // sem estado, e um objeto pode ser usado por varias threads ao mesmo tempo (ex.:
+    // particoes compartilhadas). O juce::dsp::FFT usa um buffer interno protegido por
+    // SpinLock: com juce, threads que dividem o objeto esperam umas pelas outras, entao
+    // cada uma deve ter o seu (isShareable).
+    //
+    // Selecao em tempo de execucao: o backend pedido no construtor ou, se for automatic,
+    // o padrao do processo (setDefaultBackend, inicialmente DSP_CORE_DEFAULT_FFT_BACKEND);
+    // se o padrao tambem for automatic, o mais rapido para o tamanho (findFastestBackend).
+    // Backends indisponiveis no build viram builtin. O construtor aloca e pode medir:
+    // fora da thread de audio
+    class Fft
+    {
+    public:
+        using Complex = std::complex<float>;
+
+        explicit Fft(int order, FftBackend requested = FftBackend::automatic)
+            : size(1 << order), backend(resolve(order, requested))
+        {
+            engine = makeEngine(order, backend);
+        }
+
+        int getSize() const noexcept { return size; }
+        FftBackend getBackend() const noexcept { return backend; }
+
+        // O objeto pode ser usado por varias threads sem que uma espere pela outra
+        bool isShareable() const noexcept { return backend != FftBackend::juce; }
+
+        void forward(float* buffer) const noexcept { engine->forward(buffer); }
+        void inverse(float* buffer) const noexcept { engine->inverse(buffer); }
+
+        //------------------------------------------------------------------------------
+        static juce::StringArray getBackendChoices() { return { "auto", "juce", "builtin", "fftw" }; }
+        static FftBackend getBackendForChoice(int index) noexcept { return (FftBackend)juce::jlimit(0, 3, index); }
+
+        static bool isAvailable(FftBackend candidate) noexcept
+        {
+           #if DSP_CORE_USE_FFTW
+            return true;
+           #else
+            return candidate != FftBackend::fftw;
+           #endif
+        }
+
+        static void setDefaultBackend(FftBackend newDefault) noexcept { defaultBackend().store(newDefault); }
+        static FftBackend getDefaultBackend() noexcept { return defaultBackend().load(); }
+
+        //------------------------------------------------------------------------------
+        // Backend mais rapido para 2^order pontos. Mede cada backend disponivel (ida e
+        // volta, alguns ms cada) so na primeira vez no processo, se o arquivo de wisdom
+        // ainda nao tiver o tamanho, e grava o resultado nele
+        static FftBackend findFastestBackend(int order)
+        {
+            auto& wisdom = getWisdom();
+            const juce::ScopedLock lock(wisdom.lock);
+
+            if (! wisdom.loaded)
+            {
+                wisdom.loaded = true;
+                readWisdom(wisdom, getWisdomFile());
+            }
+
+            auto found = wisdom.fastest.find(order);
+
+            if (found != wisdom.fastest.end() && isAvailable(found->second))
+                return found->second;
+
+            FftBackend fastest = FftBackend::builtin;
+            double best = 0.0;
+
+            for (auto candidate : { FftBackend::juce, FftBackend::builtin, FftBackend::fftw })
+            {
+                if (! isAvailable(candidate))
+                    continue;
+
+                const double seconds = measure(*makeEngine(order, candidate), 1 << order);
+
+                if (best == 0.0 || seconds < best)
+                {
+                    best = seconds;
+                    fastest = candidate;
+                }
+            }
+
+            wisdom.fastest[order] = fastest;
+            writeWisdom(wisdom, getWisdomFile());
+            return fastest;
+        }
+
+        // Arquivo de wisdom: uma linha "ordem backend" por tamanho medido, e a wisdom do
+        // FFTW em <arquivo>.fftw. Pode ser trocado antes do primeiro uso (ex.: para
+        // distribuir um arquivo pre-medido) ou apagado para medir de novo
+        static void setWisdomFile(const juce::File& file)
+        {
+            auto& wisdom = getWisdom();
+            const juce::ScopedLock lock(wisdom.lock);
+            wisdom.file = file;
+            wisdom.loaded = false;
+            wisdom.fastest.clear();
+        }
+
+        static juce::File getWisdomFile()
+        {
+            auto& wisdom = getWisdom();
+            const juce::ScopedLock lock(wisdom.lock);
+
+            if (wisdom.file == juce::File())
+                return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                           .getChildFile("dsp_core").getChildFile("fft_wisdom.txt");
+
+            return wisdom.file;
+        }
+
+    private:
+        //------------------------------------------------------------------------------
+        struct Engine
+        {
+            virtual ~Engine() = default;
+            virtual void forward(float* buffer) const noexcept = 0;
+            virtual void inverse(float* buffer) const noexcept = 0;
+        };
+
+        //------------------------------------------------------------------------------
+        struct JuceEngine : Engine
+        {
+            explicit JuceEngine(int order) : fft(order) {}
+
+            void forward(float* buffer) const noexcept override
+            {
+                fft.performRealOnlyForwardTransform(buffer, true);
+            }
+
+            // juce::dsp::FFT precisa do espectro completo (simetria conjugada)
+            void inverse(float* buffer) const noexcept override
+            {
+                auto* bins = reinterpret_cast<Complex*>(buffer);
+                const int n = fft.getSize();
+
+                for (int bin = n / 2 + 1; bin < n; ++bin)
+                    bins[bin] = std::conj(bins[n - bin]);
+
+                fft.performRealOnlyInverseTransform(buffer);
+            }
+
+            juce::dsp::FFT fft;
+        };
+
+        //------------------------------------------------------------------------------
+        // As N amostras reais sao lidas como M = N / 2 complexos z[k] = x[2k] + i x[2k + 1].
+        // Z = FFT(z) de M pontos e X[k] = E[k] + W^k O[k], com E e O os espectros das
+        // amostras pares e impares, separados de Z pela simetria: E[k] = (Z[k] + Z*[M - k]) / 2,
+        // O[k] = -i (Z[k] - Z*[M - k]) / 2. Cada par (k, M - k) e resolvido junto.
+        //
+        // A FFT complexa roda em formato separado (partes reais e imaginarias em arrays
+        // distintos), na segunda metade do buffer de 2 * N floats, que a interface deixa
+        // livre: sem embaralhamento de pares re/im, as borboletas de cada etapa sao
+        // vetorizadas pelo compilador. A permutacao bit-reversa e feita na copia para essa
+        // area, e a inversa usa os twiddles conjugados
+        struct BuiltinEngine : Engine
+        {
+            explicit BuiltinEngine(int order)
+                : n(1 << order), m(juce::jmax(1, n / 2))
+            {
+                int bits = 0;
+
+                while ((1 << bits) < m)
+                    ++bits;
+
+                reversed.resize((size_t)m);
+
+                for (int i = 0; i < m; ++i)
+                {
+                    int r = 0;
+
+                    for (int b = 0; b < bits; ++b)
+                        r |= ((i >> b) & 1) << (bits - 1 - b);
+
+                    reversed[(size_t)i] = r;
+                }
+
+                // twiddles da etapa de tamanho L em [L / 2, L): exp(-2 pi i j / L)
+                twiddleRe.resize((size_t)m);
+                twiddleIm.resize((size_t)m);
+
+                for (int length = 2; length <= m; length *= 2)
+                    for (int j = 0; j < length / 2; ++j)
+                    {
+                        const double angle = juce::MathConstants<double>::twoPi * j / length;
+                        twiddleRe[(size_t)(length / 2 + j)] = (float)std::cos(angle);
+                        twiddleIm[(size_t)(length / 2 + j)] = (float)-std::sin(angle);
+                    }
+
+                // W^k = exp(-2 pi i k / N), k ate M / 2
+                split.resize((size_t)(m / 2 + 1));
+
+                for (int k = 0; k <= m / 2; ++k)
+                    split[(size_t)k] = std::polar(1.0, -juce::MathConstants<double>::twoPi * k / n);
+            }
+
+            void forward(float* buffer) const noexcept override
+            {
+                float* re = buffer + n;
+                float* im = buffer + n + m;
+
+                for (int k = 0; k < m; ++k)
+                {
+                    re[reversed[(size_t)k]] = buffer[2 * k];
+                    im[reversed[(size_t)k]] = buffer[2 * k + 1];
+                }
+
+                transform(re, im, 1.0f);
+
+                auto* X = reinterpret_cast<Complex*>(buffer);
+
+                for (int k = 1; k <= m / 2; ++k)
+                {
+                    const Complex a(re[k], im[k]);
+                    const Complex b(re[m - k], -im[m - k]);
+                    const Complex even = 0.5f * (a + b);
+                    const Complex odd = multiply(Complex(0.0f, -0.5f), a - b);
+                    const Complex x = multiply(split[(size_t)k], odd);
+
+                    X[k] = even + x;
+                    X[m - k] = std::conj(even - x);
+                }
+
+                // X[M] ocupa re[0] e re[1]: escrito por ultimo
+                const float r0 = re[0], i0 = im[0];
+                X[0] = { r0 + i0, 0.0f };
+                X[m] = { r0 - i0, 0.0f };
+            }
+
+            void inverse(float* buffer) const noexcept override
+            {
+                auto* X = reinterpret_cast<Complex*>(buffer);
+                float* re = buffer + n;
+                float* im = buffer + n + m;
+
+                // X[M] ocupa re[0] e re[1]: lido antes
+                const float x0 = X[0].real(), xm = X[m].real();
+
+                for (int k = 1; k <= m / 2; ++k)
+                {
+                    const Complex a = X[k];
+                    const Complex b = std::conj(X[m - k]);
+                    const Complex even = 0.5f * (a + b);
+                    const Complex odd = multiply(0.5f * (a - b), std::conj(split[(size_t)k]));
+                    const Complex zk = even + Complex(-odd.imag(), odd.real());
+                    const Complex zmk = std::conj(even) + Complex(odd.imag(), odd.real());
+
+                    re[reversed[(size_t)k]] = zk.real();
+                    im[reversed[(size_t)k]] = zk.imag();
+                    re[reversed[(size_t)(m - k)]] = zmk.real();
+                    im[reversed[(size_t)(m - k)]] = zmk.imag();
+                }
+
+                re[0] = 0.5f * (x0 + xm);
+                im[0] = 0.5f * (x0 - xm);
+
+                transform(re, im, -1.0f);
+
+                const float scale = 1.0f / (float)m;
+
+                for (int k = 0; k < m; ++k)
+                {
+                    buffer[2 * k] = re[k] * scale;
+                    buffer[2 * k + 1] = im[k] * scale;
+                }
+            }
+
+            // FFT complexa de M pontos em formato separado, com a entrada ja em ordem
+            // bit-reversa. sign = -1 usa os twiddles conjugados (transformada inversa, sem
+            // a divisao por M)
+            void transform(float* __restrict re, float* __restrict im, float sign) const noexcept
+            {
+                // primeira etapa sem multiplicacao (twiddle 1)
+                for (int start = 0; start + 1 < m; start += 2)
+                {
+                    const float ar = re[start], ai = im[start];
+                    const float br = re[start + 1], bi = im[start + 1];
+                    re[start] = ar + br;
+                    im[start] = ai + bi;
+                    re[start + 1] = ar - br;
+                    im[start + 1] = ai - bi;
+                }
+
+                for (int half = 2; half < m; half *= 2)
+                {
+                    const float* wr = twiddleRe.data() + half;
+                    const float* wi = twiddleIm.data() + half;
+
+                    for (int start = 0; start < m; start += 2 * half)
+                    {
+                        float* __restrict ar = re + start;
+                        float* __restrict ai = im + start;
+                        float* __restrict br = re + start + half;
+                        float* __restrict bi = im + start + half;
+
+                        for (int j = 0; j < half; ++j)
+                        {
+                            const float w = sign * wi[j];
+                            const float tr = br[j] * wr[j] - bi[j] * w;
+                            const float ti = br[j] * w + bi[j] * wr[j];
+                            br[j] = ar[j] - tr;
+                            bi[j] = ai[j] - ti;
+                            ar[j] += tr;
+                            ai[j] += ti;
+                        }
+                    }
+                }
+            }
+
+            // produto complexo por extenso: o operador de std::complex trata inf/nan
+            static Complex multiply(Complex a, Complex b) noexcept
+            {
+                return { a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real() };
+            }
+
+            int n, m;
+            std::vector<int> reversed;
+            std::vector<float> twiddleRe, twiddleIm;
+            std::vector<Complex> split;
+        };
+
+        //------------------------------------------------------------------------------
+       #if DSP_CORE_USE_FFTW
+        // Planos no lugar sobre o buffer de 2 * N floats. fftwf_execute_dft_* pode ser
+        // chamado por varias threads com o mesmo plano; so o planejamento precisa de lock
+        struct FftwEngine : Engine
+        {
+            explicit FftwEngine(int order) : n(1 << order)
+            {
+                const juce::ScopedLock lock(getWisdom().lock);
+                std::vector<float> scratch((size_t)(2 * n));
+                auto* bins = reinterpret_cast<fftwf_complex*>(scratch.data());
+
+                forwardPlan = fftwf_plan_dft_r2c_1d(n, scratch.data(), bins, FFTW_MEASURE | FFTW_UNALIGNED);
+                inversePlan = fftwf_plan_dft_c2r_1d(n, bins, scratch.data(), FFTW_MEASURE | FFTW_UNALIGNED);
+            }
+
+            ~FftwEngine() override
+            {
+                const juce::ScopedLock lock(getWisdom().lock);
+                fftwf_destroy_plan(forwardPlan);
+                fftwf_destroy_plan(inversePlan);
+            }
+
+            void forward(float* buffer) const noexcept override
+            {
+                fftwf_execute_dft_r2c(forwardPlan, buffer, reinterpret_cast<fftwf_complex*>(buffer));
+            }
+
+            void inverse(float* buffer) const noexcept override
+            {
+                fftwf_execute_dft_c2r(inversePlan, reinterpret_cast<fftwf_complex*>(buffer), buffer);
+                juce::FloatVectorOperations::multiply(buffer, 1.0f / (float)n, n);
+            }
+
+            int n;
+            fftwf_plan forwardPlan = nullptr, inversePlan = nullptr;
+        };
+       #endif
+
+        static std::unique_ptr<Engine> makeEngine(int order, FftBackend selected)
+        {
+            switch (selected)
+            {
+                case FftBackend::juce:
+                    return std::make_unique<JuceEngine>(order);
+               #if DSP_CORE_USE_FFTW
+                case FftBackend::fftw:
+                    return std::make_unique<FftwEngine>(order);
+               #endif
+                default:
+                    return std::make_unique<BuiltinEngine>(order);
+            }
+        }
+
+        static FftBackend resolve(int order, FftBackend requested)
+        {
+            if (requested == FftBackend::automatic)
+                requested = getDefaultBackend();
+
+            if (requested == FftBackend::automatic)
+                return findFastestBackend(order);
+
+            return isAvailable(requested) ? requested : FftBackend::builtin;
+        }
+
+        //------------------------------------------------------------------------------
+        static std::atomic<FftBackend>& defaultBackend() noexcept
+        {
+            static std::atomic<FftBackend> value { FftBackend::DSP_CORE_DEFAULT_FFT_BACKEND };
+            return value;
+        }
+
+        // Resultados das medicoes no processo. O lock tambem protege o planejador do FFTW
+        struct Wisdom
+        {
+            juce::CriticalSection lock;
+            juce::File file;
+            bool loaded = false;
+            std::map<int, FftBackend> fastest;
+        };
+
+        static Wisdom& getWisdom()
+        {
+            static Wisdom wisdom;
+            return wisdom;
+        }
+
+        // Tempo de uma ida e volta, em segundos (melhor de 3 rodadas de ~2 ms)
+        static double measure(const Engine& candidate, int n)
+        {
+            std::vector<float> buffer((size_t)(2 * n));
+            juce::Random random(1);
+
+            for (int i = 0; i < n; ++i)
+                buffer[(size_t)i] = 2.0f * random.nextFloat() - 1.0f;
+
+            const int iterations = juce::jmax(4, (1 << 18) / n);
+            double best = 0.0;
+
+            for (int round = 0; round < 3; ++round)
+            {
+                const auto start = juce::Time::getHighResolutionTicks();
+
+                for (int i = 0; i < iterations; ++i)
+                {
+                    candidate.forward(buffer.data());
+                    candidate.inverse(buffer.data());
+                }
+
+                const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) / iterations;
+                best = round == 0 ? seconds : juce::jmin(best, seconds);
+            }
+
+            return best;
+        }
+
+        static void readWisdom(Wisdom& wisdom, const juce::File& file)
+        {
+            juce::StringArray lines;
+            file.readLines(lines);
+
+            for (const auto& line : lines)
+            {
+                const auto tokens = juce::StringArray::fromTokens(line, false);
+                const int index = tokens.size() == 2 ? getBackendChoices().indexOf(tokens[1]) : -1;
+
+                if (index > 0)
+                    wisdom.fastest[tokens[0].getIntValue()] = (FftBackend)index;
+            }
+
+           #if DSP_CORE_USE_FFTW
+            fftwf_import_wisdom_from_filename(file.withFileExtension("fftw").getFullPathName().toRawUTF8());
+           #endif
+        }
+
+        static void writeWisdom(const Wisdom& wisdom, const juce::File& file)
+        {
+            juce::String text;
+
+            for (const auto& [order, fastest] : wisdom.fastest)
+                text << order << " " << getBackendChoices()[(int)fastest] << "\n";
+
+            if (! file.getParentDirectory().createDirectory() || ! file.replaceWithText(text))
+                return;
+
+           #if DSP_CORE_USE_FFTW
+            fftwf_export_wisdom_to_filename(file.withFileExtension("fftw").getFullPathName().toRawUTF8());
+           #endif
+        }
+
+        int size;
+        FftBackend backend;
+        std::unique_ptr<Engine> engine;
+    };
+}
@@ -0,0 +1,354 @@
+//==============================================================================
+// HybridReverb.h: reverb hibrido, convolucao no inicio da IR e FDN na cauda
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <atomic>
+#include <cmath>
+
+#include "Convolution.h"
+#include "DelayLine.h"
+#include "FdnReverb.h"
+#include "ImpulseResponse.h"
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Reverb hibrido: as primeiras splitSeconds da IR (reflexoes iniciais) passam pela
+    // convolucao e a cauda e sintetizada por uma FDN. A convolucao passa a custar, em CPU e
+    // em memoria, o de uma IR de splitSeconds, qualquer que seja o tamanho da sala; a FDN
+    // tem custo fixo.
+    //
+    // Ajuste da cauda, feito ao carregar a IR ou trocar o corte (fora da thread de audio):
+    //   decaimento    RT60 da IR depois do corte, medido em duas bandas (estimateDecay).
+    //                 O RT60 da banda baixa vira o decay da FDN e o da banda alta, o damping
+    //   nivel         a FDN e renderizada uma vez com o ajuste e o ganho leva a energia dela
+    //                 nos matchWindowSeconds depois do corte para a energia da IR no mesmo
+    //                 trecho, na escala da IR normalizada pela convolucao
+    //   alinhamento   o inicio da IR termina com fade-out de crossfadeSeconds, e a FDN
+    //                 recebe a entrada com um pre-delay que faz a primeira saida dela chegar
+    //                 no inicio do fade. O pre-delay inclui a latencia da convolucao
+    //
+    // Orcamento de latencia e modo vao para a convolucao (ver Convolution.h); a FDN e
+    // sempre estereo. Como no juce::dsp::Convolution, o silencio no inicio da IR e removido
+    // e o corte e contado a partir do primeiro som
+    class HybridReverb
+    {
+    public:
+        using Tail = FdnReverb<float, 16>;
+
+        static constexpr double minSplitSeconds = 0.02;
+        static constexpr double maxSplitSeconds = 0.3;
+        static constexpr double crossfadeSeconds = 0.01;
+        static constexpr double matchWindowSeconds = 0.1;
+
+        // Tamanho e modulacao fixos da FDN da cauda: o nivel e ajustado para eles
+        static constexpr float tailSize = 0.5f;
+        static constexpr float tailModulation = 0.2f;
+
+        //------------------------------------------------------------------------------
+        // Fora da thread de audio
+        void setLatencyBudget(int samples) { early.setLatencyBudget(samples); }
+        void setMode(ConvolutionMode newMode) { early.setMode(newMode); }
+        void setFftBackend(FftBackend newBackend) { early.setFftBackend(newBackend); }
+
+        // Troca o ponto de corte. Recarrega o inicio da IR e refaz o ajuste da cauda
+        void setSplitTime(double seconds)
+        {
+            seconds = juce::jlimit(minSplitSeconds, maxSplitSeconds, seconds);
+
+            if (seconds == split)
+                return;
+
+            split = seconds;
+
+            if (impulseDecoded)
+                load();
+        }
+
+        double getSplitTime() const noexcept { return split; }
+
+        void loadImpulseResponse(const juce::File& file)
+        {
+            impulseFile = file;
+            impulseDecoded = readImpulseResponse(file, impulse, impulseRate);
+
+            if (impulseDecoded)
+                load();
+        }
+
+        // Ajuste atual da cauda, em segundos (0 sem IR)
+        const DecayEstimate& getDecayEstimate() const noexcept { return decay; }
+
+        int getLatency() const noexcept { return early.getLatency(); }
+
+        //------------------------------------------------------------------------------
+        void prepare(const juce::dsp::ProcessSpec& newSpec)
+        {
+            spec = newSpec;
+            isPrepared = true;
+
+            early.prepare(spec);
+
+            tail.prepare(spec);
+            tail.setSize(tailSize);
+            tail.setModulation(tailModulation);
+            appliedDecay = appliedDamping = -1.0f;
+
+            predelay.prepare((int)spec.numChannels,
+                             (int)(maxSplitSeconds * spec.sampleRate) + Convolution::maxLatencyBudget + 1);
+            scratch.setSize((int)spec.numChannels, (int)spec.maximumBlockSize);
+
+            updateTail();
+        }
+
+        void reset() noexcept
+        {
+            early.reset();
+            tail.reset();
+            predelay.reset();
+        }
+
+        // Substitui o bloco pelo sinal reverberado (100% wet)
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            auto&& inputBlock = context.getInputBlock();
+            auto&& outputBlock = context.getOutputBlock();
+            const int numSamples = (int)outputBlock.getNumSamples();
+            const int numChannels = juce::jmin((int)outputBlock.getNumChannels(), scratch.getNumChannels());
+
+            jassert(numSamples <= scratch.getNumSamples());
+
+            // a entrada da cauda e copiada antes que a convolucao a substitua
+            auto tailBlock = juce::dsp::AudioBlock<float>(scratch).getSubsetChannelBlock(0, (size_t)numChannels)
+                                                                   .getSubBlock(0, (size_t)numSamples);
+            tailBlock.copyFrom(inputBlock);
+
+            early.process(context);
+
+            applyTailParameters();
+            delayTailInput(tailBlock, tailPredelay.load() + early.getLatency());
+            tail.process(juce::dsp::ProcessContextReplacing<float>(tailBlock));
+
+            const float gain = tailGain.load();
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                juce::FloatVectorOperations::addWithMultiply(outputBlock.getChannelPointer((size_t)channel),
+                                                             tailBlock.getChannelPointer((size_t)channel),
+                                                             gain, numSamples);
+        }
+
+    private:
+        //------------------------------------------------------------------------------
+        // Carrega o inicio da IR na convolucao e refaz o ajuste
+        void load()
+        {
+            const int lead = findFirstSound(impulse);
+
+            ImpulseResponseOptions options;
+            options.lengthSeconds = split + lead / impulseRate;
+            options.fadeOutSeconds = crossfadeSeconds;
+            early.setImpulseResponseOptions(options);
+            early.loadImpulseResponse(impulseFile, juce::dsp::Convolution::Trim::yes);
+
+            const int start = lead + (int)(split * impulseRate);
+            const int end = juce::jmin(impulse.getNumSamples(), start + (int)(matchWindowSeconds * impulseRate));
+
+            decay = estimateDecay(impulse, impulseRate, start);
+
+            // energia do trecho depois do corte relativa a do inicio com fade, que e a parte
+            // normalizada pela convolucao (ver normaliseImpulseResponse)
+            juce::AudioBuffer<float> head(impulse.getNumChannels(), juce::jmax(1, juce::jmin(start, impulse.getNumSamples()) - lead));
+
+            for (int channel = 0; channel < impulse.getNumChannels(); ++channel)
+                head.copyFrom(channel, 0, impulse, channel, lead, head.getNumSamples());
+
+            applyFadeOut(head, juce::jmin(head.getNumSamples() / 2, (int)(crossfadeSeconds * impulseRate)));
+
+            const double headEnergy = getMaxChannelEnergy(head, 0, head.getNumSamples());
+            windowRatio = headEnergy > 0.0 && end > start ? getMaxChannelEnergy(impulse, start, end) / headEnergy : 0.0;
+
+            updateTail();
+        }
+
+        // Ajuste da cauda na taxa de processamento: decaimento, amortecimento, pre-delay e ganho
+        void updateTail()
+        {
+            if (! isPrepared || ! impulseDecoded)
+                return;
+
+            const double rate = spec.sampleRate;
+            const float newDecay = decay.lowSeconds > 0.0 ? (float)decay.lowSeconds : 0.0f;
+            const float newDamping = getDamping(decay, rate);
+
+            if (newDecay <= 0.0f || windowRatio <= 0.0)
+            {
+                tailGain.store(0.0f);
+                return;
+            }
+
+            // renderiza a resposta da FDN a um impulso ate o fim da janela de comparacao
+            Tail probe;
+            probe.prepare(spec);
+            probe.setSize(tailSize);
+            probe.setModulation(tailModulation);
+            probe.setDecay(newDecay);
+            probe.setDamping(newDamping);
+
+            const int start = (int)(split * rate);
+            const int newPredelay = juce::jmax(0, start - (int)(crossfadeSeconds * rate) - probe.getFirstArrival());
+            const int windowStart = start - newPredelay;
+            const int windowEnd = windowStart + (int)(matchWindowSeconds * rate);
+
+            juce::AudioBuffer<float> response((int)spec.numChannels, windowEnd);
+            response.clear();
+
+            for (int channel = 0; channel < response.getNumChannels(); ++channel)
+                response.setSample(channel, 0, 1.0f);
+
+            juce::dsp::AudioBlock<float> block(response);
+            probe.process(juce::dsp::ProcessContextReplacing<float>(block));
+
+            // alvo: a janela da IR com a mesma normalizacao do inicio (energia 1/64)
+            const double tailEnergy = getMaxChannelEnergy(response, windowStart, windowEnd);
+            const double target = windowRatio * 0.125 * 0.125;
+
+            tailDecay.store(newDecay);
+            tailDamping.store(newDamping);
+            tailPredelay.store(newPredelay);
+            tailGain.store(tailEnergy > 0.0 ? (float)std::sqrt(target / tailEnergy) : 0.0f);
+        }
+
+        // O filtro de cada linha da FDN acerta o RT60 em DC e em Nyquist, e entre os dois a
+        // atenuacao em dB/s cresce perto de (1 - cos w) / 2. O RT60 da banda alta, medido
+        // na borda da banda, e extrapolado para Nyquist
+        static float getDamping(const DecayEstimate& estimate, double sampleRate) noexcept
+        {
+            if (estimate.lowSeconds <= 0.0 || estimate.highSeconds <= 0.0)
+                return 0.5f;
+
+            const double w = 0.5 * (1.0 - std::cos(juce::MathConstants<double>::twoPi
+                                                   * juce::jmin(decayHighBandHz, 0.4 * sampleRate) / sampleRate));
+            const double lowRate = 60.0 / estimate.lowSeconds;
+            const double highRate = 60.0 / estimate.highSeconds;
+            const double nyquistRate = lowRate + juce::jmax(0.0, highRate - lowRate) / w;
+
+            return juce::jlimit(0.0f, 1.0f, (float)std::log10(nyquistRate / lowRate));
+        }
+
+        //------------------------------------------------------------------------------
+        // Thread de audio: aplica um novo ajuste (so recalcula ganhos, sem alocacao)
+        void applyTailParameters() noexcept
+        {
+            const float newDecay = tailDecay.load();
+            const float newDamping = tailDamping.load();
+
+            if (newDecay != appliedDecay)
+            {
+                tail.setDecay(newDecay);
+                appliedDecay = newDecay;
+            }
+
+            if (newDamping != appliedDamping)
+            {
+                tail.setDamping(newDamping);
+                appliedDamping = newDamping;
+            }
+        }
+
+        void delayTailInput(juce::dsp::AudioBlock<float>& block, int delay) noexcept
+        {
+            const int length = predelay.getLength();
+            const int numSamples = (int)block.getNumSamples();
+            delay = juce::jlimit(0, length - 1, delay);
+
+            for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+            {
+                float* line = predelay.getChannel((int)channel);
+                float* x = block.getChannelPointer(channel);
+                int write = predelay.getWritePosition();
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    line[write] = x[i];
+                    const int read = write >= delay ? write - delay : write - delay + length;
+                    x[i] = line[read];
+
+                    if (++write == length)
+                        write = 0;
+                }
+            }
+
+            predelay.advance(numSamples);
+        }
+
+        //------------------------------------------------------------------------------
+        // Primeira amostra acima de -80 dBFS, como trimSilence
+        static int findFirstSound(const juce::AudioBuffer<float>& ir) noexcept
+        {
+            const float threshold = juce::Decibels::decibelsToGain(-80.0f);
+            int first = ir.getNumSamples();
+
+            for (int channel = 0; channel < ir.getNumChannels(); ++channel)
+            {
+                const float* x = ir.getReadPointer(channel);
+
+                for (int i = 0; i < first; ++i)
+                    if (std::abs(x[i]) >= threshold)
+                    {
+                        first = i;
+                        break;
+                    }
+            }
+
+            return first < ir.getNumSamples() ? first : 0;
+        }
+
+        static double getMaxChannelEnergy(const juce::AudioBuffer<float>& buffer, int start, int end) noexcept
+        {
+            double maxEnergy = 0.0;
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            {
+                const float* x = buffer.getReadPointer(channel);
+                double energy = 0.0;
+
+                for (int i = start; i < end; ++i)
+                    energy += (double)x[i] * (double)x[i];
+
+                maxEnergy = juce::jmax(maxEnergy, energy);
+            }
+
+            return maxEnergy;
+        }
+
+        //------------------------------------------------------------------------------
+        Convolution early;
+        Tail tail;
+        DelayLine<float> predelay;
+        juce::AudioBuffer<float> scratch;
+
+        juce::dsp::ProcessSpec spec { 44100.0, 512, 2 };
+        bool isPrepared = false;
+        double split = 0.08;
+
+        // IR decodificada e ajuste (thread de mensagens)
+        juce::File impulseFile;
+        juce::AudioBuffer<float> impulse;
+        double impulseRate = 0.0;
+        bool impulseDecoded = false;
+        DecayEstimate decay;
+        double windowRatio = 0.0;
+
+        // Ajuste publicado para a thread de audio
+        std::atomic<float> tailDecay { 2.0f };
+        std::atomic<float> tailDamping { 0.5f };
+        std::atomic<float> tailGain { 0.0f };
+        std::atomic<int> tailPredelay { 0 };
+        float appliedDecay = -1.0f, appliedDamping = -1.0f;
+    };
+}
@@ -0,0 +1,479 @@
+//==============================================================================
+// ImpulseResponse.h: preparo de respostas ao impulso (IR) antes da convolucao
+//==============================================================================
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_dsp/juce_dsp.h>
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "Biquad.h"
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Conversao da IR para a taxa de processamento:
+    //   engine  a IR fica na taxa do arquivo e o juce::dsp::Convolution a converte
+    //   linear  interpolacao linear: rapida, mas com aliasing ao reduzir a taxa
+    //   sinc    sinc janelado polifasico: passa-baixas proprio ao reduzir a taxa
+    enum class ResamplingQuality { engine, linear, sinc };
+
+    //==============================================================================
+    // Opcoes aplicadas uma vez, ao carregar a IR (fora da thread de audio), nesta ordem:
+    //   resampling    conversao para a taxa de processamento (ver ResamplingQuality)
+    //   minimumPhase  converte para fase minima (mesma magnitude, energia concentrada no
+    //                 inicio), o que torna o corte seguinte mais curto
+    //   truncationDb  corta a cauda quando a energia restante fica abaixo deste nivel em
+    //                 relacao a energia total (0 = sem corte). -60 e -80 dB sao inaudiveis
+    //                 em IRs de caixa, que raramente precisam de mais de 20 a 50 ms
+    //   lengthSeconds  corta a IR neste tamanho (0 = sem corte), depois do corte por energia
+    //                  (ex.: o inicio da IR no reverb hibrido, ver HybridReverb.h)
+    //   fadeOutSeconds  janela de meio cosseno no fim da IR cortada, para nao terminar
+    //                   em degrau
+    // O custo da convolucao e proporcional ao tamanho da IR
+    struct ImpulseResponseOptions
+    {
+        ResamplingQuality resampling = ResamplingQuality::engine;
+        bool minimumPhase = false;
+        float truncationDb = 0.0f;
+        double lengthSeconds = 0.0;
+        double fadeOutSeconds = 0.005;
+
+        bool isIdentity() const noexcept
+        {
+            return resampling == ResamplingQuality::engine && ! minimumPhase && truncationDb >= 0.0f && lengthSeconds <= 0.0;
+        }
+    };
+
+    //==============================================================================
+    // Decodifica uma IR em memoria (WAV, AIFF...) ou em arquivo. Retorna false se o
+    // formato nao for reconhecido
+    inline bool readImpulseResponse(std::unique_ptr<juce::AudioFormatReader> reader,
+                                    juce::AudioBuffer<float>& destination, double& sampleRate)
+    {
+        if (reader == nullptr || reader->lengthInSamples <= 0)
+            return false;
+
+        destination.setSize((int)reader->numChannels, (int)reader->lengthInSamples);
+        reader->read(&destination, 0, (int)reader->lengthInSamples, 0, true, true);
+        sampleRate = reader->sampleRate;
+        return true;
+    }
+
+    inline bool readImpulseResponse(const void* data, size_t dataSize,
+                                    juce::AudioBuffer<float>& destination, double& sampleRate)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        return readImpulseResponse(std::unique_ptr<juce::AudioFormatReader>(formats.createReaderFor(
+                                       std::make_unique<juce::MemoryInputStream>(data, dataSize, false))),
+                                   destination, sampleRate);
+    }
+
+    inline bool readImpulseResponse(const juce::File& file, juce::AudioBuffer<float>& destination, double& sampleRate)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        return readImpulseResponse(std::unique_ptr<juce::AudioFormatReader>(formats.createReaderFor(file)),
+                                   destination, sampleRate);
+    }
+
+    //==============================================================================
+    // Tamanho em que a energia restante (integral de Schroeder, somando os canais) cai
+    // abaixo de thresholdDb em relacao a energia total
+    inline int findEnergyTruncation(const juce::AudioBuffer<float>& ir, float thresholdDb)
+    {
+        const int numSamples = ir.getNumSamples();
+        std::vector<double> energy((size_t)numSamples, 0.0);
+
+        for (int channel = 0; channel < ir.getNumChannels(); ++channel)
+        {
+            const float* x = ir.getReadPointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+                energy[(size_t)i] += (double)x[i] * (double)x[i];
+        }
+
+        double total = 0.0;
+
+        for (auto e : energy)
+            total += e;
+
+        if (total <= 0.0)
+            return numSamples;
+
+        const double limit = total * std::pow(10.0, (double)thresholdDb / 10.0);
+        double remaining = 0.0;
+
+        // anda do fim para o inicio ate a cauda passar do limite
+        for (int i = numSamples - 1; i >= 0; --i)
+        {
+            remaining += energy[(size_t)i];
+
+            if (remaining > limit)
+                return i + 1;
+        }
+
+        return numSamples;
+    }
+
+    // Meio cosseno de 1 a 0 nas ultimas numSamples amostras
+    inline void applyFadeOut(juce::AudioBuffer<float>& ir, int numSamples)
+    {
+        const int length = ir.getNumSamples();
+        numSamples = juce::jmin(numSamples, length);
+
+        if (numSamples <= 0)
+            return;
+
+        const int start = length - numSamples;
+
+        for (int channel = 0; channel < ir.getNumChannels(); ++channel)
+        {
+            float* x = ir.getWritePointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+                x[start + i] *= 0.5f * (1.0f + std::cos(juce::MathConstants<float>::pi * (float)(i + 1) / (float)numSamples));
+        }
+    }
+
+    //==============================================================================
+    // Fase minima pelo cepstro real: log da magnitude -> cepstro -> dobra a parte
+    // anticausal sobre a causal -> exp -> resposta. A FFT tem 4x o tamanho da IR para
+    // reduzir o aliasing do cepstro. A magnitude e limitada a -120 dB do pico antes do
+    // log, para que zeros espectrais nao levem a log(0)
+    inline void makeMinimumPhase(juce::AudioBuffer<float>& ir)
+    {
+        using Complex = std::complex<float>;
+
+        const int length = ir.getNumSamples();
+
+        if (length < 2)
+            return;
+
+        const int order = juce::jmax(4, (int)std::ceil(std::log2((double)length)) + 2);
+        const int size = 1 << order;
+        juce::dsp::FFT fft(order);
+
+        std::vector<Complex> time((size_t)size), frequency((size_t)size);
+
+        for (int channel = 0; channel < ir.getNumChannels(); ++channel)
+        {
+            float* x = ir.getWritePointer(channel);
+
+            std::fill(time.begin(), time.end(), Complex());
+            for (int i = 0; i < length; ++i)
+                time[(size_t)i] = x[i];
+
+            fft.perform(time.data(), frequency.data(), false);
+
+            float peak = 0.0f;
+            for (const auto& bin : frequency)
+                peak = juce::jmax(peak, std::abs(bin));
+
+            if (peak <= 0.0f)
+                continue;
+
+            const float floor = peak * 1.0e-6f;
+
+            for (auto& bin : frequency)
+                bin = std::log(juce::jmax(std::abs(bin), floor));
+
+            // cepstro real (a FFT inversa do JUCE ja divide por size)
+            fft.perform(frequency.data(), time.data(), true);
+
+            for (int i = 1; i < size / 2; ++i)
+                time[(size_t)i] = 2.0f * time[(size_t)i].real();
+
+            time[0] = time[0].real();
+            time[(size_t)size / 2] = time[(size_t)size / 2].real();
+
+            for (int i = size / 2 + 1; i < size; ++i)
+                time[(size_t)i] = 0.0f;
+
+            fft.perform(time.data(), frequency.data(), false);
+
+            for (auto& bin : frequency)
+                bin = std::exp(bin);
+
+            fft.perform(frequency.data(), time.data(), true);
+
+            for (int i = 0; i < length; ++i)
+                x[i] = time[(size_t)i].real();
+        }
+    }
+
+    //==============================================================================
+    // Converte a IR de fromRate para toRate. A IR e multiplicada por fromRate / toRate,
+    // para que a resposta em frequencia da convolucao nao mude com a taxa
+    inline void resampleImpulseResponse(juce::AudioBuffer<float>& ir, double fromRate, double toRate, ResamplingQuality quality)
+    {
+        if (quality == ResamplingQuality::engine || fromRate <= 0.0 || toRate <= 0.0 || fromRate == toRate)
+            return;
+
+        const int length = ir.getNumSamples();
+        const double ratio = toRate / fromRate;
+        const int outLength = juce::jmax(1, (int)std::ceil(length * ratio));
+        const float gain = (float)(1.0 / ratio);
+
+        juce::AudioBuffer<float> output(ir.getNumChannels(), outLength);
+
+        if (quality == ResamplingQuality::linear)
+        {
+            for (int channel = 0; channel < ir.getNumChannels(); ++channel)
+            {
+                const float* x = ir.getReadPointer(channel);
+                float* y = output.getWritePointer(channel);
+
+                for (int n = 0; n < outLength; ++n)
+                {
+                    const double t = n / ratio;
+                    const int i = (int)t;
+                    const float frac = (float)(t - i);
+                    const float a = i < length ? x[i] : 0.0f;
+                    const float b = i + 1 < length ? x[i + 1] : 0.0f;
+                    y[n] = gain * (a + frac * (b - a));
+                }
+            }
+        }
+        else
+        {
+            // tabela polifasica: numPhases posicoes fracionarias x 2 * halfWidth coeficientes.
+            // Ao reduzir a taxa, o corte desce para a nova Nyquist e o nucleo fica mais largo
+            constexpr int numPhases = 256;
+            constexpr int baseHalfWidth = 32;
+            constexpr double rolloff = 0.95;
+
+            const double cutoff = 0.5 * rolloff * juce::jmin(1.0, ratio);   // ciclos por amostra de entrada
+            const int halfWidth = (int)std::ceil(baseHalfWidth / juce::jmin(1.0, ratio));
+            const int taps = 2 * halfWidth;
+
+            std::vector<float> table((size_t)((numPhases + 1) * taps));
+
+            for (int p = 0; p <= numPhases; ++p)
+                for (int k = 0; k < taps; ++k)
+                {
+                    // distancia entre a amostra de entrada e o instante de saida
+                    const double t = (k - halfWidth + 1) - (double)p / numPhases;
+                    const double u = t / halfWidth;
+                    const double window = std::abs(u) >= 1.0 ? 0.0
+                                        : 0.42 + 0.5 * std::cos(juce::MathConstants<double>::pi * u)
+                                               + 0.08 * std::cos(2.0 * juce::MathConstants<double>::pi * u);
+                    const double x = 2.0 * cutoff * t;
+                    const double sinc = x == 0.0 ? 1.0 : std::sin(juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+                    table[(size_t)(p * taps + k)] = (float)(2.0 * cutoff * sinc * window);
+                }
+
+            for (int channel = 0; channel < ir.getNumChannels(); ++channel)
+            {
+                const float* x = ir.getReadPointer(channel);
+                float* y = output.getWritePointer(channel);
+
+                for (int n = 0; n < outLength; ++n)
+                {
+                    const double t = n / ratio;
+                    const int i = (int)t;
+                    const int phase = juce::roundToInt((t - i) * numPhases);
+                    const float* h = table.data() + phase * taps;
+                    const int first = i - halfWidth + 1;
+
+                    float sum = 0.0f;
+
+                    for (int k = juce::jmax(0, -first); k < taps && first + k < length; ++k)
+                        sum += x[first + k] * h[k];
+
+                    y[n] = gain * sum;
+                }
+            }
+        }
+
+        ir = std::move(output);
+    }
+
+    //==============================================================================
+    // Corte de silencio e normalizacao como os do juce::dsp::Convolution (Trim::yes e
+    // Normalise::yes), para motores que recebem a IR ja pronta
+
+    // Remove o inicio e o fim abaixo de -80 dBFS em todos os canais
+    inline void trimSilence(juce::AudioBuffer<float>& ir)
+    {
+        const float threshold = juce::Decibels::decibelsToGain(-80.0f);
+        const int numSamples = ir.getNumSamples();
+        int first = numSamples, last = 0;
+
+        for (int channel = 0; channel < ir.getNumChannels(); ++channel)
+        {
+            const float* x = ir.getReadPointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+                if (std::abs(x[i]) >= threshold)
+                {
+                    first = juce::jmin(first, i);
+                    last = juce::jmax(last, i + 1);
+                }
+        }
+
+        if (first >= last)
+            return;
+
+        juce::AudioBuffer<float> trimmed(ir.getNumChannels(), last - first);
+
+        for (int channel = 0; channel < ir.getNumChannels(); ++channel)
+            trimmed.copyFrom(channel, 0, ir, channel, first, last - first);
+
+        ir = std::move(trimmed);
+    }
+
+    // Ganho que leva a energia do canal mais forte para 1/64 (0.125^2)
+    inline void normaliseImpulseResponse(juce::AudioBuffer<float>& ir)
+    {
+        double maxEnergy = 0.0;
+
+        for (int channel = 0; channel < ir.getNumChannels(); ++channel)
+        {
+            const float* x = ir.getReadPointer(channel);
+            double energy = 0.0;
+
+            for (int i = 0; i < ir.getNumSamples(); ++i)
+                energy += (double)x[i] * (double)x[i];
+
+            maxEnergy = juce::jmax(maxEnergy, energy);
+        }
+
+        if (maxEnergy > 0.0)
+            ir.applyGain((float)(0.125 / std::sqrt(maxEnergy)));
+    }
+
+    //==============================================================================
+    // Aplica as opcoes (ver ImpulseResponseOptions), exceto a conversao de taxa, que
+    // depende da taxa de processamento (resampleImpulseResponse)
+    inline void processImpulseResponse(juce::AudioBuffer<float>& ir, double sampleRate, const ImpulseResponseOptions& options)
+    {
+        if (options.minimumPhase)
+            makeMinimumPhase(ir);
+
+        int length = ir.getNumSamples();
+
+        if (options.truncationDb < 0.0f)
+            length = findEnergyTruncation(ir, options.truncationDb);
+
+        if (options.lengthSeconds > 0.0)
+            length = juce::jmin(length, juce::jmax(1, (int)(options.lengthSeconds * sampleRate)));
+
+        if (length < ir.getNumSamples())
+        {
+            ir.setSize(ir.getNumChannels(), length, true);
+            applyFadeOut(ir, juce::jmin(length / 2, (int)(options.fadeOutSeconds * sampleRate)));
+        }
+    }
+
+    //==============================================================================
+    // Tempo de decaimento (RT60) em duas bandas a partir de startSample, para ajustar um
+    // reverb algoritmico a uma IR (ver HybridReverb.h)
+    struct DecayEstimate
+    {
+        double lowSeconds = 0.0;    // abaixo de decayLowBandHz (0 = sem estimativa)
+        double highSeconds = 0.0;   // acima de decayHighBandHz
+    };
+
+    constexpr double decayLowBandHz = 500.0;
+    constexpr double decayHighBandHz = 4000.0;
+
+    // Integral de Schroeder a partir de startSample e reta de minimos quadrados no trecho
+    // entre -5 e -25 dB, extrapolada para -60 dB. Se a energia acabar antes de -25 dB, a
+    // reta vai ate o fim da IR
+    inline double fitDecayTime(const std::vector<double>& energy, int startSample, double sampleRate)
+    {
+        const int numSamples = (int)energy.size();
+
+        if (startSample < 0 || startSample >= numSamples - 1)
+            return 0.0;
+
+        std::vector<double> decay((size_t)(numSamples - startSample));
+        double remaining = 0.0;
+
+        for (int i = numSamples - 1; i >= startSample; --i)
+        {
+            remaining += energy[(size_t)i];
+            decay[(size_t)(i - startSample)] = remaining;
+        }
+
+        if (remaining <= 0.0)
+            return 0.0;
+
+        double n = 0.0, sumT = 0.0, sumL = 0.0, sumTT = 0.0, sumTL = 0.0;
+
+        for (size_t i = 0; i < decay.size() && decay[i] > 0.0; ++i)
+        {
+            const double level = 10.0 * std::log10(decay[i] / remaining);
+
+            if (level < -25.0)
+                break;
+
+            if (level > -5.0)
+                continue;
+
+            const double t = (double)i / sampleRate;
+            n += 1.0;
+            sumT += t;
+            sumL += level;
+            sumTT += t * t;
+            sumTL += t * level;
+        }
+
+        const double denominator = n * sumTT - sumT * sumT;
+
+        if (n < 2.0 || denominator <= 0.0)
+            return 0.0;
+
+        const double slope = (n * sumTL - sumT * sumL) / denominator;     // dB/s
+        return slope < 0.0 ? -60.0 / slope : 0.0;
+    }
+
+    // Separa as bandas com Butterworth de 4a ordem e soma a energia dos canais
+    inline DecayEstimate estimateDecay(const juce::AudioBuffer<float>& ir, double sampleRate, int startSample)
+    {
+        static constexpr float q[] = { 0.54120f, 1.30656f };
+
+        DecayEstimate estimate;
+        const int numSamples = ir.getNumSamples();
+
+        if (startSample >= numSamples || sampleRate <= 0.0)
+            return estimate;
+
+        for (int band = 0; band < 2; ++band)
+        {
+            juce::AudioBuffer<float> filtered(ir);
+            BiquadCascade<float, 2> filter;
+            filter.prepare({ sampleRate, (juce::uint32)numSamples, (juce::uint32)ir.getNumChannels() });
+
+            for (int stage = 0; stage < 2; ++stage)
+                filter.setCoefficients(stage, band == 0
+                    ? BiquadCoefficients<float>::makeLowPass(sampleRate, (float)decayLowBandHz, q[stage])
+                    : BiquadCoefficients<float>::makeHighPass(sampleRate, (float)juce::jmin(decayHighBandHz, 0.4 * sampleRate), q[stage]));
+
+            juce::dsp::AudioBlock<float> block(filtered);
+            filter.process(juce::dsp::ProcessContextReplacing<float>(block));
+
+            std::vector<double> energy((size_t)numSamples, 0.0);
+
+            for (int channel = 0; channel < filtered.getNumChannels(); ++channel)
+            {
+                const float* x = filtered.getReadPointer(channel);
+
+                for (int i = 0; i < numSamples; ++i)
+                    energy[(size_t)i] += (double)x[i] * (double)x[i];
+            }
+
+            (band == 0 ? estimate.lowSeconds : estimate.highSeconds) = fitDecayTime(energy, startSample, sampleRate);
+        }
+
+        return estimate;
+    }
+}
@@ -0,0 +1,77 @@
+//==============================================================================
+// Interpolation.h: leitura fracionaria de buffers circulares
+//==============================================================================
+
+#pragma once
+
+#include <cmath>
+
+namespace dsp_core
+{
+    enum class Interpolation
+    {
+        NearestNeighbour,
+        Linear,
+        Cubic
+    };
+
+    //==============================================================================
+    // Todas as funcoes recebem o buffer circular (data, length) e a posicao de leitura
+    // em amostras, ja dentro de [0, length)
+    //------------------------------------------------------------------------------
+    // Arredonda a posicao para a amostra mais proxima. O arredondamento pode cair no
+    // fim do buffer, e nesse caso volta para o inicio
+    template <typename SampleType>
+    inline SampleType interpolateNearest(const SampleType* data, int length, SampleType position) noexcept
+    {
+        int closestSample = (int)std::floor(position + SampleType(0.5));
+        if (closestSample == length)
+            closestSample = 0;
+        return data[closestSample];
+    }
+
+    // Media ponderada das duas amostras vizinhas pela fracao da posicao
+    template <typename SampleType>
+    inline SampleType interpolateLinear(const SampleType* data, int length, SampleType position) noexcept
+    {
+        const SampleType fraction = position - std::floor(position);
+        const int previousSample = (int)std::floor(position);
+        const int nextSample = (previousSample + 1) % length;
+        return fraction * data[nextSample] + (SampleType(1) - fraction) * data[previousSample];
+    }
+
+    // Interpolacao cubica (variante Catmull-Rom) com as quatro amostras vizinhas.
+    // Resultado mais limpo que a linear, com mais operacoes por amostra
+    template <typename SampleType>
+    inline SampleType interpolateCubic(const SampleType* data, int length, SampleType position) noexcept
+    {
+        const int sample1 = (int)std::floor(position);
+        const int sample2 = (sample1 + 1) % length;
+        const int sample3 = (sample2 + 1) % length;
+        const int sample0 = (sample1 - 1 + length) % length;
+
+        const SampleType fraction = position - std::floor(position);
+        const SampleType frsq = fraction * fraction;
+
+        const SampleType a0 = SampleType(-0.5) * data[sample0] + SampleType(1.5) * data[sample1] - SampleType(1.5) * data[sample2] + SampleType(0.5) * data[sample3];
+        const SampleType a1 = data[sample0] - SampleType(2.5) * data[sample1] + SampleType(2.0) * data[sample2] - SampleType(0.5) * data[sample3];
+        const SampleType a2 = SampleType(-0.5) * data[sample0] + SampleType(0.5) * data[sample2];
+        const SampleType a3 = data[sample1];
+
+        return a0 * fraction * frsq + a1 * frsq + a2 * fraction + a3;
+    }
+
+    //------------------------------------------------------------------------------
+    // Escolhe o tipo de interpolacao em tempo de execucao
+    template <typename SampleType>
+    inline SampleType interpolate(const SampleType* data, int length, SampleType position, Interpolation type) noexcept
+    {
+        switch (type)
+        {
+            case Interpolation::Linear: return interpolateLinear(data, length, position);
+            case Interpolation::Cubic:  return interpolateCubic(data, length, position);
+            case Interpolation::NearestNeighbour: break;
+        }
+        return interpolateNearest(data, length, position);
+    }
+}
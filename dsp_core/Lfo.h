@@ -0,0 +1,84 @@
+//==============================================================================
+// Lfo.h: oscilador de baixa frequencia para modulacao
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <cmath>
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Fase normalizada em [0, 1). A saida e uma senoide unipolar em [0, 1] (nao em
+    // [-1, 1]), pronta para escalar tempos de delay
+    template <typename SampleType>
+    class Lfo
+    {
+    public:
+        void prepare(const juce::dsp::ProcessSpec& spec)
+        {
+            inverseSampleRate = SampleType(1) / (SampleType)spec.sampleRate;
+            reset();
+        }
+
+        void reset() noexcept { phase = 0; }
+
+        void setFrequency(SampleType newFrequency) noexcept { frequency = newFrequency; }
+        SampleType getFrequency() const noexcept { return frequency; }
+
+        // A fase e exposta para processadores que rodam o mesmo LFO em varios canais
+        // ou vozes: cada um parte da fase atual e grava o resultado no fim do bloco
+        SampleType getPhase() const noexcept { return phase; }
+        void setPhase(SampleType newPhase) noexcept { phase = newPhase; }
+
+        SampleType getPhaseIncrement() const noexcept { return frequency * inverseSampleRate; }
+
+        //------------------------------------------------------------------------------
+        // Avanca a fase, mantendo-a em [0, 1)
+        static SampleType advance(SampleType currentPhase, SampleType increment) noexcept
+        {
+            currentPhase += increment;
+            if (currentPhase >= SampleType(1))
+                currentPhase -= SampleType(1);
+            return currentPhase;
+        }
+
+        static SampleType unipolarSine(SampleType currentPhase) noexcept
+        {
+            return SampleType(0.5) + SampleType(0.5) * std::sin(SampleType(2) * juce::MathConstants<SampleType>::pi * currentPhase);
+        }
+
+        // Proxima amostra do LFO
+        SampleType processSample() noexcept
+        {
+            const SampleType out = unipolarSine(phase);
+            phase = advance(phase, getPhaseIncrement());
+            return out;
+        }
+
+        // Preenche todos os canais do bloco de saida com a forma de onda (o mesmo valor
+        // em todos os canais)
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            auto&& outputBlock = context.getOutputBlock();
+            const auto numChannels = outputBlock.getNumChannels();
+            const auto numSamples = outputBlock.getNumSamples();
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                const SampleType value = processSample();
+
+                for (size_t channel = 0; channel < numChannels; ++channel)
+                    outputBlock.getChannelPointer(channel)[i] = value;
+            }
+        }
+
+    private:
+        SampleType frequency = 0;
+        SampleType inverseSampleRate = SampleType(1) / SampleType(44100);
+        SampleType phase = 0;
+    };
+}
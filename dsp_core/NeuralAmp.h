@@ -0,0 +1,558 @@
+//==============================================================================
+// NeuralAmp.h: amplificador capturado por rede recorrente (LSTM/GRU) pequena
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include "CpuDispatch.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace dsp_core
+{
+    enum class RecurrentCell { lstm, gru };
+
+    //==============================================================================
+    // Pesos de um modelo de 1 camada recorrente + camada linear, no formato JSON exportado
+    // pelo PyTorch nos projetos de captura de amplificadores (GuitarML/Proteus,
+    // Automated-GuitarAmpModelling):
+    //
+    //   "model_data": { "unit_type": "LSTM" | "GRU", "hidden_size": H, "input_size": 1,
+    //                   "output_size": 1, "num_layers": 1, "skip": 0 | 1 }
+    //   "state_dict": { "rec.weight_ih_l0": [G*H][1], "rec.weight_hh_l0": [G*H][H],
+    //                   "rec.bias_ih_l0": [G*H], "rec.bias_hh_l0": [G*H],
+    //                   "lin.weight": [1][H], "lin.bias": [1] }
+    //
+    // G e o numero de portas: 4 na LSTM (i, f, g, o) e 3 na GRU (r, z, n), nessa ordem
+    // dentro das linhas. Com skip, a entrada e somada a saida (o modelo aprende so a
+    // diferenca). O modelo roda na taxa do host; capturas sao feitas em 44.1 ou 48 kHz
+    struct NeuralAmpWeights
+    {
+        RecurrentCell cell = RecurrentCell::lstm;
+        int hiddenSize = 0;
+        bool skip = false;
+
+        std::vector<float> inputWeights;        // [G*H]
+        std::vector<float> recurrentWeights;    // [G*H][H], linhas como no PyTorch
+        std::vector<float> inputBias;           // [G*H]
+        std::vector<float> recurrentBias;       // [G*H]
+        std::vector<float> outputWeights;       // [H]
+        float outputBias = 0.0f;
+
+        int getNumGates() const noexcept { return cell == RecurrentCell::lstm ? 4 : 3; }
+
+        juce::String getDescription() const
+        {
+            return juce::String(cell == RecurrentCell::lstm ? "LSTM " : "GRU ") + juce::String(hiddenSize)
+                 + (skip ? " + skip" : "");
+        }
+
+        // Le e valida um arquivo. Em caso de erro, retorna false com a mensagem em error
+        bool load(const juce::File& file, juce::String& error)
+        {
+            if (! file.existsAsFile())
+            {
+                error = "arquivo nao encontrado: " + file.getFullPathName();
+                return false;
+            }
+
+            return parse(juce::JSON::parse(file), error);
+        }
+
+        bool parse(const juce::var& json, juce::String& error)
+        {
+            const auto modelData = json.getProperty("model_data", {});
+            const auto stateDict = json.getProperty("state_dict", {});
+
+            if (! modelData.isObject() || ! stateDict.isObject())
+            {
+                error = "formato desconhecido (esperado model_data e state_dict)";
+                return false;
+            }
+
+            const auto unitType = modelData.getProperty("unit_type", "LSTM").toString().toUpperCase();
+
+            if (unitType != "LSTM" && unitType != "GRU")
+            {
+                error = "celula nao suportada: " + unitType;
+                return false;
+            }
+
+            if ((int)modelData.getProperty("num_layers", 1) != 1 || (int)modelData.getProperty("input_size", 1) != 1
+                || (int)modelData.getProperty("output_size", 1) != 1)
+            {
+                error = "so modelos de 1 camada, 1 entrada e 1 saida";
+                return false;
+            }
+
+            cell = unitType == "LSTM" ? RecurrentCell::lstm : RecurrentCell::gru;
+            hiddenSize = (int)modelData.getProperty("hidden_size", 0);
+            skip = (int)modelData.getProperty("skip", 0) != 0;
+
+            if (! isSupportedSize(hiddenSize))
+            {
+                error = "hidden_size nao suportado: " + juce::String(hiddenSize);
+                return false;
+            }
+
+            const int rows = getNumGates() * hiddenSize;
+            std::vector<float> outputBiasValues;
+
+            if (! readTensor(stateDict, "rec.weight_ih_l0", (size_t)rows, inputWeights, error)
+                || ! readTensor(stateDict, "rec.weight_hh_l0", (size_t)(rows * hiddenSize), recurrentWeights, error)
+                || ! readTensor(stateDict, "rec.bias_ih_l0", (size_t)rows, inputBias, error)
+                || ! readTensor(stateDict, "rec.bias_hh_l0", (size_t)rows, recurrentBias, error)
+                || ! readTensor(stateDict, "lin.weight", (size_t)hiddenSize, outputWeights, error)
+                || ! readTensor(stateDict, "lin.bias", 1, outputBiasValues, error))
+                return false;
+
+            outputBias = outputBiasValues[0];
+            return true;
+        }
+
+        // Pesos aleatorios com a inicializacao do PyTorch (uniforme em +-1/sqrt(H)), para
+        // medir custo (bench/KernelBench.cpp) sem arquivo de modelo
+        static NeuralAmpWeights makeRandom(RecurrentCell cell, int hiddenSize, juce::int64 seed = 1)
+        {
+            NeuralAmpWeights weights;
+            weights.cell = cell;
+            weights.hiddenSize = hiddenSize;
+            weights.skip = true;
+
+            juce::Random random(seed);
+            const float scale = 1.0f / std::sqrt((float)hiddenSize);
+            auto fill = [&](std::vector<float>& values, size_t size)
+            {
+                values.resize(size);
+
+                for (auto& value : values)
+                    value = scale * (2.0f * random.nextFloat() - 1.0f);
+            };
+
+            const auto rows = (size_t)(weights.getNumGates() * hiddenSize);
+            fill(weights.inputWeights, rows);
+            fill(weights.recurrentWeights, rows * (size_t)hiddenSize);
+            fill(weights.inputBias, rows);
+            fill(weights.recurrentBias, rows);
+            fill(weights.outputWeights, (size_t)hiddenSize);
+            return weights;
+        }
+
+        // Tamanhos com kernel compilado (ver NeuralAmpModel::create)
+        static bool isSupportedSize(int size) noexcept
+        {
+            for (auto supported : supportedSizes)
+                if (size == supported)
+                    return true;
+
+            return false;
+        }
+
+        static constexpr int supportedSizes[] = { 8, 12, 16, 20, 24, 32, 40 };
+
+    private:
+        // Tensor de qualquer dimensao achatado em ordem de linhas
+        static bool readTensor(const juce::var& stateDict, const char* name, size_t expectedSize,
+                               std::vector<float>& values, juce::String& error)
+        {
+            values.clear();
+            flatten(stateDict.getProperty(name, {}), values);
+
+            if (values.size() != expectedSize)
+            {
+                error = juce::String(name) + ": esperados " + juce::String((int)expectedSize)
+                      + " valores, encontrados " + juce::String((int)values.size());
+                return false;
+            }
+
+            return true;
+        }
+
+        static void flatten(const juce::var& value, std::vector<float>& values)
+        {
+            if (const auto* array = value.getArray())
+            {
+                for (const auto& element : *array)
+                    flatten(element, values);
+            }
+            else if (! value.isVoid())
+            {
+                values.push_back((float)value);
+            }
+        }
+    };
+
+    //==============================================================================
+    // Modelo pronto para rodar: pesos reorganizados para o kernel e estado por canal.
+    // prepare() aloca; reset() e process() nao alocam
+    class NeuralAmpModel
+    {
+    public:
+        virtual ~NeuralAmpModel() = default;
+
+        virtual void prepare(int numChannels, SimdLevel level) = 0;
+        virtual void reset() noexcept = 0;
+
+        // Processa numSamples amostras de um canal no lugar
+        virtual void process(float* samples, int numSamples, int channel) noexcept = 0;
+
+        // Kernel com o tamanho de weights.hiddenSize fixo em tempo de compilacao
+        static std::unique_ptr<NeuralAmpModel> create(const NeuralAmpWeights& weights);
+    };
+
+    namespace neural_amp_detail
+    {
+        //==============================================================================
+        // Ativacoes racionais (juce::dsp::FastMathApproximations::tanh, erro < 1e-4 em
+        // +-5), sem desvios: vetorizam junto com os lacos das portas
+        inline float tanh(float x) noexcept
+        {
+            return juce::dsp::FastMathApproximations::tanh(juce::jlimit(-5.0f, 5.0f, x));
+        }
+
+        inline float sigmoid(float x) noexcept
+        {
+            return 0.5f + 0.5f * tanh(0.5f * x);
+        }
+
+        //==============================================================================
+        // Camada linear e pesos comuns as duas celulas. A matriz recorrente fica transposta
+        // ([H][G*H]): cada passo soma H colunas contiguas de G*H portas, um laco de tamanho
+        // fixo sem reducao horizontal que o compilador vetoriza para o nivel do dispatch
+        template <int H, int G>
+        struct RecurrentLayer
+        {
+            static constexpr int numGates = G * H;
+
+            alignas(64) std::array<float, numGates> inputWeights {};
+            alignas(64) std::array<float, numGates> bias {};
+            alignas(64) std::array<float, numGates> recurrentBias {};
+            alignas(64) std::array<float, H * numGates> recurrent {};
+            alignas(64) std::array<float, H> outputWeights {};
+            float outputBias = 0.0f;
+            bool skip = false;
+
+            explicit RecurrentLayer(const NeuralAmpWeights& weights, bool mergeBiases)
+            {
+                for (int row = 0; row < numGates; ++row)
+                {
+                    inputWeights[(size_t)row] = weights.inputWeights[(size_t)row];
+                    bias[(size_t)row] = weights.inputBias[(size_t)row]
+                                      + (mergeBiases ? weights.recurrentBias[(size_t)row] : 0.0f);
+                    recurrentBias[(size_t)row] = mergeBiases ? 0.0f : weights.recurrentBias[(size_t)row];
+
+                    for (int column = 0; column < H; ++column)
+                        recurrent[(size_t)(column * numGates + row)] = weights.recurrentWeights[(size_t)(row * H + column)];
+                }
+
+                for (int column = 0; column < H; ++column)
+                    outputWeights[(size_t)column] = weights.outputWeights[(size_t)column];
+
+                outputBias = weights.outputBias;
+                skip = weights.skip;
+            }
+
+            // gates += recurrent^T * hidden
+            void addRecurrent(float* gates, const float* hidden) const noexcept
+            {
+                for (int column = 0; column < H; ++column)
+                {
+                    const float value = hidden[column];
+                    const float* weights = recurrent.data() + column * numGates;
+
+                    for (int row = 0; row < numGates; ++row)
+                        gates[row] += value * weights[row];
+                }
+            }
+
+            float output(const float* hidden, float input) const noexcept
+            {
+                float sum = outputBias;
+
+                for (int column = 0; column < H; ++column)
+                    sum += outputWeights[(size_t)column] * hidden[column];
+
+                return skip ? sum + input : sum;
+            }
+        };
+
+        //==============================================================================
+        // LSTM (PyTorch): i, f, o = sigmoide, g = tanh; c = f*c + i*g; h = o*tanh(c)
+        template <int H>
+        class LstmModel final : public NeuralAmpModel
+        {
+        public:
+            explicit LstmModel(const NeuralAmpWeights& weights) : layer(weights, true) {}
+
+            void prepare(int numChannels, SimdLevel level) override
+            {
+                states.assign((size_t)juce::jmax(1, numChannels), State {});
+                simdLevel = level;
+            }
+
+            void reset() noexcept override
+            {
+                for (auto& state : states)
+                    state = State {};
+            }
+
+            void process(float* samples, int numSamples, int channel) noexcept override
+            {
+                if ((size_t)channel >= states.size())
+                    return;
+
+                auto& state = states[(size_t)channel];
+
+                dispatch(simdLevel, [&]
+                {
+                    for (int n = 0; n < numSamples; ++n)
+                        samples[n] = step(state, samples[n]);
+                });
+            }
+
+        private:
+            struct State
+            {
+                alignas(64) std::array<float, H> hidden {};
+                alignas(64) std::array<float, H> cell {};
+            };
+
+            float step(State& state, float input) const noexcept
+            {
+                alignas(64) float gates[4 * H];
+
+                for (int row = 0; row < 4 * H; ++row)
+                    gates[row] = layer.bias[(size_t)row] + layer.inputWeights[(size_t)row] * input;
+
+                layer.addRecurrent(gates, state.hidden.data());
+
+                for (int k = 0; k < H; ++k)
+                {
+                    const float inputGate = sigmoid(gates[k]);
+                    const float forgetGate = sigmoid(gates[H + k]);
+                    const float candidate = tanh(gates[2 * H + k]);
+                    const float outputGate = sigmoid(gates[3 * H + k]);
+
+                    state.cell[(size_t)k] = forgetGate * state.cell[(size_t)k] + inputGate * candidate;
+                    state.hidden[(size_t)k] = outputGate * tanh(state.cell[(size_t)k]);
+                }
+
+                return layer.output(state.hidden.data(), input);
+            }
+
+            RecurrentLayer<H, 4> layer;
+            std::vector<State> states;
+            SimdLevel simdLevel = SimdLevel::generic;
+        };
+
+        //==============================================================================
+        // GRU (PyTorch): r, z = sigmoide; n = tanh(Wx + b + r*(Uh + bh)); h = (1-z)*n + z*h.
+        // O bias recorrente de n fica separado por estar dentro do produto com r
+        template <int H>
+        class GruModel final : public NeuralAmpModel
+        {
+        public:
+            explicit GruModel(const NeuralAmpWeights& weights) : layer(weights, false) {}
+
+            void prepare(int numChannels, SimdLevel level) override
+            {
+                states.assign((size_t)juce::jmax(1, numChannels), State {});
+                simdLevel = level;
+            }
+
+            void reset() noexcept override
+            {
+                for (auto& state : states)
+                    state = State {};
+            }
+
+            void process(float* samples, int numSamples, int channel) noexcept override
+            {
+                if ((size_t)channel >= states.size())
+                    return;
+
+                auto& state = states[(size_t)channel];
+
+                dispatch(simdLevel, [&]
+                {
+                    for (int n = 0; n < numSamples; ++n)
+                        samples[n] = step(state, samples[n]);
+                });
+            }
+
+        private:
+            struct State
+            {
+                alignas(64) std::array<float, H> hidden {};
+            };
+
+            float step(State& state, float input) const noexcept
+            {
+                alignas(64) float recurrentGates[3 * H];
+
+                for (int row = 0; row < 3 * H; ++row)
+                    recurrentGates[row] = layer.recurrentBias[(size_t)row];
+
+                layer.addRecurrent(recurrentGates, state.hidden.data());
+
+                for (int k = 0; k < H; ++k)
+                {
+                    const auto input0 = layer.bias[(size_t)k] + layer.inputWeights[(size_t)k] * input;
+                    const auto input1 = layer.bias[(size_t)(H + k)] + layer.inputWeights[(size_t)(H + k)] * input;
+                    const auto input2 = layer.bias[(size_t)(2 * H + k)] + layer.inputWeights[(size_t)(2 * H + k)] * input;
+
+                    const float resetGate = sigmoid(input0 + recurrentGates[k]);
+                    const float updateGate = sigmoid(input1 + recurrentGates[H + k]);
+                    const float candidate = tanh(input2 + resetGate * recurrentGates[2 * H + k]);
+
+                    state.hidden[(size_t)k] = candidate + updateGate * (state.hidden[(size_t)k] - candidate);
+                }
+
+                return layer.output(state.hidden.data(), input);
+            }
+
+            RecurrentLayer<H, 3> layer;
+            std::vector<State> states;
+            SimdLevel simdLevel = SimdLevel::generic;
+        };
+
+        template <int H>
+        std::unique_ptr<NeuralAmpModel> createModel(const NeuralAmpWeights& weights)
+        {
+            if (weights.cell == RecurrentCell::lstm)
+                return std::make_unique<LstmModel<H>>(weights);
+
+            return std::make_unique<GruModel<H>>(weights);
+        }
+    }
+
+    inline std::unique_ptr<NeuralAmpModel> NeuralAmpModel::create(const NeuralAmpWeights& weights)
+    {
+        using namespace neural_amp_detail;
+
+        switch (weights.hiddenSize)
+        {
+            case 8:  return createModel<8>(weights);
+            case 12: return createModel<12>(weights);
+            case 16: return createModel<16>(weights);
+            case 20: return createModel<20>(weights);
+            case 24: return createModel<24>(weights);
+            case 32: return createModel<32>(weights);
+            case 40: return createModel<40>(weights);
+            default: break;
+        }
+
+        return nullptr;
+    }
+
+    //==============================================================================
+    // Estagio de cadeia (prepare/reset/process, como juce::dsp::ProcessorChain) com um
+    // modelo carregado. Sem modelo, o sinal passa sem alteracao.
+    //
+    // loadModel e clearModel sao chamados fora da thread de audio: o modelo novo e criado
+    // e preparado antes e trocado sob um SpinLock, como o motor de Convolution.h; se
+    // process() encontrar o lock ocupado, o bloco passa sem alteracao. Cada passo custa
+    // cerca de G*H*(H+2) multiplicacoes e somas (LSTM 20: ~1800 por amostra)
+    class NeuralAmp
+    {
+    public:
+        // Fora da thread de audio. Em caso de erro, mantem o modelo atual
+        bool loadModel(const juce::File& file, juce::String& error)
+        {
+            NeuralAmpWeights weights;
+
+            if (! weights.load(file, error))
+                return false;
+
+            loadModel(weights);
+            return true;
+        }
+
+        void loadModel(const NeuralAmpWeights& weights)
+        {
+            auto newModel = NeuralAmpModel::create(weights);
+            jassert(newModel != nullptr);
+            newModel->prepare(numChannels, simdLevel);
+            swapModel(newModel);
+            description = weights.getDescription();
+        }
+
+        void clearModel()
+        {
+            std::unique_ptr<NeuralAmpModel> empty;
+            swapModel(empty);
+            description = {};
+        }
+
+        bool hasModel() const noexcept { return loaded.load(); }
+
+        // Descricao do modelo atual (vazia sem modelo). Thread de mensagens
+        const juce::String& getModelDescription() const noexcept { return description; }
+
+        //------------------------------------------------------------------------------
+        void prepare(const juce::dsp::ProcessSpec& spec)
+        {
+            numChannels = (int)spec.numChannels;
+            simdLevel = CpuDispatch::getLevel();
+
+            const juce::SpinLock::ScopedLockType lock(modelLock);
+
+            if (model != nullptr)
+                model->prepare(numChannels, simdLevel);
+        }
+
+        void reset() noexcept
+        {
+            const juce::SpinLock::ScopedTryLockType lock(modelLock);
+
+            if (lock.isLocked() && model != nullptr)
+                model->reset();
+        }
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            auto&& input = context.getInputBlock();
+            auto&& output = context.getOutputBlock();
+
+            if (context.usesSeparateInputAndOutputBlocks())
+                output.copyFrom(input);
+
+            if (context.isBypassed)
+                return;
+
+            const juce::SpinLock::ScopedTryLockType lock(modelLock);
+
+            if (! lock.isLocked() || model == nullptr)
+                return;
+
+            const auto numSamples = (int)output.getNumSamples();
+
+            for (size_t channel = 0; channel < output.getNumChannels(); ++channel)
+                model->process(output.getChannelPointer(channel), numSamples, (int)channel);
+        }
+
+    private:
+        void swapModel(std::unique_ptr<NeuralAmpModel>& newModel)
+        {
+            {
+                const juce::SpinLock::ScopedLockType lock(modelLock);
+                std::swap(model, newModel);
+                loaded.store(model != nullptr);
+            }
+
+            // o modelo anterior (agora em newModel) e destruido pelo chamador, fora do lock
+        }
+
+        std::unique_ptr<NeuralAmpModel> model;
+        juce::SpinLock modelLock;
+        std::atomic<bool> loaded { false };
+        juce::String description;
+        int numChannels = 2;
+        SimdLevel simdLevel = CpuDispatch::getLevel();
+    };
+}
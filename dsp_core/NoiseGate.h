@@ -0,0 +1,246 @@
+//==============================================================================
+// NoiseGate.h: noise gate com histerese, attack, hold e release
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include "CpuDispatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Gate ligado entre os canais. O detector trabalha em trechos de chunkSize amostras:
+    // o pico de |x| do trecho (em todos os canais) vem de um laco com lanes acumuladores
+    // independentes, que o compilador vetoriza para o nivel do dispatch, e alimenta um
+    // envelope com subida instantanea que cai rangeDb em detectorReleaseSeconds. No fim
+    // de cada trecho:
+    //   fechado: abre quando o envelope passa de threshold
+    //   aberto:  com o envelope acima de threshold - hysteresis o hold e renovado; abaixo,
+    //            o hold conta e, esgotado, o gate fecha
+    // O ganho segue 1 (aberto) ou 0 (fechado) nos tempos de attack e release, em
+    // rampa linear dentro do trecho seguinte. A decisao tem atraso de um trecho (0.7 ms
+    // em 48 kHz). Com o ganho parado em 1 ou 0, o bloco e copiado ou zerado.
+    //
+    // getClosedSamples() conta ha quantas amostras a saida ja processada e silencio exato:
+    // quem vem depois pode parar de processar quando a propria cauda tambem ja acabou
+    template <typename SampleType>
+    class NoiseGate
+    {
+    public:
+        static constexpr int chunkSize = 32;
+        static constexpr int numLanes = 8;
+        static constexpr double detectorReleaseSeconds = 0.02;
+        static constexpr double rangeDb = -60.0;
+
+        //------------------------------------------------------------------------------
+        // Limiar de abertura em dBFS e distancia ate o de fechamento, em dB
+        void setThreshold(float newThresholdDb, float newHysteresisDb) noexcept
+        {
+            openLevel = juce::Decibels::decibelsToGain(newThresholdDb);
+            closeLevel = juce::Decibels::decibelsToGain(newThresholdDb - juce::jmax(0.0f, newHysteresisDb));
+        }
+
+        // Tempos em milissegundos. Attack e release: tempo para o ganho chegar a
+        // rangeDb do alvo (de 0 a 1 ou de 1 a 0), quando entao salta para o alvo
+        void setTimes(float attackMs, float holdMs, float releaseMs) noexcept
+        {
+            attackTime = attackMs;
+            holdTime = holdMs;
+            releaseTime = releaseMs;
+            updateCoefficients();
+        }
+
+        //------------------------------------------------------------------------------
+        void prepare(const juce::dsp::ProcessSpec& spec) noexcept
+        {
+            sampleRate = spec.sampleRate;
+            simdLevel = CpuDispatch::getLevel();
+            updateCoefficients();
+            reset();
+        }
+
+        // Comeca fechado e em silencio
+        void reset() noexcept
+        {
+            envelope = 0;
+            chunkPeak = 0;
+            chunkPosition = 0;
+            chunkGain = 0;
+            chunkStep = 0;
+            gain = 0;
+            open = false;
+            holdRemaining = 0;
+            closedSamples = 0;
+        }
+
+        bool isOpen() const noexcept { return open; }
+
+        // Amostras seguidas, ja na saida, com ganho 0 (0 enquanto houver sinal passando).
+        // Conta os trechos inteiros ja processados em silencio e a parte processada do
+        // trecho atual, nunca o que ainda vai sair
+        juce::int64 getClosedSamples() const noexcept
+        {
+            if (chunkStep == 0 && chunkGain == 0)
+                return closedSamples + chunkPosition;
+
+            return chunkPosition == 0 ? closedSamples : 0;
+        }
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            auto&& inputBlock = context.getInputBlock();
+            auto&& outputBlock = context.getOutputBlock();
+            const auto numChannels = outputBlock.getNumChannels();
+            const auto numSamples = outputBlock.getNumSamples();
+
+            if (context.isBypassed)
+            {
+                if (context.usesSeparateInputAndOutputBlocks())
+                    outputBlock.copyFrom(inputBlock);
+                return;
+            }
+
+            dispatch(simdLevel, [&]
+            {
+                size_t done = 0;
+
+                while (done < numSamples)
+                {
+                    const auto count = juce::jmin(numSamples - done, (size_t)(chunkSize - chunkPosition));
+
+                    for (size_t channel = 0; channel < numChannels; ++channel)
+                    {
+                        const SampleType* input = inputBlock.getChannelPointer(channel) + done;
+                        SampleType* output = outputBlock.getChannelPointer(channel) + done;
+
+                        chunkPeak = juce::jmax(chunkPeak, getPeak(input, count));
+                        applyGain(input, output, count);
+                    }
+
+                    done += count;
+                    chunkPosition += (int)count;
+
+                    if (chunkPosition == chunkSize)
+                        endChunk();
+                }
+            });
+        }
+
+    private:
+        // Pico de |x| com numLanes maximos independentes: sem dependencia entre lanes, o
+        // laco interno vira instrucoes vetoriais de abs e max
+        static SampleType getPeak(const SampleType* input, size_t count) noexcept
+        {
+            SampleType lanes[numLanes] {};
+            size_t i = 0;
+
+            for (; i + numLanes <= count; i += numLanes)
+                for (int lane = 0; lane < numLanes; ++lane)
+                    lanes[lane] = juce::jmax(lanes[lane], std::abs(input[i + (size_t)lane]));
+
+            SampleType peak = 0;
+
+            for (; i < count; ++i)
+                peak = juce::jmax(peak, std::abs(input[i]));
+
+            for (auto lane : lanes)
+                peak = juce::jmax(peak, lane);
+
+            return peak;
+        }
+
+        // Ganho da posicao atual do trecho: chunkGain + chunkStep * (posicao + 1)
+        void applyGain(const SampleType* input, SampleType* output, size_t count) const noexcept
+        {
+            if (chunkStep == 0)
+            {
+                if (chunkGain == 0)
+                    std::fill(output, output + count, SampleType(0));
+                else if (input != output)
+                    std::copy(input, input + count, output);
+
+                return;
+            }
+
+            const SampleType start = chunkGain + chunkStep * (SampleType)(chunkPosition + 1);
+
+            for (size_t i = 0; i < count; ++i)
+                output[i] = input[i] * (start + chunkStep * (SampleType)i);
+        }
+
+        void endChunk() noexcept
+        {
+            envelope = juce::jmax(chunkPeak, envelope * detectorDecay);
+            chunkPeak = 0;
+            chunkPosition = 0;
+
+            // o trecho que acabou de sair foi todo zerado?
+            closedSamples = (chunkStep == 0 && chunkGain == 0) ? closedSamples + chunkSize : 0;
+
+            if (! open)
+            {
+                if (envelope >= openLevel)
+                {
+                    open = true;
+                    holdRemaining = holdSamples;
+                }
+            }
+            else if (envelope >= closeLevel)
+            {
+                holdRemaining = holdSamples;
+            }
+            else if ((holdRemaining -= chunkSize) <= 0)
+            {
+                open = false;
+            }
+
+            // aproximacao exponencial do alvo, encerrada a rangeDb da distancia inicial
+            const SampleType target = open ? SampleType(1) : SampleType(0);
+            SampleType next = target + (gain - target) * (open ? attackCoefficient : releaseCoefficient);
+
+            if (std::abs(next - target) < rangeGain)
+                next = target;
+
+            chunkGain = gain;
+            chunkStep = (next - gain) / (SampleType)chunkSize;
+            gain = next;
+        }
+
+        void updateCoefficients() noexcept
+        {
+            // fator por trecho para cair decibels em milliseconds
+            auto coefficient = [this](float milliseconds, double decibels)
+            {
+                const double samples = 0.001 * milliseconds * sampleRate;
+                return samples > 0.0 ? (SampleType)std::pow(10.0, decibels / 20.0 * chunkSize / samples) : SampleType(0);
+            };
+
+            attackCoefficient = coefficient(attackTime, rangeDb);
+            releaseCoefficient = coefficient(releaseTime, rangeDb);
+            detectorDecay = coefficient((float)(1000.0 * detectorReleaseSeconds), rangeDb);
+            holdSamples = (int)(0.001 * holdTime * sampleRate);
+        }
+
+        double sampleRate = 44100.0;
+        SimdLevel simdLevel = SimdLevel::generic;
+
+        SampleType openLevel = SampleType(0.001), closeLevel = SampleType(0.0005);
+        float attackTime = 1.0f, holdTime = 50.0f, releaseTime = 100.0f;
+        SampleType attackCoefficient = 0, releaseCoefficient = 0, detectorDecay = 0;
+        const SampleType rangeGain = (SampleType)std::pow(10.0, rangeDb / 20.0);
+        int holdSamples = 0;
+
+        SampleType envelope = 0, chunkPeak = 0;
+        int chunkPosition = 0;
+        SampleType chunkGain = 0, chunkStep = 0, gain = 0;
+        bool open = false;
+        int holdRemaining = 0;
+        juce::int64 closedSamples = 0;
+    };
+}
@@ -0,0 +1,614 @@
+//==============================================================================
+// PartitionedConvolution.h: convolucao particionada com particoes compartilhadas
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <algorithm>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "CpuDispatch.h"
+#include "Fft.h"
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Roteamento entre os canais de entrada, os canais da IR e os de saida:
+    //   mono          IR de 1 canal aplicada a cada canal de entrada
+    //   stereo        canal c da IR aplicado ao canal c de entrada
+    //   monoToStereo  media das entradas convolvida com cada canal da IR (L e R)
+    //   trueStereo    IR de 4 canais na ordem LL, LR, RL, RR (entrada -> saida):
+    //                 L = L * LL + R * RL, R = L * LR + R * RR
+    // Cada entrada passa por uma FFT por particao, compartilhada por todos os canais da
+    // IR que a usam, e cada saida soma seus caminhos no dominio da frequencia antes de
+    // uma unica IFFT: o true stereo custa 2 FFTs e 2 IFFTs por particao, e nao 4 e 4
+    enum class ConvolutionMode { mono, stereo, monoToStereo, trueStereo };
+
+    // Canais de IR usados por cada modo
+    inline int getNumImpulseChannels(ConvolutionMode mode) noexcept
+    {
+        return mode == ConvolutionMode::mono ? 1 : mode == ConvolutionMode::trueStereo ? 4 : 2;
+    }
+
+    //==============================================================================
+    // Espectros das particoes de uma IR. Imutavel depois de criado: instancias que
+    // carregam a mesma IR com o mesmo particionamento recebem o mesmo objeto
+    // (getShared), entao N instancias do mesmo plugin com a mesma caixa guardam a IR
+    // uma vez so por processo. Cada instancia tem apenas o historico de entrada e os
+    // acumuladores (PartitionedConvolution), mais a propria FFT quando o backend e juce
+    // (ver Fft::isShareable).
+    //
+    // A IR e dividida em ate dois estagios de particoes uniformes: particoes de
+    // partitionSize no inicio e, se tailPartitionSize > partitionSize, particoes de
+    // tailPartitionSize no resto. Um estagio de particoes B atrasa sua saida em B
+    // amostras; o estagio da cauda comeca no ponto em que esse atraso coincide com a
+    // posicao do trecho na IR, entao a cauda longa custa poucas FFTs grandes sem
+    // aumentar a latencia.
+    //
+    // zeroLatency: as primeiras partitionSize amostras da IR sao aplicadas por convolucao
+    // direta e o primeiro estagio comeca em partitionSize, chegando no tempo certo. Sem
+    // cabeca direta a latencia e partitionSize
+    //
+    // fftBackend: implementacao da FFT dos estagios (ver Fft.h). Faz parte da chave do
+    // cache, entao trocar o backend cria particoes novas
+    struct ImpulseResponsePartitions
+    {
+        using Complex = std::complex<float>;
+
+        struct Stage
+        {
+            int partitionSize = 0;
+            int fftSize = 0;            // 2 * partitionSize
+            int numBins = 0;            // fftSize / 2 + 1
+            int offset = 0;             // inicio do trecho da IR
+            int delay = 0;              // particoes de entrada puladas antes da primeira
+            int numPartitions = 0;
+
+            std::vector<std::vector<Complex>> spectra;  // [canal][particao * numBins + bin]
+            std::unique_ptr<Fft> fft;                   // compartilhado tambem, se isShareable()
+        };
+
+        int partitionSize = 0;
+        int tailPartitionSize = 0;
+        bool zeroLatency = false;
+        FftBackend fftBackend = FftBackend::automatic;
+        int headSize = 0;
+        juce::AudioBuffer<float> impulse;   // IR no tempo (cabeca e comparacao no cache)
+        std::vector<Stage> stages;
+
+        int getNumChannels() const noexcept { return impulse.getNumChannels(); }
+        int getLatency() const noexcept { return zeroLatency ? 0 : partitionSize; }
+
+        //------------------------------------------------------------------------------
+        static std::shared_ptr<const ImpulseResponsePartitions> create(const juce::AudioBuffer<float>& ir, int partitionSize,
+                                                                       bool zeroLatency, int tailPartitionSize = 0,
+                                                                       FftBackend fftBackend = FftBackend::automatic)
+        {
+            auto partitions = std::make_shared<ImpulseResponsePartitions>();
+            const int length = ir.getNumSamples();
+            const int latency = zeroLatency ? 0 : partitionSize;
+
+            partitions->partitionSize = partitionSize;
+            partitions->tailPartitionSize = tailPartitionSize;
+            partitions->zeroLatency = zeroLatency;
+            partitions->fftBackend = fftBackend;
+            partitions->headSize = zeroLatency ? juce::jmin(partitionSize, length) : 0;
+            partitions->impulse.makeCopyOf(ir);
+
+            // a cauda comeca onde o atraso do seu estagio (tailPartitionSize) compensa a
+            // posicao na IR mais a latencia
+            const bool hasTail = tailPartitionSize > partitionSize && length > tailPartitionSize - latency;
+            const int firstOffset = zeroLatency ? partitionSize : 0;
+            const int firstEnd = hasTail ? tailPartitionSize - latency : length;
+
+            partitions->addStage(ir, partitionSize, firstOffset, juce::jmax(firstOffset, firstEnd), latency);
+
+            if (hasTail)
+                partitions->addStage(ir, tailPartitionSize, firstEnd, length, latency);
+
+            return partitions;
+        }
+
+        // Particoes da IR, reaproveitando as de outra instancia se a mesma IR (amostra a
+        // amostra) ja estiver carregada com o mesmo particionamento. O cache guarda
+        // weak_ptr: as particoes sao liberadas quando a ultima instancia deixa de usa-las
+        static std::shared_ptr<const ImpulseResponsePartitions> getShared(const juce::AudioBuffer<float>& ir, int partitionSize,
+                                                                          bool zeroLatency, int tailPartitionSize = 0,
+                                                                          FftBackend fftBackend = FftBackend::automatic)
+        {
+            struct Cache
+            {
+                juce::CriticalSection lock;
+                std::multimap<std::uint64_t, std::weak_ptr<const ImpulseResponsePartitions>> entries;
+            };
+
+            static Cache cache;
+
+            const int layout[] = { partitionSize, zeroLatency ? 1 : 0, tailPartitionSize, (int)fftBackend };
+            const auto key = hash(ir, layout, sizeof(layout));
+            const juce::ScopedLock lock(cache.lock);
+
+            for (auto it = cache.entries.lower_bound(key); it != cache.entries.end() && it->first == key;)
+            {
+                if (auto existing = it->second.lock())
+                {
+                    if (existing->matches(ir, partitionSize, zeroLatency, tailPartitionSize, fftBackend))
+                        return existing;
+
+                    ++it;
+                }
+                else
+                {
+                    it = cache.entries.erase(it);
+                }
+            }
+
+            auto partitions = create(ir, partitionSize, zeroLatency, tailPartitionSize, fftBackend);
+            cache.entries.emplace(key, partitions);
+            return partitions;
+        }
+
+    private:
+        void addStage(const juce::AudioBuffer<float>& ir, int size, int offset, int end, int latency)
+        {
+            auto& stage = stages.emplace_back();
+            stage.partitionSize = size;
+            stage.fftSize = 2 * size;
+            stage.numBins = size + 1;
+            stage.offset = offset;
+            stage.delay = (offset + latency) / size - 1;
+            stage.numPartitions = (end - offset + size - 1) / size;
+            stage.fft = std::make_unique<Fft>(juce::roundToInt(std::log2((double)stage.fftSize)), fftBackend);
+
+            std::vector<float> buffer((size_t)(2 * stage.fftSize));
+
+            for (int channel = 0; channel < ir.getNumChannels(); ++channel)
+            {
+                const float* h = ir.getReadPointer(channel);
+                auto& spectrum = stage.spectra.emplace_back((size_t)(stage.numPartitions * stage.numBins));
+
+                for (int p = 0; p < stage.numPartitions; ++p)
+                {
+                    const int start = offset + p * size;
+                    const int count = juce::jmin(size, end - start);
+
+                    std::fill(buffer.begin(), buffer.end(), 0.0f);
+                    std::copy(h + start, h + start + count, buffer.begin());
+                    stage.fft->forward(buffer.data());
+
+                    const auto* bins = reinterpret_cast<const Complex*>(buffer.data());
+                    std::copy(bins, bins + stage.numBins, spectrum.begin() + p * stage.numBins);
+                }
+            }
+        }
+
+        bool matches(const juce::AudioBuffer<float>& ir, int otherPartitionSize, bool otherZeroLatency, int otherTail,
+                     FftBackend otherBackend) const
+        {
+            if (otherPartitionSize != partitionSize || otherZeroLatency != zeroLatency || otherTail != tailPartitionSize
+                || otherBackend != fftBackend
+                || ir.getNumChannels() != impulse.getNumChannels() || ir.getNumSamples() != impulse.getNumSamples())
+                return false;
+
+            for (int channel = 0; channel < ir.getNumChannels(); ++channel)
+                if (std::memcmp(ir.getReadPointer(channel), impulse.getReadPointer(channel),
+                                sizeof(float) * (size_t)ir.getNumSamples()) != 0)
+                    return false;
+
+            return true;
+        }
+
+        // FNV-1a sobre o particionamento e as amostras
+        static std::uint64_t hash(const juce::AudioBuffer<float>& ir, const void* layout, size_t layoutSize) noexcept
+        {
+            std::uint64_t h = 14695981039346656037ull;
+
+            auto add = [&h](const void* data, size_t size)
+            {
+                const auto* bytes = static_cast<const unsigned char*>(data);
+
+                for (size_t i = 0; i < size; ++i)
+                    h = (h ^ bytes[i]) * 1099511628211ull;
+            };
+
+            const int header[] = { ir.getNumChannels(), ir.getNumSamples() };
+            add(header, sizeof(header));
+            add(layout, layoutSize);
+
+            for (int channel = 0; channel < ir.getNumChannels(); ++channel)
+                add(ir.getReadPointer(channel), sizeof(float) * (size_t)ir.getNumSamples());
+
+            return h;
+        }
+    };
+
+    //==============================================================================
+    // Convolucao particionada uniforme por estagio (overlap-save no dominio da
+    // frequencia) sobre particoes compartilhadas, com o roteamento de ConvolutionMode.
+    // Canais da IR que faltam para o modo sao substituidos pelo ultimo canal; true
+    // stereo com menos de 4 canais na IR (ou fora de 2 canais de audio) vira stereo.
+    // Um bloco com menos canais que os preparados (ex.: monoToStereo ou true stereo num
+    // barramento mono) e convolvido com os canais que faltam copiados do ultimo e as
+    // saidas excedentes somadas em media no ultimo canal do bloco.
+    //
+    // prepare() aloca o estado por instancia e roda fora da thread de audio; process()
+    // nao aloca
+    class PartitionedConvolution
+    {
+    public:
+        using Complex = ImpulseResponsePartitions::Complex;
+
+        void prepare(std::shared_ptr<const ImpulseResponsePartitions> newPartitions, int numChannels,
+                     ConvolutionMode newMode = ConvolutionMode::stereo)
+        {
+            partitions = std::move(newPartitions);
+            stages.clear();
+            paths.clear();
+
+            if (partitions == nullptr || partitions->stages.empty())
+                return;
+
+            const int numImpulseChannels = partitions->getNumChannels();
+            auto impulseChannel = [numImpulseChannels](int channel) { return juce::jmin(channel, numImpulseChannels - 1); };
+
+            mode = newMode;
+
+            if (mode == ConvolutionMode::trueStereo && (numImpulseChannels < 4 || numChannels != 2))
+                mode = ConvolutionMode::stereo;
+
+            downmix = mode == ConvolutionMode::monoToStereo;
+            numInputs = downmix ? 1 : numChannels;
+            numOutputs = numChannels;
+
+            if (mode == ConvolutionMode::trueStereo)
+            {
+                paths = { { 0, 0, 0 }, { 0, 1, 1 }, { 1, 0, 2 }, { 1, 1, 3 } };
+            }
+            else
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                    paths.push_back({ downmix ? 0 : channel, channel, mode == ConvolutionMode::mono ? 0 : impulseChannel(channel) });
+            }
+
+            for (const auto& stage : partitions->stages)
+            {
+                auto& state = stages.emplace_back();
+                const int historySize = (stage.delay + stage.numPartitions) * stage.numBins;
+
+                state.inputs.assign((size_t)numInputs, std::vector<float>((size_t)(2 * stage.partitionSize)));
+                state.history.assign((size_t)numInputs, std::vector<Complex>((size_t)historySize));
+                state.outputs.assign((size_t)numOutputs, std::vector<float>((size_t)stage.partitionSize));
+                state.accumulator.assign((size_t)stage.numBins, Complex());
+                state.fftBuffer.assign((size_t)(2 * stage.fftSize), 0.0f);
+
+                // a FFT do JUCE serializa as chamadas: cada instancia usa a sua
+                if (! stage.fft->isShareable())
+                    state.ownFft = std::make_unique<Fft>(juce::roundToInt(std::log2((double)stage.fftSize)),
+                                                         stage.fft->getBackend());
+
+                state.fft = state.ownFft != nullptr ? state.ownFft.get() : stage.fft.get();
+            }
+
+            mixBuffer.assign((size_t)partitions->partitionSize, 0.0f);
+            foldBuffer.setSize(numOutputs, partitions->partitionSize);
+            simdLevel = CpuDispatch::getLevel();
+            reset();
+        }
+
+        void reset() noexcept
+        {
+            for (auto& state : stages)
+            {
+                for (auto& input : state.inputs)
+                    std::fill(input.begin(), input.end(), 0.0f);
+
+                for (auto& history : state.history)
+                    std::fill(history.begin(), history.end(), Complex());
+
+                for (auto& output : state.outputs)
+                    std::fill(output.begin(), output.end(), 0.0f);
+
+                state.position = 0;
+                state.slot = 0;
+            }
+        }
+
+        int getLatency() const noexcept { return partitions != nullptr ? partitions->getLatency() : 0; }
+        ConvolutionMode getMode() const noexcept { return mode; }
+
+        const ImpulseResponsePartitions* getPartitions() const noexcept { return partitions.get(); }
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            auto&& outputBlock = context.getOutputBlock();
+
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom(context.getInputBlock());
+
+            if (stages.empty())
+            {
+                outputBlock.clear();
+                return;
+            }
+
+            if ((int)outputBlock.getNumChannels() < numOutputs)
+                processFolded(outputBlock);
+            else
+                processChannels(outputBlock);
+        }
+
+    private:
+        // Caminho entrada -> saida atraves de um canal da IR
+        struct Path
+        {
+            int input, output, impulseChannel;
+        };
+
+        // Estado de um estagio. inputs guarda a particao anterior e a atual (no tempo);
+        // history guarda os espectros das ultimas delay + numPartitions particoes
+        struct StageState
+        {
+            std::vector<std::vector<float>> inputs;     // [entrada]
+            std::vector<std::vector<Complex>> history;  // [entrada]
+            std::vector<std::vector<float>> outputs;    // [saida]
+            std::vector<Complex> accumulator;
+            std::vector<float> fftBuffer;
+            std::unique_ptr<Fft> ownFft;    // so quando a FFT das particoes nao pode ser compartilhada
+            const Fft* fft = nullptr;       // FFT usada por esta instancia
+            int position = 0;   // amostras da particao atual ja recebidas
+            int slot = 0;       // posicao da particao mais nova em history
+        };
+
+        // Convolucao no lugar de um bloco com pelo menos numOutputs canais
+        void processChannels(const juce::dsp::AudioBlock<float>& block) noexcept
+        {
+            const int numSamples = (int)block.getNumSamples();
+
+            for (int done = 0; done < numSamples;)
+            {
+                // ate o fim da particao mais proxima de completar
+                int count = numSamples - done;
+
+                for (const auto& state : stages)
+                    count = juce::jmin(count, (int)state.outputs[0].size() - state.position);
+
+                writeInputs(block, done, count);
+                readOutputs(block, done, count);
+
+                done += count;
+
+                for (size_t s = 0; s < stages.size(); ++s)
+                {
+                    auto& state = stages[s];
+                    state.position += count;
+
+                    if (state.position == partitions->stages[s].partitionSize)
+                    {
+                        processPartition(partitions->stages[s], state);
+                        state.position = 0;
+                    }
+                }
+            }
+        }
+
+        // Bloco com menos canais que os preparados: convolve em foldBuffer, de
+        // partitionSize em partitionSize amostras, com as entradas que faltam copiadas do
+        // ultimo canal do bloco, e devolve as saidas excedentes em media no ultimo canal
+        void processFolded(const juce::dsp::AudioBlock<float>& block) noexcept
+        {
+            const int numSamples = (int)block.getNumSamples();
+            const int available = (int)block.getNumChannels();
+
+            if (available == 0)
+                return;
+
+            const int last = available - 1;
+            const float foldGain = 1.0f / (float)(numOutputs - last);
+
+            for (int done = 0; done < numSamples;)
+            {
+                const int count = juce::jmin(numSamples - done, foldBuffer.getNumSamples());
+                auto scratch = juce::dsp::AudioBlock<float>(foldBuffer).getSubBlock(0, (size_t)count);
+
+                for (int channel = 0; channel < numOutputs; ++channel)
+                    std::copy_n(block.getChannelPointer((size_t)juce::jmin(channel, last)) + done, count,
+                                scratch.getChannelPointer((size_t)channel));
+
+                processChannels(scratch);
+
+                for (int channel = 0; channel < last; ++channel)
+                    std::copy_n(scratch.getChannelPointer((size_t)channel), count, block.getChannelPointer((size_t)channel) + done);
+
+                float* y = block.getChannelPointer((size_t)last) + done;
+                std::fill(y, y + count, 0.0f);
+
+                for (int channel = last; channel < numOutputs; ++channel)
+                {
+                    const float* folded = scratch.getChannelPointer((size_t)channel);
+
+                    for (int i = 0; i < count; ++i)
+                        y[i] += foldGain * folded[i];
+                }
+
+                done += count;
+            }
+        }
+
+        void writeInputs(const juce::dsp::AudioBlock<float>& block, int start, int count) noexcept
+        {
+            for (auto& state : stages)
+            {
+                const int offset = (int)state.outputs[0].size() + state.position;
+
+                if (downmix)
+                {
+                    float* input = state.inputs[0].data() + offset;
+                    const float gain = 1.0f / (float)block.getNumChannels();
+
+                    std::fill(input, input + count, 0.0f);
+
+                    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+                    {
+                        const float* x = block.getChannelPointer(channel) + start;
+
+                        for (int i = 0; i < count; ++i)
+                            input[i] += gain * x[i];
+                    }
+                }
+                else
+                {
+                    for (int channel = 0; channel < numInputs; ++channel)
+                    {
+                        const float* x = block.getChannelPointer((size_t)channel) + start;
+                        std::copy(x, x + count, state.inputs[(size_t)channel].begin() + offset);
+                    }
+                }
+            }
+        }
+
+        // Saida: caudas calculadas nas particoes anteriores de cada estagio mais a cabeca
+        // direta de cada caminho
+        void readOutputs(const juce::dsp::AudioBlock<float>& block, int start, int count) noexcept
+        {
+            const auto& first = stages[0];
+            const int headSize = partitions->headSize;
+
+            for (int output = 0; output < numOutputs; ++output)
+            {
+                float* y = mixBuffer.data();
+                std::fill(y, y + count, 0.0f);
+
+                for (const auto& state : stages)
+                {
+                    const float* tail = state.outputs[(size_t)output].data() + state.position;
+
+                    for (int i = 0; i < count; ++i)
+                        y[i] += tail[i];
+                }
+
+                // laco interno sobre as amostras (e nao sobre a IR), para vetorizar sem
+                // reassociar uma soma
+                if (headSize > 0)
+                    dispatch(simdLevel, [&]
+                    {
+                        for (const auto& path : paths)
+                            if (path.output == output)
+                            {
+                                const float* h = partitions->impulse.getReadPointer(path.impulseChannel);
+                                // input[i - k] existe para k < partitionSize: a particao anterior fica antes
+                                const float* input = first.inputs[(size_t)path.input].data() + partitions->partitionSize + first.position;
+
+                                for (int k = 0; k < headSize; ++k)
+                                    multiplyAdd(y, input - k, h[k], count);
+                            }
+                    });
+
+                std::copy(y, y + count, block.getChannelPointer((size_t)output) + start);
+            }
+        }
+
+        // Particao completa de um estagio: uma FFT por entrada, produtos somados sobre o
+        // historico e sobre os caminhos de cada saida, uma IFFT por saida. A segunda metade
+        // do resultado e a saida valida (overlap-save)
+        void processPartition(const ImpulseResponsePartitions::Stage& stage, StageState& state) noexcept
+        {
+            const int size = stage.partitionSize;
+            const int numBins = stage.numBins;
+            const int historyLength = stage.delay + stage.numPartitions;
+
+            if (stage.numPartitions > 0)
+            {
+                for (int input = 0; input < numInputs; ++input)
+                {
+                    auto& time = state.inputs[(size_t)input];
+
+                    std::copy(time.begin(), time.end(), state.fftBuffer.begin());
+                    state.fft->forward(state.fftBuffer.data());
+
+                    const auto* bins = reinterpret_cast<const Complex*>(state.fftBuffer.data());
+                    std::copy(bins, bins + numBins, state.history[(size_t)input].begin() + state.slot * numBins);
+                }
+
+                for (int output = 0; output < numOutputs; ++output)
+                {
+                    std::fill(state.accumulator.begin(), state.accumulator.end(), Complex());
+
+                    dispatch(simdLevel, [&]
+                    {
+                        auto* accumulator = reinterpret_cast<float*>(state.accumulator.data());
+
+                        for (const auto& path : paths)
+                        {
+                            if (path.output != output)
+                                continue;
+
+                            const auto& spectrum = stage.spectra[(size_t)path.impulseChannel];
+                            const auto& history = state.history[(size_t)path.input];
+
+                            for (int p = 0; p < stage.numPartitions; ++p)
+                            {
+                                const int age = stage.delay + p;
+                                const Complex* x = history.data() + ((state.slot - age + historyLength) % historyLength) * numBins;
+                                const Complex* H = spectrum.data() + p * numBins;
+
+                                multiplyAccumulate(accumulator, reinterpret_cast<const float*>(x),
+                                                   reinterpret_cast<const float*>(H), numBins);
+                            }
+                        }
+                    });
+
+                    std::copy(state.accumulator.begin(), state.accumulator.end(),
+                              reinterpret_cast<Complex*>(state.fftBuffer.data()));
+                    state.fft->inverse(state.fftBuffer.data());
+                    std::copy(state.fftBuffer.begin() + size, state.fftBuffer.begin() + 2 * size,
+                              state.outputs[(size_t)output].begin());
+                }
+
+                state.slot = (state.slot + 1) % historyLength;
+            }
+
+            for (auto& time : state.inputs)
+                std::copy(time.begin() + size, time.end(), time.begin());
+        }
+
+        // accumulator += x * H sobre numBins complexos intercalados (re, im). Escrito por
+        // extenso porque o operador * de std::complex trata NaN e infinito (chamada a
+        // __mulsc3 no GCC) e nao vetoriza
+        static void multiplyAccumulate(float* __restrict accumulator, const float* __restrict x,
+                                       const float* __restrict H, int numBins) noexcept
+        {
+            for (int bin = 0; bin < numBins; ++bin)
+            {
+                const float xr = x[2 * bin], xi = x[2 * bin + 1];
+                const float hr = H[2 * bin], hi = H[2 * bin + 1];
+                accumulator[2 * bin] += xr * hr - xi * hi;
+                accumulator[2 * bin + 1] += xr * hi + xi * hr;
+            }
+        }
+
+        static void multiplyAdd(float* __restrict y, const float* __restrict x, float gain, int count) noexcept
+        {
+            for (int i = 0; i < count; ++i)
+                y[i] += gain * x[i];
+        }
+
+        std::shared_ptr<const ImpulseResponsePartitions> partitions;
+        std::vector<StageState> stages;
+        std::vector<Path> paths;
+        std::vector<float> mixBuffer;
+        juce::AudioBuffer<float> foldBuffer;    // numOutputs canais, para processFolded
+        ConvolutionMode mode = ConvolutionMode::stereo;
+        bool downmix = false;
+        int numInputs = 0;
+        int numOutputs = 0;
+        SimdLevel simdLevel = SimdLevel::generic;
+    };
+}
@@ -1,7 +1,16 @@
 #pragma once
 
 //==============================================================================
-// Common.h: funcoes comuns a todos os plugins
+// PluginCommon.h: funcoes comuns a todos os plugins
+//
+// Define membros de MyAudioProcessor que sao iguais em todos os plugins. Deve ser
+// incluido uma unica vez, no PluginProcessor.cpp, depois de PluginProcessor.h.
+// createEditor() fica em cada plugin, pois alguns usam editor proprio
+//
+// Opcoes (definidas antes do include ou pelo build):
+//   PLUGIN_NAME          nome retornado por getName() (padrao: JucePlugin_Name). Usado
+//                        quando o plugin e compilado dentro de outro (ver 061_rack)
+//   PLUGIN_CUSTOM_STATE  o plugin define get/setStateInformation
 //==============================================================================
 
 //==============================================================================
@@ -11,21 +20,16 @@
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter() { return new MyAudioProcessor(); }
 
 // Nome do plugin
-const juce::String MyAudioProcessor::getName() const { return JucePlugin_Name; }
+#ifndef PLUGIN_NAME
+ #define PLUGIN_NAME JucePlugin_Name
+#endif
+const juce::String MyAudioProcessor::getName() const { return PLUGIN_NAME; }
 
 // Tamanho da cauda gerada pelo processamento do plugin
 double MyAudioProcessor::getTailLengthSeconds() const { return 0.0; }
 
 // Indica se plugin tem editor ou nao
 bool MyAudioProcessor::hasEditor() const { return true; }
-
-// Cria editor generico
-juce::AudioProcessorEditor* MyAudioProcessor::createEditor() 
-{ 
-    auto editor = new juce::GenericAudioProcessorEditor(*this);
-    editor->setSize(500, 500);
-    return editor;
-}
 //==============================================================================
 
 //==============================================================================
@@ -55,6 +59,7 @@ void MyAudioProcessor::changeProgramName (int index, const juce::String& newName
     juce::ignoreUnused(index, newName); 
 }
 
+#ifndef PLUGIN_CUSTOM_STATE
 // Retorna configuracao atual, com presets, para host capaz de salvar configuracoes, como uma DAW
 void MyAudioProcessor::getStateInformation (juce::MemoryBlock& destData) 
 {
@@ -71,6 +76,7 @@ void MyAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
         parametersChanged.store(true);
     }
 }
+#endif
 //==============================================================================
 
 //==============================================================================
@@ -0,0 +1,283 @@
+//==============================================================================
+// Profiler.h: custo de CPU por estagio de uma cadeia de processadores
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <tuple>
+#include <utility>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Relogio dos estagios. Em x86 le o TSC (rdtsc, ~20 ciclos, sem chamada ao sistema);
+    // nas demais plataformas usa juce::Time::getHighResolutionTicks (clock_gettime
+    // monotonico no Linux). A frequencia do TSC e medida uma vez por processo, no
+    // primeiro prepare(), contra o relogio de alta resolucao
+    class ProfileClock
+    {
+    public:
+        static juce::int64 now() noexcept
+        {
+           #if JUCE_INTEL
+            return (juce::int64)__rdtsc();
+           #else
+            return juce::Time::getHighResolutionTicks();
+           #endif
+        }
+
+        static double getTicksPerSecond()
+        {
+            static const double ticksPerSecond = calibrate();
+            return ticksPerSecond;
+        }
+
+    private:
+        static double calibrate()
+        {
+           #if JUCE_INTEL
+            // ~10 ms de espera ativa: pouco perto do resto de prepareToPlay
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            const auto startCycles = now();
+            double elapsed = 0;
+
+            do
+                elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+            while (elapsed < 0.01);
+
+            return (double)(now() - startCycles) / elapsed;
+           #else
+            return (double)juce::Time::getHighResolutionTicksPerSecond();
+           #endif
+        }
+    };
+
+    //==============================================================================
+    // Estatisticas de um estagio. A thread de audio e a unica que escreve: soma os ticks
+    // e as amostras e conta o bloco em um histograma da carga (tempo do estagio dividido
+    // pela duracao do bloco), com binsPerDecade faixas logaritmicas por decada entre
+    // minLoad e minLoad * 10^(numBins / binsPerDecade). Sem locks: cada contador e um
+    // atomico lido a qualquer momento pelo editor ou pelo benchmark (getSnapshot).
+    //
+    // Nada e zerado: quem le guarda um Snapshot e calcula a janela com since(), entao
+    // varios leitores convivem sem disputar com a thread de audio
+    class StageProfiler
+    {
+    public:
+        static constexpr int numBins = 64;
+        static constexpr int binsPerDecade = 8;
+        static constexpr double minLoad = 1.0e-5;
+
+        struct Snapshot
+        {
+            juce::int64 ticks = 0;
+            juce::int64 samples = 0;
+            juce::int64 blocks = 0;
+            std::array<juce::int64, numBins> bins {};
+            double ticksPerSecond = 1.0;
+            double sampleRate = 44100.0;
+
+            // Diferenca para uma leitura anterior: as estatisticas so do intervalo
+            Snapshot since(const Snapshot& earlier) const noexcept
+            {
+                auto window = *this;
+                window.ticks -= earlier.ticks;
+                window.samples -= earlier.samples;
+                window.blocks -= earlier.blocks;
+
+                for (size_t bin = 0; bin < bins.size(); ++bin)
+                    window.bins[bin] -= earlier.bins[bin];
+
+                return window;
+            }
+
+            // Fracao media do tempo de audio gasta no estagio (1 = 100% de um nucleo)
+            double getMeanLoad() const noexcept
+            {
+                return samples > 0 ? (double)ticks * sampleRate / ((double)samples * ticksPerSecond) : 0.0;
+            }
+
+            // Carga abaixo da qual ficam percentile (0..1) dos blocos, pelo limite
+            // superior da faixa do histograma (ex.: 0.99 = p99)
+            double getPercentileLoad(double percentile) const noexcept
+            {
+                if (blocks <= 0)
+                    return 0.0;
+
+                const auto target = (juce::int64)std::ceil(percentile * (double)blocks);
+                juce::int64 count = 0;
+
+                for (int bin = 0; bin < numBins; ++bin)
+                {
+                    count += bins[(size_t)bin];
+
+                    if (count >= target)
+                        return getBinUpperLoad(bin);
+                }
+
+                return getBinUpperLoad(numBins - 1);
+            }
+
+            double getMeanMicrosecondsPerBlock() const noexcept
+            {
+                return blocks > 0 ? 1.0e6 * (double)ticks / (ticksPerSecond * (double)blocks) : 0.0;
+            }
+        };
+
+        void prepare(double newSampleRate)
+        {
+            sampleRate = newSampleRate;
+            ticksPerSecond = ProfileClock::getTicksPerSecond();
+            loadPerTickSample = sampleRate / ticksPerSecond;
+        }
+
+        // Thread de audio
+        void record(juce::int64 elapsedTicks, int numSamples) noexcept
+        {
+            if (numSamples <= 0)
+                return;
+
+            const double load = (double)elapsedTicks * loadPerTickSample / (double)numSamples;
+            increment(bins[(size_t)getBin(load)], 1);
+            increment(ticks, elapsedTicks);
+            increment(samples, numSamples);
+            increment(blocks, 1);
+        }
+
+        Snapshot getSnapshot() const noexcept
+        {
+            Snapshot snapshot;
+            snapshot.blocks = blocks.load(std::memory_order_relaxed);
+            snapshot.ticks = ticks.load(std::memory_order_relaxed);
+            snapshot.samples = samples.load(std::memory_order_relaxed);
+
+            for (size_t bin = 0; bin < bins.size(); ++bin)
+                snapshot.bins[bin] = bins[bin].load(std::memory_order_relaxed);
+
+            snapshot.ticksPerSecond = ticksPerSecond;
+            snapshot.sampleRate = sampleRate;
+            return snapshot;
+        }
+
+        static double getBinUpperLoad(int bin) noexcept
+        {
+            return minLoad * std::pow(10.0, (double)(bin + 1) / (double)binsPerDecade);
+        }
+
+    private:
+        static int getBin(double load) noexcept
+        {
+            if (load <= minLoad)
+                return 0;
+
+            return juce::jlimit(0, numBins - 1, (int)(binsPerDecade * std::log10(load / minLoad)));
+        }
+
+        // Um so escritor: load + store em vez de fetch_add, sem instrucao com lock
+        static void increment(std::atomic<juce::int64>& counter, juce::int64 amount) noexcept
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+
+        std::atomic<juce::int64> ticks { 0 }, samples { 0 }, blocks { 0 };
+        std::array<std::atomic<juce::int64>, numBins> bins {};
+        double sampleRate = 44100.0;
+        double ticksPerSecond = 1.0;
+        double loadPerTickSample = 0.0;
+    };
+
+    //==============================================================================
+    // Mesma interface de juce::dsp::ProcessorChain (get<>, setBypassed<>, prepare,
+    // reset, process), mas le o relogio entre os estagios e acumula o custo de cada um
+    // em um StageProfiler. Com setProfilingEnabled(false) o processamento e o mesmo de
+    // ProcessorChain, sem leituras de relogio. Estagios em bypass nao sao contados
+    template <typename... Processors>
+    class ProfiledChain
+    {
+    public:
+        static constexpr size_t numStages = sizeof...(Processors);
+
+        template <int Index> auto& get() noexcept { return std::get<Index>(processors); }
+        template <int Index> const auto& get() const noexcept { return std::get<Index>(processors); }
+
+        template <int Index> void setBypassed(bool shouldBeBypassed) noexcept { bypassed[(size_t)Index] = shouldBeBypassed; }
+        template <int Index> bool isBypassed() const noexcept { return bypassed[(size_t)Index]; }
+
+        void setProfilingEnabled(bool shouldProfile) noexcept { profiling.store(shouldProfile); }
+        bool isProfilingEnabled() const noexcept { return profiling.load(); }
+
+        const StageProfiler& getProfiler(size_t stage) const noexcept { return profilers[stage]; }
+
+        void prepare(const juce::dsp::ProcessSpec& spec)
+        {
+            std::apply([&](auto&... processor) { (processor.prepare(spec), ...); }, processors);
+
+            for (auto& profiler : profilers)
+                profiler.prepare(spec.sampleRate);
+        }
+
+        void reset() noexcept
+        {
+            std::apply([](auto&... processor) { (processor.reset(), ...); }, processors);
+        }
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            processStages(context, std::index_sequence_for<Processors...> {});
+        }
+
+    private:
+        template <typename ProcessContext, size_t... Index>
+        void processStages(const ProcessContext& context, std::index_sequence<Index...>) noexcept
+        {
+            const bool shouldProfile = profiling.load(std::memory_order_relaxed);
+            const auto numSamples = (int)context.getOutputBlock().getNumSamples();
+
+            (processStage<Index>(context, shouldProfile, numSamples), ...);
+        }
+
+        // Como em ProcessorChain: a partir do segundo estagio, um contexto separado vira
+        // substituicao sobre o bloco de saida
+        template <size_t Index, typename ProcessContext>
+        void processStage(const ProcessContext& context, bool shouldProfile, int numSamples) noexcept
+        {
+            const bool stageBypassed = bypassed[Index] || context.isBypassed;
+            const auto start = shouldProfile && ! stageBypassed ? ProfileClock::now() : 0;
+
+            if (context.usesSeparateInputAndOutputBlocks() && Index != 0)
+            {
+                juce::dsp::ProcessContextReplacing<typename ProcessContext::SampleType> replacingContext(context.getOutputBlock());
+                replacingContext.isBypassed = stageBypassed;
+                std::get<Index>(processors).process(replacingContext);
+            }
+            else
+            {
+                ProcessContext contextCopy(context);
+                contextCopy.isBypassed = stageBypassed;
+                std::get<Index>(processors).process(contextCopy);
+            }
+
+            if (shouldProfile && ! stageBypassed)
+                profilers[Index].record(ProfileClock::now() - start, numSamples);
+        }
+
+        std::tuple<Processors...> processors;
+        std::array<bool, numStages> bypassed {};
+        std::array<StageProfiler, numStages> profilers;
+        std::atomic<bool> profiling { true };
+    };
+}
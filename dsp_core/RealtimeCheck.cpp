@@ -0,0 +1,198 @@
+//==============================================================================
+// RealtimeCheck.cpp: substituicao das funcoes de alocacao e de lock para
+// RealtimeCheck (ver RealtimeCheck.h). Compilado so com a opcao DSP_CORE_RT_CHECK,
+// nas ferramentas e nos benchmarks; nunca no binario dos plugins
+//==============================================================================
+
+#include "RealtimeCheck.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+using dsp_core::RealtimeCheck;
+using dsp_core::RealtimeViolation;
+
+//==============================================================================
+// malloc e locks (glibc): as versoes originais sao as __libc_* e, para os mutexes, a
+// proxima definicao na ordem de busca (libc)
+//------------------------------------------------------------------------------
+#if defined(__GLIBC__)
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+}
+
+namespace
+{
+    void* rawAllocate(size_t size) noexcept { return __libc_malloc(size); }
+    void* rawAllocateAligned(size_t alignment, size_t size) noexcept { return __libc_memalign(alignment, size); }
+    void rawFree(void* pointer) noexcept { __libc_free(pointer); }
+
+    using MutexFunction = int (*)(pthread_mutex_t*);
+
+    // sem static local: a guarda de inicializacao usaria o proprio pthread_mutex_lock
+    std::atomic<MutexFunction> realLock { nullptr };
+    std::atomic<MutexFunction> realTryLock { nullptr };
+
+    MutexFunction resolve(std::atomic<MutexFunction>& cache, const char* name) noexcept
+    {
+        auto function = cache.load(std::memory_order_acquire);
+
+        if (function == nullptr)
+        {
+            function = reinterpret_cast<MutexFunction>(dlsym(RTLD_NEXT, name));
+            cache.store(function, std::memory_order_release);
+        }
+
+        return function;
+    }
+
+    // a primeira chamada de backtrace() carrega a libgcc_s; melhor antes de qualquer secao
+    struct Warmup
+    {
+        Warmup() noexcept
+        {
+            void* frames[1];
+            backtrace(frames, 1);
+            resolve(realLock, "pthread_mutex_lock");
+            resolve(realTryLock, "pthread_mutex_trylock");
+        }
+    } warmup;
+}
+
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        RealtimeCheck::check(RealtimeViolation::allocation);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        RealtimeCheck::check(RealtimeViolation::allocation);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        RealtimeCheck::check(RealtimeViolation::allocation);
+        return __libc_realloc(pointer, size);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        RealtimeCheck::check(RealtimeViolation::allocation);
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        RealtimeCheck::check(RealtimeViolation::allocation);
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size)
+    {
+        RealtimeCheck::check(RealtimeViolation::allocation);
+        *result = __libc_memalign(alignment, size);
+        return *result != nullptr || size == 0 ? 0 : ENOMEM;
+    }
+
+    void free(void* pointer)
+    {
+        if (pointer != nullptr)
+            RealtimeCheck::check(RealtimeViolation::deallocation);
+        __libc_free(pointer);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        RealtimeCheck::check(RealtimeViolation::lock);
+        return resolve(realLock, "pthread_mutex_lock")(mutex);
+    }
+
+    int pthread_mutex_trylock(pthread_mutex_t* mutex)
+    {
+        RealtimeCheck::check(RealtimeViolation::lock);
+        return resolve(realTryLock, "pthread_mutex_trylock")(mutex);
+    }
+}
+#else
+namespace
+{
+    void* rawAllocate(size_t size) noexcept { return std::malloc(size); }
+    void rawFree(void* pointer) noexcept { std::free(pointer); }
+}
+#endif
+
+//==============================================================================
+// new/delete. Com glibc vao direto as __libc_*, para contar uma vez so
+//------------------------------------------------------------------------------
+namespace
+{
+    void* allocate(size_t size)
+    {
+        RealtimeCheck::check(RealtimeViolation::allocation);
+
+        if (void* pointer = rawAllocate(size == 0 ? 1 : size))
+            return pointer;
+
+        throw std::bad_alloc();
+    }
+
+    void deallocate(void* pointer) noexcept
+    {
+        if (pointer == nullptr)
+            return;
+
+        RealtimeCheck::check(RealtimeViolation::deallocation);
+        rawFree(pointer);
+    }
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { try { return allocate(size); } catch (...) { return nullptr; } }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { try { return allocate(size); } catch (...) { return nullptr; } }
+
+void operator delete(void* pointer) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, size_t) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { deallocate(pointer); }
+
+#if defined(__GLIBC__)
+// versoes alinhadas: so com glibc, onde a memoria alinhada e liberada por free
+namespace
+{
+    void* allocateAligned(size_t size, std::align_val_t alignment)
+    {
+        RealtimeCheck::check(RealtimeViolation::allocation);
+
+        if (void* pointer = rawAllocateAligned((size_t)alignment, size == 0 ? 1 : size))
+            return pointer;
+
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void operator delete(void* pointer, std::align_val_t) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { deallocate(pointer); }
+#endif
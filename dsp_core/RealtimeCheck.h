@@ -0,0 +1,216 @@
+//==============================================================================
+// RealtimeCheck.h: deteccao de alocacoes e locks na thread de audio (modo de teste)
+//==============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if DSP_CORE_RT_CHECK && defined(__GLIBC__)
+ #include <execinfo.h>
+ #define DSP_CORE_RT_CHECK_BACKTRACE 1
+#else
+ #define DSP_CORE_RT_CHECK_BACKTRACE 0
+#endif
+
+namespace dsp_core
+{
+    enum class RealtimeViolation { allocation, deallocation, lock };
+
+    //==============================================================================
+    // Com DSP_CORE_RT_CHECK=1 (opcao DSP_CORE_RT_CHECK do CMake, so para ferramentas e
+    // benchmarks), RealtimeCheck.cpp substitui malloc/calloc/realloc/free, new/delete e
+    // pthread_mutex_lock/trylock. Cada chamada feita por uma thread dentro de um
+    // ScopedSection (processBlock, update(), um kernel do benchmark) e registrada com a
+    // pilha de chamadas; o chamador imprime o relatorio fora da secao (printReport) e
+    // falha se houve violacoes.
+    //
+    // Sem DSP_CORE_RT_CHECK, ScopedSection nao faz nada e nenhuma funcao e substituida.
+    // O registro nao aloca: ate maxRecords violacoes com ate maxFrames enderecos cada, os
+    // nomes sao resolvidos so no relatorio. A substituicao de malloc e dos locks so existe
+    // com glibc; nas demais plataformas apenas new/delete sao verificados
+    class RealtimeCheck
+    {
+    public:
+        static constexpr int maxRecords = 64;
+        static constexpr int maxFrames = 24;
+
+        static constexpr bool isEnabled() noexcept
+        {
+           #if DSP_CORE_RT_CHECK
+            return true;
+           #else
+            return false;
+           #endif
+        }
+
+        //------------------------------------------------------------------------------
+        // Marca o trecho da thread atual que nao pode alocar nem bloquear. Pode ser aninhado
+        class ScopedSection
+        {
+        public:
+           #if DSP_CORE_RT_CHECK
+            ScopedSection() noexcept { ++threadState().depth; }
+            ~ScopedSection() { --threadState().depth; }
+           #else
+            ScopedSection() noexcept {}
+           #endif
+
+            ScopedSection(const ScopedSection&) = delete;
+            ScopedSection& operator=(const ScopedSection&) = delete;
+        };
+
+        // Libera o trecho atual da verificacao (ex.: log de depuracao aceito em testes)
+        class ScopedExemption
+        {
+        public:
+           #if DSP_CORE_RT_CHECK
+            ScopedExemption() noexcept : savedDepth(threadState().depth) { threadState().depth = 0; }
+            ~ScopedExemption() { threadState().depth = savedDepth; }
+
+        private:
+            int savedDepth;
+           #else
+            ScopedExemption() noexcept {}
+           #endif
+        };
+
+        //------------------------------------------------------------------------------
+        // Chamado pelas funcoes substituidas. Retorna rapido fora de uma secao
+        static void check(RealtimeViolation kind) noexcept
+        {
+           #if DSP_CORE_RT_CHECK
+            auto& state = threadState();
+
+            if (state.depth <= 0 || state.recording)
+                return;
+
+            // backtrace() pode alocar na primeira chamada: sem recursao
+            state.recording = true;
+            const int index = numViolations().fetch_add(1);
+
+            if (index < maxRecords)
+            {
+                auto& record = records()[index];
+                record.kind = kind;
+               #if DSP_CORE_RT_CHECK_BACKTRACE
+                record.numFrames = backtrace(record.frames, maxFrames);
+               #else
+                record.numFrames = 0;
+               #endif
+            }
+
+            state.recording = false;
+           #else
+            (void)kind;
+           #endif
+        }
+
+        static int getNumViolations() noexcept { return numViolations().load(); }
+
+        static void reset() noexcept { numViolations().store(0); }
+
+        // Imprime as violacoes agrupadas por pilha de chamadas. Fora de uma secao
+        static void printReport(const char* context)
+        {
+            const int total = getNumViolations();
+
+            if (total == 0)
+                return;
+
+            std::printf("\n%s: %d chamada(s) proibida(s) em secao de tempo real\n", context, total);
+
+            const int stored = total < maxRecords ? total : maxRecords;
+
+            for (int i = 0; i < stored; ++i)
+            {
+                const auto& record = records()[i];
+                bool repeated = false;
+                int count = 0;
+
+                for (int j = 0; j < stored; ++j)
+                    if (sameTrace(record, records()[j]))
+                    {
+                        repeated = repeated || j < i;
+                        ++count;
+                    }
+
+                if (repeated)
+                    continue;
+
+                std::printf("\n  %s (%d vez(es))\n", getName(record.kind), count);
+
+               #if DSP_CORE_RT_CHECK_BACKTRACE
+                if (char** symbols = backtrace_symbols(record.frames, record.numFrames))
+                {
+                    // o primeiro endereco e o proprio check()
+                    for (int frame = 1; frame < record.numFrames; ++frame)
+                        std::printf("    %s\n", symbols[frame]);
+
+                    std::free(symbols);
+                }
+               #endif
+            }
+
+            if (total > maxRecords)
+                std::printf("\n  (so as primeiras %d foram registradas)\n", maxRecords);
+        }
+
+        static const char* getName(RealtimeViolation kind) noexcept
+        {
+            switch (kind)
+            {
+                case RealtimeViolation::deallocation: return "liberacao de memoria";
+                case RealtimeViolation::lock:         return "lock de mutex";
+                case RealtimeViolation::allocation:   break;
+            }
+            return "alocacao de memoria";
+        }
+
+    private:
+        struct Record
+        {
+            RealtimeViolation kind = RealtimeViolation::allocation;
+            int numFrames = 0;
+            void* frames[maxFrames] {};
+        };
+
+        struct ThreadState
+        {
+            int depth = 0;
+            bool recording = false;
+        };
+
+        // initial-exec: o acesso nao pode chamar malloc, que esta substituido
+        static ThreadState& threadState() noexcept
+        {
+           #if defined(__GNUC__)
+            static thread_local ThreadState state __attribute__((tls_model("initial-exec")));
+           #else
+            static thread_local ThreadState state;
+           #endif
+            return state;
+        }
+
+        static std::atomic<int>& numViolations() noexcept
+        {
+            static std::atomic<int> value { 0 };
+            return value;
+        }
+
+        static Record* records() noexcept
+        {
+            static Record values[maxRecords];
+            return values;
+        }
+
+        static bool sameTrace(const Record& a, const Record& b) noexcept
+        {
+            return a.kind == b.kind && a.numFrames == b.numFrames
+                && std::memcmp(a.frames, b.frames, sizeof(void*) * (size_t)a.numFrames) == 0;
+        }
+    };
+}
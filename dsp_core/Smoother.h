@@ -0,0 +1,67 @@
+//==============================================================================
+// Smoother.h: ganho com rampa linear entre valores de parametro
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Ganho linear (nao em dB) aplicado ao bloco. Quando o alvo muda, o ganho vai ate
+    // ele em rampa linear de rampSeconds, igual em todos os canais, evitando cliques.
+    // Fora da rampa e uma multiplicacao vetorial do bloco
+    template <typename SampleType>
+    class SmoothedGain
+    {
+    public:
+        void prepare(const juce::dsp::ProcessSpec& spec, double rampSeconds = 0.05) noexcept
+        {
+            gain.reset(spec.sampleRate, rampSeconds);
+            reset();
+        }
+
+        // Termina qualquer rampa em andamento
+        void reset() noexcept { gain.setCurrentAndTargetValue(gain.getTargetValue()); }
+
+        void setGain(SampleType newGain) noexcept { gain.setTargetValue(newGain); }
+
+        SampleType getGain() const noexcept { return gain.getTargetValue(); }
+        bool isSmoothing() const noexcept { return gain.isSmoothing(); }
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            auto&& inputBlock = context.getInputBlock();
+            auto&& outputBlock = context.getOutputBlock();
+            const auto numChannels = outputBlock.getNumChannels();
+            const auto numSamples = outputBlock.getNumSamples();
+
+            if (context.isBypassed)
+            {
+                gain.skip((int)numSamples);
+                if (context.usesSeparateInputAndOutputBlocks())
+                    outputBlock.copyFrom(inputBlock);
+                return;
+            }
+
+            if (! gain.isSmoothing())
+            {
+                outputBlock.replaceWithProductOf(inputBlock, gain.getTargetValue());
+                return;
+            }
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                const SampleType g = gain.getNextValue();
+
+                for (size_t channel = 0; channel < numChannels; ++channel)
+                    outputBlock.getChannelPointer(channel)[i] = inputBlock.getChannelPointer(channel)[i] * g;
+            }
+        }
+
+    private:
+        juce::LinearSmoothedValue<SampleType> gain { SampleType(1) };
+    };
+}
@@ -0,0 +1,343 @@
+//==============================================================================
+// ToneStack.h: tone stack passivo de amplificador (graves, medios, agudos) com
+// coeficientes tabelados
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include "CpuDispatch.h"
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Topologias: a rede classica de tres potenciometros (treble, bass, mid) com os
+    // valores de componentes de cada amplificador
+    //   fender    '59 Bassman (5F6-A)
+    //   marshall  JCM800/JCM900 (mesma rede, valores diferentes)
+    //   vox       AC30 aproximado pela mesma rede (o Top Boost original tem outra
+    //             topologia, sem controle de medios)
+    enum class ToneStackModel { fender, marshall, vox };
+
+    //==============================================================================
+    // Modelo analogico de Yeh e Smith ("Discretization of the '59 Fender Bassman Tone
+    // Stack", DAFx 2006): funcao de transferencia de 3a ordem cujos coeficientes sao
+    // polinomios nas posicoes dos potenciometros, discretizada pela transformada bilinear
+    struct ToneStackCoefficients
+    {
+        double b0 = 1, b1 = 0, b2 = 0, b3 = 0, a1 = 0, a2 = 0, a3 = 0;
+
+        // bass, mid e treble em 0..1 (posicao do botao). O potenciometro de graves e
+        // logaritmico: a posicao vira exp(3.4 * (bass - 1)), como no circuito
+        static ToneStackCoefficients compute(ToneStackModel model, double sampleRate,
+                                             double bass, double mid, double treble) noexcept
+        {
+            const auto [R1, R2, R3, R4, C1, C2, C3] = getComponents(model);
+
+            const double l = std::exp(3.4 * (juce::jlimit(0.0, 1.0, bass) - 1.0));
+            const double m = juce::jlimit(0.0, 1.0, mid);
+            const double t = juce::jlimit(0.0, 1.0, treble);
+
+            // H(s) = (sb1 s + sb2 s^2 + sb3 s^3) / (1 + sa1 s + sa2 s^2 + sa3 s^3)
+            const double sb1 = t * C1 * R1 + m * C3 * R3 + l * (C1 * R2 + C2 * R2) + (C1 * R3 + C2 * R3);
+
+            const double sb2 = t * (C1 * C2 * R1 * R4 + C1 * C3 * R1 * R4)
+                             - m * m * (C1 * C3 * R3 * R3 + C2 * C3 * R3 * R3)
+                             + m * (C1 * C3 * R1 * R3 + C1 * C3 * R3 * R3 + C2 * C3 * R3 * R3)
+                             + l * (C1 * C2 * R1 * R2 + C1 * C2 * R2 * R4 + C1 * C3 * R2 * R4)
+                             + l * m * (C1 * C3 * R2 * R3 + C2 * C3 * R2 * R3)
+                             + (C1 * C2 * R1 * R3 + C1 * C2 * R3 * R4 + C1 * C3 * R3 * R4);
+
+            const double sb3 = l * m * (C1 * C2 * C3 * R1 * R2 * R3 + C1 * C2 * C3 * R2 * R3 * R4)
+                             - m * m * (C1 * C2 * C3 * R1 * R3 * R3 + C1 * C2 * C3 * R3 * R3 * R4)
+                             + m * (C1 * C2 * C3 * R1 * R3 * R3 + C1 * C2 * C3 * R3 * R3 * R4)
+                             + t * C1 * C2 * C3 * R1 * R3 * R4
+                             - t * m * C1 * C2 * C3 * R1 * R3 * R4
+                             + t * l * C1 * C2 * C3 * R1 * R2 * R4;
+
+            const double sa1 = (C1 * R1 + C1 * R3 + C2 * R3 + C2 * R4 + C3 * R4) + m * C3 * R3 + l * (C1 * R2 + C2 * R2);
+
+            const double sa2 = m * (C1 * C3 * R1 * R3 - C2 * C3 * R3 * R4 + C1 * C3 * R3 * R3 + C2 * C3 * R3 * R3)
+                             + l * m * (C1 * C3 * R2 * R3 + C2 * C3 * R2 * R3)
+                             - m * m * (C1 * C3 * R3 * R3 + C2 * C3 * R3 * R3)
+                             + l * (C1 * C2 * R2 * R4 + C1 * C2 * R1 * R2 + C1 * C3 * R2 * R4 + C2 * C3 * R2 * R4)
+                             + (C1 * C2 * R1 * R4 + C1 * C3 * R1 * R4 + C1 * C2 * R3 * R4
+                                + C1 * C2 * R1 * R3 + C1 * C3 * R3 * R4 + C2 * C3 * R3 * R4);
+
+            const double sa3 = l * m * (C1 * C2 * C3 * R1 * R2 * R3 + C1 * C2 * C3 * R2 * R3 * R4)
+                             - m * m * (C1 * C2 * C3 * R1 * R3 * R3 + C1 * C2 * C3 * R3 * R3 * R4)
+                             + m * (C1 * C2 * C3 * R3 * R3 * R4 + C1 * C2 * C3 * R1 * R3 * R3 - C1 * C2 * C3 * R1 * R3 * R4)
+                             + l * C1 * C2 * C3 * R1 * R2 * R4
+                             + C1 * C2 * C3 * R1 * R3 * R4;
+
+            // bilinear: s = c (1 - z^-1) / (1 + z^-1)
+            const double c = 2.0 * sampleRate;
+            const double c2 = c * c, c3 = c2 * c;
+
+            const double B0 = -sb1 * c - sb2 * c2 - sb3 * c3;
+            const double B1 = -sb1 * c + sb2 * c2 + 3.0 * sb3 * c3;
+            const double B2 =  sb1 * c + sb2 * c2 - 3.0 * sb3 * c3;
+            const double B3 =  sb1 * c - sb2 * c2 + sb3 * c3;
+
+            const double A0 = -1.0 - sa1 * c - sa2 * c2 - sa3 * c3;
+            const double A1 = -3.0 - sa1 * c + sa2 * c2 + 3.0 * sa3 * c3;
+            const double A2 = -3.0 + sa1 * c + sa2 * c2 - 3.0 * sa3 * c3;
+            const double A3 = -1.0 + sa1 * c - sa2 * c2 + sa3 * c3;
+
+            return { B0 / A0, B1 / A0, B2 / A0, B3 / A0, A1 / A0, A2 / A0, A3 / A0 };
+        }
+
+        // |H| na frequencia, para a compensacao de nivel da tabela
+        double getMagnitude(double frequency, double sampleRate) const noexcept
+        {
+            const auto z = std::polar(1.0, -2.0 * juce::MathConstants<double>::pi * frequency / sampleRate);
+            const auto numerator = b0 + z * (b1 + z * (b2 + z * b3));
+            const auto denominator = 1.0 + z * (a1 + z * (a2 + z * a3));
+            return std::abs(numerator / denominator);
+        }
+
+        struct Components
+        {
+            double R1, R2, R3, R4, C1, C2, C3;  // R1 treble, R2 bass, R3 mid, R4 inclinacao
+        };
+
+        static Components getComponents(ToneStackModel model) noexcept
+        {
+            switch (model)
+            {
+                case ToneStackModel::marshall: return { 220e3, 1e6, 22e3, 33e3, 470e-12, 22e-9, 22e-9 };
+                case ToneStackModel::vox:      return { 1e6, 1e6, 10e3, 100e3, 50e-12, 22e-9, 22e-9 };
+                case ToneStackModel::fender:   break;
+            }
+            return { 250e3, 1e6, 25e3, 56e3, 250e-12, 20e-9, 20e-9 };
+        }
+    };
+
+    //==============================================================================
+    // Coeficientes de uma topologia em uma taxa, calculados em uma grade de gridSize^3
+    // posicoes dos botoes e interpolados (trilinear) entre os pontos vizinhos: trocar
+    // um botao na thread de audio custa 8 leituras da tabela, sem alocacao. A tabela
+    // inclui uma compensacao de nivel fixa por topologia (0 dB em 1 kHz com os botoes
+    // no meio), ja que a rede passiva atenua 10 a 20 dB.
+    //
+    // Tabelas sao compartilhadas por topologia e taxa entre todas as instancias
+    // (getShared, como as particoes de IR em PartitionedConvolution.h)
+    class ToneStackTable
+    {
+    public:
+        static constexpr int gridSize = 11;
+
+        ToneStackTable(ToneStackModel newModel, double newSampleRate)
+            : model(newModel), sampleRate(newSampleRate), entries((size_t)(gridSize * gridSize * gridSize))
+        {
+            const double makeup = 1.0 / ToneStackCoefficients::compute(model, sampleRate, 0.5, 0.5, 0.5)
+                                            .getMagnitude(1000.0, sampleRate);
+
+            for (int bass = 0; bass < gridSize; ++bass)
+                for (int mid = 0; mid < gridSize; ++mid)
+                    for (int treble = 0; treble < gridSize; ++treble)
+                    {
+                        auto c = ToneStackCoefficients::compute(model, sampleRate, getPosition(bass),
+                                                                getPosition(mid), getPosition(treble));
+                        c.b0 *= makeup;
+                        c.b1 *= makeup;
+                        c.b2 *= makeup;
+                        c.b3 *= makeup;
+                        entries[getIndex(bass, mid, treble)] = c;
+                    }
+        }
+
+        static std::shared_ptr<const ToneStackTable> getShared(ToneStackModel model, double sampleRate)
+        {
+            struct Cache
+            {
+                juce::CriticalSection lock;
+                std::map<std::pair<int, double>, std::weak_ptr<const ToneStackTable>> entries;
+            };
+
+            static Cache cache;
+            const juce::ScopedLock lock(cache.lock);
+            auto& entry = cache.entries[{ (int)model, sampleRate }];
+
+            if (auto existing = entry.lock())
+                return existing;
+
+            auto table = std::make_shared<const ToneStackTable>(model, sampleRate);
+            entry = table;
+            return table;
+        }
+
+        // bass, mid, treble em 0..1
+        ToneStackCoefficients interpolate(double bass, double mid, double treble) const noexcept
+        {
+            int i[3];
+            double f[3];
+            const double positions[] = { bass, mid, treble };
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const double x = juce::jlimit(0.0, 1.0, positions[axis]) * (gridSize - 1);
+                i[axis] = juce::jmin((int)x, gridSize - 2);
+                f[axis] = x - i[axis];
+            }
+
+            ToneStackCoefficients result { 0, 0, 0, 0, 0, 0, 0 };
+
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                const int db = corner & 1, dm = (corner >> 1) & 1, dt = (corner >> 2) & 1;
+                const double weight = (db ? f[0] : 1.0 - f[0]) * (dm ? f[1] : 1.0 - f[1]) * (dt ? f[2] : 1.0 - f[2]);
+                const auto& c = entries[getIndex(i[0] + db, i[1] + dm, i[2] + dt)];
+
+                result.b0 += weight * c.b0;
+                result.b1 += weight * c.b1;
+                result.b2 += weight * c.b2;
+                result.b3 += weight * c.b3;
+                result.a1 += weight * c.a1;
+                result.a2 += weight * c.a2;
+                result.a3 += weight * c.a3;
+            }
+
+            return result;
+        }
+
+        ToneStackModel getModel() const noexcept { return model; }
+        double getSampleRate() const noexcept { return sampleRate; }
+
+    private:
+        static double getPosition(int index) noexcept { return (double)index / (double)(gridSize - 1); }
+
+        static size_t getIndex(int bass, int mid, int treble) noexcept
+        {
+            return (size_t)((bass * gridSize + mid) * gridSize + treble);
+        }
+
+        ToneStackModel model;
+        double sampleRate;
+        std::vector<ToneStackCoefficients> entries;
+    };
+
+    //==============================================================================
+    // IIR de 3a ordem (forma direta transposta II) com os coeficientes da tabela da
+    // topologia atual. Coeficientes e estado em double: em forma direta, os polos graves
+    // ficam perto de z = 1 e a precisao de float nao basta. prepare() busca as tabelas
+    // das tres topologias, entao setModel e setKnobs podem ser chamados na thread de audio
+    template <typename SampleType>
+    class ToneStack
+    {
+    public:
+        static constexpr int numModels = 3;
+
+        void prepare(const juce::dsp::ProcessSpec& spec)
+        {
+            for (int index = 0; index < numModels; ++index)
+                tables[(size_t)index] = ToneStackTable::getShared((ToneStackModel)index, spec.sampleRate);
+
+            state.resize(spec.numChannels);
+            simdLevel = CpuDispatch::getLevel();
+            updateCoefficients();
+            reset();
+        }
+
+        void reset() noexcept
+        {
+            for (auto& channelState : state)
+                channelState = {};
+        }
+
+        void setModel(ToneStackModel newModel) noexcept
+        {
+            model = newModel;
+            updateCoefficients();
+        }
+
+        ToneStackModel getModel() const noexcept { return model; }
+
+        // Posicoes dos botoes em 0..1
+        void setKnobs(double newBass, double newMid, double newTreble) noexcept
+        {
+            bass = newBass;
+            mid = newMid;
+            treble = newTreble;
+            updateCoefficients();
+        }
+
+        const ToneStackCoefficients& getCoefficients() const noexcept { return coefficients; }
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            auto&& inputBlock = context.getInputBlock();
+            auto&& outputBlock = context.getOutputBlock();
+            const auto numChannels = outputBlock.getNumChannels();
+            const auto numSamples = outputBlock.getNumSamples();
+
+            jassert(inputBlock.getNumChannels() == numChannels);
+            jassert(numChannels <= state.size());
+
+            if (context.isBypassed)
+            {
+                if (context.usesSeparateInputAndOutputBlocks())
+                    outputBlock.copyFrom(inputBlock);
+                return;
+            }
+
+            dispatch(simdLevel, [&]
+            {
+                for (size_t channel = 0; channel < numChannels; ++channel)
+                    processChannel(inputBlock.getChannelPointer(channel),
+                                   outputBlock.getChannelPointer(channel),
+                                   numSamples,
+                                   state[channel]);
+            });
+        }
+
+    private:
+        struct ChannelState
+        {
+            double s1 = 0, s2 = 0, s3 = 0;
+        };
+
+        void updateCoefficients() noexcept
+        {
+            if (const auto& table = tables[(size_t)model])
+                coefficients = table->interpolate(bass, mid, treble);
+        }
+
+        void processChannel(const SampleType* input, SampleType* output, size_t numSamples, ChannelState& channelState) noexcept
+        {
+            const auto c = coefficients;
+            auto s = channelState;
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                const double x = (double)input[i];
+                const double y = x * c.b0 + s.s1;
+                s.s1 = x * c.b1 - y * c.a1 + s.s2;
+                s.s2 = x * c.b2 - y * c.a2 + s.s3;
+                s.s3 = x * c.b3 - y * c.a3;
+                output[i] = (SampleType)y;
+            }
+
+            juce::dsp::util::snapToZero(s.s1);
+            juce::dsp::util::snapToZero(s.s2);
+            juce::dsp::util::snapToZero(s.s3);
+            channelState = s;
+        }
+
+        std::array<std::shared_ptr<const ToneStackTable>, (size_t)numModels> tables;
+        ToneStackModel model = ToneStackModel::fender;
+        double bass = 0.5, mid = 0.5, treble = 0.5;
+        ToneStackCoefficients coefficients;
+        std::vector<ChannelState> state;
+        SimdLevel simdLevel = SimdLevel::generic;
+    };
+}
@@ -0,0 +1,400 @@
+//==============================================================================
+// Trace.h: registro de eventos da thread de audio em tempo real, gravado como trace
+// do Chrome/Perfetto
+//==============================================================================
+
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Evento binario de tamanho fixo. name aponta para um literal (nunca uma String
+    // montada na thread de audio)
+    struct TraceEvent
+    {
+        enum class Type : juce::uint8 { blockBegin, blockEnd, parameter, instant, xrun };
+
+        juce::int64 ticks = 0;      // juce::Time::getHighResolutionTicks()
+        const char* name = nullptr;
+        float value = 0.0f;
+        int index = 0;              // amostras do bloco ou indice do parametro
+        Type type = Type::instant;
+    };
+
+    //==============================================================================
+    // Fila circular de um produtor e um consumidor, sem locks e sem alocacao depois do
+    // construtor. Cheia, descarta o evento novo e conta a perda
+    class TraceRing
+    {
+    public:
+        explicit TraceRing(int capacityPowerOfTwo)
+            : events((size_t)juce::nextPowerOfTwo(capacityPowerOfTwo)), mask((juce::uint32)events.size() - 1)
+        {
+        }
+
+        void push(const TraceEvent& event) noexcept
+        {
+            const auto write = head.load(std::memory_order_relaxed);
+
+            if (write - tail.load(std::memory_order_acquire) > mask)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            events[write & mask] = event;
+            head.store(write + 1, std::memory_order_release);
+        }
+
+        template <typename Function>
+        void drain(Function&& function)
+        {
+            const auto write = head.load(std::memory_order_acquire);
+            auto read = tail.load(std::memory_order_relaxed);
+
+            for (; read != write; ++read)
+                function(events[read & mask]);
+
+            tail.store(read, std::memory_order_release);
+        }
+
+        int getNumDropped() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+    private:
+        std::vector<TraceEvent> events;
+        const juce::uint32 mask;
+        std::atomic<juce::uint32> head { 0 }, tail { 0 };
+        std::atomic<int> dropped { 0 };
+    };
+
+    class Trace;
+
+    //==============================================================================
+    // Thread de fundo compartilhada por todas as instancias do processo
+    // (juce::SharedResourcePointer): a cada drainIntervalMs esvazia as filas e acrescenta
+    // os eventos ao arquivo no formato Trace Event do Chrome (abre em ui.perfetto.dev ou
+    // chrome://tracing). Cada instancia vira uma "thread" do trace, com o bloco de audio
+    // como fatia, os parametros como contadores e os eventos pontuais como marcas.
+    //
+    // Desligado por padrao: liga com a variavel de ambiente DSP_CORE_TRACE=<arquivo.json>
+    // (sessoes de producao, sem recompilar) ou com start(). O arquivo e gravado aos
+    // poucos; se o processo cair, o que ja foi gravado continua legivel (o formato aceita
+    // o array sem o fechamento)
+    class TraceWriter : private juce::Thread
+    {
+    public:
+        static constexpr int drainIntervalMs = 100;
+
+        TraceWriter() : juce::Thread("dsp_core trace")
+        {
+            startTicks = juce::Time::getHighResolutionTicks();
+
+            if (const char* path = std::getenv("DSP_CORE_TRACE"))
+                start(juce::File(juce::String::fromUTF8(path)));
+        }
+
+        ~TraceWriter() override { stop(); }
+
+        bool start(const juce::File& file)
+        {
+            stop();
+
+            const juce::ScopedLock lock(writeLock);
+            file.deleteFile();
+            stream = std::make_unique<juce::FileOutputStream>(file);
+
+            if (stream->failedToOpen())
+            {
+                stream.reset();
+                return false;
+            }
+
+            *stream << "[\n";
+            writeMetadata();
+            active.store(true);
+            startThread();
+            return true;
+        }
+
+        void stop()
+        {
+            if (! active.exchange(false))
+                return;
+
+            stopThread(1000);
+            flush();
+
+            const juce::ScopedLock lock(writeLock);
+            *stream << "{\"name\":\"trace end\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":"
+                    << juce::String(toMicroseconds(juce::Time::getHighResolutionTicks()), 3) << "}]\n";
+            stream.reset();
+        }
+
+        bool isActive() const noexcept { return active.load(std::memory_order_relaxed); }
+
+        // Esvazia as filas de todas as instancias no arquivo
+        void flush();
+
+    private:
+        friend class Trace;
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                wait(drainIntervalMs);
+                flush();
+            }
+        }
+
+        int add(Trace* trace)
+        {
+            const juce::ScopedLock lock(writeLock);
+            traces.add(trace);
+            return ++lastId;
+        }
+
+        // drena a instancia antes de remove-la: os eventos finais nao se perdem
+        void remove(Trace* trace);
+
+        void writeMetadata();
+        void writeMetadata(const Trace& trace);
+        void writeEvent(const Trace& trace, int tid, const TraceEvent& event);
+
+        double toMicroseconds(juce::int64 ticks) const noexcept
+        {
+            return 1.0e6 * juce::Time::highResolutionTicksToSeconds(ticks - startTicks);
+        }
+
+        juce::CriticalSection writeLock;
+        juce::Array<Trace*> traces;
+        std::unique_ptr<juce::FileOutputStream> stream;
+        std::atomic<bool> active { false };
+        juce::int64 startTicks = 0;
+        int lastId = 0;
+    };
+
+    //==============================================================================
+    // Registro de uma instancia de plugin. As chamadas da thread de audio (blockBegin,
+    // blockEnd, parameters, event) so gravam um evento binario na fila da instancia e
+    // nao fazem nada com o trace desligado. messageEvent e para a thread de mensagens
+    // (ex.: troca de IR em handleAsyncUpdate), com uma fila propria.
+    //
+    // Suspeita de xrun: um bloco cujo processamento levou mais que xrunLoad do tempo
+    // real do bloco (numSamples / sampleRate). Nao e um xrun confirmado (o host pode
+    // ter folga), mas marca os blocos que explicam um estalo
+    class Trace
+    {
+    public:
+        static constexpr int audioCapacity = 4096;
+        static constexpr int messageCapacity = 256;
+        static constexpr double xrunLoad = 0.5;
+
+        Trace() : audio(audioCapacity), message(messageCapacity)
+        {
+            id = writer->add(this);
+        }
+
+        ~Trace() { writer->remove(this); }
+
+        // Nome da instancia no trace e parametros acompanhados por parameters(). No
+        // construtor do plugin, antes de qualquer processamento
+        void setup(const juce::String& name, const juce::Array<juce::AudioProcessorParameter*>& parameters)
+        {
+            const juce::ScopedLock lock(writer->writeLock);
+            instanceName = name + " #" + juce::String(id);
+            parameterNames.clear();
+
+            for (auto* parameter : parameters)
+                parameterNames.add(instanceName + ": " + parameter->getName(64));
+
+            lastValues.assign((size_t)parameters.size(), -1.0f);
+
+            if (writer->isActive())
+                writer->writeMetadata(*this);
+        }
+
+        void prepare(double newSampleRate) noexcept { sampleRate.store(newSampleRate); }
+
+        bool isActive() const noexcept { return writer->isActive(); }
+
+        //------------------------------------------------------------------------------
+        // Thread de audio
+        void blockBegin(int numSamples) noexcept
+        {
+            if (! isActive())
+                return;
+
+            blockStart = juce::Time::getHighResolutionTicks();
+            blockSamples = numSamples;
+            audio.push({ blockStart, "processBlock", 0.0f, numSamples, TraceEvent::Type::blockBegin });
+        }
+
+        void blockEnd() noexcept
+        {
+            if (! isActive() || blockStart == 0)
+                return;
+
+            const auto now = juce::Time::getHighResolutionTicks();
+            audio.push({ now, "processBlock", 0.0f, blockSamples, TraceEvent::Type::blockEnd });
+
+            const double budget = (double)blockSamples / sampleRate.load(std::memory_order_relaxed);
+            const double load = juce::Time::highResolutionTicksToSeconds(now - blockStart) / budget;
+
+            if (load > xrunLoad)
+                audio.push({ now, "xrun?", (float)load, blockSamples, TraceEvent::Type::xrun });
+
+            blockStart = 0;
+        }
+
+        // Grava os parametros que mudaram desde a ultima chamada (valor normalizado)
+        void parameters(const juce::Array<juce::AudioProcessorParameter*>& list) noexcept
+        {
+            if (! isActive())
+                return;
+
+            const auto now = juce::Time::getHighResolutionTicks();
+            const int count = juce::jmin(list.size(), (int)lastValues.size());
+
+            for (int i = 0; i < count; ++i)
+            {
+                const float value = list.getUnchecked(i)->getValue();
+
+                if (value != lastValues[(size_t)i])
+                {
+                    lastValues[(size_t)i] = value;
+                    audio.push({ now, nullptr, value, i, TraceEvent::Type::parameter });
+                }
+            }
+        }
+
+        // Evento pontual; name deve ser um literal
+        void event(const char* name, float value = 0.0f) noexcept
+        {
+            if (isActive())
+                audio.push({ juce::Time::getHighResolutionTicks(), name, value, 0, TraceEvent::Type::instant });
+        }
+
+        //------------------------------------------------------------------------------
+        // Thread de mensagens
+        void messageEvent(const char* name, float value = 0.0f) noexcept
+        {
+            if (isActive())
+                message.push({ juce::Time::getHighResolutionTicks(), name, value, 0, TraceEvent::Type::instant });
+        }
+
+        int getNumDropped() const noexcept { return audio.getNumDropped() + message.getNumDropped(); }
+
+        //------------------------------------------------------------------------------
+        // Marca processBlock inteiro: blockBegin no construtor e blockEnd no destrutor
+        class ScopedBlock
+        {
+        public:
+            ScopedBlock(Trace& traceToUse, int numSamples) noexcept : trace(traceToUse) { trace.blockBegin(numSamples); }
+            ~ScopedBlock() { trace.blockEnd(); }
+
+        private:
+            Trace& trace;
+        };
+
+    private:
+        friend class TraceWriter;
+
+        juce::SharedResourcePointer<TraceWriter> writer;
+        TraceRing audio, message;
+        int id = 0;
+
+        // escritos sob writer->writeLock, antes do processamento
+        juce::String instanceName;
+        juce::StringArray parameterNames;
+
+        // so a thread de audio
+        std::vector<float> lastValues;
+        juce::int64 blockStart = 0;
+        int blockSamples = 0;
+        std::atomic<double> sampleRate { 44100.0 };
+    };
+
+    //==============================================================================
+    inline void TraceWriter::flush()
+    {
+        const juce::ScopedLock lock(writeLock);
+
+        if (stream == nullptr)
+            return;
+
+        // thread da instancia: 2 * id (audio) e 2 * id + 1 (mensagens)
+        for (auto* trace : traces)
+        {
+            trace->audio.drain([this, trace](const TraceEvent& event) { writeEvent(*trace, 2 * trace->id, event); });
+            trace->message.drain([this, trace](const TraceEvent& event) { writeEvent(*trace, 2 * trace->id + 1, event); });
+        }
+
+        stream->flush();
+    }
+
+    inline void TraceWriter::remove(Trace* trace)
+    {
+        flush();
+        const juce::ScopedLock lock(writeLock);
+        traces.removeFirstMatchingValue(trace);
+    }
+
+    inline void TraceWriter::writeMetadata()
+    {
+        for (auto* trace : traces)
+            writeMetadata(*trace);
+    }
+
+    inline void TraceWriter::writeMetadata(const Trace& trace)
+    {
+        if (stream == nullptr || trace.instanceName.isEmpty())
+            return;
+
+        const auto name = trace.instanceName.replace("\"", "'");
+
+        *stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << 2 * trace.id
+                << ",\"args\":{\"name\":\"" << name << "\"}},\n";
+        *stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << 2 * trace.id + 1
+                << ",\"args\":{\"name\":\"" << name << " (mensagens)\"}},\n";
+    }
+
+    inline void TraceWriter::writeEvent(const Trace& trace, int tid, const TraceEvent& event)
+    {
+        const auto common = ",\"pid\":1,\"tid\":" + juce::String(tid) + ",\"ts\":" + juce::String(toMicroseconds(event.ticks), 3);
+
+        switch (event.type)
+        {
+            case TraceEvent::Type::blockBegin:
+                *stream << "{\"name\":\"" << event.name << "\",\"ph\":\"B\"" << common
+                        << ",\"args\":{\"samples\":" << event.index << "}},\n";
+                break;
+
+            case TraceEvent::Type::blockEnd:
+                *stream << "{\"name\":\"" << event.name << "\",\"ph\":\"E\"" << common << "},\n";
+                break;
+
+            case TraceEvent::Type::parameter:
+                // contadores sao por processo: o nome inclui a instancia
+                *stream << "{\"name\":\"" << trace.parameterNames[event.index].replace("\"", "'") << "\",\"ph\":\"C\"" << common
+                        << ",\"args\":{\"value\":" << juce::String(event.value, 4) << "}},\n";
+                break;
+
+            case TraceEvent::Type::xrun:
+                *stream << "{\"name\":\"" << event.name << "\",\"ph\":\"i\",\"s\":\"p\"" << common
+                        << ",\"args\":{\"load\":" << juce::String(event.value, 2) << "}},\n";
+                break;
+
+            case TraceEvent::Type::instant:
+                *stream << "{\"name\":\"" << event.name << "\",\"ph\":\"i\",\"s\":\"t\"" << common
+                        << ",\"args\":{\"value\":" << juce::String(event.value, 4) << "}},\n";
+                break;
+        }
+    }
+}
@@ -0,0 +1,397 @@
+//==============================================================================
+// TriodePreamp.h: pre-amplificador valvulado (12AX7 em catodo comum) em wave digital filter
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <cmath>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Corrente de placa da 12AX7 pelo modelo de Koren:
+    //   E1 = Vpk / kp * ln(1 + exp(kp * (1 / mu + Vgk / sqrt(kvb + Vpk^2))))
+    //   Ip = 2 * E1^ex / kg1   (0 para E1 <= 0)
+    // Crescente em Vpk e em Vgk, o que garante uma unica raiz no estagio abaixo
+    struct KorenTriode
+    {
+        static constexpr double mu = 100.0;
+        static constexpr double ex = 1.4;
+        static constexpr double kg1 = 1060.0;
+        static constexpr double kp = 600.0;
+        static constexpr double kvb = 300.0;
+
+        static double getPlateCurrent(double vpk, double vgk) noexcept
+        {
+            if (vpk <= 0.0)
+                return 0.0;
+
+            const double exponent = kp * (1.0 / mu + vgk / std::sqrt(kvb + vpk * vpk));
+            // ln(1 + e^x) sem overflow para x grande
+            const double softplus = exponent > 30.0 ? exponent : std::log1p(std::exp(exponent));
+            const double e1 = vpk / kp * softplus;
+
+            return e1 > 0.0 ? 2.0 * std::pow(e1, ex) / kg1 : 0.0;
+        }
+    };
+
+    //==============================================================================
+    // Componentes do estagio (valores classicos de entrada de amplificador de guitarra):
+    //
+    //   entrada -- Ci --+-- grade        B+ -- Rp --+-- placa -- Co --+-- saida
+    //                   Rg                          |                 RL
+    //                  terra               catodo -- Rk || Ck -- terra
+    struct TriodeCircuit
+    {
+        static constexpr double supplyVoltage = 250.0;
+        static constexpr double plateResistor = 100.0e3;
+        static constexpr double cathodeResistor = 1.5e3;
+        static constexpr double cathodeCapacitor = 22.0e-6;
+        static constexpr double inputCapacitor = 22.0e-9;
+        static constexpr double sourceResistor = 1.0e3;
+        static constexpr double gridResistor = 1.0e6;
+        static constexpr double outputCapacitor = 22.0e-9;
+        static constexpr double loadResistor = 1.0e6;
+
+        // Resistencia de porta de um capacitor na transformada bilinear
+        static double getCapacitorResistance(double capacitor, double sampleRate) noexcept
+        {
+            return 1.0 / (2.0 * sampleRate * capacitor);
+        }
+
+        // Resistencia de porta vista pela valvula: Rp em serie com Rk || Ck
+        static double getCathodeResistance(double sampleRate) noexcept
+        {
+            const double capacitorResistance = getCapacitorResistance(cathodeCapacitor, sampleRate);
+            return cathodeResistor * capacitorResistance / (cathodeResistor + capacitorResistance);
+        }
+
+        static double getPortResistance(double sampleRate) noexcept
+        {
+            return plateResistor + getCathodeResistance(sampleRate);
+        }
+    };
+
+    //==============================================================================
+    // A valvula e a raiz da arvore do circuito de placa. A cada amostra chega a onda
+    // incidente a (B+ menos a onda do catodo) e a raiz precisa resolver
+    //   Ip(Vpk, Vgk) = (a - Vpk) / R
+    // com R a resistencia de porta. Em vez de iteracoes de Newton por amostra, a solucao
+    // Vpk e tabelada em uma grade 2D sobre (onda do catodo, Vgk) e lida com interpolacao
+    // bilinear: 4 leituras por amostra, sem log/exp/pow na thread de audio.
+    //
+    // R depende da taxa (pelo capacitor do catodo), entao ha uma tabela por taxa,
+    // construida no primeiro prepare() que a pede e compartilhada entre todas as
+    // instancias (getShared, como ToneStackTable). Fora da grade, os valores sao limitados
+    // a borda: abaixo de vgkMin a valvula ja esta em corte, e o limite de vgkMax faz o
+    // papel da conducao de grade, que o modelo nao inclui
+    class TriodeTable
+    {
+    public:
+        static constexpr int numCathodePoints = 64;
+        static constexpr int numGridPoints = 512;
+        static constexpr double cathodeMin = -5.0;
+        static constexpr double cathodeMax = 10.0;
+        static constexpr double vgkMin = -12.0;
+        static constexpr double vgkMax = 2.0;
+
+        explicit TriodeTable(double newSampleRate)
+            : sampleRate(newSampleRate),
+              portResistance(TriodeCircuit::getPortResistance(newSampleRate)),
+              entries((size_t)(numCathodePoints * numGridPoints))
+        {
+            // ao longo de Vgk a solucao muda pouco de um ponto para o seguinte: cada raiz
+            // parte da anterior
+            for (int cathode = 0; cathode < numCathodePoints; ++cathode)
+            {
+                const double incident = TriodeCircuit::supplyVoltage - getCathodeWave(cathode);
+                double previous = incident;
+
+                for (int grid = 0; grid < numGridPoints; ++grid)
+                {
+                    previous = solve(incident, getGridVoltage(grid), portResistance, previous);
+                    entries[(size_t)(cathode * numGridPoints + grid)] = (float)previous;
+                }
+            }
+        }
+
+        static std::shared_ptr<const TriodeTable> getShared(double sampleRate)
+        {
+            struct Cache
+            {
+                juce::CriticalSection lock;
+                std::map<double, std::weak_ptr<const TriodeTable>> entries;
+            };
+
+            static Cache cache;
+            const juce::ScopedLock lock(cache.lock);
+            auto& entry = cache.entries[sampleRate];
+
+            if (auto existing = entry.lock())
+                return existing;
+
+            auto table = std::make_shared<const TriodeTable>(sampleRate);
+            entry = table;
+            return table;
+        }
+
+        // Vpk para a onda do catodo e a tensao grade-catodo. Thread de audio
+        double getPlateVoltage(double cathodeWave, double vgk) const noexcept
+        {
+            const double x = (juce::jlimit(cathodeMin, cathodeMax, cathodeWave) - cathodeMin) * cathodeScale;
+            const double y = (juce::jlimit(vgkMin, vgkMax, vgk) - vgkMin) * gridScale;
+            const int i = juce::jmin((int)x, numCathodePoints - 2);
+            const int j = juce::jmin((int)y, numGridPoints - 2);
+            const double fx = x - i;
+            const double fy = y - j;
+
+            const float* row = entries.data() + i * numGridPoints + j;
+            const double lower = row[0] + fy * (row[1] - row[0]);
+            const double upper = row[numGridPoints] + fy * (row[numGridPoints + 1] - row[numGridPoints]);
+            return lower + fx * (upper - lower);
+        }
+
+        double getSampleRate() const noexcept { return sampleRate; }
+        double getPortResistance() const noexcept { return portResistance; }
+
+        // Raiz exata (construcao da tabela e referencia de precisao). A funcao
+        // f(v) = (a - v) / R - Ip(v) e decrescente em v e troca de sinal em [0, a]: Newton a
+        // partir de guess, com derivada por diferenca finita, e bissecao quando o passo sai
+        // do intervalo que contem a raiz
+        static double solve(double incident, double vgk, double resistance, double guess) noexcept
+        {
+            if (incident <= 0.0)
+                return incident;
+
+            auto f = [&](double v) { return (incident - v) / resistance - KorenTriode::getPlateCurrent(v, vgk); };
+
+            double low = 0.0, high = incident;
+            double v = juce::jlimit(low, high, guess);
+
+            for (int iteration = 0; iteration < 64; ++iteration)
+            {
+                const double value = f(v);
+
+                if (value > 0.0)
+                    low = v;
+                else
+                    high = v;
+
+                const double delta = 1.0e-6 * (1.0 + v);
+                const double slope = (f(v + delta) - value) / delta;
+                double next = slope < 0.0 ? v - value / slope : 0.5 * (low + high);
+
+                if (next <= low || next >= high)
+                    next = 0.5 * (low + high);
+
+                if (std::abs(next - v) < 1.0e-9 || high - low < 1.0e-9)
+                    return next;
+
+                v = next;
+            }
+
+            return v;
+        }
+
+    private:
+        static constexpr double cathodeScale = (numCathodePoints - 1) / (cathodeMax - cathodeMin);
+        static constexpr double gridScale = (numGridPoints - 1) / (vgkMax - vgkMin);
+
+        static double getCathodeWave(int index) noexcept { return cathodeMin + index / cathodeScale; }
+        static double getGridVoltage(int index) noexcept { return vgkMin + index / gridScale; }
+
+        double sampleRate;
+        double portResistance;
+        std::vector<float> entries;
+    };
+
+    //==============================================================================
+    // Um estagio de valvula em wave digital filter, a uma taxa fixa (a do oversampling).
+    // Tres arvores lineares ligadas pelas tensoes de grade e de placa:
+    //   grade: adaptador serie de fonte (entrada, Rs), Ci e Rg
+    //   placa: raiz na valvula, adaptador serie de B+ (com Rp) e do paralelo Rk || Ck
+    //   saida: adaptador serie de placa, Co e RL
+    // Vgk usa a tensao de catodo da amostra anterior, para a raiz ter uma so incognita.
+    // O sinal entra em volts na grade (1.0 = 1 V) e sai com ganho de pequenos sinais 1
+    // e sem a inversao de fase da valvula; o estado comeca no ponto de polarizacao
+    class TriodeStage
+    {
+    public:
+        struct State
+        {
+            double input = 0.0;             // onda refletida por Ci
+            double cathode = 0.0;           // onda refletida por Ck
+            double cathodeVoltage = 0.0;
+            double output = 0.0;            // onda refletida por Co
+        };
+
+        void prepare(double newSampleRate)
+        {
+            table = TriodeTable::getShared(newSampleRate);
+
+            const double sampleRate = table->getSampleRate();
+            const double cathodeCapacitorResistance = TriodeCircuit::getCapacitorResistance(TriodeCircuit::cathodeCapacitor, sampleRate);
+
+            inputCapacitorResistance = TriodeCircuit::getCapacitorResistance(TriodeCircuit::inputCapacitor, sampleRate);
+            inputLoopConductance = 1.0 / (TriodeCircuit::sourceResistor + inputCapacitorResistance + TriodeCircuit::gridResistor);
+            cathodeResistance = TriodeCircuit::getCathodeResistance(sampleRate);
+            cathodeReflection = TriodeCircuit::cathodeResistor / (TriodeCircuit::cathodeResistor + cathodeCapacitorResistance);
+            portConductance = 1.0 / table->getPortResistance();
+            outputCapacitorResistance = TriodeCircuit::getCapacitorResistance(TriodeCircuit::outputCapacitor, sampleRate);
+            outputLoopConductance = 1.0 / (outputCapacitorResistance + TriodeCircuit::loadResistor);
+
+            computeOperatingPoint();
+        }
+
+        // Estado em repouso: capacitores carregados no ponto de polarizacao, sem corrente
+        State getRestState() const noexcept
+        {
+            State state;
+            state.cathode = restCathodeVoltage;
+            state.cathodeVoltage = restCathodeVoltage;
+            state.output = restPlateVoltage;
+            return state;
+        }
+
+        double processSample(double input, State& state) const noexcept
+        {
+            // grade: corrente da malha Rs + Ci + Rg
+            const double gridCurrent = (input - state.input) * inputLoopConductance;
+            const double vg = TriodeCircuit::gridResistor * gridCurrent;
+            state.input += 2.0 * inputCapacitorResistance * gridCurrent;
+
+            // placa: onda do paralelo Rk || Ck para cima, raiz tabelada, onda de volta para baixo
+            const double cathodeWave = cathodeReflection * state.cathode;
+            const double vpk = table->getPlateVoltage(cathodeWave, vg - state.cathodeVoltage);
+            const double plateCurrent = (TriodeCircuit::supplyVoltage - cathodeWave - vpk) * portConductance;
+            const double vk = cathodeWave + cathodeResistance * plateCurrent;
+            state.cathode = 2.0 * vk - state.cathode;
+            state.cathodeVoltage = vk;
+
+            // saida: malha Co + RL a partir da tensao de placa
+            const double outputCurrent = (vpk + vk - state.output) * outputLoopConductance;
+            state.output += 2.0 * outputCapacitorResistance * outputCurrent;
+
+            return TriodeCircuit::loadResistor * outputCurrent * outputScale;
+        }
+
+        double getRestPlateVoltage() const noexcept { return restPlateVoltage; }
+        double getRestCathodeVoltage() const noexcept { return restCathodeVoltage; }
+
+        // Ganho de pequenos sinais na faixa media (ja compensado em processSample)
+        double getSmallSignalGain() const noexcept { return -1.0 / outputScale; }
+
+    private:
+        // Ponto de polarizacao (capacitores abertos): Ip = Koren(B+ - (Rp + Rk) Ip, -Rk Ip),
+        // por bissecao. O ganho vem das derivadas de Koren nesse ponto:
+        //   A = -gm * (Rp || rp || RL), com o catodo desacoplado por Ck
+        void computeOperatingPoint() noexcept
+        {
+            const double rp = TriodeCircuit::plateResistor;
+            const double rk = TriodeCircuit::cathodeResistor;
+            double low = 0.0, high = TriodeCircuit::supplyVoltage / (rp + rk);
+
+            for (int iteration = 0; iteration < 60; ++iteration)
+            {
+                const double current = 0.5 * (low + high);
+
+                if (current < KorenTriode::getPlateCurrent(TriodeCircuit::supplyVoltage - (rp + rk) * current, -rk * current))
+                    low = current;
+                else
+                    high = current;
+            }
+
+            const double current = 0.5 * (low + high);
+            const double vpk = TriodeCircuit::supplyVoltage - (rp + rk) * current;
+            const double vgk = -rk * current;
+            restCathodeVoltage = rk * current;
+            restPlateVoltage = vpk + restCathodeVoltage;
+
+            const double delta = 1.0e-3;
+            const double gm = (KorenTriode::getPlateCurrent(vpk, vgk + delta) - KorenTriode::getPlateCurrent(vpk, vgk - delta)) / (2.0 * delta);
+            const double gp = (KorenTriode::getPlateCurrent(vpk + delta, vgk) - KorenTriode::getPlateCurrent(vpk - delta, vgk)) / (2.0 * delta);
+            const double load = 1.0 / (1.0 / rp + gp + 1.0 / TriodeCircuit::loadResistor);
+            outputScale = gm > 0.0 ? -1.0 / (gm * load) : 1.0;
+        }
+
+        std::shared_ptr<const TriodeTable> table;
+        double inputCapacitorResistance = 0.0, inputLoopConductance = 0.0;
+        double cathodeResistance = 0.0, cathodeReflection = 0.0, portConductance = 0.0;
+        double outputCapacitorResistance = 0.0, outputLoopConductance = 0.0;
+        double restPlateVoltage = 0.0, restCathodeVoltage = 0.0;
+        double outputScale = 1.0;
+    };
+
+    //==============================================================================
+    // Estagio de cadeia (prepare/reset/process) com o TriodeStage em oversampling 2x
+    // (juce::dsp::Oversampling, meia-banda IIR polifasica, latencia inteira). A
+    // tabela da valvula e a da taxa interna. getLatency() e a latencia do oversampling
+    // em amostras da taxa do host
+    class TriodePreamp
+    {
+    public:
+        static constexpr int oversamplingOrder = 1;
+
+        void prepare(const juce::dsp::ProcessSpec& spec)
+        {
+            oversampling = std::make_unique<juce::dsp::Oversampling<float>>(
+                spec.numChannels, (size_t)oversamplingOrder,
+                juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true);
+            oversampling->initProcessing(spec.maximumBlockSize);
+
+            stage.prepare(spec.sampleRate * (double)(1 << oversamplingOrder));
+            states.assign((size_t)spec.numChannels, stage.getRestState());
+            latency = juce::roundToInt(oversampling->getLatencyInSamples());
+        }
+
+        void reset() noexcept
+        {
+            if (oversampling != nullptr)
+                oversampling->reset();
+
+            for (auto& state : states)
+                state = stage.getRestState();
+        }
+
+        int getLatency() const noexcept { return latency; }
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            auto&& input = context.getInputBlock();
+            auto&& output = context.getOutputBlock();
+
+            if (context.usesSeparateInputAndOutputBlocks())
+                output.copyFrom(input);
+
+            if (context.isBypassed || oversampling == nullptr)
+                return;
+
+            juce::dsp::AudioBlock<float> block(output);
+            auto upsampled = oversampling->processSamplesUp(block);
+            const auto numChannels = juce::jmin(upsampled.getNumChannels(), states.size());
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+            {
+                auto& state = states[channel];
+                float* samples = upsampled.getChannelPointer(channel);
+
+                for (size_t i = 0; i < upsampled.getNumSamples(); ++i)
+                    samples[i] = (float)stage.processSample((double)samples[i], state);
+            }
+
+            oversampling->processSamplesDown(block);
+        }
+
+    private:
+        TriodeStage stage;
+        std::vector<TriodeStage::State> states;
+        std::unique_ptr<juce::dsp::Oversampling<float>> oversampling;
+        int latency = 0;
+    };
+}
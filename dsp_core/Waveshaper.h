@@ -0,0 +1,80 @@
+//==============================================================================
+// Waveshaper.h: saturacao por funcao de transferencia aplicada amostra a amostra
+//==============================================================================
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include "CpuDispatch.h"
+
+#include <cmath>
+#include <functional>
+
+namespace dsp_core
+{
+    //==============================================================================
+    // Funcoes de transferencia como objetos funcao, para que a chamada seja expandida
+    // inline no laco (juce::dsp::WaveShaper<float> usa ponteiro de funcao)
+    //------------------------------------------------------------------------------
+    // tangente hiperbolica
+    template <typename SampleType>
+    struct Tanh
+    {
+        SampleType operator()(SampleType x) const noexcept { return std::tanh(x); }
+    };
+
+    // soft-clipping: sign(x) * (1 - 0.25 / (|x| + 0.25)). Calculado em double, como a
+    // versao original do 052_ampsim, para manter a mesma saida
+    template <typename SampleType>
+    struct SoftClip
+    {
+        SampleType operator()(SampleType x) const noexcept
+        {
+            return (SampleType)(std::copysign(1.0, (double)x) * (1 - 0.25 / (std::fabs((double)x) + 0.25)));
+        }
+    };
+
+    //==============================================================================
+    // Aplica functionToUse em todas as amostras do bloco. Function pode ser um dos
+    // objetos acima ou std::function, quando a funcao e escolhida em tempo de execucao
+    template <typename SampleType, typename Function = std::function<SampleType(SampleType)>>
+    struct Waveshaper
+    {
+        Function functionToUse;
+        SimdLevel simdLevel = SimdLevel::generic;
+
+        void prepare(const juce::dsp::ProcessSpec&) noexcept { simdLevel = CpuDispatch::getLevel(); }
+        void reset() noexcept {}
+
+        template <typename ProcessContext>
+        void process(const ProcessContext& context) noexcept
+        {
+            auto&& inputBlock = context.getInputBlock();
+            auto&& outputBlock = context.getOutputBlock();
+            const auto numChannels = outputBlock.getNumChannels();
+            const auto numSamples = outputBlock.getNumSamples();
+
+            jassert(inputBlock.getNumChannels() == numChannels);
+
+            if (context.isBypassed)
+            {
+                if (context.usesSeparateInputAndOutputBlocks())
+                    outputBlock.copyFrom(inputBlock);
+                return;
+            }
+
+            dispatch(simdLevel, [&]
+            {
+                for (size_t channel = 0; channel < numChannels; ++channel)
+                {
+                    const SampleType* input = inputBlock.getChannelPointer(channel);
+                    SampleType* output = outputBlock.getChannelPointer(channel);
+
+                    for (size_t i = 0; i < numSamples; ++i)
+                        output[i] = functionToUse(input[i]);
+                }
+            });
+        }
+    };
+}
@@ -0,0 +1,513 @@
+//==============================================================================
+// GoldenTest.cpp: verificacao de regressao da saida dos plugins contra saidas de
+// referencia (golden files)
+//
+// Para cada preset do plugin (createPrograms) e cada sinal canonico (impulso,
+// varredura senoidal, ruido, rajada seguida de silencio para a cauda), renderiza a
+// saida sem host e compara com <golden-dir>/pNN_<preset>_<sinal>.wav:
+//   ULP:       maior distancia em unidades de precisao float entre as amostras
+//   nulo:      pico do residuo (saida - referencia) em dBFS e RMS do residuo em dB
+//              relativo ao RMS da referencia
+//   espectro:  maior diferenca, em dB, entre os espectros medios de potencia
+// O caso passa se a distancia ULP nao passa de --ulp ou, quando --db e dado, se o pico
+// do residuo fica abaixo de --db dBFS. O padrao e exigir saida identica (--ulp=0).
+//
+// Uso:
+//   <Plugin>_Golden --record                grava as referencias com o codigo atual
+//   <Plugin>_Golden                         compara (retorna erro se algum caso falhar)
+//   <Plugin>_Golden --isa=avx2 --db=-120    outra variante, com pequenas diferencas
+//   <Plugin>_Golden --double --db=-100      compara o caminho double com as referencias
+//   --golden-dir=<pasta>  (padrao: golden/ na pasta do plugin)
+//   --filter=<texto>      apenas os casos cujo nome contem o texto
+//   --report=<arq.json>   grava as medidas de todos os casos
+//   --diff-dir=<pasta>    grava o residuo dos casos que falharam em wav
+//   --sample-rate=48000 --block-size=512
+//   --isa=generic         variante dos kernels de dsp_core (generic, avx2, avx512; ver
+//                         dsp_core/CpuDispatch.h). O padrao e generic, a mesma em
+//                         qualquer maquina: com FMA a saida muda no arredondamento e
+//                         --ulp=0 so vale na variante generic
+//
+// As referencias ficam em golden/ de cada plugin, gravadas por tools/record_golden_nix.sh
+// com o codigo do primeiro commit (antes de qualquer otimizacao), com esta ferramenta
+// compilada sobre os fontes daquela revisao. Devem ser gravadas de novo quando a
+// mudanca na saida for intencional.
+//
+// Compilado com DSP_CORE_RT_CHECK, tambem falha se processBlock alocar memoria ou
+// travar um mutex (ver dsp_core/RealtimeCheck.h), imprimindo as pilhas de chamadas.
+//==============================================================================
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_dsp/juce_dsp.h>
+
+#include "ToolsCommon.h"
+#include "dsp_core/CpuDispatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    constexpr int numChannels = 2;
+
+    //==============================================================================
+    // Opcoes de linha de comando
+    //------------------------------------------------------------------------------
+    struct Options
+    {
+        juce::File goldenDir { PLUGIN_GOLDEN_DIR };
+        juce::File reportFile;
+        juce::File diffDir;
+        juce::String filter;
+        juce::String isa { "generic" };
+        bool record = false;
+        bool doublePrecision = false;
+        juce::int64 maxUlp = 0;
+        double maxDb = std::numeric_limits<double>::quiet_NaN(); // NaN: sem tolerancia em dB
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+    };
+
+    Options parseOptions(const juce::ArgumentList& args)
+    {
+        Options options;
+
+        if (args.containsOption("--golden-dir"))
+            options.goldenDir = args.getFileForOption("--golden-dir");
+        if (args.containsOption("--report"))
+            options.reportFile = args.getFileForOption("--report");
+        if (args.containsOption("--diff-dir"))
+            options.diffDir = args.getFileForOption("--diff-dir");
+        if (args.containsOption("--filter"))
+            options.filter = args.getValueForOption("--filter");
+        if (args.containsOption("--ulp"))
+            options.maxUlp = args.getValueForOption("--ulp").getLargeIntValue();
+        if (args.containsOption("--db"))
+            options.maxDb = args.getValueForOption("--db").getDoubleValue();
+        if (args.containsOption("--sample-rate"))
+            options.sampleRate = args.getValueForOption("--sample-rate").getDoubleValue();
+        if (args.containsOption("--isa"))
+            options.isa = args.getValueForOption("--isa");
+        if (args.containsOption("--block-size"))
+            options.blockSize = juce::jmax(1, args.getValueForOption("--block-size").getIntValue());
+
+        options.record = args.containsOption("--record");
+        options.doublePrecision = args.containsOption("--double");
+
+        return options;
+    }
+
+    //==============================================================================
+    // Sinais canonicos (estereo)
+    //------------------------------------------------------------------------------
+    struct Signal
+    {
+        juce::String name;
+        juce::AudioBuffer<float> buffer;
+    };
+
+    std::vector<Signal> makeSignals(double sampleRate)
+    {
+        const int length = (int)(2.0 * sampleRate);
+        std::vector<Signal> signals;
+
+        // impulso unitario: resposta ao impulso completa do plugin
+        {
+            juce::AudioBuffer<float> buffer(numChannels, length);
+            buffer.clear();
+            for (int channel = 0; channel < numChannels; ++channel)
+                buffer.setSample(channel, 0, 1.0f);
+            signals.push_back({ "impulse", std::move(buffer) });
+        }
+
+        // varredura exponencial de 20 Hz a 20 kHz em 1.5 s, seguida de silencio. O canal
+        // direito tem metade da amplitude, para detectar canais processados de forma diferente
+        {
+            juce::AudioBuffer<float> buffer(numChannels, length);
+            buffer.clear();
+
+            const double duration = 1.5, f0 = 20.0, f1 = 20000.0;
+            const double k = std::log(f1 / f0);
+            const int sweepLength = (int)(duration * sampleRate);
+
+            for (int i = 0; i < sweepLength; ++i)
+            {
+                const double t = (double)i / sampleRate;
+                const double phase = juce::MathConstants<double>::twoPi * f0 * duration / k * (std::exp(t * k / duration) - 1.0);
+                const float value = 0.5f * (float)std::sin(phase);
+                buffer.setSample(0, i, value);
+                buffer.setSample(1, i, 0.5f * value);
+            }
+            signals.push_back({ "sweep", std::move(buffer) });
+        }
+
+        // ruido branco independente por canal
+        {
+            juce::AudioBuffer<float> buffer(numChannels, length);
+            juce::Random random(1);
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < length; ++i)
+                    buffer.setSample(channel, i, 0.25f * (2.0f * random.nextFloat() - 1.0f));
+            signals.push_back({ "noise", std::move(buffer) });
+        }
+
+        // rajada de ruido de 0.25 s e silencio: cauda de delays e reverbs, e o decaimento
+        // ate a faixa de denormais
+        {
+            juce::AudioBuffer<float> buffer(numChannels, (int)(3.0 * sampleRate));
+            juce::Random random(2);
+            buffer.clear();
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < (int)(0.25 * sampleRate); ++i)
+                    buffer.setSample(channel, i, 0.5f * (2.0f * random.nextFloat() - 1.0f));
+            signals.push_back({ "tail", std::move(buffer) });
+        }
+
+        return signals;
+    }
+
+    //==============================================================================
+    // Renderizacao
+    //------------------------------------------------------------------------------
+    // Processa input em blocos de blockSize com uma instancia nova do plugin no preset
+    // program. A saida tem o numero de canais de saida do plugin
+    template <typename SampleType>
+    juce::AudioBuffer<float> render(int program, const juce::AudioBuffer<float>& input, const Options& options)
+    {
+        auto processor = plugin_tools::createProcessor();
+        processor->setCurrentProgram(program);
+        plugin_tools::prepareForOfflineRendering<SampleType>(*processor, options.sampleRate, options.blockSize);
+
+        const int channels = plugin_tools::getNumProcessingChannels(*processor);
+        const int length = input.getNumSamples();
+        juce::MidiBuffer midi;
+
+        juce::AudioBuffer<SampleType> work(channels, length);
+        work.clear();
+
+        for (int channel = 0; channel < juce::jmin(channels, input.getNumChannels()); ++channel)
+            for (int i = 0; i < length; ++i)
+                work.setSample(channel, i, (SampleType)input.getSample(channel, i));
+
+        for (int start = 0; start < length; start += options.blockSize)
+        {
+            juce::AudioBuffer<SampleType> block(work.getArrayOfWritePointers(), channels, start, juce::jmin(options.blockSize, length - start));
+            plugin_tools::processBlock(*processor, block, midi);
+        }
+
+        processor->releaseResources();
+
+        juce::AudioBuffer<float> output(processor->getTotalNumOutputChannels(), length);
+
+        for (int channel = 0; channel < output.getNumChannels(); ++channel)
+            for (int i = 0; i < length; ++i)
+                output.setSample(channel, i, (float)work.getSample(channel, i));
+
+        return output;
+    }
+
+    //==============================================================================
+    // Arquivos wav (float 32 bits, sem perda)
+    //------------------------------------------------------------------------------
+    bool writeWav(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate)
+    {
+        file.getParentDirectory().createDirectory();
+        file.deleteFile();
+
+        auto stream = std::make_unique<juce::FileOutputStream>(file);
+        if (! stream->openedOk())
+            return false;
+
+        juce::WavAudioFormat format;
+        std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(stream.get(), sampleRate, (unsigned int)buffer.getNumChannels(), 32, {}, 0));
+        if (writer == nullptr)
+            return false;
+
+        stream.release(); // o writer passa a ser dono do stream
+        return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+    }
+
+    bool readWav(const juce::File& file, juce::AudioBuffer<float>& buffer)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader == nullptr)
+            return false;
+
+        buffer.setSize((int)reader->numChannels, (int)reader->lengthInSamples);
+        return reader->read(&buffer, 0, buffer.getNumSamples(), 0, true, true);
+    }
+
+    //==============================================================================
+    // Comparacao
+    //------------------------------------------------------------------------------
+    struct Comparison
+    {
+        juce::int64 maxUlp = 0;
+        double peakDb = -std::numeric_limits<double>::infinity();       // pico do residuo, dBFS
+        double residualDb = -std::numeric_limits<double>::infinity();   // RMS residuo / RMS referencia, dB
+        double spectralDb = 0;                                          // maior diferenca espectral, dB
+        double spectralHz = 0;                                          // frequencia onde ela ocorre
+        bool passed = false;
+    };
+
+    double toDb(double value)
+    {
+        return value > 0 ? 20.0 * std::log10(value) : -std::numeric_limits<double>::infinity();
+    }
+
+    // Distancia em ULPs: os bits do float sao mapeados para inteiros ordenados, de modo
+    // que floats vizinhos diferem de 1
+    juce::int64 ulpDistance(float a, float b)
+    {
+        if (std::isnan(a) || std::isnan(b))
+            return a == b || (std::isnan(a) && std::isnan(b)) ? 0 : std::numeric_limits<juce::int32>::max();
+
+        auto ordered = [](float x)
+        {
+            juce::int32 bits;
+            std::memcpy(&bits, &x, sizeof(bits));
+            return bits < 0 ? (juce::int64)std::numeric_limits<juce::int32>::min() - (juce::int64)bits : (juce::int64)bits;
+        };
+
+        return std::abs(ordered(a) - ordered(b));
+    }
+
+    // Espectro medio de potencia (janela de Hann, 50% de sobreposicao), somando os canais
+    std::vector<double> averagePowerSpectrum(const juce::AudioBuffer<float>& buffer)
+    {
+        constexpr int order = 12;
+        constexpr int size = 1 << order;
+
+        juce::dsp::FFT fft(order);
+        juce::dsp::WindowingFunction<float> window((size_t)size, juce::dsp::WindowingFunction<float>::hann, false);
+        std::vector<float> frame((size_t)(2 * size));
+        std::vector<double> power((size_t)(size / 2 + 1), 0.0);
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int start = 0; start + size <= buffer.getNumSamples(); start += size / 2)
+            {
+                std::fill(frame.begin(), frame.end(), 0.0f);
+                std::memcpy(frame.data(), buffer.getReadPointer(channel, start), sizeof(float) * (size_t)size);
+                window.multiplyWithWindowingTable(frame.data(), (size_t)size);
+                fft.performFrequencyOnlyForwardTransform(frame.data(), true);
+
+                for (size_t bin = 0; bin < power.size(); ++bin)
+                    power[bin] += (double)frame[bin] * (double)frame[bin];
+            }
+
+        return power;
+    }
+
+    Comparison compare(const juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& golden,
+                       const Options& options)
+    {
+        Comparison result;
+
+        if (output.getNumChannels() != golden.getNumChannels() || output.getNumSamples() != golden.getNumSamples())
+        {
+            result.maxUlp = std::numeric_limits<juce::int32>::max();
+            result.peakDb = std::numeric_limits<double>::infinity();
+            return result;
+        }
+
+        // teste de nulo
+        double peak = 0, residualEnergy = 0, goldenEnergy = 0;
+
+        for (int channel = 0; channel < golden.getNumChannels(); ++channel)
+        {
+            const float* out = output.getReadPointer(channel);
+            const float* ref = golden.getReadPointer(channel);
+
+            for (int i = 0; i < golden.getNumSamples(); ++i)
+            {
+                const double difference = (double)out[i] - (double)ref[i];
+                result.maxUlp = juce::jmax(result.maxUlp, ulpDistance(out[i], ref[i]));
+                peak = juce::jmax(peak, std::abs(difference));
+                residualEnergy += difference * difference;
+                goldenEnergy += (double)ref[i] * (double)ref[i];
+            }
+        }
+
+        result.peakDb = std::isnan(peak) ? std::numeric_limits<double>::infinity() : toDb(peak);
+        result.residualDb = goldenEnergy > 0 ? 10.0 * std::log10(residualEnergy / goldenEnergy) : toDb(std::sqrt(residualEnergy));
+
+        // diferenca espectral, ignorando as faixas mais de 120 dB abaixo do pico da referencia
+        const auto outputSpectrum = averagePowerSpectrum(output);
+        const auto goldenSpectrum = averagePowerSpectrum(golden);
+        const double floor = *std::max_element(goldenSpectrum.begin(), goldenSpectrum.end()) * 1.0e-12;
+
+        for (size_t bin = 0; bin < goldenSpectrum.size(); ++bin)
+        {
+            if (goldenSpectrum[bin] <= floor)
+                continue;
+
+            const double difference = 10.0 * std::log10(juce::jmax(outputSpectrum[bin], floor) / goldenSpectrum[bin]);
+
+            if (std::abs(difference) > std::abs(result.spectralDb))
+            {
+                result.spectralDb = difference;
+                result.spectralHz = (double)bin * options.sampleRate / (double)(2 * (goldenSpectrum.size() - 1));
+            }
+        }
+
+        result.passed = result.maxUlp <= options.maxUlp
+                     || (! std::isnan(options.maxDb) && result.peakDb <= options.maxDb);
+        return result;
+    }
+
+    //==============================================================================
+    // Relatorio
+    //------------------------------------------------------------------------------
+    juce::var toJson(const juce::String& name, const Comparison& comparison)
+    {
+        // JSON nao representa infinito: residuo nulo e gravado como -999 dB
+        auto finite = [](double value) { return std::isfinite(value) ? value : (value < 0 ? -999.0 : 999.0); };
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("name", name);
+        entry->setProperty("max_ulp", comparison.maxUlp);
+        entry->setProperty("null_peak_dbfs", finite(comparison.peakDb));
+        entry->setProperty("null_rms_db", finite(comparison.residualDb));
+        entry->setProperty("spectral_max_db", comparison.spectralDb);
+        entry->setProperty("spectral_max_hz", comparison.spectralHz);
+        entry->setProperty("passed", comparison.passed);
+        return juce::var(entry);
+    }
+
+    juce::String caseName(int program, const juce::String& presetName, const juce::String& signalName)
+    {
+        const auto preset = juce::File::createLegalFileName(presetName.trim()).replaceCharacter(' ', '_');
+        return "p" + juce::String(program).paddedLeft('0', 2) + "_" + preset + "_" + signalName;
+    }
+
+    bool parseLevel(const juce::String& name, dsp_core::SimdLevel& level)
+    {
+        for (auto candidate : { dsp_core::SimdLevel::generic, dsp_core::SimdLevel::avx2, dsp_core::SimdLevel::avx512 })
+            if (name == dsp_core::CpuDispatch::getName(candidate))
+            {
+                level = candidate;
+                return true;
+            }
+
+        return false;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // o gerenciador de mensagens precisa existir para os timers de AudioProcessorValueTreeState
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const auto options = parseOptions(juce::ArgumentList(argc, argv));
+
+    // antes de criar os processadores: o nivel e lido no prepare() de cada kernel
+    auto level = dsp_core::SimdLevel::generic;
+
+    if (! parseLevel(options.isa, level))
+    {
+        std::printf("variante desconhecida: %s\n", options.isa.toRawUTF8());
+        return 1;
+    }
+
+    dsp_core::CpuDispatch::setMaxLevel(level);
+
+    auto probe = plugin_tools::createProcessor();
+    const int numPrograms = juce::jmax(1, probe->getNumPrograms());
+
+    if (options.doublePrecision && ! probe->supportsDoublePrecisionProcessing())
+    {
+        std::printf("%s nao tem caminho double; nada a verificar\n", probe->getName().toRawUTF8());
+        return 0;
+    }
+
+    const auto signals = makeSignals(options.sampleRate);
+
+    std::printf("%s: %d preset(s), referencias em %s, variante %s\n", probe->getName().toRawUTF8(), numPrograms,
+                options.goldenDir.getFullPathName().toRawUTF8(),
+                dsp_core::CpuDispatch::getName(dsp_core::CpuDispatch::getLevel()));
+
+    if (! options.record)
+        std::printf("%-40s %10s %12s %12s %12s %10s\n", "caso", "ULP", "nulo pico", "nulo RMS", "espectro", "");
+
+    juce::Array<juce::var> report;
+    int failures = 0;
+
+    for (int program = 0; program < numPrograms; ++program)
+    {
+        for (const auto& signal : signals)
+        {
+            const auto name = caseName(program, probe->getProgramName(program), signal.name);
+
+            if (options.filter.isNotEmpty() && ! name.contains(options.filter))
+                continue;
+
+            const auto output = options.doublePrecision ? render<double>(program, signal.buffer, options)
+                                                        : render<float>(program, signal.buffer, options);
+            const auto goldenFile = options.goldenDir.getChildFile(name + ".wav");
+
+            if (options.record)
+            {
+                const bool written = writeWav(goldenFile, output, options.sampleRate);
+                std::printf("%-40s %s\n", name.toRawUTF8(), written ? "gravado" : "ERRO ao gravar");
+                failures += written ? 0 : 1;
+                continue;
+            }
+
+            juce::AudioBuffer<float> golden;
+
+            if (! readWav(goldenFile, golden))
+            {
+                std::printf("%-40s sem referencia (rode tools/record_golden_nix.sh)\n", name.toRawUTF8());
+                ++failures;
+                continue;
+            }
+
+            const auto comparison = compare(output, golden, options);
+
+            std::printf("%-40s %10lld %8.1f dB %8.1f dB %+9.2f dB %10s\n", name.toRawUTF8(), (long long)comparison.maxUlp,
+                        comparison.peakDb, comparison.residualDb, comparison.spectralDb,
+                        comparison.passed ? "ok" : "FALHOU");
+
+            report.add(toJson(name, comparison));
+
+            if (! comparison.passed)
+            {
+                ++failures;
+
+                if (options.diffDir != juce::File())
+                {
+                    juce::AudioBuffer<float> residual;
+                    residual.makeCopyOf(output);
+                    for (int channel = 0; channel < residual.getNumChannels(); ++channel)
+                        residual.addFrom(channel, 0, golden, channel, 0, residual.getNumSamples(), -1.0f);
+                    writeWav(options.diffDir.getChildFile(name + ".residual.wav"), residual, options.sampleRate);
+                }
+            }
+        }
+    }
+
+    if (options.reportFile != juce::File())
+    {
+        auto* root = new juce::DynamicObject();
+        root->setProperty("plugin", probe->getName());
+        root->setProperty("precision", options.doublePrecision ? "double" : "float");
+        root->setProperty("sample_rate", options.sampleRate);
+        root->setProperty("block_size", options.blockSize);
+        root->setProperty("cases", report);
+        options.reportFile.replaceWithText(juce::JSON::toString(juce::var(root)));
+    }
+
+    if (plugin_tools::reportRealtimeViolations(probe->getName()))
+        ++failures;
+
+    std::printf("%d falha(s)\n", failures);
+    return failures > 0 ? 1 : 0;
+}
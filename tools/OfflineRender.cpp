@@ -0,0 +1,380 @@
+//==============================================================================
+// OfflineRender.cpp: processa arquivos de audio pelo plugin, sem host
+//
+// Cada arquivo e processado por uma instancia propria do plugin em uma thread de um
+// pool (um arquivo por nucleo). A leitura de WAV/AIFF e mapeada em memoria; os demais
+// formatos (FLAC) sao lidos com antecedencia em outra thread (BufferingAudioReader).
+// A escrita passa por uma fila e e feita por outra thread (ThreadedWriter), entao o
+// processamento nao espera pelo disco.
+//
+// Uso:
+//   <Plugin>_Render [opcoes] <arquivos ou pastas>...
+//   --out-dir=<pasta>     destino (padrao: ./rendered). Pastas de entrada mantem a
+//                         estrutura de subpastas
+//   --preset=<n>          preset de createPrograms (padrao: o preset inicial do plugin)
+//   --state=<arquivo>     estado salvo (binario de getStateInformation ou XML)
+//   --write-state=<arq>   grava o estado do preset escolhido em XML e sai
+//   --format=wav|flac|aiff  formato de saida (padrao: o mesmo da entrada)
+//   --bits=<n>            bits por amostra (padrao: os da entrada)
+//   --block-size=<n>      amostras por bloco (padrao: 8192)
+//   --jobs=<n>            arquivos em paralelo (padrao: numero de nucleos)
+//   --tail=<segundos>     cauda renderizada apos o fim da entrada (padrao: a do plugin)
+//
+// A latencia do plugin (getLatencySamples) e compensada: a saida fica alinhada com a
+// entrada, como em um host com compensacao de atraso.
+//
+// Compilado com DSP_CORE_RT_CHECK, retorna erro se processBlock alocar memoria ou
+// travar um mutex (ver dsp_core/RealtimeCheck.h).
+//==============================================================================
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include "ToolsCommon.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    const char* const audioWildcard = "*.wav;*.flac;*.aif;*.aiff";
+
+    constexpr int readAheadSamples = 1 << 16;   // leitura antecipada (BufferingAudioReader)
+    constexpr int writeFifoSamples = 1 << 17;   // fila de escrita (ThreadedWriter)
+
+    //==============================================================================
+    // Opcoes de linha de comando
+    //------------------------------------------------------------------------------
+    struct Job
+    {
+        juce::File input;
+        juce::File output;
+    };
+
+    struct Options
+    {
+        juce::File outDir { juce::File::getCurrentWorkingDirectory().getChildFile("rendered") };
+        juce::File stateFile;
+        juce::File writeStateFile;
+        juce::String format;
+        int preset = -1;
+        int bits = 0;
+        int blockSize = 8192;
+        int jobs = juce::SystemStats::getNumCpus();
+        double tailSeconds = -1.0;
+        std::vector<Job> files;
+    };
+
+    juce::String outputExtension(const juce::File& input, const Options& options)
+    {
+        return options.format.isNotEmpty() ? "." + options.format.trimCharactersAtStart(".") : input.getFileExtension();
+    }
+
+    Options parseOptions(const juce::ArgumentList& args)
+    {
+        Options options;
+
+        if (args.containsOption("--out-dir"))
+            options.outDir = args.getFileForOption("--out-dir");
+        if (args.containsOption("--state"))
+            options.stateFile = args.getFileForOption("--state");
+        if (args.containsOption("--write-state"))
+            options.writeStateFile = args.getFileForOption("--write-state");
+        if (args.containsOption("--format"))
+            options.format = args.getValueForOption("--format").toLowerCase();
+        if (args.containsOption("--preset"))
+            options.preset = args.getValueForOption("--preset").getIntValue();
+        if (args.containsOption("--bits"))
+            options.bits = args.getValueForOption("--bits").getIntValue();
+        if (args.containsOption("--block-size"))
+            options.blockSize = juce::jmax(64, args.getValueForOption("--block-size").getIntValue());
+        if (args.containsOption("--jobs"))
+            options.jobs = juce::jmax(1, args.getValueForOption("--jobs").getIntValue());
+        if (args.containsOption("--tail"))
+            options.tailSeconds = args.getValueForOption("--tail").getDoubleValue();
+
+        // argumentos que nao sao opcoes: arquivos ou pastas de entrada
+        for (const auto& argument : args.arguments)
+        {
+            if (argument.isOption())
+                continue;
+
+            const auto path = juce::File::getCurrentWorkingDirectory().getChildFile(argument.text);
+
+            if (path.isDirectory())
+            {
+                for (const auto& file : path.findChildFiles(juce::File::findFiles, true, audioWildcard))
+                    options.files.push_back({ file, options.outDir.getChildFile(file.getRelativePathFrom(path))
+                                                                  .withFileExtension(outputExtension(file, options)) });
+            }
+            else if (path.existsAsFile())
+            {
+                options.files.push_back({ path, options.outDir.getChildFile(path.getFileName())
+                                                              .withFileExtension(outputExtension(path, options)) });
+            }
+            else
+            {
+                std::printf("ignorado (nao encontrado): %s\n", argument.text.toRawUTF8());
+            }
+        }
+
+        return options;
+    }
+
+    //==============================================================================
+    // Entrada e saida
+    //------------------------------------------------------------------------------
+    std::unique_ptr<juce::AudioFormatReader> openReader(const juce::File& file, juce::AudioFormatManager& formats,
+                                                        juce::TimeSliceThread& readThread)
+    {
+        // WAV e AIFF: arquivo mapeado em memoria, lido sem copias intermediarias
+        if (auto* format = formats.findFormatForFileExtension(file.getFileExtension()))
+        {
+            std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(file));
+
+            if (mapped != nullptr && mapped->mapEntireFile())
+                return mapped;
+        }
+
+        // demais formatos: decodificacao antecipada em outra thread
+        if (auto* reader = formats.createReaderFor(file))
+        {
+            auto buffering = std::make_unique<juce::BufferingAudioReader>(reader, readThread, readAheadSamples);
+            buffering->setReadTimeout(-1); // offline: espera os dados em vez de devolver silencio
+            return buffering;
+        }
+
+        return {};
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> openWriter(const juce::File& file, juce::AudioFormat& format,
+                                                                        double sampleRate, int numChannels, int bits,
+                                                                        juce::TimeSliceThread& writeThread)
+    {
+        // usa a profundidade pedida se o formato aceitar; senao a maior disponivel
+        const auto depths = format.getPossibleBitDepths();
+        if (! depths.contains(bits) && ! depths.isEmpty())
+            bits = depths.getLast();
+
+        file.getParentDirectory().createDirectory();
+        file.deleteFile();
+
+        std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+        if (stream == nullptr)
+            return {};
+
+        auto* writer = format.createWriterFor(stream.get(), sampleRate, (unsigned int)numChannels, bits, {}, 0);
+        if (writer == nullptr)
+            return {};
+
+        stream.release(); // o writer passa a ser dono do stream
+        return std::make_unique<juce::AudioFormatWriter::ThreadedWriter>(writer, writeThread, writeFifoSamples);
+    }
+
+    //==============================================================================
+    // Renderizacao de um arquivo
+    //------------------------------------------------------------------------------
+    class RenderJob : public juce::ThreadPoolJob
+    {
+    public:
+        RenderJob(const Job& jobToRun, const Options& renderOptions, const juce::MemoryBlock& stateToApply,
+                  juce::TimeSliceThread& readingThread, juce::TimeSliceThread& writingThread, std::atomic<int>& failureCount)
+            : juce::ThreadPoolJob(jobToRun.input.getFileName()),
+              job(jobToRun), options(renderOptions), state(stateToApply),
+              readThread(readingThread), writeThread(writingThread), failures(failureCount)
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+            const auto error = render();
+            const auto seconds = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+            if (error.isNotEmpty())
+            {
+                ++failures;
+                std::printf("ERRO %s: %s\n", job.input.getFullPathName().toRawUTF8(), error.toRawUTF8());
+            }
+            else
+            {
+                std::printf("ok   %s -> %s (%.2f s, %.0fx tempo real)\n", job.input.getFileName().toRawUTF8(),
+                            job.output.getFullPathName().toRawUTF8(), seconds, renderedSeconds / juce::jmax(seconds, 1.0e-6));
+            }
+
+            return jobHasFinished;
+        }
+
+    private:
+        // Retorna a mensagem de erro, ou vazio se o arquivo foi gravado
+        juce::String render()
+        {
+            juce::AudioFormatManager formats;
+            formats.registerBasicFormats();
+
+            auto reader = openReader(job.input, formats, readThread);
+            if (reader == nullptr)
+                return "formato de entrada nao reconhecido";
+
+            auto* outputFormat = formats.findFormatForFileExtension(job.output.getFileExtension());
+            if (outputFormat == nullptr)
+                return "formato de saida nao reconhecido";
+
+            auto processor = plugin_tools::createProcessor();
+
+            if (state.getSize() > 0)
+                processor->setStateInformation(state.getData(), (int)state.getSize());
+            else if (options.preset >= 0)
+                processor->setCurrentProgram(juce::jlimit(0, processor->getNumPrograms() - 1, options.preset));
+
+            const double sampleRate = reader->sampleRate;
+            plugin_tools::prepareForOfflineRendering<float>(*processor, sampleRate, options.blockSize);
+
+            const int numOutputChannels = processor->getTotalNumOutputChannels();
+            const int bits = options.bits > 0 ? options.bits : (int)reader->bitsPerSample;
+
+            auto writer = openWriter(job.output, *outputFormat, sampleRate, numOutputChannels, bits, writeThread);
+            if (writer == nullptr)
+                return "nao foi possivel criar " + job.output.getFullPathName();
+
+            // a saida vem atrasada pela latencia do plugin: as primeiras latency amostras sao
+            // descartadas e o mesmo tanto e renderizado a mais no fim, alinhado com a entrada
+            const double tail = options.tailSeconds >= 0 ? options.tailSeconds : processor->getTailLengthSeconds();
+            const juce::int64 latency = juce::jmax(0, processor->getLatencySamples());
+            const juce::int64 inputLength = reader->lengthInSamples;
+            const juce::int64 totalLength = inputLength + latency + (juce::int64)(tail * sampleRate);
+
+            juce::AudioBuffer<float> buffer(plugin_tools::getNumProcessingChannels(*processor), options.blockSize);
+            juce::MidiBuffer midi;
+
+            for (juce::int64 position = 0; position < totalLength; position += options.blockSize)
+            {
+                if (shouldExit())
+                    return "interrompido";
+
+                const int numSamples = (int)juce::jmin((juce::int64)options.blockSize, totalLength - position);
+
+                // entrada mono e copiada para os dois canais pelo proprio reader
+                buffer.clear();
+                if (position < inputLength)
+                    reader->read(&buffer, 0, (int)juce::jmin((juce::int64)numSamples, inputLength - position), position, true, true);
+
+                juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), 0, numSamples);
+                plugin_tools::processBlock(*processor, block, midi);
+
+                const int skip = (int)juce::jlimit((juce::int64)0, (juce::int64)numSamples, latency - position);
+
+                if (skip == numSamples)
+                    continue;
+
+                const juce::AudioBuffer<float> output(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), skip, numSamples - skip);
+
+                // a fila so recusa quando esta cheia: espera a thread de escrita esvazia-la
+                while (! writer->write(output.getArrayOfReadPointers(), numSamples - skip))
+                    juce::Thread::sleep(1);
+            }
+
+            processor->releaseResources();
+
+            // o destrutor grava o que ainda esta na fila
+            writer.reset();
+
+            renderedSeconds = (double)(totalLength - latency) / sampleRate;
+            return {};
+        }
+
+        const Job job;
+        const Options& options;
+        const juce::MemoryBlock& state;
+        juce::TimeSliceThread& readThread;
+        juce::TimeSliceThread& writeThread;
+        std::atomic<int>& failures;
+        double renderedSeconds = 0;
+    };
+
+    //==============================================================================
+    // Estado do plugin
+    //------------------------------------------------------------------------------
+    // Le o estado salvo, aceitando tanto o binario de getStateInformation quanto XML
+    bool loadState(const juce::File& file, juce::MemoryBlock& state)
+    {
+        if (! file.loadFileAsData(state))
+            return false;
+
+        if (auto xml = juce::parseXML(file))
+        {
+            state.reset();
+            juce::AudioProcessor::copyXmlToBinary(*xml, state);
+        }
+
+        return state.getSize() > 0;
+    }
+
+    bool writeState(const juce::File& file, const Options& options)
+    {
+        auto processor = plugin_tools::createProcessor();
+
+        if (options.preset >= 0)
+            processor->setCurrentProgram(juce::jlimit(0, processor->getNumPrograms() - 1, options.preset));
+
+        juce::MemoryBlock state;
+        processor->getStateInformation(state);
+
+        auto xml = juce::AudioProcessor::getXmlFromBinary(state.getData(), (int)state.getSize());
+        return xml != nullptr && xml->writeTo(file);
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // o gerenciador de mensagens precisa existir para os timers de AudioProcessorValueTreeState
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const auto options = parseOptions(juce::ArgumentList(argc, argv));
+
+    if (options.writeStateFile != juce::File())
+        return writeState(options.writeStateFile, options) ? 0 : 1;
+
+    if (options.files.empty())
+    {
+        std::printf("uso: %s [opcoes] <arquivos ou pastas>... (ver tools/OfflineRender.cpp)\n", argv[0]);
+        return 1;
+    }
+
+    juce::MemoryBlock state;
+
+    if (options.stateFile != juce::File() && ! loadState(options.stateFile, state))
+    {
+        std::printf("estado invalido: %s\n", options.stateFile.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    juce::TimeSliceThread readThread("leitura");
+    juce::TimeSliceThread writeThread("escrita");
+    readThread.startThread();
+    writeThread.startThread();
+
+    std::atomic<int> failures { 0 };
+
+    {
+        juce::ThreadPool pool(options.jobs);
+
+        for (const auto& job : options.files)
+            pool.addJob(new RenderJob(job, options, state, readThread, writeThread, failures), true);
+
+        while (pool.getNumJobs() > 0)
+            juce::Thread::sleep(50);
+    }
+
+    readThread.stopThread(1000);
+    writeThread.stopThread(1000);
+
+    std::printf("%d arquivo(s), %d erro(s)\n", (int)options.files.size(), failures.load());
+
+    if (plugin_tools::reportRealtimeViolations("processBlock"))
+        return 1;
+
+    return failures > 0 ? 1 : 0;
+}
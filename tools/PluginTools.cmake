@@ -0,0 +1,67 @@
+# ==============================================================
+#   Ferramentas de console dos plugins (sem host)
+
+#   Uso no CMakeLists.txt do plugin (depois de add_subdirectory(../dsp_core ...)):
+#   include(../tools/PluginTools.cmake)
+#   add_plugin_tools(${PROJECT_NAME} PluginProcessor.cpp PluginEditor.cpp)
+#
+#   Cria, para cada plugin:
+#   ${PROJECT_NAME}_Golden   renderiza os presets sobre sinais canonicos e compara
+#                            com as saidas de referencia em golden/ (ver GoldenTest.cpp;
+#                            gravadas do primeiro commit por record_golden_nix.sh)
+#   ${PROJECT_NAME}_Render   processa arquivos de audio em lote, um arquivo por nucleo
+#                            (ver OfflineRender.cpp)
+#
+#   Com -DDSP_CORE_RT_CHECK=ON as duas ferramentas tambem falham se processBlock alocar
+#   memoria ou travar um mutex (ver dsp_core/RealtimeCheck.h)
+#
+#   Todos os plugins declaram a mesma classe MyAudioProcessor, entao cada ferramenta
+#   compila os fontes do proprio plugin e obtem o processador por createPluginFilter()
+# ==============================================================
+
+set(PLUGIN_TOOLS_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+# Executavel de console com os fontes do plugin mais tool_source
+function(_add_plugin_console_tool target tool_name tool_source)
+    set(tool ${target}_${tool_name})
+
+    juce_add_console_app(${tool} PRODUCT_NAME "${tool}")
+
+    set_target_properties(${tool} PROPERTIES CXX_STANDARD 17)
+
+    target_sources(${tool}
+        PRIVATE
+            ${PLUGIN_TOOLS_DIR}/${tool_source}
+            ${ARGN}
+    )
+
+    target_include_directories(${tool} PRIVATE ${CMAKE_CURRENT_SOURCE_DIR})
+
+    target_compile_definitions(${tool}
+        PRIVATE
+            JucePlugin_Name="${target}"
+            JUCE_WEB_BROWSER=0
+            JUCE_USE_CURL=0
+            JUCE_DSP_ENABLE_SNAP_TO_ZERO=1
+            # pasta das saidas de referencia do plugin
+            PLUGIN_GOLDEN_DIR="${CMAKE_CURRENT_SOURCE_DIR}/golden")
+
+    target_link_libraries(${tool}
+        PRIVATE
+	    juce::juce_audio_utils
+	    juce::juce_dsp
+	    dsp_core
+	    dsp_core_rt_check
+        PUBLIC
+            juce::juce_recommended_config_flags
+            juce::juce_recommended_lto_flags
+            juce::juce_recommended_warning_flags
+    )
+endfunction()
+
+# Adiciona as ferramentas de console do plugin target. Os argumentos seguintes sao os
+# fontes do plugin (os mesmos de target_sources)
+function(add_plugin_tools target)
+    _add_plugin_console_tool(${target} Golden GoldenTest.cpp ${ARGN})
+    _add_plugin_console_tool(${target} Render OfflineRender.cpp ${ARGN})
+endfunction()
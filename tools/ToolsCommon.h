@@ -0,0 +1,75 @@
+//==============================================================================
+// ToolsCommon.h: funcoes comuns as ferramentas de console dos plugins
+//==============================================================================
+
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include "dsp_core/RealtimeCheck.h"
+
+#include <memory>
+#include <type_traits>
+
+// Definida no PluginProcessor.cpp do plugin (ver dsp_core/PluginCommon.h)
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+namespace plugin_tools
+{
+    // Blocos de silencio processados depois de prepareToPlay, com uma pausa entre eles:
+    // aplicam os parametros atuais (update() roda no fim do bloco) e dao tempo para
+    // cargas em segundo plano, como a IR de juce::dsp::Convolution. O numero de amostras
+    // e fixo para que a saida seja deterministica
+    constexpr int settleBlocks = 8;
+    constexpr int settleSleepMs = 100;
+
+    // Nova instancia do plugin, fora de um host
+    inline std::unique_ptr<juce::AudioProcessor> createProcessor()
+    {
+        std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+        processor->setNonRealtime(true);
+        return processor;
+    }
+
+    // Numero de canais do buffer passado a processBlock
+    inline int getNumProcessingChannels(const juce::AudioProcessor& processor)
+    {
+        return juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+    }
+
+    // processBlock como secao de tempo real: com DSP_CORE_RT_CHECK, alocacoes e locks
+    // dentro dele (incluindo update()) sao registrados (ver dsp_core/RealtimeCheck.h)
+    template <typename SampleType>
+    void processBlock(juce::AudioProcessor& processor, juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midi)
+    {
+        const dsp_core::RealtimeCheck::ScopedSection realtimeSection;
+        processor.processBlock(buffer, midi);
+    }
+
+    // Imprime as violacoes de tempo real registradas ate aqui; true se houve alguma
+    inline bool reportRealtimeViolations(const juce::String& context)
+    {
+        dsp_core::RealtimeCheck::printReport(context.toRawUTF8());
+        return dsp_core::RealtimeCheck::getNumViolations() > 0;
+    }
+
+    // Prepara o plugin (ja com preset ou estado aplicado) para processar em SampleType
+    template <typename SampleType>
+    void prepareForOfflineRendering(juce::AudioProcessor& processor, double sampleRate, int blockSize)
+    {
+        processor.setProcessingPrecision(std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                           : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<SampleType> silence(getNumProcessingChannels(processor), blockSize);
+        juce::MidiBuffer midi;
+
+        for (int i = 0; i < settleBlocks; ++i)
+        {
+            silence.clear();
+            processBlock(processor, silence, midi);
+            juce::Thread::sleep(settleSleepMs);
+        }
+    }
+}
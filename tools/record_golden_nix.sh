@@ -0,0 +1,74 @@
+#!/bin/sh
+# ==============================================================
+#   Grava as saidas de referencia (golden/) de todos os plugins com o codigo de uma
+#   revisao anterior, para que as otimizacoes seguintes sejam comparadas com o
+#   comportamento original, e nao com o proprio resultado (ver GoldenTest.cpp)
+#
+#   Uso (na raiz do repositorio):
+#   tools/record_golden_nix.sh [revisao]
+#
+#   revisao: padrao e o primeiro commit do repositorio (o codigo escalar original, antes
+#   de Denormals, do caminho double e de dsp_core). A revisao e extraida em uma git
+#   worktree temporaria. Se ela ainda nao tem as ferramentas, tools/ e dsp_core/ desta
+#   arvore sao copiados para la e o CMakeLists.txt de cada plugin ganha
+#   add_plugin_tools com os fontes do proprio plugin naquela revisao: o codigo do
+#   plugin continua o original, so o GoldenTest e o verificador de tempo real vem daqui.
+#   Cada <Plugin>_Golden e compilado la e grava as referencias em <plugin>/golden/
+#   desta arvore. Plugins que nao existem na revisao sao ignorados. Depois:
+#   git add */golden
+# ==============================================================
+
+set -e
+
+root=$(git rev-parse --show-toplevel)
+revision=${1:-$(git -C "$root" rev-list --max-parents=0 HEAD | tail -n 1)}
+work=$(mktemp -d)
+
+trap 'git -C "$root" worktree remove --force "$work/src" >/dev/null 2>&1; rm -rf "$work"' EXIT
+
+echo "referencias da revisao $revision"
+git -C "$root" worktree add --detach "$work/src" "$revision" >/dev/null
+
+# ferramentas e dsp_core atuais, so quando a revisao nao tem as proprias
+if [ ! -f "$work/src/tools/PluginTools.cmake" ]
+then
+    rm -rf "$work/src/tools" "$work/src/dsp_core"
+    cp -R "$root/tools" "$work/src/tools"
+    cp -R "$root/dsp_core" "$work/src/dsp_core"
+fi
+
+for d in "$work"/src/0??_*
+do
+    plugin=$(basename "$d")
+
+    if ! grep -q "add_plugin_tools" "$root/$plugin/CMakeLists.txt" 2>/dev/null || [ ! -f "$d/CMakeLists.txt" ]
+    then
+        continue
+    fi
+
+    if ! grep -q "add_plugin_tools" "$d/CMakeLists.txt"
+    then
+        # fontes .cpp de target_sources(${PROJECT_NAME} ...) da revisao
+        sources=$(awk '/target_sources\(\$\{PROJECT_NAME\}/ { inside = 1; next }
+                       inside && /\)/ { inside = 0 }
+                       inside { for (i = 1; i <= NF; ++i) if ($i ~ /\.cpp$/) printf "%s ", $i }' "$d/CMakeLists.txt")
+
+        if ! grep -q "add_subdirectory(../dsp_core" "$d/CMakeLists.txt"
+        then
+            echo "add_subdirectory(../dsp_core dsp_core)" >> "$d/CMakeLists.txt"
+        fi
+
+        echo "include(../tools/PluginTools.cmake)" >> "$d/CMakeLists.txt"
+        echo "add_plugin_tools(\${PROJECT_NAME} $sources)" >> "$d/CMakeLists.txt"
+    fi
+
+    name=$(sed -n 's/^project(\([A-Za-z0-9_]*\).*/\1/p' "$d/CMakeLists.txt")
+    echo "$plugin - ${name}_Golden"
+
+    cmake -S "$d" -B "$work/build/$plugin" -DCMAKE_BUILD_TYPE=Release >/dev/null
+    cmake --build "$work/build/$plugin" --config Release --target "${name}_Golden" -j4 >/dev/null
+
+    tool=$(find "$work/build/$plugin" -type f -name "${name}_Golden" -perm -u+x | head -n 1)
+    mkdir -p "$root/$plugin/golden"
+    "$tool" --record --golden-dir="$root/$plugin/golden"
+done